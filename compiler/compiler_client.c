@@ -0,0 +1,77 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/* forwards its command line to a running `xvr --server` and exits with the
+ * compile's status, or runs the full compiler itself when none listens */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "compiler_server.h"
+
+/* the compiler installed next to this client, else the one on PATH */
+static void exec_compiler(int argc, const char* argv[]) {
+    char** args = calloc((size_t)argc + 1, sizeof(char*));
+    if (!args) {
+        return;
+    }
+    for (int i = 1; i < argc; i++) {
+        args[i] = (char*)argv[i];
+    }
+
+    char path[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length > 0) {
+        path[length] = '\0';
+        char* slash = strrchr(path, '/');
+        if (slash && (size_t)(slash - path) + 5 < sizeof(path)) {
+            strcpy(slash + 1, "xvr");
+            args[0] = path;
+            execv(path, args);
+        }
+    }
+
+    args[0] = (char*)"xvr";
+    execvp("xvr", args);
+    free(args);
+}
+
+int main(int argc, const char* argv[]) {
+    char socket_path[PATH_MAX];
+    int status = 0;
+    if (Xvr_compileServerSocketPath(NULL, socket_path, sizeof(socket_path)) &&
+        Xvr_forwardToCompileServer(socket_path, argc, argv, &status)) {
+        return status;
+    }
+
+    exec_compiler(argc, argv);
+    fprintf(stderr, "error: no compile server is running and xvr could not "
+                    "be started: %s\n",
+            strerror(errno));
+    return 1;
+}
@@ -0,0 +1,471 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // struct ucred
+#endif
+
+#include "compiler_server.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+extern char** environ;
+
+#define XVR_SERVER_MAGIC 0x58565253u  // "XVRS"
+#define XVR_SERVER_MAX_PAYLOAD (16u << 20)
+
+/* sent with the client's stdin, stdout and stderr attached, followed by the
+ * payload: cwd, argv and the environment, each NUL terminated */
+typedef struct {
+    uint32_t magic;
+    uint32_t argc;
+    uint32_t envc;
+    uint32_t payload_size;
+} Xvr_ServerRequest;
+
+static volatile sig_atomic_t server_stopping = 0;
+
+static void stop_server(int signal_number) {
+    (void)signal_number;
+    server_stopping = 1;
+}
+
+static bool write_all(int fd, const void* data, size_t size) {
+    const char* bytes = (const char*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void* data, size_t size) {
+    char* bytes = (char*)data;
+    while (size > 0) {
+        ssize_t got = read(fd, bytes, size);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        bytes += got;
+        size -= (size_t)got;
+    }
+    return true;
+}
+
+static bool socket_address(const char* socket_path, struct sockaddr_un* addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr->sun_path)) {
+        return false;
+    }
+    strcpy(addr->sun_path, socket_path);
+    return true;
+}
+
+static int connect_server(const char* socket_path) {
+    struct sockaddr_un addr;
+    if (!socket_address(socket_path, &addr)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* the uid of the process at the other end of a connected socket */
+static bool peer_uid(int fd, uid_t* out) {
+#if defined(SO_PEERCRED)
+    struct ucred cred;
+    socklen_t length = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &length) != 0) {
+        return false;
+    }
+    *out = cred.uid;
+    return true;
+#else
+    gid_t gid;
+    return getpeereid(fd, out, &gid) == 0;
+#endif
+}
+
+/* /tmp/xvr-<uid>, made 0700 on first use. refused when another user or a
+ * symlink holds the name */
+static bool private_directory(char* out, size_t out_size) {
+    int written = snprintf(out, out_size, "/tmp/xvr-%u", (unsigned)getuid());
+    if (written <= 0 || (size_t)written >= out_size) {
+        return false;
+    }
+    if (mkdir(out, 0700) != 0 && errno != EEXIST) {
+        return false;
+    }
+
+    struct stat info;
+    if (lstat(out, &info) != 0 || !S_ISDIR(info.st_mode) ||
+        info.st_uid != getuid()) {
+        return false;
+    }
+    return (info.st_mode & 077) == 0 || chmod(out, 0700) == 0;
+}
+
+bool Xvr_compileServerSocketPath(const char* requested, char* out,
+                                 size_t out_size) {
+    const char* from_env = getenv("XVR_SERVER_SOCKET");
+    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+
+    int written;
+    if (requested && requested[0] != '\0') {
+        written = snprintf(out, out_size, "%s", requested);
+    } else if (from_env && from_env[0] != '\0') {
+        written = snprintf(out, out_size, "%s", from_env);
+    } else if (runtime_dir && runtime_dir[0] != '\0') {
+        written = snprintf(out, out_size, "%s/xvr.sock", runtime_dir);
+    } else {
+        char directory[64];
+        if (!private_directory(directory, sizeof(directory))) {
+            return false;
+        }
+        written = snprintf(out, out_size, "%s/xvr.sock", directory);
+    }
+
+    struct sockaddr_un addr;
+    return written > 0 && (size_t)written < out_size &&
+           (size_t)written < sizeof(addr.sun_path);
+}
+
+static bool receive_request(int conn, Xvr_ServerRequest* request,
+                            int fds[3]) {
+    char control[CMSG_SPACE(sizeof(int) * 3)];
+    struct iovec iov = {.iov_base = request, .iov_len = sizeof(*request)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t got;
+    do {
+        got = recvmsg(conn, &msg, 0);
+    } while (got < 0 && errno == EINTR);
+    if (got <= 0) {
+        return false;
+    }
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+        cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(int) * 3)) {
+        return false;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * 3);
+
+    // the descriptors came with the first bytes, the rest is plain data
+    if ((size_t)got < sizeof(*request) &&
+        !read_all(conn, (char*)request + got, sizeof(*request) - (size_t)got)) {
+        return false;
+    }
+    /* every string takes at least its NUL, so the counts are bounded by the
+     * payload before anything is allocated for them */
+    return request->magic == XVR_SERVER_MAGIC &&
+           request->payload_size <= XVR_SERVER_MAX_PAYLOAD &&
+           request->argc <= request->payload_size &&
+           request->envc <= request->payload_size;
+}
+
+/* splits `count` NUL terminated strings off the payload cursor */
+static bool take_strings(char** cursor, const char* end, uint32_t count,
+                         char** out) {
+    for (uint32_t i = 0; i < count; i++) {
+        char* terminator = memchr(*cursor, '\0', (size_t)(end - *cursor));
+        if (!terminator) {
+            return false;
+        }
+        out[i] = *cursor;
+        *cursor = terminator + 1;
+    }
+    out[count] = NULL;
+    return true;
+}
+
+/* runs in the forked child, the client's stdio replaces the server's */
+static int serve_request(int conn, Xvr_CompileServerCommand command) {
+    signal(SIGCHLD, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    // the socket is 0600, but its mode can be loosened after bind()
+    uid_t uid;
+    if (!peer_uid(conn, &uid) || uid != getuid()) {
+        fprintf(stderr, "xvr: refused a request from another user\n");
+        return 1;
+    }
+
+    Xvr_ServerRequest request;
+    int fds[3] = {-1, -1, -1};
+    if (!receive_request(conn, &request, fds)) {
+        return 1;
+    }
+    for (int i = 0; i < 3; i++) {
+        dup2(fds[i], i);
+        close(fds[i]);
+    }
+
+    char* payload = malloc((size_t)request.payload_size + 1);
+    char** argv = calloc((size_t)request.argc + 1, sizeof(char*));
+    char** envp = calloc((size_t)request.envc + 1, sizeof(char*));
+    if (!payload || !argv || !envp ||
+        !read_all(conn, payload, request.payload_size)) {
+        fprintf(stderr, "error: the compile server could not read the "
+                        "request\n");
+        return 1;
+    }
+    payload[request.payload_size] = '\0';
+
+    char* cursor = payload;
+    const char* end = payload + request.payload_size + 1;
+    char* directory[2];
+    if (request.argc == 0 || !take_strings(&cursor, end, 1, directory) ||
+        !take_strings(&cursor, end, request.argc, argv) ||
+        !take_strings(&cursor, end, request.envc, envp)) {
+        fprintf(stderr, "error: malformed compile server request\n");
+        return 1;
+    }
+
+    environ = envp;
+    if (chdir(directory[0]) != 0) {
+        fprintf(stderr, "error: could not enter '%s': %s\n", directory[0],
+                strerror(errno));
+        return 1;
+    }
+
+    int32_t status = command((int)request.argc, (const char**)argv);
+    fflush(NULL);
+    write_all(conn, &status, sizeof(status));
+    return status;
+}
+
+int Xvr_runCompileServer(const char* socket_path,
+                         Xvr_CompileServerCommand command) {
+    struct sockaddr_un addr;
+    if (!socket_address(socket_path, &addr)) {
+        fprintf(stderr, "error: socket path '%s' is too long\n", socket_path);
+        return 1;
+    }
+
+    int running = connect_server(socket_path);
+    if (running >= 0) {
+        close(running);
+        fprintf(stderr, "error: a compile server already listens on %s\n",
+                socket_path);
+        return 1;
+    }
+    unlink(socket_path);  // left behind by a server that did not shut down
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    // only this user may hand the server a command line
+    mode_t previous_mask = umask(0077);
+    int bound = bind(listener, (struct sockaddr*)&addr, sizeof(addr));
+    umask(previous_mask);
+    if (bound != 0 || listen(listener, 64) != 0) {
+        fprintf(stderr, "error: could not listen on %s: %s\n", socket_path,
+                strerror(errno));
+        close(listener);
+        return 1;
+    }
+
+    struct sigaction reap;
+    memset(&reap, 0, sizeof(reap));
+    reap.sa_handler = SIG_IGN;
+    reap.sa_flags = SA_NOCLDWAIT;
+    sigaction(SIGCHLD, &reap, NULL);
+
+    // no SA_RESTART, a signal has to interrupt accept()
+    struct sigaction stop;
+    memset(&stop, 0, sizeof(stop));
+    stop.sa_handler = stop_server;
+    sigaction(SIGINT, &stop, NULL);
+    sigaction(SIGTERM, &stop, NULL);
+
+    fprintf(stderr, "xvr: compile server listening on %s\n", socket_path);
+
+    int status = 0;
+    while (!server_stopping) {
+        int conn = accept(listener, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            perror("accept");
+            status = 1;
+            break;
+        }
+
+        fflush(NULL);
+        pid_t child = fork();
+        if (child == 0) {
+            close(listener);
+            _exit(serve_request(conn, command) & 0xff);
+        }
+        if (child < 0) {
+            perror("fork");
+        }
+        close(conn);
+    }
+
+    close(listener);
+    unlink(socket_path);
+    return status;
+}
+
+bool Xvr_forwardToCompileServer(const char* socket_path, int argc,
+                                const char* argv[], int* out_status) {
+    char cwd[4096];
+    if (argc <= 0 || !getcwd(cwd, sizeof(cwd))) {
+        return false;
+    }
+
+    uint32_t envc = 0;
+    size_t payload_size = strlen(cwd) + 1;
+    for (int i = 0; i < argc; i++) {
+        payload_size += strlen(argv[i]) + 1;
+    }
+    for (char** env = environ; env && *env; env++) {
+        payload_size += strlen(*env) + 1;
+        envc++;
+    }
+    if (payload_size > XVR_SERVER_MAX_PAYLOAD) {
+        return false;
+    }
+
+    char* payload = malloc(payload_size);
+    if (!payload) {
+        return false;
+    }
+    char* cursor = payload;
+    size_t length = strlen(cwd) + 1;
+    memcpy(cursor, cwd, length);
+    cursor += length;
+    for (int i = 0; i < argc; i++) {
+        length = strlen(argv[i]) + 1;
+        memcpy(cursor, argv[i], length);
+        cursor += length;
+    }
+    for (uint32_t i = 0; i < envc; i++) {
+        length = strlen(environ[i]) + 1;
+        memcpy(cursor, environ[i], length);
+        cursor += length;
+    }
+
+    int conn = connect_server(socket_path);
+    if (conn < 0) {
+        free(payload);
+        return false;
+    }
+
+    // the environment and stdio only go to a server this user started
+    uid_t uid;
+    if (!peer_uid(conn, &uid) || uid != getuid()) {
+        fprintf(stderr, "error: the compile server on %s belongs to another "
+                        "user, compiling locally\n",
+                socket_path);
+        close(conn);
+        free(payload);
+        return false;
+    }
+
+    Xvr_ServerRequest request = {.magic = XVR_SERVER_MAGIC,
+                                 .argc = (uint32_t)argc,
+                                 .envc = envc,
+                                 .payload_size = (uint32_t)payload_size};
+    int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+    struct iovec iov = {.iov_base = &request, .iov_len = sizeof(request)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(conn, &msg, 0);
+    } while (sent < 0 && errno == EINTR);
+    bool forwarded =
+        sent > 0 &&
+        write_all(conn, (char*)&request + sent, sizeof(request) - (size_t)sent) &&
+        write_all(conn, payload, payload_size);
+    free(payload);
+    if (!forwarded) {
+        close(conn);
+        return false;
+    }
+
+    int32_t status = 0;
+    if (!read_all(conn, &status, sizeof(status))) {
+        fprintf(stderr, "error: the compile server dropped the request\n");
+        status = 1;
+    }
+    close(conn);
+    *out_status = status;
+    return true;
+}
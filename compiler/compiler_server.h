@@ -0,0 +1,62 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef COMPILER_SERVER_H
+#define COMPILER_SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* runs one forwarded command line, stdio and the working directory are the
+ * client's by then. returns the exit status handed back to the client */
+typedef int (*Xvr_CompileServerCommand)(int argc, const char* argv[]);
+
+/* the socket a server listens on when `requested` is NULL:
+ * $XVR_SERVER_SOCKET, $XDG_RUNTIME_DIR/xvr.sock or /tmp/xvr-<uid>/xvr.sock.
+ * false when the path is too long or /tmp/xvr-<uid> is not this user's
+ * private directory */
+bool Xvr_compileServerSocketPath(const char* requested, char* out,
+                                 size_t out_size);
+
+/* accepts requests until SIGINT or SIGTERM. every request runs `command` in a
+ * child forked from this process, so whatever was set up before the call is
+ * already warm for it */
+int Xvr_runCompileServer(const char* socket_path,
+                         Xvr_CompileServerCommand command);
+
+/* sends the command line, environment, working directory and stdio to the
+ * server and waits for the exit status. false when no server listens or
+ * another user's process holds the socket */
+bool Xvr_forwardToCompileServer(const char* socket_path, int argc,
+                                const char* argv[], int* out_status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
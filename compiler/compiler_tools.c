@@ -53,11 +53,12 @@ const unsigned char* Xvr_readFile(const char* path, size_t* fileSize) {
 }
 
 #ifdef XVR_EXPORT_LLVM
-Xvr_ASTNode** parse_to_ast(const char* source, int* out_count) {
+Xvr_ASTNode** parse_to_ast(Xvr_CompilerSession* session, const char* source,
+                           int* out_count) {
     Xvr_Lexer lexer;
     Xvr_Parser parser;
 
-    Xvr_initLexer(&lexer, source);
+    Xvr_initLexerWithSession(&lexer, source, session);
     Xvr_initParser(&parser, &lexer);
 
     Xvr_ASTNode** nodes = NULL;
@@ -27,15 +27,19 @@ SOFTWARE.
 
 #include "xvr_ast_node.h"
 #include "xvr_common.h"
+#include "xvr_compiler_session.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* copies the whole file into the heap, for objects and files that may change
+ * while they are read; sources are loaded with Xvr_mapSourceFile */
 const unsigned char* Xvr_readFile(const char* path, size_t* fileSize);
 
 #ifdef XVR_EXPORT_LLVM
-Xvr_ASTNode** parse_to_ast(const char* source, int* out_count);
+Xvr_ASTNode** parse_to_ast(Xvr_CompilerSession* session, const char* source,
+                           int* out_count);
 #endif
 
 #ifdef __cplusplus
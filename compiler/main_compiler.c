@@ -1,5 +1,7 @@
 #include <limits.h>
 #include <llvm-c/Core.h>
+#include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,30 +11,25 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "backend/xvr_llvm_build_cache.h"
 #include "backend/xvr_llvm_codegen.h"
+#include "backend/xvr_llvm_object_cache.h"
+#include "backend/xvr_llvm_repl.h"
+#include "backend/xvr_llvm_source_build.h"
+#include "backend/xvr_llvm_target.h"
+#include "backend/xvr_llvm_thin_build.h"
+#include "compiler_server.h"
 #include "compiler_tools.h"
 #include "optimizer/xvr_ast_optimizer.h"
+#include "sema/xvr_builtin.h"
+#include "sema/xvr_watch.h"
 #include "xvr_ast_node.h"
 #include "xvr_common.h"
 #include "xvr_console_colors.h"
 #include "xvr_parser.h"
+#include "xvr_source_file.h"
 #include "xvr_unused.h"
 
-static int is_safe_path_component(const char* path) {
-    if (!path) return 0;
-    while (*path) {
-        if (*path == ';' || *path == '|' || *path == '&' || *path == '<' ||
-            *path == '>' || *path == '$' || *path == '`' || *path == '(' ||
-            *path == ')' || *path == '[' || *path == ']' || *path == '{' ||
-            *path == '}' || *path == '"' || *path == '\'' || *path == '\\' ||
-            *path == '\n' || *path == '\r') {
-            return 0;
-        }
-        path++;
-    }
-    return 1;
-}
-
 static double get_time_ms(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -66,10 +63,10 @@ static char* get_filename_without_ext(const char* path) {
     }
     if (!base) {
         base = path;
-        path_len = 0;
-        while (base[path_len] != '\0') {
-            path_len++;
-        }
+    }
+    path_len = 0;
+    while (base[path_len] != '\0') {
+        path_len++;
     }
 
     if (path_len < 4) {
@@ -170,6 +167,8 @@ static void print_note(const char* filename, int line, const char* message) {
 static void print_compiler_error(const char* filename, int line,
                                  const char* error_type, const char* message,
                                  const char* hint) {
+    /* keep anything already printed ahead of the error */
+    fflush(stdout);
     fputc('\n', stderr);
     fputs("error: ", stderr);
     fputs(message, stderr);
@@ -187,7 +186,681 @@ static void print_compiler_error(const char* filename, int line,
     fputc('\n', stderr);
 }
 
-int main(int argc, const char* argv[]) {
+/* the front end and code generator options this run was given */
+static void session_options(Xvr_CompilerOptions* options) {
+    Xvr_CompilerOptionsInit(options);
+    options->dumpTokens = Xvr_commandLine.dumpTokens;
+    options->verbose = Xvr_commandLine.verbose;
+    options->printDiagnostics = true;
+    options->optimizationLevel = Xvr_commandLine.optimizationLevel;
+    options->sizeLevel = Xvr_commandLine.sizeLevel;
+    options->asmSyntax = Xvr_commandLine.asmSyntax;
+    options->targetCPU = Xvr_commandLine.targetCPU;
+    options->targetFeatures = Xvr_commandLine.targetFeatures;
+    options->vectorizeLoops = Xvr_commandLine.vectorizeLoops;
+    options->vectorizeSLP = Xvr_commandLine.vectorizeSLP;
+    options->unrollLoops = Xvr_commandLine.unrollLoops;
+    options->inlineThreshold = Xvr_commandLine.inlineThreshold;
+    options->runtimeBitcode = Xvr_commandLine.runtimeBitcode;
+    options->thinLTO = Xvr_commandLine.thinLTO;
+    options->jobs = Xvr_commandLine.jobs;
+    options->passPipeline = Xvr_commandLine.passPipeline;
+    options->profileGenerate = Xvr_commandLine.profileGenerate;
+    options->profileUse = Xvr_commandLine.profileUse;
+}
+
+/* the session of everything compiled on the main thread */
+static Xvr_CompilerSession* cli_session(void) {
+    static Xvr_CompilerSession* session = NULL;
+    if (!session) {
+        Xvr_CompilerOptions options;
+        session_options(&options);
+        session = Xvr_CompilerSessionCreate(&options);
+    }
+    return session;
+}
+
+static bool write_file(const char* output_path, const void* data,
+                       size_t size) {
+    FILE* f = fopen(output_path, "wb");
+    if (!f) {
+        return false;
+    }
+    bool written = fwrite(data, 1, size, f) == size;
+    return fclose(f) == 0 && written;
+}
+
+static void free_objects(void** objects, size_t* sizes, size_t count) {
+    for (size_t i = 0; objects && i < count; i++) {
+        free(objects[i]);
+    }
+    free(objects);
+    free(sizes);
+}
+
+/* cpu time over wall time is what the split saved against one thread */
+static void print_codegen_timing(const Xvr_LLVMCodegenTiming* timing) {
+    if (timing->jobs == 0) {
+        return;
+    }
+    if (timing->jobs == 1) {
+        printf("  " XVR_CC_NOTICE "Codegen:" XVR_CC_RESET " %.2f ms\n",
+               timing->wall_ms);
+        return;
+    }
+    printf("  " XVR_CC_NOTICE "Codegen:" XVR_CC_RESET
+           " %.2f ms (%u jobs, %.2f ms cpu, %.1fx)\n",
+           timing->wall_ms, timing->jobs, timing->cpu_ms,
+           timing->wall_ms > 0.0 ? timing->cpu_ms / timing->wall_ms : 1.0);
+}
+
+/* xvr a.o b.o -o app: ThinLTO bitcode goes through the thin link, native
+ * objects are handed to the linker as they are */
+static int link_object_inputs(void) {
+    if (Xvr_commandLine.sourceFile || Xvr_commandLine.source) {
+        print_compiler_error(NULL, 0, "error",
+                             "object files cannot be mixed with a source "
+                             "file",
+                             "Compile the source with -c first");
+        return 1;
+    }
+
+    char* message = NULL;
+    bool ok = Xvr_LLVMThinBuildLinkInputs(
+        cli_session(), Xvr_commandLine.linkInputs,
+        (size_t)Xvr_commandLine.linkInputCount,
+        Xvr_commandLine.thinLTOCacheDir,
+        Xvr_commandLine.outFile ? Xvr_commandLine.outFile : "a.out",
+        &message);
+    if (!ok) {
+        print_compiler_error(NULL, 0, "error",
+                             message ? message : "failed to link executable",
+                             "Objects for a ThinLTO link come from "
+                             "'xvr -flto=thin -c'");
+    }
+    free(message);
+    return ok ? 0 : 1;
+}
+
+/* executables are named after the source, -c and --emit outputs get the
+ * matching extension; a name taken by a directory falls back to xvr_* */
+static char* output_file_name(bool shouldRun, bool useEmitType,
+                              int emitFileType) {
+    char* outFile = NULL;
+    if (Xvr_commandLine.outFile) {
+        return strdup(Xvr_commandLine.outFile);
+    }
+    if (!Xvr_commandLine.sourceFile) {
+        return strdup("a.out");
+    }
+
+    struct stat st;
+    if (shouldRun) {
+        outFile = get_filename_without_ext(Xvr_commandLine.sourceFile);
+        if (!outFile) {
+            outFile = strdup("a.out");
+        }
+        if (stat(outFile, &st) == 0 && S_ISDIR(st.st_mode)) {
+            free(outFile);
+            outFile = strdup("xvr_out");
+        }
+        return outFile;
+    }
+
+    const char* ext = NULL;
+    if (useEmitType) {
+        if (emitFileType == 1) {
+            ext = ".s";
+        } else if (emitFileType == 2) {
+            ext = ".ll";
+        }
+    } else if (Xvr_commandLine.compileOnly) {
+        ext = ".o";
+    }
+    outFile = build_output_filename(Xvr_commandLine.sourceFile, ext);
+    if (!outFile) {
+        outFile = strdup("a.out");
+    }
+    if (stat(outFile, &st) == 0 && S_ISDIR(st.st_mode)) {
+        free(outFile);
+        asprintf(&outFile, "xvr_%s", ext ? ext : "out");
+    }
+    return outFile;
+}
+
+/* links and runs the program, or reports the object -c wrote; takes the
+ * objects and the thin link */
+static int finish_build(void** objects, size_t* object_sizes,
+                        size_t object_count, Xvr_LLVMThinLink* thin_link,
+                        bool shouldRun, const char* outFile,
+                        const char* srcForError, double start_time,
+                        const Xvr_LLVMCodegenTiming* codegen_timing,
+                        const char* cache_note) {
+    double total_time = get_time_ms() - start_time;
+
+    if (!shouldRun) {
+        free_objects(objects, object_sizes, object_count);
+        long obj_size = get_file_size(outFile);
+        if (Xvr_commandLine.showTiming) {
+            const char* target = LLVMGetDefaultTargetTriple();
+            printf("\n");
+            printf("  " XVR_CC_NOTICE "Target:" XVR_CC_RESET " %s\n", target);
+            printf("  " XVR_CC_NOTICE "Size:" XVR_CC_RESET " %.1f KB\n",
+                   obj_size / 1024.0);
+            printf("  " XVR_CC_NOTICE "Time:" XVR_CC_RESET " %.2f ms\n",
+                   total_time);
+            print_codegen_timing(codegen_timing);
+            if (cache_note) {
+                printf("  " XVR_CC_NOTICE "Cache:" XVR_CC_RESET " %s\n",
+                       cache_note);
+            }
+            printf("\n");
+            LLVMDisposeMessage((char*)target);
+        }
+        return 0;
+    }
+
+    char* link_error = NULL;
+    bool linked;
+    if (thin_link) {
+        linked = Xvr_LLVMThinBuildLinkExecutable(thin_link, NULL, NULL, 0,
+                                                 outFile, &link_error);
+    } else if (Xvr_commandLine.profileGenerate) {
+        linked = Xvr_LLVMLinkerLinkInstrumentedExecutable(
+            objects[0], object_sizes[0], outFile, &link_error);
+    } else {
+        linked = Xvr_LLVMLinkerLinkExecutables((const void* const*)objects,
+                                               object_sizes, object_count,
+                                               outFile, &link_error);
+    }
+    Xvr_LLVMThinLinkDestroy(thin_link);
+    free_objects(objects, object_sizes, object_count);
+    if (!linked) {
+        print_compiler_error(srcForError, 0, "error",
+                             link_error ? link_error
+                                        : "failed to link executable",
+                             Xvr_commandLine.profileGenerate
+                                 ? "Set XVR_PROFILE_RUNTIME to "
+                                   "compiler-rt's libclang_rt.profile "
+                                   "archive"
+                                 : "Set XVR_RUNTIME_LIB to the libxvr.a "
+                                   "to link against");
+        free(link_error);
+        return 1;
+    }
+
+    double link_time = get_time_ms() - start_time - total_time;
+    long bin_size = get_file_size(outFile);
+
+    if (Xvr_commandLine.showTiming) {
+        const char* target = LLVMGetDefaultTargetTriple();
+        printf("\n");
+        printf("  " XVR_CC_NOTICE "Target:" XVR_CC_RESET " %s\n", target);
+        printf("  " XVR_CC_NOTICE "Size:" XVR_CC_RESET " %.1f KB\n",
+               bin_size / 1024.0);
+        printf("  " XVR_CC_NOTICE "Time:" XVR_CC_RESET " %.2f ms\n",
+               total_time);
+        print_codegen_timing(codegen_timing);
+        if (cache_note) {
+            printf("  " XVR_CC_NOTICE "Cache:" XVR_CC_RESET " %s\n",
+                   cache_note);
+        }
+        printf("  " XVR_CC_NOTICE "Link:" XVR_CC_RESET " %.2f ms\n",
+               link_time);
+        printf("\n");
+        LLVMDisposeMessage((char*)target);
+    }
+
+    char* run_args[2];
+    run_args[0] = (char*)outFile;
+    run_args[1] = NULL;
+    pid_t run_pid = fork();
+    if (run_pid == 0) {
+        execve(outFile, run_args, NULL);
+        _exit(127);
+    } else if (run_pid > 0) {
+        int run_status;
+        waitpid(run_pid, &run_status, 0);
+    }
+    return 0;
+}
+
+/* only native objects are cached; the JIT, IR and assembly dumps and
+ * ThinLTO (which caches per module itself) always compile */
+static bool cacheable_build(bool useEmitType, int emitFileType) {
+    return !Xvr_commandLine.runJIT && !Xvr_commandLine.dumpLLVM &&
+           !Xvr_commandLine.dumpAST && !Xvr_commandLine.thinLTO &&
+           !Xvr_commandLine.printPipeline &&
+           (!useEmitType || emitFileType == 0);
+}
+
+static Xvr_LLVMBuildCache* open_build_cache(const char* module_name,
+                                            bool shouldRun) {
+    return Xvr_LLVMBuildCacheCreate(
+        Xvr_commandLine.cacheDir, (uint64_t)Xvr_commandLine.cacheMaxSize,
+        Xvr_CompilerSessionGetOptions(cli_session()), module_name, shouldRun);
+}
+
+/* a hit goes straight to the link (or the -c output) without lexing,
+ * parsing or code generation */
+static bool cached_build(const char* module_name, const char* source,
+                         size_t size, bool shouldRun, bool useEmitType,
+                         int emitFileType, const char* srcForError,
+                         double start_time, int* out_status) {
+    if (!Xvr_LLVMBuildCacheDirectory(Xvr_commandLine.cacheDir) ||
+        !cacheable_build(useEmitType, emitFileType)) {
+        return false;
+    }
+    Xvr_LLVMBuildCache* cache = open_build_cache(module_name, shouldRun);
+    size_t* object_sizes = NULL;
+    size_t object_count = 0;
+    void** objects = Xvr_LLVMBuildCacheLookup(cache, source, size,
+                                              &object_sizes, &object_count);
+    Xvr_LLVMBuildCacheDestroy(cache);
+    if (!objects) {
+        return false;
+    }
+
+    char* outFile = output_file_name(shouldRun, useEmitType, emitFileType);
+    if (!shouldRun && !write_file(outFile, objects[0], object_sizes[0])) {
+        print_compiler_error(srcForError, 0, "error",
+                             "failed to write output file",
+                             "Check write permissions in the output "
+                             "directory");
+        free_objects(objects, object_sizes, object_count);
+        free(outFile);
+        *out_status = 1;
+        return true;
+    }
+    Xvr_LLVMCodegenTiming timing = {0.0, 0.0, 0};
+    *out_status = finish_build(objects, object_sizes, object_count, NULL,
+                               shouldRun, outFile, srcForError, start_time,
+                               &timing, "hit");
+    free(outFile);
+    return true;
+}
+
+/* the objects of an executable build, or the object file -c wrote */
+static void store_cached_build(const char* module_name, const char* source,
+                               size_t size, Xvr_LLVMCodegen* codegen,
+                               bool shouldRun, void** objects,
+                               size_t* object_sizes, size_t object_count,
+                               const char* objFile) {
+    Xvr_LLVMBuildCache* cache = open_build_cache(module_name, shouldRun);
+    if (shouldRun) {
+        Xvr_LLVMBuildCacheStore(cache, source, size, codegen,
+                                (const void* const*)objects, object_sizes,
+                                object_count);
+    } else if (objFile) {
+        size_t written_size = 0;
+        const char* written = Xvr_readSourceFile(objFile, &written_size);
+        if (written) {
+            const void* single[1] = {written};
+            Xvr_LLVMBuildCacheStore(cache, source, size, codegen, single,
+                                    &written_size, 1);
+            Xvr_unmapSourceFile(written, written_size);
+        }
+    }
+    Xvr_LLVMBuildCacheDestroy(cache);
+}
+
+static int print_cache_stats(void) {
+    const char* dir = Xvr_LLVMBuildCacheDirectory(Xvr_commandLine.cacheDir);
+    if (!dir) {
+        print_compiler_error(NULL, 0, "error", "no cache directory",
+                             "Pass --cache-dir=<dir> or set XVR_CACHE_DIR");
+        return 1;
+    }
+    Xvr_LLVMObjectCache* cache = Xvr_LLVMObjectCacheCreate(
+        dir, (uint64_t)Xvr_commandLine.cacheMaxSize);
+    Xvr_LLVMObjectCacheStats stats;
+    if (!cache || !Xvr_LLVMObjectCacheGetStats(cache, &stats)) {
+        print_compiler_error(dir, 0, "error", "could not open the cache",
+                             NULL);
+        Xvr_LLVMObjectCacheDestroy(cache);
+        return 1;
+    }
+    uint64_t lookups = stats.hits + stats.misses;
+    printf("cache directory: %s\n", dir);
+    printf("hits:            %llu (%.1f%%)\n",
+           (unsigned long long)stats.hits,
+           lookups ? 100.0 * (double)stats.hits / (double)lookups : 0.0);
+    printf("misses:          %llu\n", (unsigned long long)stats.misses);
+    printf("stores:          %llu\n", (unsigned long long)stats.stores);
+    printf("evictions:       %llu\n", (unsigned long long)stats.evictions);
+    printf("entries:         %llu\n", (unsigned long long)stats.entries);
+    printf("size:            %.1f KB\n", (double)stats.bytes / 1024.0);
+    Xvr_LLVMObjectCacheDestroy(cache);
+    return 0;
+}
+
+/* --precompile compiles a module's procs once so importers link them
+ * instead of parsing the source again */
+static int precompile_module(void) {
+    const char* path = Xvr_commandLine.sourceFile;
+    if (!path) {
+        print_compiler_error(NULL, 0, "error", "no module to precompile",
+                             "Pass the module's .xvr file");
+        return 1;
+    }
+
+    Xvr_CompilerSession* session = cli_session();
+    char* output = Xvr_commandLine.outFile
+                       ? strdup(Xvr_commandLine.outFile)
+                       : Xvr_LLVMPrecompiledPath(path);
+    bool ok = session && output &&
+              Xvr_CompilerSessionPrecompile(session, path, output);
+    if (!ok) {
+        size_t count = Xvr_CompilerSessionGetDiagnosticCount(session);
+        const char* err =
+            count > 0 ? Xvr_CompilerSessionGetDiagnostic(session, count - 1)
+                      : NULL;
+        char message[1024];
+        snprintf(message, sizeof(message), "%s: %s", path,
+                 err ? err : "out of memory");
+        print_compiler_error(NULL, 0, "error", message, NULL);
+    } else if (Xvr_commandLine.verbose) {
+        printf("  " XVR_CC_NOTICE "Precompiled:" XVR_CC_RESET " %s\n",
+               output);
+    }
+    free(output);
+    return ok ? 0 : 1;
+}
+
+/* xvr a.xvr b.xvr: see Xvr_LLVMSourceBuild, the objects are written with
+ * -c or linked like those of a single file */
+static int compile_source_files(void) {
+    const char* unsupported = NULL;
+    if (Xvr_commandLine.source) {
+        unsupported = "-i cannot be combined with source files";
+    } else if (Xvr_commandLine.runJIT) {
+        unsupported = "--jit runs a single source file";
+    } else if (Xvr_commandLine.dumpLLVM || Xvr_commandLine.emitType ||
+               Xvr_commandLine.printPipeline) {
+        unsupported = "IR and assembly are emitted for a single source file";
+    } else if (Xvr_commandLine.thinLTO) {
+        unsupported = "-flto=thin takes a single source file";
+    } else if (Xvr_commandLine.profileGenerate) {
+        unsupported = "--profile-generate takes a single source file";
+    }
+    if (unsupported) {
+        print_compiler_error(NULL, 0, "error", unsupported,
+                             "Compile the files with -c and link the objects");
+        return 1;
+    }
+
+    double start_time = get_time_ms();
+    Xvr_CompilerOptions options;
+    session_options(&options);
+    Xvr_LLVMSourceBuild* build = Xvr_LLVMSourceBuildCreate(
+        &options, Xvr_commandLine.jobs > 0 ? (unsigned)Xvr_commandLine.jobs
+                                           : 0);
+    bool ok = build != NULL;
+    for (int i = 0; ok && i < Xvr_commandLine.sourceFileCount; i++) {
+        ok = Xvr_LLVMSourceBuildAddInput(build,
+                                         Xvr_commandLine.sourceFiles[i]);
+    }
+    ok = ok && Xvr_LLVMSourceBuildRun(build);
+
+    /* diagnostics in command-line order, whichever thread finished first */
+    size_t unit_count = Xvr_LLVMSourceBuildGetUnitCount(build);
+    for (size_t i = 0; i < unit_count; i++) {
+        const char* unit_message = Xvr_LLVMSourceBuildGetUnitMessage(build, i);
+        if (unit_message) {
+            char message[1024];
+            snprintf(message, sizeof(message), "%s: %s",
+                     Xvr_LLVMSourceBuildGetUnitPath(build, i), unit_message);
+            print_compiler_error(NULL, 0, "error", message, NULL);
+        }
+    }
+    size_t* object_sizes = NULL;
+    size_t object_count = 0;
+    void** objects =
+        ok ? Xvr_LLVMSourceBuildTakeObjects(build, &object_sizes,
+                                            &object_count)
+           : NULL;
+    if (!build || Xvr_LLVMSourceBuildGetError(build)) {
+        print_compiler_error(NULL, 0, "error", "out of memory", NULL);
+    }
+    if (!objects) {
+        Xvr_LLVMSourceBuildDestroy(build);
+        return 1;
+    }
+
+    int status = 0;
+    if (Xvr_commandLine.compileOnly && !Xvr_commandLine.outFile) {
+        for (size_t i = 0; status == 0 && i < object_count; i++) {
+            const char* path = Xvr_LLVMSourceBuildGetUnitPath(build, i);
+            char* objFile = build_output_filename(path, ".o");
+            if (!objFile || !write_file(objFile, objects[i], object_sizes[i])) {
+                print_compiler_error(path, 0, "error",
+                                     "failed to write output file",
+                                     "Check write permissions in the output "
+                                     "directory");
+                status = 1;
+            } else if (Xvr_commandLine.verbose) {
+                printf("  " XVR_CC_NOTICE "Object:" XVR_CC_RESET " %s\n",
+                       objFile);
+            }
+            free(objFile);
+        }
+        free_objects(objects, object_sizes, object_count);
+    } else if (Xvr_commandLine.compileOnly) {
+        char* link_error = NULL;
+        if (!Xvr_LLVMLinkerLinkExecutables((const void* const*)objects,
+                                           object_sizes, object_count,
+                                           Xvr_commandLine.outFile,
+                                           &link_error)) {
+            print_compiler_error(NULL, 0, "error",
+                                 link_error ? link_error
+                                            : "failed to link executable",
+                                 "Set XVR_RUNTIME_LIB to the libxvr.a to "
+                                 "link against");
+            status = 1;
+        }
+        free(link_error);
+        free_objects(objects, object_sizes, object_count);
+    } else {
+        char* outFile = output_file_name(true, false, 0);
+        Xvr_LLVMCodegenTiming timing = {0.0, 0.0, 0};
+        status = finish_build(objects, object_sizes, object_count, NULL, true,
+                              outFile,
+                              Xvr_LLVMSourceBuildGetUnitPath(build, 0),
+                              start_time, &timing, NULL);
+        free(outFile);
+    }
+
+    if (status == 0 && Xvr_commandLine.showTiming &&
+        Xvr_commandLine.compileOnly) {
+        printf("\n");
+        printf("  " XVR_CC_NOTICE "Units:" XVR_CC_RESET " %zu (%u jobs)\n",
+               object_count, Xvr_LLVMSourceBuildGetJobs(build));
+        printf("  " XVR_CC_NOTICE "Time:" XVR_CC_RESET " %.2f ms\n",
+               get_time_ms() - start_time);
+        printf("\n");
+    }
+    Xvr_LLVMSourceBuildDestroy(build);
+    return status;
+}
+
+/* xvr --watch app.xvr: see Xvr_Watch, each build is linked like that of
+ * a single file */
+static volatile sig_atomic_t watch_stopping = 0;
+
+static void stop_watching(int signal_number) {
+    (void)signal_number;
+    watch_stopping = 1;
+}
+
+/* what fails is reported and the objects of the last good build are kept
+ * for the next one */
+static void watch_build(Xvr_Watch* watch) {
+    double start_time = get_time_ms();
+    const char* path = Xvr_commandLine.sourceFile;
+    if (!Xvr_WatchBuild(watch)) {
+        if (Xvr_WatchGetError(watch)) {
+            print_compiler_error(Xvr_WatchGetErrorPath(watch), 0, "error",
+                                 Xvr_WatchGetError(watch), NULL);
+        }
+        return;
+    }
+
+    size_t* object_sizes = NULL;
+    size_t used = 0;
+    void** objects = Xvr_WatchCopyObjects(watch, &object_sizes, &used);
+    if (!objects) {
+        print_compiler_error(NULL, 0, "error", "out of memory", NULL);
+        return;
+    }
+    printf("  " XVR_CC_NOTICE "Watch:" XVR_CC_RESET
+           " %zu of %zu fragments compiled in %.2f ms\n",
+           Xvr_WatchGetCompiledCount(watch), used,
+           get_time_ms() - start_time);
+    fflush(stdout);
+    char* outFile = output_file_name(true, false, 0);
+    if (!Xvr_commandLine.compileOnly) {
+        Xvr_LLVMCodegenTiming timing = {0.0, 0.0, 0};
+        finish_build(objects, object_sizes, used, NULL, true, outFile, path,
+                     start_time, &timing, NULL);
+    } else {
+        char* link_error = NULL;
+        if (!Xvr_LLVMLinkerLinkExecutables((const void* const*)objects,
+                                           object_sizes, used, outFile,
+                                           &link_error)) {
+            print_compiler_error(path, 0, "error",
+                                 link_error ? link_error
+                                            : "failed to link executable",
+                                 "Set XVR_RUNTIME_LIB to the libxvr.a to "
+                                 "link against");
+        }
+        free(link_error);
+        free_objects(objects, object_sizes, used);
+    }
+    free(outFile);
+}
+
+/* editors replace the file as often as they rewrite it */
+static bool watched_file_changed(const struct stat* before,
+                                 const struct stat* now) {
+#if defined(__APPLE__)
+    const struct timespec* before_time = &before->st_mtimespec;
+    const struct timespec* now_time = &now->st_mtimespec;
+#else
+    const struct timespec* before_time = &before->st_mtim;
+    const struct timespec* now_time = &now->st_mtim;
+#endif
+    return before->st_ino != now->st_ino || before->st_size != now->st_size ||
+           before_time->tv_sec != now_time->tv_sec ||
+           before_time->tv_nsec != now_time->tv_nsec;
+}
+
+static int watch_source_file(void) {
+    const char* unsupported = NULL;
+    if (Xvr_commandLine.sourceFileCount != 1 || Xvr_commandLine.source) {
+        unsupported = "--watch takes a single source file";
+    } else if (Xvr_commandLine.runJIT) {
+        unsupported = "--watch links an executable, it cannot run with --jit";
+    } else if (Xvr_commandLine.dumpLLVM || Xvr_commandLine.emitType ||
+               Xvr_commandLine.printPipeline) {
+        unsupported = "--watch does not emit IR or assembly";
+    } else if (Xvr_commandLine.thinLTO || Xvr_commandLine.profileGenerate) {
+        unsupported = "--watch is not supported with -flto=thin or "
+                      "--profile-generate";
+    }
+    if (unsupported) {
+        print_compiler_error(NULL, 0, "error", unsupported, NULL);
+        return 1;
+    }
+
+    Xvr_CompilerOptions options;
+    session_options(&options);
+    Xvr_Watch* watch = Xvr_WatchCreate(&options, Xvr_commandLine.sourceFile);
+    if (!watch) {
+        print_compiler_error(NULL, 0, "error",
+                             "failed to create a compiler session", NULL);
+        return 1;
+    }
+
+    struct sigaction stop;
+    memset(&stop, 0, sizeof(stop));
+    stop.sa_handler = stop_watching;
+    sigaction(SIGINT, &stop, NULL);
+    sigaction(SIGTERM, &stop, NULL);
+
+    const char* path = Xvr_commandLine.sourceFile;
+    struct stat last;
+    memset(&last, 0, sizeof(last));
+    stat(path, &last);
+    while (!watch_stopping) {
+        watch_build(watch);
+        printf("  " XVR_CC_NOTICE "Watching:" XVR_CC_RESET
+               " %s (Ctrl-C stops)\n",
+               path);
+        fflush(stdout);
+
+        while (!watch_stopping) {
+            struct timespec delay = {0, 100 * 1000000L};
+            nanosleep(&delay, NULL);
+            struct stat now;
+            if (stat(path, &now) == 0 && watched_file_changed(&last, &now)) {
+                last = now;
+                break;
+            }
+            if (Xvr_WatchImportsChanged(watch)) {
+                break;
+            }
+        }
+    }
+
+    Xvr_WatchDestroy(watch);
+    return 0;
+}
+
+/* entries run in the session's JIT next to everything entered before,
+ * prompts are only written to a terminal */
+static int run_repl(void) {
+    Xvr_CompilerSession* session = cli_session();
+    Xvr_LLVMRepl* repl = session ? Xvr_LLVMReplCreate(session) : NULL;
+    if (!repl) {
+        print_compiler_error("<repl>", 0, "error",
+                             "failed to create JIT for host target", NULL);
+        return 1;
+    }
+
+    /* a failed entry only fails a session read from a pipe or file */
+    bool interactive = isatty(STDIN_FILENO);
+    bool ok = Xvr_LLVMReplRun(repl, stdin, interactive ? stdout : NULL,
+                              Xvr_commandLine.showTiming ? stderr : NULL);
+    Xvr_LLVMReplDestroy(repl);
+    return ok ? 0 : 1;
+}
+
+static int compile_command(int argc, const char* argv[]);
+
+/* everything set up here is inherited by the process each request forks */
+static int run_compile_server(void) {
+    char socket_path[PATH_MAX];
+    if (!Xvr_compileServerSocketPath(Xvr_commandLine.serverSocket, socket_path,
+                                     sizeof(socket_path))) {
+        print_compiler_error("<server>", 0, "error",
+                             "no usable server socket path",
+                             "The path is too long or /tmp/xvr-<uid> is not "
+                             "a private directory, pass one with --socket");
+        return 1;
+    }
+
+    Xvr_LLVMTargetWarmUp();
+    Xvr_ModuleResolver* resolver = Xvr_ModuleResolverCreate(NULL);
+    int preloaded = Xvr_ModuleResolverPreloadStdlib(resolver);
+    Xvr_ModuleResolverDestroy(resolver);
+    if (Xvr_commandLine.verbose) {
+        fprintf(stderr, "Preloaded %d stdlib modules\n", preloaded);
+    }
+
+    return Xvr_runCompileServer(socket_path, compile_command);
+}
+
+static int compile_command(int argc, const char* argv[]) {
     Xvr_initCommandLine(argc, argv);
 
     if (Xvr_commandLine.error) {
@@ -213,6 +886,34 @@ int main(int argc, const char* argv[]) {
             XVR_VERSION_PATCH, XVR_VERSION_BUILD, XVR_CC_RESET);
     }
 
+    if (Xvr_commandLine.server) {
+        return run_compile_server();
+    }
+
+    if (Xvr_commandLine.watch) {
+        return watch_source_file();
+    }
+
+    if (Xvr_commandLine.repl) {
+        return run_repl();
+    }
+
+    if (Xvr_commandLine.linkInputCount > 0) {
+        return link_object_inputs();
+    }
+
+    if (Xvr_commandLine.cacheStats) {
+        return print_cache_stats();
+    }
+
+    if (Xvr_commandLine.precompile) {
+        return precompile_module();
+    }
+
+    if (Xvr_commandLine.sourceFileCount > 1) {
+        return compile_source_files();
+    }
+
     const char* source = NULL;
     size_t size = 0;
     char module_name[256] = "inline";
@@ -235,7 +936,7 @@ int main(int argc, const char* argv[]) {
         char* dot = strrchr(module_name, '.');
         if (dot) *dot = '\0';
 
-        source = (const char*)Xvr_readFile(Xvr_commandLine.sourceFile, &size);
+        source = Xvr_mapSourceFile(Xvr_commandLine.sourceFile, &size);
         if (!source) {
             print_compiler_error(
                 Xvr_commandLine.sourceFile, 0, "error",
@@ -253,11 +954,35 @@ int main(int argc, const char* argv[]) {
     int nodeCount = 0;
     const char* srcForError =
         Xvr_commandLine.sourceFile ? Xvr_commandLine.sourceFile : "<inline>";
-    Xvr_ASTNode** nodes = parse_to_ast(source, &nodeCount);
+
+    bool shouldRun = !Xvr_commandLine.compileOnly &&
+                     !Xvr_commandLine.dumpLLVM &&
+                     (Xvr_commandLine.emitType == NULL);
+
+    bool useEmitType = Xvr_commandLine.emitType != NULL;
+    int emitFileType = 0;
+    if (useEmitType) {
+        if (strcmp(Xvr_commandLine.emitType, "asm") == 0) {
+            emitFileType = 1;
+        } else if (strcmp(Xvr_commandLine.emitType, "llvm-ir") == 0) {
+            emitFileType = 2;
+        } else {
+            emitFileType = 0;
+        }
+    }
+
+    int cached_status = 0;
+    if (cached_build(module_name, source, size, shouldRun, useEmitType,
+                     emitFileType, srcForError, start_time, &cached_status)) {
+        if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
+        return cached_status;
+    }
+
+    Xvr_ASTNode** nodes = parse_to_ast(cli_session(), source, &nodeCount);
     if (!nodes) {
         print_compiler_error(srcForError, 0, "error",
                              "parsing failed - check syntax", NULL);
-        free((void*)source);
+        if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
         return 1;
     }
 
@@ -273,7 +998,7 @@ int main(int argc, const char* argv[]) {
     }
 
     Xvr_UnusedChecker checker;
-    Xvr_initUnusedChecker(&checker);
+    Xvr_initUnusedCheckerWithSource(&checker, source);
     Xvr_checkUnusedBegin(&checker);
 
     for (int i = 0; i < nodeCount; i++) {
@@ -286,7 +1011,7 @@ int main(int argc, const char* argv[]) {
             Xvr_freeASTNode(nodes[i]);
         }
         free(nodes);
-        if (Xvr_commandLine.sourceFile) free((void*)source);
+        if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
         return 1;
     }
     Xvr_freeUnusedChecker(&checker);
@@ -311,17 +1036,97 @@ int main(int argc, const char* argv[]) {
         Xvr_ASTOptimizerDestroy(ast_opt);
     }
 
-    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate(module_name);
+    Xvr_LLVMCodegen* codegen =
+        Xvr_LLVMCodegenCreateWithSession(module_name, cli_session());
     if (!codegen) {
+        /* the session's target is set up with the codegen */
+        if (Xvr_commandLine.targetCPU || Xvr_commandLine.targetFeatures) {
+            print_compiler_error(srcForError, 0, "error",
+                                 "could not create a target machine for the "
+                                 "requested CPU and features",
+                                 "Check the -march and --target-features "
+                                 "values");
+        } else {
+            print_compiler_error(srcForError, 0, "error",
+                                 "failed to initialize code generator",
+                                 "This may indicate an out-of-memory "
+                                 "condition");
+        }
+        for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
+        free(nodes);
+        if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
+        return 1;
+    }
+
+    int opt_level = Xvr_commandLine.optimizationLevel;
+
+    const char* thin_error = NULL;
+    if (Xvr_commandLine.thinLTO && Xvr_commandLine.runJIT) {
+        thin_error = "-flto=thin links an executable, it cannot run with --jit";
+    } else if (Xvr_commandLine.thinLTO && Xvr_commandLine.profileGenerate) {
+        thin_error = "--profile-generate is not supported with -flto=thin";
+    }
+    if (thin_error) {
+        print_compiler_error(srcForError, 0, "error", thin_error,
+                             "Build without -flto=thin");
+        Xvr_LLVMCodegenDestroy(codegen);
+        for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
+        free(nodes);
+        if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
+        return 1;
+    }
+
+    const char* profile_error = NULL;
+    if (Xvr_commandLine.profileGenerate && Xvr_commandLine.profileUse) {
+        profile_error = "--profile-generate and --profile-use are exclusive";
+    } else if (Xvr_commandLine.profileGenerate && Xvr_commandLine.runJIT) {
+        profile_error = "--profile-generate needs a linked executable, not "
+                        "--jit";
+
+    } else if (Xvr_commandLine.profileUse &&
+               !Xvr_LLVMCodegenSetProfileUse(codegen,
+                                             Xvr_commandLine.profileUse)) {
+        profile_error = Xvr_LLVMCodegenGetError(codegen);
+    }
+    if (profile_error) {
+        print_compiler_error(srcForError, 0, "error", profile_error,
+                             "Merge raw profiles with 'llvm-profdata merge "
+                             "-o app.profdata *.profraw'");
+        Xvr_LLVMCodegenDestroy(codegen);
+        for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
+        free(nodes);
+        if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
+        return 1;
+    }
+
+    // --passes appends to the level's pipeline, at -O0 it runs alone
+    bool custom_passes = Xvr_commandLine.passPipeline != NULL;
+    bool pipeline_ok =
+        !custom_passes ||
+        (Xvr_LLVMCodegenAddStandardPasses(codegen) &&
+         Xvr_LLVMCodegenAddPasses(codegen, Xvr_commandLine.passPipeline));
+    const char* pipeline = NULL;
+    if (pipeline_ok && Xvr_commandLine.printPipeline) {
+        pipeline = Xvr_LLVMCodegenGetPipeline(codegen);
+        pipeline_ok = pipeline != NULL;
+    }
+    if (!pipeline_ok) {
+        const char* err = Xvr_LLVMCodegenGetError(codegen);
         print_compiler_error(srcForError, 0, "error",
-                             "failed to initialize code generator",
-                             "This may indicate an out-of-memory condition");
+                             err ? err : "invalid pass pipeline",
+                             "Check the --passes value");
+        Xvr_LLVMCodegenDestroy(codegen);
         for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
         free(nodes);
-        if (Xvr_commandLine.sourceFile) free((void*)source);
+        if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
         return 1;
     }
+    if (pipeline) {
+        fprintf(stderr, "%s\n", pipeline[0] ? pipeline : "(no passes)");
+    }
 
+    // every import is parsed up front, independent modules in parallel
+    Xvr_LLVMCodegenPreloadImports(codegen, nodes, nodeCount);
     for (int i = 0; i < nodeCount; i++) {
         Xvr_LLVMCodegenEmitAST(codegen, nodes[i]);
     }
@@ -334,101 +1139,72 @@ int main(int argc, const char* argv[]) {
         Xvr_LLVMCodegenDestroy(codegen);
         for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
         free(nodes);
-        if (Xvr_commandLine.sourceFile) free((void*)source);
+        if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
         return 1;
     }
 
-    int opt_level = Xvr_commandLine.optimizationLevel;
-    if (opt_level > 0 && !Xvr_commandLine.dumpLLVM) {
-        Xvr_LLVMOptimizationLevel llvm_level = XVR_LLVM_OPT_O2;
-        switch (opt_level) {
-        case 1:
-            llvm_level = XVR_LLVM_OPT_O1;
-            break;
-        case 2:
-            llvm_level = XVR_LLVM_OPT_O2;
-            break;
-        case 3:
-            llvm_level = XVR_LLVM_OPT_O3;
-            break;
-        default:
-            llvm_level = XVR_LLVM_OPT_O2;
-            break;
-        }
-        Xvr_LLVMCodegenSetOptimizationLevel(codegen, llvm_level);
+    double opt_start = get_time_ms();
+    bool run_passes = opt_level > 0 || custom_passes ||
+                      Xvr_commandLine.profileGenerate ||
+                      Xvr_commandLine.profileUse;
+    bool ir_ok = Xvr_LLVMCodegenOptimize(codegen);
+    if (!ir_ok) {
+        const char* err = Xvr_LLVMCodegenGetError(codegen);
+        print_compiler_error(srcForError, 0, "error",
+                             err ? err : "LLVM optimization failed",
+                             "This is a compiler bug, please report it");
+        Xvr_LLVMCodegenDestroy(codegen);
+        for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
+        free(nodes);
+        if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
+        return 1;
+    }
 
-        if (Xvr_commandLine.verbose) {
-            fputs("AST optimization enabled (-O level)\n", stderr);
+    if (Xvr_commandLine.verbose && run_passes) {
+        fprintf(stderr, "LLVM optimization (-O%d): %.2f ms\n", opt_level,
+                get_time_ms() - opt_start);
+    }
+
+    if (shouldRun && Xvr_commandLine.runJIT) {
+        double frontend_time = get_time_ms() - start_time;
+        Xvr_LLVMJITStats stats = {0.0, 0.0, 0};
+        bool ran = Xvr_LLVMCodegenExecuteJIT(codegen, &stats);
+        if (!ran) {
+            const char* err = Xvr_LLVMCodegenGetError(codegen);
+            print_compiler_error(srcForError, 0, "error",
+                                 err ? err : "JIT execution failed", NULL);
+        } else if (Xvr_commandLine.showTiming) {
+            const char* target = LLVMGetDefaultTargetTriple();
+            printf("\n");
+            printf("  " XVR_CC_NOTICE "Target:" XVR_CC_RESET " %s (jit)\n",
+                   target);
+            printf("  " XVR_CC_NOTICE "Frontend:" XVR_CC_RESET " %.2f ms\n",
+                   frontend_time);
+            printf("  " XVR_CC_NOTICE "JIT compile:" XVR_CC_RESET " %.2f ms\n",
+                   stats.compile_ms);
+            printf("  " XVR_CC_NOTICE "Execution:" XVR_CC_RESET " %.2f ms\n",
+                   stats.exec_ms);
+            printf("\n");
+            LLVMDisposeMessage((char*)target);
         }
+
+        Xvr_LLVMCodegenDestroy(codegen);
+        for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
+        free(nodes);
+        if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
+        return ran ? stats.exit_code : 1;
     }
 
-    bool shouldRun = !Xvr_commandLine.compileOnly &&
-                     !Xvr_commandLine.dumpLLVM &&
-                     (Xvr_commandLine.emitType == NULL);
     char* outFile = NULL;
     char* objFile = NULL;
+    void** objects = NULL;
+    size_t* object_sizes = NULL;
+    size_t object_count = 0;
+    Xvr_LLVMCodegenTiming codegen_timing = {0.0, 0.0, 0};
+    Xvr_LLVMThinLink* thin_link = NULL;
 
-    bool useEmitType = Xvr_commandLine.emitType != NULL;
-    int emitFileType = 0;
-    if (useEmitType) {
-        if (strcmp(Xvr_commandLine.emitType, "asm") == 0) {
-            emitFileType = 1;
-        } else if (strcmp(Xvr_commandLine.emitType, "llvm-ir") == 0) {
-            emitFileType = 2;
-        } else {
-            emitFileType = 0;
-        }
-    }
-
-    /* TODO: Consolidate output filename generation into a separate helper
-       function to avoid code duplication between shouldRun and else branches */
-    if (shouldRun) {
-        objFile = strdup("/tmp/xvr_compile.o");
-        /* NOTE: Use safe helper function to extract filename without extension
-         */
-        if (Xvr_commandLine.outFile) {
-            outFile = strdup(Xvr_commandLine.outFile);
-        } else if (Xvr_commandLine.sourceFile) {
-            outFile = get_filename_without_ext(Xvr_commandLine.sourceFile);
-            if (!outFile) {
-                outFile = strdup("a.out");
-            }
-            // Check if output file name conflicts with existing directory
-            struct stat st;
-            if (stat(outFile, &st) == 0 && S_ISDIR(st.st_mode)) {
-                free(outFile);
-                outFile = strdup("xvr_out");
-            }
-        } else {
-            outFile = strdup("a.out");
-        }
-    } else {
-        if (Xvr_commandLine.outFile) {
-            outFile = strdup(Xvr_commandLine.outFile);
-        } else if (Xvr_commandLine.sourceFile) {
-            const char* ext = NULL;
-            if (useEmitType) {
-                if (emitFileType == 1) {
-                    ext = ".s";
-                } else if (emitFileType == 2) {
-                    ext = ".ll";
-                }
-            } else if (Xvr_commandLine.compileOnly) {
-                ext = ".o";
-            }
-            outFile = build_output_filename(Xvr_commandLine.sourceFile, ext);
-            if (!outFile) {
-                outFile = strdup("a.out");
-            }
-            // Check if output file name conflicts with existing directory
-            struct stat st;
-            if (stat(outFile, &st) == 0 && S_ISDIR(st.st_mode)) {
-                free(outFile);
-                asprintf(&outFile, "xvr_%s", ext ? ext : "out");
-            }
-        } else {
-            outFile = strdup("a.out");
-        }
+    outFile = output_file_name(shouldRun, useEmitType, emitFileType);
+    if (!shouldRun) {
         objFile = strdup(outFile);
     }
 
@@ -454,6 +1230,69 @@ int main(int argc, const char* argv[]) {
             }
             free(ir);
         }
+    } else if (Xvr_commandLine.thinLTO && (shouldRun || !useEmitType)) {
+        Xvr_LLVMThinBuild* thin = Xvr_LLVMThinBuildCreate(cli_session());
+        bool built =
+            thin && Xvr_LLVMThinBuildAddProgram(thin, srcForError, codegen);
+        if (built && shouldRun) {
+            thin_link = Xvr_LLVMThinBuildLink(thin, codegen,
+                                              Xvr_commandLine.thinLTOCacheDir);
+            built = thin_link != NULL;
+        } else if (built) {
+            built = Xvr_LLVMThinBuildWrite(thin, objFile);
+        }
+
+        if (!built) {
+            const char* err = thin ? Xvr_LLVMThinBuildGetError(thin) : NULL;
+            print_compiler_error(srcForError, 0, "error",
+                                 err ? err : "out of memory", NULL);
+            Xvr_LLVMThinBuildDestroy(thin);
+            Xvr_LLVMCodegenDestroy(codegen);
+            for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
+            free(nodes);
+            free(outFile);
+            free(objFile);
+            if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
+            return 1;
+        }
+        Xvr_LLVMThinBuildDestroy(thin);
+    } else if (shouldRun) {
+        objects = Xvr_LLVMCodegenEmitObjects(codegen, false, &object_sizes,
+                                             &object_count, &codegen_timing);
+        if (!objects) {
+            print_compiler_error(srcForError, 0, "error",
+                                 "failed to emit object code", NULL);
+            Xvr_LLVMCodegenDestroy(codegen);
+            for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
+            free(nodes);
+            free(outFile);
+            if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
+            return 1;
+        }
+    } else if (Xvr_commandLine.jobs > 1 && emitFileType == 0) {
+        /* the partitions are merged back into the one object asked for */
+        char* link_error = NULL;
+        objects = Xvr_LLVMCodegenEmitObjects(codegen, true, &object_sizes,
+                                             &object_count, &codegen_timing);
+        bool written = objects && Xvr_LLVMLinkerLinkRelocatable(
+                                      (const void* const*)objects,
+                                      object_sizes, object_count, objFile,
+                                      &link_error);
+        free_objects(objects, object_sizes, object_count);
+        if (!written) {
+            print_compiler_error(srcForError, 0, "error",
+                                 link_error ? link_error
+                                            : "failed to emit object code",
+                                 NULL);
+            free(link_error);
+            Xvr_LLVMCodegenDestroy(codegen);
+            for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
+            free(nodes);
+            free(outFile);
+            free(objFile);
+            if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
+            return 1;
+        }
     } else {
         if (!Xvr_LLVMCodegenWriteObjectFile(codegen, objFile, emitFileType)) {
             print_compiler_error(
@@ -464,156 +1303,32 @@ int main(int argc, const char* argv[]) {
             free(nodes);
             free(outFile);
             free(objFile);
-            if (Xvr_commandLine.sourceFile) free((void*)source);
+            if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
             return 1;
         }
     }
 
+    const char* cache_note = NULL;
+    if (Xvr_LLVMBuildCacheDirectory(Xvr_commandLine.cacheDir) &&
+        cacheable_build(useEmitType, emitFileType)) {
+        store_cached_build(module_name, source, size, codegen, shouldRun,
+                           objects, object_sizes, object_count, objFile);
+        cache_note = "miss";
+    }
+
     Xvr_LLVMCodegenDestroy(codegen);
     for (int i = 0; i < nodeCount; i++) Xvr_freeASTNode(nodes[i]);
     free(nodes);
-    if (Xvr_commandLine.sourceFile) free((void*)source);
-
-    double total_time = get_time_ms() - start_time;
-
-    if (shouldRun) {
-        char* libxvr_path = NULL;
-        int has_libxvr = 0;
-
-        char search_paths[24][4096];
-        int path_count = 0;
-
-        const char* env_build =
-            getenv("XVR_BUILD_DIR"); /* Flawfinder: ignore */
-        if (env_build && is_safe_path_component(env_build)) {
-            snprintf(search_paths[path_count++], sizeof(search_paths[0]), "%s",
-                     env_build);
-        }
-
-        const char* home = getenv("HOME"); /* Flawfinder: ignore */
-        if (home && is_safe_path_component(home)) {
-            char path[4096];
-            snprintf(path, sizeof(path),
-                     "%s/Documents/project/xvrlang/xvr/build", home);
-            snprintf(search_paths[path_count++], sizeof(search_paths[0]), "%s",
-                     path);
-            snprintf(path, sizeof(path), "%s/project/xvrlang/xvr/build", home);
-            snprintf(search_paths[path_count++], sizeof(search_paths[0]), "%s",
-                     path);
-        }
-
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]),
-                 "/home/arfyslowy/Documents/project/xvrlang/xvr/build");
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]),
-                 "/home/arfyslowy/project/xvrlang/xvr/build");
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]), "build");
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]),
-                 "../build");
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]),
-                 "./build");
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]),
-                 "../../build");
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]), ".");
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]), "..");
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]), "../..");
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]),
-                 "/usr/local/xvr/build");
-        snprintf(search_paths[path_count++], sizeof(search_paths[0]),
-                 "/opt/xvr/build");
-
-        for (int i = 0; i < path_count; i++) {
-            char test_path[8192];
-            snprintf(test_path, sizeof(test_path), "%s/src/libxvr.a",
-                     search_paths[i]);
-            FILE* rf = fopen(test_path, "r");
-            if (rf) {
-                fclose(rf);
-                libxvr_path = strdup(test_path);
-                has_libxvr = 1;
-                break;
-            }
-        }
-
-        char* final_exe = outFile ? outFile : "/tmp/xvr_bin";
-
-        extern char** environ;
-        char* gcc_args[12];
-        int gcc_argc = 0;
-        gcc_args[gcc_argc++] = "gcc";
-        gcc_args[gcc_argc++] = objFile;
-        gcc_args[gcc_argc++] = "-o";
-        gcc_args[gcc_argc++] = final_exe;
-        gcc_args[gcc_argc++] = "-lm";
-        gcc_args[gcc_argc++] = "-lpthread";
-        gcc_args[gcc_argc++] = "-lxml2";
-        if (has_libxvr && libxvr_path) {
-            gcc_args[gcc_argc++] = libxvr_path;
-        }
-        gcc_args[gcc_argc++] = NULL;
-
-        pid_t pid = fork();
-        if (pid == 0) {
-            execve("/usr/bin/gcc", gcc_args, environ);
-            _exit(127);
-        } else if (pid > 0) {
-            int status;
-            waitpid(pid, &status, 0);
-            if (libxvr_path) free(libxvr_path);
-
-            if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
-                fprintf(stderr, "error: failed to link executable\n");
-            } else if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
-                long bin_size = get_file_size(final_exe);
-
-                if (Xvr_commandLine.showTiming) {
-                    const char* target = LLVMGetDefaultTargetTriple();
-                    printf("\n");
-                    printf("  " XVR_CC_NOTICE "Target:" XVR_CC_RESET " %s\n",
-                           target);
-                    printf("  " XVR_CC_NOTICE "Size:" XVR_CC_RESET " %.1f KB\n",
-                           bin_size / 1024.0);
-                    printf("  " XVR_CC_NOTICE "Time:" XVR_CC_RESET " %.2f ms\n",
-                           total_time);
-                    printf("\n");
-                    LLVMDisposeMessage((char*)target);
-                }
-
-                if (shouldRun && outFile) {
-                    char* run_args[2];
-                    run_args[0] = final_exe;
-                    run_args[1] = NULL;
-                    pid_t run_pid = fork();
-                    if (run_pid == 0) {
-                        execve(final_exe, run_args, NULL);
-                        _exit(127);
-                    } else if (run_pid > 0) {
-                        int run_status;
-                        waitpid(run_pid, &run_status, 0);
-                    }
-                }
-
-                unlink(objFile);
-            }
-        }
-
-        if (!Xvr_commandLine.outFile && !shouldRun) {
-        }
-    } else {
-        long obj_size = get_file_size(outFile);
-        if (Xvr_commandLine.showTiming) {
-            const char* target = LLVMGetDefaultTargetTriple();
-            printf("\n");
-            printf("  " XVR_CC_NOTICE "Target:" XVR_CC_RESET " %s\n", target);
-            printf("  " XVR_CC_NOTICE "Size:" XVR_CC_RESET " %.1f KB\n",
-                   obj_size / 1024.0);
-            printf("  " XVR_CC_NOTICE "Time:" XVR_CC_RESET " %.2f ms\n",
-                   total_time);
-            printf("\n");
-            LLVMDisposeMessage((char*)target);
-        }
-    }
+    if (Xvr_commandLine.sourceFile) Xvr_unmapSourceFile(source, size);
 
+    int status = finish_build(objects, object_sizes, object_count, thin_link,
+                              shouldRun, outFile, srcForError, start_time,
+                              &codegen_timing, cache_note);
     free(outFile);
     free(objFile);
-    return 0;
+    return status;
+}
+
+int main(int argc, const char* argv[]) {
+    return compile_command(argc, argv);
 }
@@ -0,0 +1,162 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_llvm_build_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xvr_llvm_linker.h"
+#include "xvr_llvm_target.h"
+
+struct Xvr_LLVMBuildCache {
+    Xvr_LLVMObjectCache* objects;
+    char* fingerprint;
+    bool runtime_bitcode;  // the runtime bitcode is linked in
+    char* profile_use;
+};
+
+const char* Xvr_LLVMBuildCacheDirectory(const char* dir) {
+    if (dir) {
+        return dir;
+    }
+    const char* env = getenv("XVR_CACHE_DIR"); /* Flawfinder: ignore */
+    return env && *env ? env : NULL;
+}
+
+/* everything besides the source and the files it reads that changes the
+ * objects; the object cache adds the compiler version itself */
+static char* build_fingerprint(const Xvr_CompilerOptions* options,
+                               const char* module_name, bool executable) {
+    const char* cpu = options->targetCPU ? options->targetCPU : "generic";
+    const char* host_features = "";
+    if (strcmp(cpu, "native") == 0) {
+        cpu = Xvr_LLVMTargetMachineGetHostCPU();
+        host_features = Xvr_LLVMTargetMachineGetHostFeatures();
+    }
+    char* fingerprint = NULL;
+    if (asprintf(&fingerprint,
+                 "module=%s\nmode=%s\ntriple=%s\ncpu=%s\nfeatures=%s,%s\n"
+                 "O=%d\nsize=%d\nvectorize=%d\nslp=%d\nunroll=%d\n"
+                 "inline=%d\npasses=%s\nruntime-bitcode=%d\n"
+                 "profile-generate=%s\nprofile-use=%d\njobs=%d\n",
+                 module_name, executable ? "exe" : "obj",
+                 Xvr_LLVMTargetMachineGetDefaultTargetTriple(), cpu,
+                 host_features,
+                 options->targetFeatures ? options->targetFeatures : "",
+                 options->optimizationLevel, options->sizeLevel,
+                 options->vectorizeLoops, options->vectorizeSLP,
+                 options->unrollLoops, options->inlineThreshold,
+                 options->passPipeline ? options->passPipeline : "",
+                 options->runtimeBitcode,
+                 options->profileGenerate ? options->profileGenerate
+                                          : "(none)",
+                 options->profileUse != NULL, options->jobs) < 0) {
+        return NULL;
+    }
+    return fingerprint;
+}
+
+Xvr_LLVMBuildCache* Xvr_LLVMBuildCacheCreate(
+    const char* dir, uint64_t max_bytes, const Xvr_CompilerOptions* options,
+    const char* module_name, bool executable) {
+    dir = Xvr_LLVMBuildCacheDirectory(dir);
+    if (!dir || !options || !module_name) {
+        return NULL;
+    }
+    Xvr_LLVMBuildCache* cache =
+        (Xvr_LLVMBuildCache*)calloc(1, sizeof(Xvr_LLVMBuildCache));
+    if (!cache) {
+        return NULL;
+    }
+    cache->objects = Xvr_LLVMObjectCacheCreate(dir, max_bytes);
+    cache->fingerprint = build_fingerprint(options, module_name, executable);
+    cache->runtime_bitcode =
+        options->runtimeBitcode && options->optimizationLevel > 0;
+    cache->profile_use =
+        options->profileUse ? strdup(options->profileUse) : NULL;
+    if (!cache->objects || !cache->fingerprint ||
+        (options->profileUse && !cache->profile_use)) {
+        Xvr_LLVMBuildCacheDestroy(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+void Xvr_LLVMBuildCacheDestroy(Xvr_LLVMBuildCache* cache) {
+    if (!cache) {
+        return;
+    }
+    Xvr_LLVMObjectCacheDestroy(cache->objects);
+    free(cache->fingerprint);
+    free(cache->profile_use);
+    free(cache);
+}
+
+void** Xvr_LLVMBuildCacheLookup(Xvr_LLVMBuildCache* cache, const void* source,
+                                size_t source_size, size_t** out_sizes,
+                                size_t* out_count) {
+    if (!cache) {
+        return NULL;
+    }
+    return Xvr_LLVMObjectCacheLookup(cache->objects, cache->fingerprint,
+                                     source, source_size, out_sizes,
+                                     out_count);
+}
+
+bool Xvr_LLVMBuildCacheStore(Xvr_LLVMBuildCache* cache, const void* source,
+                             size_t source_size, Xvr_LLVMCodegen* codegen,
+                             const void* const* objects, const size_t* sizes,
+                             size_t count) {
+    if (!cache || !codegen || !objects || count == 0) {
+        return false;
+    }
+    size_t import_count = Xvr_LLVMCodegenGetImportCount(codegen);
+    const char** deps =
+        (const char**)calloc(import_count + 2, sizeof(const char*));
+    if (!deps) {
+        return false;
+    }
+    size_t dep_count = 0;
+    for (size_t i = 0; i < import_count; i++) {
+        deps[dep_count++] = Xvr_LLVMCodegenGetImport(codegen, i);
+    }
+    const char* runtime_bitcode = Xvr_LLVMLinkerFindRuntimeBitcode();
+    if (cache->runtime_bitcode && runtime_bitcode) {
+        deps[dep_count++] = runtime_bitcode;
+    }
+    if (cache->profile_use) {
+        deps[dep_count++] = cache->profile_use;
+    }
+    bool stored = Xvr_LLVMObjectCacheStore(cache->objects, cache->fingerprint,
+                                           source, source_size, deps,
+                                           dep_count, objects, sizes, count);
+    free(deps);
+    return stored;
+}
+
+const char* Xvr_LLVMBuildCacheGetFingerprint(Xvr_LLVMBuildCache* cache) {
+    return cache ? cache->fingerprint : NULL;
+}
@@ -25,12 +25,18 @@ SOFTWARE.
 #include "xvr_llvm_codegen.h"
 
 #include <dlfcn.h>
+#include <llvm-c/Analysis.h>
 #include <llvm-c/Target.h>
 #include <llvm-c/TargetMachine.h>
+#include <llvm/Config/llvm-config.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "../../sema/xvr_builtin.h"
+#include "../../sema/xvr_module_graph.h"
+#include "../../sema/xvr_module_manifest.h"
+#include "../../xvr_compiler_session.h"
 
 static const char* literal_type_name(Xvr_LiteralType type) {
     switch (type) {
@@ -101,11 +107,30 @@ static char* Xvr_private_strdup(const char* str) { return Xvr_strdup(str); }
 #include "xvr_llvm_expression_emitter.h"
 #include "xvr_llvm_function_emitter.h"
 #include "xvr_llvm_ir_builder.h"
+#include "xvr_llvm_jit.h"
+#include "xvr_llvm_linker.h"
 #include "xvr_llvm_module_manager.h"
 #include "xvr_llvm_optimizer.h"
+#include "xvr_llvm_precompiled.h"
 #include "xvr_llvm_target.h"
+#include "xvr_llvm_thinlto.h"
 #include "xvr_llvm_type_mapper.h"
 
+/* an imported proc that is only declared until something calls it */
+typedef struct {
+    Xvr_ASTNode* node;
+    LLVMValueRef function;
+    bool internal;
+    bool done;
+} Xvr_LLVMDeferredProc;
+
+/* a top-level variable of a REPL entry and the global it is kept in */
+typedef struct {
+    Xvr_LLVMReplVar var;
+    LLVMValueRef slot;
+    LLVMValueRef global;
+} Xvr_LLVMReplSlot;
+
 struct Xvr_LLVMCodegen {
     Xvr_LLVMContext* context;
     Xvr_LLVMModuleManager* module;
@@ -118,12 +143,92 @@ struct Xvr_LLVMCodegen {
     Xvr_LLVMTargetMachine* target_machine;
     Xvr_ModuleResolver* module_resolver;
 
+    /* the type table of a codegen created without a session */
+    Xvr_TypeTable* own_types;
+    /* NULL for Xvr_LLVMCodegenCreate, its options are the defaults */
+    Xvr_CompilerSession* session;
+
     bool has_error;
     char* error_message;
+    /* set once verification fails, see Xvr_LLVMCodegenDestroy */
+    bool ir_invalid;
     bool main_created;
+    bool main_finalized;
+
+    Xvr_LLVMOptimizationLevel level;
+    /* NULL links no runtime bitcode, see Xvr_LLVMCodegenSetRuntimeBitcode */
+    char* runtime_bitcode;
+    bool runtime_linked;
+
+    /* imports are compiled as their own modules, only declared here */
+    bool separate_imports;
+    bool library_unit;
+    /* top-level statements a library unit left out, which a precompiled
+     * module has no room for */
+    size_t skipped_statements;
+    char** imports;
+    size_t import_count;
+    size_t import_capacity;
+
+    /* object emission threads, 0 and 1 emit the module in one piece */
+    unsigned codegen_jobs;
+
+    /* every imported module, parsed once; precompiled ones wait here until
+     * the graph reaches them */
+    Xvr_ModuleGraph* module_graph;
+    Xvr_LLVMPrecompiledModule** precompiled;
+    char** precompiled_paths;
+    size_t precompiled_count;
+
+    /* imported procs whose bodies wait for a call site, see
+     * emit_deferred_procs */
+    Xvr_LLVMDeferredProc* deferred;
+    size_t deferred_count;
+    size_t deferred_capacity;
+
+    /* a REPL entry's function and its top-level variables, the first
+     * repl_bound of them carried over from earlier entries */
+    char* entry_name;
+    Xvr_LLVMReplSlot* repl_slots;
+    size_t repl_slot_count;
+    size_t repl_bound;
+    Xvr_LLVMReplVar* repl_declared;
 };
 
+static bool load_precompiled(void* context, const char* path,
+                             char*** out_imports, size_t* out_count);
+
+static void free_repl_var(Xvr_LLVMReplVar* var) {
+    free(var->name);
+    free(var->symbol);
+    free(var->type);
+}
+
+static Xvr_LLVMOptimizationLevel session_level(
+    const Xvr_CompilerOptions* options) {
+    switch (options->optimizationLevel) {
+    case 0:
+        return XVR_LLVM_OPT_NONE;
+    case 1:
+        return XVR_LLVM_OPT_O1;
+    case 3:
+        return XVR_LLVM_OPT_O3;
+    default:
+        if (options->sizeLevel == 1) {
+            return XVR_LLVM_OPT_OS;
+        } else if (options->sizeLevel == 2) {
+            return XVR_LLVM_OPT_OZ;
+        }
+        return XVR_LLVM_OPT_O2;
+    }
+}
+
 Xvr_LLVMCodegen* Xvr_LLVMCodegenCreate(const char* module_name) {
+    return Xvr_LLVMCodegenCreateWithSession(module_name, NULL);
+}
+
+Xvr_LLVMCodegen* Xvr_LLVMCodegenCreateWithSession(
+    const char* module_name, Xvr_CompilerSession* session) {
     if (!module_name) {
         return NULL;
     }
@@ -177,7 +282,22 @@ Xvr_LLVMCodegen* Xvr_LLVMCodegenCreate(const char* module_name) {
         return NULL;
     }
 
-    codegen->module_resolver = Xvr_ModuleResolverCreate("./lib/std");
+    const Xvr_CompilerOptions* options = Xvr_CompilerSessionGetOptions(session);
+    codegen->session = session;
+    if (session) {
+        Xvr_LLVMExpressionEmitterSetTypeTable(
+            codegen->expr_emitter, Xvr_CompilerSessionGetTypeTable(session));
+    } else {
+        codegen->own_types = Xvr_TypeTableCreate();
+        Xvr_LLVMExpressionEmitterSetTypeTable(codegen->expr_emitter,
+                                              codegen->own_types);
+    }
+
+    codegen->module_resolver = Xvr_ModuleResolverCreate(options->stdlibPath);
+    Xvr_ModuleResolverSetSession(codegen->module_resolver, session);
+    codegen->module_graph = Xvr_ModuleGraphCreate(codegen->module_resolver);
+    Xvr_ModuleGraphSetPrebuilt(codegen->module_graph, load_precompiled,
+                               codegen);
 
     codegen->fn_emitter = Xvr_LLVMFunctionEmitterCreate(
         codegen->context, codegen->module, codegen->builder,
@@ -243,9 +363,8 @@ Xvr_LLVMCodegen* Xvr_LLVMCodegenCreate(const char* module_name) {
     Xvr_LLVMTargetConfigSetReloc(target_config, "PIC");
     Xvr_LLVMTargetConfigSetCodeModel(target_config, "jitdefault");
 
-    if (Xvr_commandLine.asmSyntax) {
-        Xvr_AsmSyntax syntax =
-            Xvr_AsmSyntaxFromString(Xvr_commandLine.asmSyntax);
+    if (options->asmSyntax) {
+        Xvr_AsmSyntax syntax = Xvr_AsmSyntaxFromString(options->asmSyntax);
         Xvr_LLVMTargetConfigSetAsmSyntax(target_config, syntax);
     }
 
@@ -264,12 +383,77 @@ Xvr_LLVMCodegen* Xvr_LLVMCodegenCreate(const char* module_name) {
         return NULL;
     }
 
+    Xvr_LLVMTargetMachineApplyToModule(
+        codegen->target_machine,
+        Xvr_LLVMModuleManagerGetModule(codegen->module));
+
+    codegen->level = XVR_LLVM_OPT_O2;
+    const char* runtime_bitcode = Xvr_LLVMLinkerFindRuntimeBitcode();
+    codegen->runtime_bitcode =
+        runtime_bitcode ? Xvr_private_strdup(runtime_bitcode) : NULL;
+
     codegen->has_error = false;
     codegen->error_message = NULL;
 
+    if (session) {
+        Xvr_LLVMCodegenSetOptimizationLevel(codegen, session_level(options));
+        if ((options->targetCPU &&
+             !Xvr_LLVMCodegenSetTargetCPU(codegen, options->targetCPU)) ||
+            (options->targetFeatures &&
+             !Xvr_LLVMCodegenSetTargetFeatures(codegen,
+                                               options->targetFeatures))) {
+            Xvr_LLVMCodegenDestroy(codegen);
+            return NULL;
+        }
+        if (options->vectorizeLoops >= 0) {
+            Xvr_LLVMCodegenSetLoopVectorize(codegen, options->vectorizeLoops);
+        }
+        if (options->vectorizeSLP >= 0) {
+            Xvr_LLVMCodegenSetSLPVectorize(codegen, options->vectorizeSLP);
+        }
+        if (options->unrollLoops >= 0) {
+            Xvr_LLVMCodegenSetLoopUnrolling(codegen, options->unrollLoops);
+        }
+        if (options->inlineThreshold >= 0) {
+            Xvr_LLVMCodegenSetInlinerThreshold(codegen,
+                                               options->inlineThreshold);
+        }
+        if (!options->runtimeBitcode) {
+            Xvr_LLVMCodegenSetRuntimeBitcode(codegen, NULL);
+        }
+        if (options->thinLTO) {
+            Xvr_LLVMCodegenSetThinLTO(codegen, true);
+        }
+        if (options->profileGenerate) {
+            Xvr_LLVMCodegenSetProfileGenerate(codegen,
+                                              options->profileGenerate);
+        }
+        /* the instrumented link takes a single object */
+        if (options->jobs > 0 && !options->profileGenerate) {
+            Xvr_LLVMCodegenSetCodegenJobs(codegen, (unsigned)options->jobs);
+        }
+    }
+
     return codegen;
 }
 
+bool Xvr_LLVMCodegenApplySessionPipeline(Xvr_LLVMCodegen* codegen) {
+    if (!codegen) {
+        return false;
+    }
+    const Xvr_CompilerOptions* options =
+        Xvr_CompilerSessionGetOptions(codegen->session);
+    if (options->profileUse &&
+        !Xvr_LLVMCodegenSetProfileUse(codegen, options->profileUse)) {
+        return false;
+    }
+    /* the fragment is appended to the level's pipeline, at -O0 it runs
+     * alone */
+    return !options->passPipeline ||
+           (Xvr_LLVMCodegenAddStandardPasses(codegen) &&
+            Xvr_LLVMCodegenAddPasses(codegen, options->passPipeline));
+}
+
 void Xvr_LLVMCodegenDestroy(Xvr_LLVMCodegen* codegen) {
     if (!codegen) {
         return;
@@ -296,16 +480,43 @@ void Xvr_LLVMCodegenDestroy(Xvr_LLVMCodegen* codegen) {
     if (codegen->builder) {
         Xvr_LLVMIRBuilderDestroy(codegen->builder);
     }
-    if (codegen->module) {
+    /* LLVM tears a module down assuming its IR is valid, so one that failed
+     * verification is left to the process, along with its context */
+    if (codegen->module && codegen->ir_invalid) {
+        Xvr_LLVMModuleManagerAbandon(codegen->module);
+    } else if (codegen->module) {
         Xvr_LLVMModuleManagerDestroy(codegen->module);
     }
+    /* held modules live in the codegen's LLVM context */
+    for (size_t i = 0; i < codegen->precompiled_count; i++) {
+        Xvr_LLVMPrecompiledDestroy(codegen->precompiled[i]);
+        free(codegen->precompiled_paths[i]);
+    }
+    free(codegen->precompiled);
+    free(codegen->precompiled_paths);
+    free(codegen->deferred);
+    for (size_t i = 0; i < codegen->repl_slot_count; i++) {
+        free_repl_var(&codegen->repl_slots[i].var);
+    }
+    free(codegen->repl_slots);
+    free(codegen->repl_declared);
+    free(codegen->entry_name);
+    Xvr_TypeTableDestroy(codegen->own_types);
+    Xvr_ModuleGraphDestroy(codegen->module_graph);
     if (codegen->module_resolver) {
         Xvr_ModuleResolverDestroy(codegen->module_resolver);
     }
-    if (codegen->context) {
+    if (codegen->context && codegen->ir_invalid) {
+        Xvr_LLVMContextAbandon(codegen->context);
+    } else if (codegen->context) {
         Xvr_LLVMContextDestroy(codegen->context);
     }
 
+    for (size_t i = 0; i < codegen->import_count; i++) {
+        free(codegen->imports[i]);
+    }
+    free(codegen->imports);
+    free(codegen->runtime_bitcode);
     free(codegen->error_message);
     free(codegen);
 }
@@ -315,34 +526,244 @@ bool Xvr_LLVMCodegenSetOptimizationLevel(Xvr_LLVMCodegen* codegen,
     if (!codegen || !codegen->optimizer) {
         return false;
     }
+    codegen->level = level;
     return Xvr_LLVMOptimizerSetLevel(codegen->optimizer, level);
 }
 
-bool Xvr_LLVMCodegenRunOptimizer(Xvr_LLVMCodegen* codegen) {
+bool Xvr_LLVMCodegenSetRuntimeBitcode(Xvr_LLVMCodegen* codegen,
+                                      const char* path) {
+    if (!codegen) {
+        return false;
+    }
+    char* copy = NULL;
+    if (path) {
+        copy = Xvr_private_strdup(path);
+        if (!copy) {
+            return false;
+        }
+    }
+    free(codegen->runtime_bitcode);
+    codegen->runtime_bitcode = copy;
+    return true;
+}
+
+bool Xvr_LLVMCodegenSetThinLTO(Xvr_LLVMCodegen* codegen, bool enable) {
     if (!codegen || !codegen->optimizer) {
         return false;
     }
+    codegen->separate_imports = enable;
+    return Xvr_LLVMOptimizerSetThinLTOPreLink(codegen->optimizer, enable);
+}
 
-    if (codegen->target_machine) {
-        Xvr_LLVMOptimizerSetTargetMachine(
-            codegen->optimizer,
-            Xvr_LLVMTargetMachineGetLLVMTargetMachine(codegen->target_machine));
+bool Xvr_LLVMCodegenSetSeparateImports(Xvr_LLVMCodegen* codegen,
+                                       bool enable) {
+    if (!codegen) {
+        return false;
+    }
+    codegen->separate_imports = enable;
+    return true;
+}
+
+bool Xvr_LLVMCodegenSetCodegenJobs(Xvr_LLVMCodegen* codegen, unsigned jobs) {
+    if (!codegen) {
+        return false;
+    }
+    codegen->codegen_jobs = jobs;
+    Xvr_ModuleGraphSetJobs(codegen->module_graph, jobs);
+    return true;
+}
+
+bool Xvr_LLVMCodegenSetReplEntry(Xvr_LLVMCodegen* codegen, const char* entry,
+                                 const Xvr_LLVMReplVar* vars, size_t count) {
+    if (!codegen || !entry || (!vars && count > 0) || codegen->main_created ||
+        codegen->entry_name) {
+        return false;
+    }
+    codegen->repl_slots =
+        (Xvr_LLVMReplSlot*)calloc(count + 1, sizeof(Xvr_LLVMReplSlot));
+    codegen->entry_name = Xvr_private_strdup(entry);
+    if (!codegen->repl_slots || !codegen->entry_name) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        Xvr_LLVMReplVar* var = &codegen->repl_slots[i].var;
+        var->name = Xvr_private_strdup(vars[i].name);
+        var->symbol = Xvr_private_strdup(vars[i].symbol);
+        var->type = Xvr_private_strdup(vars[i].type);
+        var->var_type = vars[i].var_type;
+        var->array_count = vars[i].array_count;
+        codegen->repl_slot_count++;
+        if (!var->name || !var->symbol || !var->type) {
+            return false;
+        }
     }
+    codegen->repl_bound = count;
+    return true;
+}
 
-    return Xvr_LLVMOptimizerRun(codegen->optimizer, codegen->module);
+const Xvr_LLVMReplVar* Xvr_LLVMCodegenGetReplVars(Xvr_LLVMCodegen* codegen,
+                                                  size_t* out_count) {
+    if (out_count) {
+        *out_count = 0;
+    }
+    if (!codegen || !out_count ||
+        codegen->repl_slot_count == codegen->repl_bound) {
+        return NULL;
+    }
+    size_t count = codegen->repl_slot_count - codegen->repl_bound;
+    if (!codegen->repl_declared) {
+        codegen->repl_declared =
+            (Xvr_LLVMReplVar*)calloc(count, sizeof(Xvr_LLVMReplVar));
+        if (!codegen->repl_declared) {
+            return NULL;
+        }
+        for (size_t i = 0; i < count; i++) {
+            codegen->repl_declared[i] =
+                codegen->repl_slots[codegen->repl_bound + i].var;
+        }
+    }
+    *out_count = count;
+    return codegen->repl_declared;
+}
+
+bool Xvr_LLVMCodegenSetLibraryUnit(Xvr_LLVMCodegen* codegen, bool enable) {
+    if (!codegen) {
+        return false;
+    }
+    codegen->library_unit = enable;
+    return true;
+}
+
+size_t Xvr_LLVMCodegenGetImportCount(Xvr_LLVMCodegen* codegen) {
+    return codegen ? codegen->import_count : 0;
+}
+
+const char* Xvr_LLVMCodegenGetImport(Xvr_LLVMCodegen* codegen, size_t index) {
+    if (!codegen || index >= codegen->import_count) {
+        return NULL;
+    }
+    return codegen->imports[index];
+}
+
+static bool record_import(Xvr_LLVMCodegen* codegen, const char* path) {
+    for (size_t i = 0; i < codegen->import_count; i++) {
+        if (strcmp(codegen->imports[i], path) == 0) {
+            return false;
+        }
+    }
+    if (codegen->import_count == codegen->import_capacity) {
+        size_t capacity =
+            codegen->import_capacity ? codegen->import_capacity * 2 : 4;
+        char** grown =
+            (char**)realloc(codegen->imports, capacity * sizeof(char*));
+        if (!grown) {
+            return false;
+        }
+        codegen->imports = grown;
+        codegen->import_capacity = capacity;
+    }
+    char* copy = Xvr_private_strdup(path);
+    if (!copy) {
+        return false;
+    }
+    codegen->imports[codegen->import_count++] = copy;
+    return true;
+}
+
+bool Xvr_LLVMCodegenSetLoopVectorize(Xvr_LLVMCodegen* codegen, bool enable) {
+    if (!codegen || !codegen->optimizer) {
+        return false;
+    }
+    return Xvr_LLVMOptimizerSetLoopVectorize(codegen->optimizer, enable);
+}
+
+bool Xvr_LLVMCodegenSetSLPVectorize(Xvr_LLVMCodegen* codegen, bool enable) {
+    if (!codegen || !codegen->optimizer) {
+        return false;
+    }
+    return Xvr_LLVMOptimizerSetSLPVectorize(codegen->optimizer, enable);
+}
+
+bool Xvr_LLVMCodegenSetLoopUnrolling(Xvr_LLVMCodegen* codegen, bool enable) {
+    if (!codegen || !codegen->optimizer) {
+        return false;
+    }
+    return Xvr_LLVMOptimizerSetLoopUnrolling(codegen->optimizer, enable);
+}
+
+bool Xvr_LLVMCodegenSetInlinerThreshold(Xvr_LLVMCodegen* codegen,
+                                        int threshold) {
+    if (!codegen || !codegen->optimizer) {
+        return false;
+    }
+    return Xvr_LLVMOptimizerSetInlinerThreshold(codegen->optimizer, threshold);
+}
+
+/* target machines are immutable, so a setting change builds a new one from
+ * a copy of the current config and only swaps it in once it exists */
+static bool rebuild_target_machine(Xvr_LLVMCodegen* codegen,
+                                   Xvr_LLVMTargetConfig* config) {
+    if (!config) {
+        return false;
+    }
+    Xvr_LLVMTargetMachine* tm = Xvr_LLVMTargetMachineCreate(config);
+    if (!tm) {
+        Xvr_LLVMTargetConfigDestroy(config);
+        return false;
+    }
+    Xvr_LLVMTargetMachineDestroy(codegen->target_machine);
+    codegen->target_machine = tm;
+    Xvr_LLVMOptimizerSetTargetMachine(
+        codegen->optimizer, Xvr_LLVMTargetMachineGetLLVMTargetMachine(tm));
+    return Xvr_LLVMTargetMachineApplyToModule(
+        tm, Xvr_LLVMModuleManagerGetModule(codegen->module));
 }
 
 bool Xvr_LLVMCodegenSetTargetTriple(Xvr_LLVMCodegen* codegen,
                                     const char* triple) {
-    (void)codegen;
-    (void)triple;
-    return true;
+    if (!codegen || !triple) {
+        return false;
+    }
+    Xvr_LLVMTargetConfig* config = Xvr_LLVMTargetConfigClone(
+        Xvr_LLVMTargetMachineGetConfig(codegen->target_machine));
+    if (!config || !Xvr_LLVMTargetConfigSetTriple(config, triple)) {
+        Xvr_LLVMTargetConfigDestroy(config);
+        return false;
+    }
+    return rebuild_target_machine(codegen, config);
 }
 
 bool Xvr_LLVMCodegenSetTargetCPU(Xvr_LLVMCodegen* codegen, const char* cpu) {
-    (void)codegen;
-    (void)cpu;
-    return true;
+    if (!codegen || !cpu) {
+        return false;
+    }
+    Xvr_LLVMTargetConfig* config = Xvr_LLVMTargetConfigClone(
+        Xvr_LLVMTargetMachineGetConfig(codegen->target_machine));
+    if (!config || !Xvr_LLVMTargetConfigSetCPU(config, cpu)) {
+        Xvr_LLVMTargetConfigDestroy(config);
+        return false;
+    }
+    return rebuild_target_machine(codegen, config);
+}
+
+bool Xvr_LLVMCodegenSetTargetFeatures(Xvr_LLVMCodegen* codegen,
+                                      const char* features) {
+    if (!codegen || !features) {
+        return false;
+    }
+    Xvr_LLVMTargetConfig* config = Xvr_LLVMTargetConfigClone(
+        Xvr_LLVMTargetMachineGetConfig(codegen->target_machine));
+    if (!config || !Xvr_LLVMTargetConfigSetFeatures(config, features)) {
+        Xvr_LLVMTargetConfigDestroy(config);
+        return false;
+    }
+    return rebuild_target_machine(codegen, config);
+}
+
+static double get_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
 }
 
 static void set_error(Xvr_LLVMCodegen* codegen, const char* message) {
@@ -354,25 +775,233 @@ static void set_error(Xvr_LLVMCodegen* codegen, const char* message) {
     codegen->has_error = (codegen->error_message != NULL);
 }
 
+static void set_pipeline_error(Xvr_LLVMCodegen* codegen) {
+    const char* message = Xvr_LLVMOptimizerGetError(codegen->optimizer);
+    char error_msg[1024];
+    snprintf(error_msg, sizeof(error_msg), "invalid pass pipeline: %s",
+             message ? message : "unknown error");
+    set_error(codegen, error_msg);
+}
+
+bool Xvr_LLVMCodegenSetProfileGenerate(Xvr_LLVMCodegen* codegen,
+                                       const char* raw_profile_path) {
+    if (!codegen || !codegen->optimizer) {
+        return false;
+    }
+    return Xvr_LLVMOptimizerSetProfileGenerate(codegen->optimizer,
+                                               raw_profile_path);
+}
+
+bool Xvr_LLVMCodegenSetProfileUse(Xvr_LLVMCodegen* codegen,
+                                  const char* profile_path) {
+    if (!codegen || !codegen->optimizer) {
+        return false;
+    }
+    if (!Xvr_LLVMOptimizerSetProfileUse(codegen->optimizer, profile_path)) {
+        const char* message = Xvr_LLVMOptimizerGetError(codegen->optimizer);
+        set_error(codegen, message ? message : "cannot use profile");
+        return false;
+    }
+    return true;
+}
+
+bool Xvr_LLVMCodegenAddPasses(Xvr_LLVMCodegen* codegen, const char* pipeline) {
+    if (!codegen || !codegen->optimizer) {
+        return false;
+    }
+    if (!Xvr_LLVMOptimizerAddPass(codegen->optimizer, pipeline)) {
+        set_pipeline_error(codegen);
+        return false;
+    }
+    return true;
+}
+
+bool Xvr_LLVMCodegenAddStandardPasses(Xvr_LLVMCodegen* codegen) {
+    if (!codegen || !codegen->optimizer) {
+        return false;
+    }
+    return Xvr_LLVMOptimizerAddStandardPasses(codegen->optimizer);
+}
+
+const char* Xvr_LLVMCodegenGetPipeline(Xvr_LLVMCodegen* codegen) {
+    if (!codegen || !codegen->optimizer) {
+        return NULL;
+    }
+    const char* pipeline = Xvr_LLVMOptimizerGetPipeline(codegen->optimizer);
+    if (!pipeline) {
+        set_pipeline_error(codegen);
+    }
+    return pipeline;
+}
+
 static bool emit_main_function(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* stmt);
 static bool ensure_main_function(Xvr_LLVMCodegen* codegen);
 static void finalize_main_function(Xvr_LLVMCodegen* codegen);
 
+/* value types are spelled i<bits>, f, d and p<pointee> so that a later
+ * REPL entry can rebuild them in its own context; from LLVM 15 on pointers
+ * are opaque and carry no pointee */
+static bool spell_value_type(LLVMTypeRef type, char* out, size_t size) {
+    if (size < 2) {
+        return false;
+    }
+    switch (LLVMGetTypeKind(type)) {
+    case LLVMIntegerTypeKind:
+        return snprintf(out, size, "i%u", LLVMGetIntTypeWidth(type)) <
+               (int)size;
+    case LLVMFloatTypeKind:
+        return snprintf(out, size, "f") < (int)size;
+    case LLVMDoubleTypeKind:
+        return snprintf(out, size, "d") < (int)size;
+    case LLVMPointerTypeKind:
+        out[0] = 'p';
+        out[1] = '\0';
+#if LLVM_VERSION_MAJOR < 15
+        return spell_value_type(LLVMGetElementType(type), out + 1, size - 1);
+#else
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+static LLVMTypeRef read_value_type(LLVMContextRef llvm_ctx,
+                                   const char* spelling) {
+    switch (spelling[0]) {
+    case 'i': {
+        unsigned long bits = strtoul(spelling + 1, NULL, 10);
+        return bits > 0 ? LLVMIntTypeInContext(llvm_ctx, (unsigned)bits)
+                        : NULL;
+    }
+    case 'f':
+        return LLVMFloatTypeInContext(llvm_ctx);
+    case 'd':
+        return LLVMDoubleTypeInContext(llvm_ctx);
+    case 'p': {
+        LLVMTypeRef pointee = spelling[1]
+                                  ? read_value_type(llvm_ctx, spelling + 1)
+                                  : LLVMInt8TypeInContext(llvm_ctx);
+        return pointee ? LLVMPointerType(pointee, 0) : NULL;
+    }
+    default:
+        return NULL;
+    }
+}
+
+/* variables of earlier REPL entries become locals of this one, loaded from
+ * the globals those entries defined */
+static void bind_repl_vars(Xvr_LLVMCodegen* codegen) {
+    LLVMContextRef llvm_ctx = Xvr_LLVMContextGetLLVMContext(codegen->context);
+    LLVMModuleRef module = Xvr_LLVMModuleManagerGetModule(codegen->module);
+    for (size_t i = 0; i < codegen->repl_bound; i++) {
+        Xvr_LLVMReplSlot* slot = &codegen->repl_slots[i];
+        LLVMTypeRef type = read_value_type(llvm_ctx, slot->var.type);
+        if (!type) {
+            continue;
+        }
+        slot->global = LLVMAddGlobal(module, type, slot->var.symbol);
+        slot->slot = Xvr_LLVMIRBuilderCreateAlloca(codegen->builder, type,
+                                                   slot->var.name);
+        Xvr_LLVMIRBuilderCreateStore(
+            codegen->builder,
+            Xvr_LLVMIRBuilderCreateLoad(codegen->builder, type, slot->global,
+                                        slot->var.name),
+            slot->slot);
+        Xvr_LLVMFunctionEmitterAddLocalVar(codegen->fn_emitter,
+                                           slot->var.name, slot->slot,
+                                           slot->var.var_type,
+                                           slot->var.array_count);
+    }
+}
+
+/* a top-level variable of a REPL entry gets a global named after the entry,
+ * filled in as the entry returns */
+static bool share_repl_var(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* ast) {
+    Xvr_Literal* ident = &ast->varDecl.identifier;
+    if (ident->type != XVR_LITERAL_IDENTIFIER || !ident->as.identifier.ptr) {
+        return true;
+    }
+    const char* name = ident->as.identifier.ptr->data;
+    Xvr_LiteralType var_type = XVR_LITERAL_ANY;
+    LLVMValueRef slot = Xvr_LLVMFunctionEmitterLookupVarWithType(
+        codegen->fn_emitter, name, &var_type);
+    char spelling[32];
+    if (!slot || !LLVMIsAAllocaInst(slot) ||
+        !spell_value_type(LLVMGetAllocatedType(slot), spelling,
+                          sizeof(spelling))) {
+        return true;
+    }
+
+    Xvr_LLVMReplSlot* grown = (Xvr_LLVMReplSlot*)realloc(
+        codegen->repl_slots,
+        (codegen->repl_slot_count + 1) * sizeof(Xvr_LLVMReplSlot));
+    if (!grown) {
+        set_error(codegen, "out of memory");
+        return false;
+    }
+    codegen->repl_slots = grown;
+
+    LLVMModuleRef module = Xvr_LLVMModuleManagerGetModule(codegen->module);
+    LLVMTypeRef type = LLVMGetAllocatedType(slot);
+    char symbol[256];
+    snprintf(symbol, sizeof(symbol), "%s.%s", codegen->entry_name, name);
+    LLVMValueRef global = LLVMAddGlobal(module, type, symbol);
+    LLVMSetInitializer(global, LLVMConstNull(type));
+
+    /* a name declared twice in one entry has its global renamed */
+    size_t length = 0;
+    Xvr_LLVMReplSlot* added = &grown[codegen->repl_slot_count++];
+    added->var.name = Xvr_private_strdup(name);
+    added->var.symbol = Xvr_private_strdup(LLVMGetValueName2(global, &length));
+    added->var.type = Xvr_private_strdup(spelling);
+    added->var.var_type = var_type;
+    added->var.array_count =
+        Xvr_LLVMFunctionEmitterLookupVarArrayCount(codegen->fn_emitter, name);
+    added->slot = slot;
+    added->global = global;
+    if (!added->var.name || !added->var.symbol || !added->var.type) {
+        set_error(codegen, "out of memory");
+        return false;
+    }
+    return true;
+}
+
+static void store_repl_vars(Xvr_LLVMCodegen* codegen) {
+    for (size_t i = 0; i < codegen->repl_slot_count; i++) {
+        Xvr_LLVMReplSlot* slot = &codegen->repl_slots[i];
+        if (!slot->slot || !slot->global) {
+            continue;
+        }
+        LLVMTypeRef type = LLVMGlobalGetValueType(slot->global);
+        Xvr_LLVMIRBuilderCreateStore(
+            codegen->builder,
+            Xvr_LLVMIRBuilderCreateLoad(codegen->builder, type, slot->slot,
+                                        slot->var.name),
+            slot->global);
+    }
+}
+
 static bool ensure_main_function(Xvr_LLVMCodegen* codegen) {
     LLVMContextRef llvm_ctx = Xvr_LLVMContextGetLLVMContext(codegen->context);
     LLVMModuleRef module = Xvr_LLVMModuleManagerGetModule(codegen->module);
     LLVMBuilderRef builder = Xvr_LLVMIRBuilderGetLLVMBuilder(codegen->builder);
+    const char* main_name =
+        codegen->entry_name ? codegen->entry_name : "main";
 
-    LLVMValueRef main_fn = LLVMGetNamedFunction(module, "main");
+    LLVMValueRef main_fn = LLVMGetNamedFunction(module, main_name);
     if (!main_fn) {
         LLVMTypeRef int32_type = LLVMInt32TypeInContext(llvm_ctx);
         LLVMTypeRef main_fn_type = LLVMFunctionType(int32_type, NULL, 0, false);
-        LLVMAddFunction(module, "main", main_fn_type);
-        main_fn = LLVMGetNamedFunction(module, "main");
+        LLVMAddFunction(module, main_name, main_fn_type);
+        main_fn = LLVMGetNamedFunction(module, main_name);
 
         LLVMBasicBlockRef entry =
             LLVMAppendBasicBlockInContext(llvm_ctx, main_fn, "entry");
         LLVMPositionBuilderAtEnd(builder, entry);
+        Xvr_LLVMFunctionEmitterSetCurrentFunction(codegen->fn_emitter,
+                                                  main_fn);
+        bind_repl_vars(codegen);
     } else {
         LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(main_fn);
         if (entry) {
@@ -399,15 +1028,115 @@ static bool ensure_main_function(Xvr_LLVMCodegen* codegen) {
     return true;
 }
 
+/* functions carry the machine's CPU and features so that IR passes (and
+ * anything that later reloads the bitcode) see the same target */
+static void apply_target_attributes(Xvr_LLVMCodegen* codegen) {
+    const char* cpu = Xvr_LLVMTargetMachineGetCPU(codegen->target_machine);
+    const char* features =
+        Xvr_LLVMTargetMachineGetFeatures(codegen->target_machine);
+    if (!cpu) {
+        return;
+    }
+
+    LLVMContextRef llvm_ctx = Xvr_LLVMContextGetLLVMContext(codegen->context);
+    LLVMModuleRef module = Xvr_LLVMModuleManagerGetModule(codegen->module);
+    LLVMAttributeRef cpu_attr = LLVMCreateStringAttribute(
+        llvm_ctx, "target-cpu", 10, cpu, (unsigned)strlen(cpu));
+    LLVMAttributeRef features_attr =
+        features && *features
+            ? LLVMCreateStringAttribute(llvm_ctx, "target-features", 15,
+                                        features, (unsigned)strlen(features))
+            : NULL;
+
+    for (LLVMValueRef fn = LLVMGetFirstFunction(module); fn;
+         fn = LLVMGetNextFunction(fn)) {
+        if (LLVMIsDeclaration(fn)) {
+            continue;
+        }
+        LLVMAddAttributeAtIndex(fn, LLVMAttributeFunctionIndex, cpu_attr);
+        if (features_attr) {
+            LLVMAddAttributeAtIndex(fn, LLVMAttributeFunctionIndex,
+                                    features_attr);
+        }
+    }
+}
+
+/* gives each deferred proc that is called by now its body; a body may call
+ * other deferred procs, so this repeats until no new proc is reached. the
+ * ones nothing calls lose their declaration */
+static bool emit_deferred_procs(Xvr_LLVMCodegen* codegen) {
+    LLVMBuilderRef builder = Xvr_LLVMIRBuilderGetLLVMBuilder(codegen->builder);
+    LLVMBasicBlockRef saved_block = LLVMGetInsertBlock(builder);
+    LLVMValueRef saved_function =
+        Xvr_LLVMFunctionEmitterGetCurrentFunction(codegen->fn_emitter);
+
+    bool emitted = true;
+    bool reached = true;
+    while (emitted && reached) {
+        reached = false;
+        for (size_t i = 0; emitted && i < codegen->deferred_count; i++) {
+            Xvr_LLVMDeferredProc* proc = &codegen->deferred[i];
+            if (proc->done || !LLVMGetFirstUse(proc->function)) {
+                continue;
+            }
+            proc->done = true;
+            reached = true;
+            emitted =
+                Xvr_LLVMFunctionEmitterEmit(codegen->fn_emitter, proc->node);
+            if (emitted && proc->internal) {
+                LLVMSetLinkage(proc->function, LLVMInternalLinkage);
+            }
+        }
+    }
+
+    for (size_t i = 0; emitted && i < codegen->deferred_count; i++) {
+        Xvr_LLVMDeferredProc* proc = &codegen->deferred[i];
+        if (!proc->done) {
+            LLVMDeleteFunction(proc->function);
+            proc->done = true;
+        }
+    }
+    codegen->deferred_count = 0;
+
+    if (saved_block) {
+        LLVMPositionBuilderAtEnd(builder, saved_block);
+    }
+    Xvr_LLVMFunctionEmitterSetCurrentFunction(codegen->fn_emitter,
+                                              saved_function);
+    if (!emitted) {
+        set_error(codegen,
+                  Xvr_LLVMContextHasError(codegen->context)
+                      ? Xvr_LLVMContextGetErrorMessage(codegen->context)
+                      : "failed to emit imported proc");
+    }
+    return emitted;
+}
+
+static bool prepare_module(Xvr_LLVMCodegen* codegen) {
+    finalize_main_function(codegen);
+    if (codegen->deferred_count > 0 && !emit_deferred_procs(codegen)) {
+        return false;
+    }
+    Xvr_LLVMModuleManagerStripUnreachable(codegen->module);
+    apply_target_attributes(codegen);
+    return true;
+}
+
 static void finalize_main_function(Xvr_LLVMCodegen* codegen) {
-    if (!codegen->main_created) {
+    if (!codegen->main_created || codegen->main_finalized) {
         return;
     }
+    codegen->main_finalized = true;
 
     LLVMBuilderRef builder = Xvr_LLVMIRBuilderGetLLVMBuilder(codegen->builder);
+    LLVMBasicBlockRef current = LLVMGetInsertBlock(builder);
+    if (current && LLVMGetBasicBlockTerminator(current)) {
+        return;
+    }
     LLVMContextRef llvm_ctx = Xvr_LLVMContextGetLLVMContext(codegen->context);
     LLVMTypeRef int32_type = LLVMInt32TypeInContext(llvm_ctx);
 
+    store_repl_vars(codegen);
     LLVMBuildRet(builder, LLVMConstInt(int32_type, 0, false));
 }
 
@@ -423,6 +1152,325 @@ static bool emit_main_function(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* stmt) {
     return true;
 }
 
+/* a separately compiled import contributes prototypes for its procs; its
+ * top-level statements still run in the importing program's main */
+static bool emit_import_declarations(Xvr_LLVMCodegen* codegen,
+                                     Xvr_ASTNode* ast) {
+    bool declared = true;
+    if (ast->type == XVR_AST_NODE_FN_DECL) {
+        declared = Xvr_LLVMFunctionEmitterDeclare(codegen->fn_emitter, ast);
+    } else if (ast->type == XVR_AST_NODE_FN_COLLECTION) {
+        for (int i = 0; declared && i < ast->fnCollection.count; i++) {
+            declared = Xvr_LLVMFunctionEmitterDeclare(
+                codegen->fn_emitter, &ast->fnCollection.nodes[i]);
+        }
+    } else if (codegen->library_unit) {
+        return true;
+    } else {
+        return Xvr_LLVMCodegenEmitAST(codegen, ast);
+    }
+
+    if (!declared && Xvr_LLVMContextHasError(codegen->context)) {
+        set_error(codegen, Xvr_LLVMContextGetErrorMessage(codegen->context));
+    }
+    return declared;
+}
+
+static bool hold_precompiled(Xvr_LLVMCodegen* codegen, const char* path,
+                             Xvr_LLVMPrecompiledModule* precompiled) {
+    size_t count = codegen->precompiled_count;
+    Xvr_LLVMPrecompiledModule** grown = (Xvr_LLVMPrecompiledModule**)realloc(
+        codegen->precompiled, (count + 1) * sizeof(*grown));
+    if (!grown) {
+        return false;
+    }
+    codegen->precompiled = grown;
+    char** grown_paths = (char**)realloc(codegen->precompiled_paths,
+                                         (count + 1) * sizeof(char*));
+    if (!grown_paths) {
+        return false;
+    }
+    codegen->precompiled_paths = grown_paths;
+    char* copy = Xvr_private_strdup(path);
+    if (!copy) {
+        return false;
+    }
+    codegen->precompiled[count] = precompiled;
+    codegen->precompiled_paths[count] = copy;
+    codegen->precompiled_count++;
+    return true;
+}
+
+/* the module graph asks before parsing a module; a precompiled module that
+ * is still current is held until its turn to be emitted */
+static bool load_precompiled(void* context, const char* path,
+                             char*** out_imports, size_t* out_count) {
+    Xvr_LLVMCodegen* codegen = (Xvr_LLVMCodegen*)context;
+    if (codegen->separate_imports || codegen->library_unit) {
+        return false;
+    }
+    LLVMContextRef llvm_ctx = Xvr_LLVMContextGetLLVMContext(codegen->context);
+    Xvr_LLVMPrecompiledModule* precompiled =
+        Xvr_LLVMPrecompiledLoad(llvm_ctx, path);
+    if (!precompiled) {
+        return false;
+    }
+
+    size_t count = Xvr_LLVMPrecompiledGetImportCount(precompiled);
+    char** imports = (char**)calloc(count + 1, sizeof(char*));
+    bool ok = imports && hold_precompiled(codegen, path, precompiled);
+    for (size_t i = 0; ok && i < count; i++) {
+        imports[i] =
+            Xvr_private_strdup(Xvr_LLVMPrecompiledGetImport(precompiled, i));
+        ok = imports[i] != NULL;
+    }
+    if (!ok) {
+        /* parsing the source is still an option */
+        for (size_t i = 0; imports && i < count; i++) {
+            free(imports[i]);
+        }
+        free(imports);
+        if (codegen->precompiled_count > 0 &&
+            codegen->precompiled[codegen->precompiled_count - 1] ==
+                precompiled) {
+            codegen->precompiled_count--;
+            free(codegen->precompiled_paths[codegen->precompiled_count]);
+        }
+        Xvr_LLVMPrecompiledDestroy(precompiled);
+        return false;
+    }
+
+    *out_imports = imports;
+    *out_count = count;
+    return true;
+}
+
+/* links a held precompiled module and registers its procs */
+static bool link_precompiled(Xvr_LLVMCodegen* codegen, const char* path) {
+    Xvr_LLVMPrecompiledModule* precompiled = NULL;
+    for (size_t i = 0; i < codegen->precompiled_count; i++) {
+        if (codegen->precompiled[i] &&
+            strcmp(codegen->precompiled_paths[i], path) == 0) {
+            precompiled = codegen->precompiled[i];
+            codegen->precompiled[i] = NULL;
+            break;
+        }
+    }
+    if (!precompiled) {
+        return true;
+    }
+
+    char* link_error = NULL;
+    if (!Xvr_LLVMPrecompiledLink(precompiled, codegen->module, &link_error)) {
+        set_error(codegen, link_error ? link_error : "link failed");
+        free(link_error);
+        Xvr_LLVMPrecompiledDestroy(precompiled);
+        return false;
+    }
+
+    LLVMModuleRef module = Xvr_LLVMModuleManagerGetModule(codegen->module);
+    size_t proc_count = Xvr_LLVMPrecompiledGetProcCount(precompiled);
+    for (size_t i = 0; i < proc_count; i++) {
+        const char* name = Xvr_LLVMPrecompiledGetProc(precompiled, i);
+        LLVMValueRef fn = LLVMGetNamedFunction(module, name);
+        if (fn) {
+            Xvr_LLVMModuleManagerRegisterFunctionType(
+                codegen->module, name, LLVMGlobalGetValueType(fn));
+        }
+    }
+    Xvr_LLVMPrecompiledDestroy(precompiled);
+    return true;
+}
+
+/* an imported proc is declared now and emitted once a call site needs it;
+ * a name that already has a body is emitted as before */
+static bool defer_proc(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* node) {
+    Xvr_NodeFnDecl* decl = &node->fnDecl;
+    LLVMModuleRef module = Xvr_LLVMModuleManagerGetModule(codegen->module);
+    const char* name = decl->identifier.as.string.ptr
+                           ? decl->identifier.as.string.ptr->data
+                           : NULL;
+    LLVMValueRef existing = name ? LLVMGetNamedFunction(module, name) : NULL;
+    if (!name || (existing && !LLVMIsDeclaration(existing))) {
+        return Xvr_LLVMCodegenEmitAST(codegen, node);
+    }
+
+    if (codegen->deferred_count == codegen->deferred_capacity) {
+        size_t capacity =
+            codegen->deferred_capacity ? codegen->deferred_capacity * 2 : 16;
+        Xvr_LLVMDeferredProc* grown = (Xvr_LLVMDeferredProc*)realloc(
+            codegen->deferred, capacity * sizeof(*grown));
+        if (!grown) {
+            set_error(codegen, "out of memory");
+            return false;
+        }
+        codegen->deferred = grown;
+        codegen->deferred_capacity = capacity;
+    }
+    if (!Xvr_LLVMFunctionEmitterDeclare(codegen->fn_emitter, node)) {
+        if (Xvr_LLVMContextHasError(codegen->context)) {
+            set_error(codegen,
+                      Xvr_LLVMContextGetErrorMessage(codegen->context));
+        }
+        return false;
+    }
+
+    Xvr_LLVMDeferredProc* proc = &codegen->deferred[codegen->deferred_count++];
+    proc->node = node;
+    proc->function = LLVMGetNamedFunction(module, name);
+    proc->internal = false;
+    proc->done = false;
+    return true;
+}
+
+static bool emit_module_node(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* node) {
+    if (node->type == XVR_AST_NODE_FN_DECL) {
+        return defer_proc(codegen, node);
+    }
+    if (node->type == XVR_AST_NODE_FN_COLLECTION) {
+        bool deferred = true;
+        for (int i = 0; deferred && i < node->fnCollection.count; i++) {
+            deferred = defer_proc(codegen, &node->fnCollection.nodes[i]);
+        }
+        return deferred;
+    }
+    return Xvr_LLVMCodegenEmitAST(codegen, node);
+}
+
+/* procs the module's manifest does not export become internal, the ones
+ * nothing calls are then stripped before the module is emitted */
+static void apply_manifest(Xvr_LLVMCodegen* codegen, const char* path,
+                           LLVMValueRef last_before, size_t first_deferred) {
+    Xvr_ModuleManifest* manifest = Xvr_ModuleManifestLoad(path);
+    if (!manifest) {
+        return;
+    }
+    LLVMModuleRef module = Xvr_LLVMModuleManagerGetModule(codegen->module);
+    for (LLVMValueRef fn = last_before ? LLVMGetNextFunction(last_before)
+                                       : LLVMGetFirstFunction(module);
+         fn; fn = LLVMGetNextFunction(fn)) {
+        size_t length = 0;
+        const char* name = LLVMGetValueName2(fn, &length);
+        if (LLVMIsDeclaration(fn) || strcmp(name, "main") == 0) {
+            continue;
+        }
+        if (!Xvr_ModuleManifestIsExported(manifest, name)) {
+            LLVMSetLinkage(fn, LLVMInternalLinkage);
+        }
+    }
+    /* deferred procs take their linkage along with their body */
+    for (size_t i = first_deferred; i < codegen->deferred_count; i++) {
+        size_t length = 0;
+        const char* name =
+            LLVMGetValueName2(codegen->deferred[i].function, &length);
+        codegen->deferred[i].internal =
+            !Xvr_ModuleManifestIsExported(manifest, name);
+    }
+    Xvr_ModuleManifestDestroy(manifest);
+}
+
+static bool emit_module(Xvr_LLVMCodegen* codegen, size_t index) {
+    const char* path = Xvr_ModuleGraphGetPath(codegen->module_graph, index);
+    record_import(codegen, path);
+
+    /* functions are appended, so the module's procs follow this one */
+    LLVMValueRef last_before = LLVMGetLastFunction(
+        Xvr_LLVMModuleManagerGetModule(codegen->module));
+    size_t first_deferred = codegen->deferred_count;
+    bool separate = codegen->separate_imports || codegen->library_unit;
+    bool emitted = true;
+    if (Xvr_ModuleGraphIsPrebuilt(codegen->module_graph, index)) {
+        emitted = link_precompiled(codegen, path);
+    } else {
+        int node_count = 0;
+        Xvr_ASTNode** nodes =
+            Xvr_ModuleGraphGetNodes(codegen->module_graph, index, &node_count);
+        for (int i = 0; emitted && i < node_count; i++) {
+            emitted = separate ? emit_import_declarations(codegen, nodes[i])
+                               : emit_module_node(codegen, nodes[i]);
+        }
+        /* deferred procs still need their nodes */
+        if (codegen->deferred_count == first_deferred) {
+            Xvr_ModuleGraphRelease(codegen->module_graph, index);
+        }
+    }
+
+    /* a separately compiled module keeps its procs visible for the link */
+    if (emitted && !separate) {
+        apply_manifest(codegen, path, last_before, first_deferred);
+    }
+    return emitted;
+}
+
+/* emits the module and whatever it needs that is not emitted yet,
+ * dependencies first, so each module is emitted exactly once */
+static bool import_module(Xvr_LLVMCodegen* codegen, const char* module_name) {
+    size_t index = 0;
+    if (!Xvr_ModuleGraphRequire(codegen->module_graph, module_name,
+                                &index)) {
+        return true;
+    }
+
+    size_t count = 0;
+    size_t* order = Xvr_ModuleGraphOrder(codegen->module_graph, index, &count);
+    if (!order) {
+        const char* message = Xvr_ModuleGraphGetError(codegen->module_graph);
+        set_error(codegen, message ? message : "out of memory");
+        return false;
+    }
+    bool ok = true;
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = emit_module(codegen, order[i]);
+    }
+    free(order);
+    return ok;
+}
+
+bool Xvr_LLVMCodegenPreloadImports(Xvr_LLVMCodegen* codegen,
+                                   Xvr_ASTNode** nodes, int count) {
+    if (!codegen || (!nodes && count > 0)) {
+        return false;
+    }
+    const char** names = (const char**)calloc((size_t)count + 1,
+                                              sizeof(char*));
+    if (!names) {
+        return false;
+    }
+    size_t name_count = 0;
+    for (int i = 0; i < count; i++) {
+        Xvr_Literal* ident = &nodes[i]->import.identifier;
+        if (nodes[i]->type == XVR_AST_NODE_IMPORT &&
+            ident->type == XVR_LITERAL_IDENTIFIER && ident->as.identifier.ptr) {
+            names[name_count++] = ident->as.identifier.ptr->data;
+        }
+    }
+    Xvr_ModuleGraphAdd(codegen->module_graph, names, name_count);
+    free(names);
+    return true;
+}
+
+bool Xvr_LLVMCodegenDeclareProcs(Xvr_LLVMCodegen* codegen,
+                                 Xvr_ASTNode** nodes, int count) {
+    if (!codegen || (!nodes && count > 0)) {
+        return false;
+    }
+    bool declared = true;
+    for (int i = 0; declared && i < count; i++) {
+        if (nodes[i]->type == XVR_AST_NODE_FN_DECL ||
+            nodes[i]->type == XVR_AST_NODE_FN_COLLECTION) {
+            declared = emit_import_declarations(codegen, nodes[i]);
+        }
+    }
+    return declared;
+}
+
+bool Xvr_LLVMCodegenEnsureMain(Xvr_LLVMCodegen* codegen) {
+    if (!codegen || codegen->library_unit) {
+        return false;
+    }
+    return ensure_main_function(codegen);
+}
+
 bool Xvr_LLVMCodegenEmitAST(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* ast) {
     if (!codegen || !ast) {
         return false;
@@ -436,32 +1484,7 @@ bool Xvr_LLVMCodegenEmitAST(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* ast) {
     if (ast->type == XVR_AST_NODE_IMPORT) {
         Xvr_Literal* ident = &ast->import.identifier;
         if (ident->type == XVR_LITERAL_IDENTIFIER && ident->as.identifier.ptr) {
-            const char* module_name = ident->as.identifier.ptr->data;
-            char* module_path = NULL;
-            if (Xvr_ModuleResolverResolve(codegen->module_resolver, module_name,
-                                          &module_path)) {
-                Xvr_ASTNode** module_nodes = NULL;
-                int module_node_count = 0;
-                if (Xvr_ModuleResolverLoadModule(codegen->module_resolver,
-                                                 module_path, &module_nodes,
-                                                 &module_node_count)) {
-                    for (int i = 0; i < module_node_count; i++) {
-                        if (!Xvr_LLVMCodegenEmitAST(codegen, module_nodes[i])) {
-                            for (int j = i; j < module_node_count; j++) {
-                                Xvr_freeASTNode(module_nodes[j]);
-                            }
-                            free(module_nodes);
-                            free(module_path);
-                            return false;
-                        }
-                    }
-                    for (int i = 0; i < module_node_count; i++) {
-                        Xvr_freeASTNode(module_nodes[i]);
-                    }
-                    free(module_nodes);
-                }
-                free(module_path);
-            }
+            return import_module(codegen, ident->as.identifier.ptr->data);
         }
         return true;
     }
@@ -469,7 +1492,7 @@ bool Xvr_LLVMCodegenEmitAST(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* ast) {
     if (ast->type == XVR_AST_NODE_FN_COLLECTION) {
         bool result =
             Xvr_LLVMFunctionEmitterEmitCollection(codegen->fn_emitter, ast);
-        if (result) {
+        if (result && !codegen->library_unit) {
             ensure_main_function(codegen);
         }
         return result;
@@ -477,12 +1500,18 @@ bool Xvr_LLVMCodegenEmitAST(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* ast) {
 
     if (ast->type == XVR_AST_NODE_FN_DECL) {
         bool result = Xvr_LLVMFunctionEmitterEmit(codegen->fn_emitter, ast);
-        if (result) {
+        if (result && !codegen->library_unit) {
             ensure_main_function(codegen);
         }
         return result;
     }
 
+    /* a library's top-level statements belong to whoever imports it */
+    if (codegen->library_unit) {
+        codegen->skipped_statements++;
+        return true;
+    }
+
     if (!emit_main_function(codegen, ast)) {
         if (Xvr_LLVMContextHasError(codegen->context)) {
             set_error(codegen,
@@ -491,6 +1520,9 @@ bool Xvr_LLVMCodegenEmitAST(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* ast) {
         return false;
     }
 
+    if (codegen->entry_name && ast->type == XVR_AST_NODE_VAR_DECL) {
+        return share_repl_var(codegen, ast);
+    }
     return true;
 }
 
@@ -498,7 +1530,9 @@ char* Xvr_LLVMCodegenPrintIR(Xvr_LLVMCodegen* codegen, size_t* out_len) {
     if (!codegen || !out_len) {
         return NULL;
     }
-    finalize_main_function(codegen);
+    if (!prepare_module(codegen)) {
+        return NULL;
+    }
     return Xvr_LLVMModuleManagerPrintIR(codegen->module, out_len);
 }
 
@@ -510,6 +1544,184 @@ bool Xvr_LLVMCodegenWriteBitcode(Xvr_LLVMCodegen* codegen,
     return Xvr_LLVMModuleManagerWriteBitcode(codegen->module, filepath);
 }
 
+/* the resolver maps "name" to "<stdlib>/name.xvr", so the file name is
+ * what an importer asks for */
+static char* import_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    const char* name = slash ? slash + 1 : path;
+    size_t length = strlen(name);
+    if (length > 4 && strcmp(name + length - 4, ".xvr") == 0) {
+        length -= 4;
+    }
+    char* copy = (char*)malloc(length + 1);
+    if (copy) {
+        memcpy(copy, name, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+bool Xvr_LLVMCodegenWritePrecompiled(Xvr_LLVMCodegen* codegen,
+                                     const void* source, size_t source_size,
+                                     const char* output_path) {
+    if (!codegen || !source || !output_path) {
+        return false;
+    }
+    if (!codegen->library_unit) {
+        set_error(codegen, "only a library unit can be precompiled");
+        return false;
+    }
+    if (codegen->skipped_statements > 0) {
+        set_error(codegen,
+                  "module has top-level statements, only procs can be "
+                  "precompiled");
+        return false;
+    }
+    if (!Xvr_LLVMCodegenVerify(codegen)) {
+        return false;
+    }
+
+    char** names = (char**)calloc(codegen->import_count + 1, sizeof(char*));
+    if (!names) {
+        return false;
+    }
+    bool ok = true;
+    for (size_t i = 0; i < codegen->import_count && ok; i++) {
+        names[i] = import_name(codegen->imports[i]);
+        ok = names[i] != NULL;
+    }
+
+    char* write_error = NULL;
+    if (ok && !Xvr_LLVMPrecompiledWrite(codegen->module, source, source_size,
+                                        (const char* const*)names,
+                                        codegen->import_count, output_path,
+                                        &write_error)) {
+        set_error(codegen, write_error ? write_error : "write failed");
+        free(write_error);
+        ok = false;
+    }
+
+    for (size_t i = 0; i < codegen->import_count; i++) {
+        free(names[i]);
+    }
+    free(names);
+    return ok;
+}
+
+void* Xvr_LLVMCodegenEmitThinLTOBitcode(Xvr_LLVMCodegen* codegen,
+                                        size_t* out_size) {
+    if (!codegen || !out_size) {
+        return NULL;
+    }
+    if (!prepare_module(codegen)) {
+        return NULL;
+    }
+    void* bitcode =
+        Xvr_LLVMModuleManagerEmitSummaryBitcode(codegen->module, out_size);
+    if (!bitcode) {
+        set_error(codegen, "failed to write ThinLTO bitcode");
+    }
+    return bitcode;
+}
+
+bool Xvr_LLVMCodegenConfigureThinLink(Xvr_LLVMCodegen* codegen,
+                                      Xvr_LLVMThinLink* link) {
+    if (!codegen || !link) {
+        return false;
+    }
+    return Xvr_LLVMThinLinkSetTarget(
+               link, Xvr_LLVMTargetMachineGetCPU(codegen->target_machine),
+               Xvr_LLVMTargetMachineGetFeatures(codegen->target_machine)) &&
+           Xvr_LLVMThinLinkSetOptimizationLevel(link, codegen->level) &&
+           (codegen->codegen_jobs == 0 ||
+            Xvr_LLVMThinLinkSetJobs(link, codegen->codegen_jobs));
+}
+
+bool Xvr_LLVMCodegenVerify(Xvr_LLVMCodegen* codegen) {
+    if (!codegen) {
+        return false;
+    }
+
+    if (!prepare_module(codegen)) {
+        return false;
+    }
+
+    LLVMModuleRef module = Xvr_LLVMModuleManagerGetModule(codegen->module);
+    char* message = NULL;
+    if (LLVMVerifyModule(module, LLVMReturnStatusAction, &message)) {
+        char error_msg[1024];
+        snprintf(error_msg, sizeof(error_msg), "invalid IR: %s",
+                 message ? message : "module verification failed");
+        set_error(codegen, error_msg);
+        LLVMDisposeMessage(message);
+        codegen->ir_invalid = true;
+        return false;
+    }
+    LLVMDisposeMessage(message);
+    return true;
+}
+
+bool Xvr_LLVMCodegenRunOptimizer(Xvr_LLVMCodegen* codegen) {
+    if (!codegen || !codegen->optimizer) {
+        return false;
+    }
+
+    /* the pass pipelines assume verified IR, so check before handing over */
+    if (!Xvr_LLVMCodegenVerify(codegen)) {
+        return false;
+    }
+
+    /* at -O0 nothing would inline the runtime, so calls stay external */
+    if (codegen->level != XVR_LLVM_OPT_NONE && codegen->runtime_bitcode &&
+        !codegen->runtime_linked) {
+        char* link_error = NULL;
+        if (!Xvr_LLVMModuleManagerLinkBitcode(
+                codegen->module, codegen->runtime_bitcode, &link_error)) {
+            char error_msg[1024];
+            snprintf(error_msg, sizeof(error_msg), "runtime bitcode: %s",
+                     link_error ? link_error : "link failed");
+            free(link_error);
+            set_error(codegen, error_msg);
+            return false;
+        }
+        codegen->runtime_linked = true;
+        apply_target_attributes(codegen);
+    }
+
+    if (codegen->target_machine) {
+        Xvr_LLVMOptimizerSetTargetMachine(
+            codegen->optimizer,
+            Xvr_LLVMTargetMachineGetLLVMTargetMachine(codegen->target_machine));
+    }
+
+    /* passes may delete the block the builder points into */
+    LLVMClearInsertionPosition(
+        Xvr_LLVMIRBuilderGetLLVMBuilder(codegen->builder));
+
+    if (!Xvr_LLVMOptimizerRun(codegen->optimizer, codegen->module)) {
+        const char* message = Xvr_LLVMOptimizerGetError(codegen->optimizer);
+        char error_msg[1024];
+        snprintf(error_msg, sizeof(error_msg), "optimization failed: %s",
+                 message ? message : "unknown error");
+        set_error(codegen, error_msg);
+        return false;
+    }
+    return true;
+}
+
+bool Xvr_LLVMCodegenOptimize(Xvr_LLVMCodegen* codegen) {
+    if (!codegen) {
+        return false;
+    }
+    const Xvr_CompilerOptions* options =
+        Xvr_CompilerSessionGetOptions(codegen->session);
+    bool run_passes = codegen->level != XVR_LLVM_OPT_NONE ||
+                      options->passPipeline || options->profileGenerate ||
+                      options->profileUse;
+    return run_passes ? Xvr_LLVMCodegenRunOptimizer(codegen)
+                      : Xvr_LLVMCodegenVerify(codegen);
+}
+
 bool Xvr_LLVMCodegenWriteObjectFile(Xvr_LLVMCodegen* codegen,
                                     const char* filepath, int filetype) {
     if (!codegen || !filepath) {
@@ -518,22 +1730,124 @@ bool Xvr_LLVMCodegenWriteObjectFile(Xvr_LLVMCodegen* codegen,
     if (!codegen->target_machine) {
         return false;
     }
-    finalize_main_function(codegen);
+    if (!prepare_module(codegen)) {
+        return false;
+    }
     return Xvr_LLVMTargetMachineEmitToFile(codegen->target_machine,
                                            codegen->module, filepath, filetype);
 }
 
-bool Xvr_LLVMCodegenExecuteJIT(Xvr_LLVMCodegen* codegen) {
-    if (!codegen) {
+void* Xvr_LLVMCodegenEmitObject(Xvr_LLVMCodegen* codegen, size_t* out_size) {
+    if (!codegen || !out_size || !codegen->target_machine) {
+        return NULL;
+    }
+    if (!prepare_module(codegen)) {
+        return NULL;
+    }
+    return Xvr_LLVMTargetMachineEmitToMemory(codegen->target_machine,
+                                             codegen->module, out_size);
+}
+
+void** Xvr_LLVMCodegenEmitObjects(Xvr_LLVMCodegen* codegen, bool relocatable,
+                                  size_t** out_sizes, size_t* out_count,
+                                  Xvr_LLVMCodegenTiming* out_timing) {
+    if (!codegen || !out_sizes || !out_count || !codegen->target_machine) {
+        return NULL;
+    }
+    if (!prepare_module(codegen)) {
+        return NULL;
+    }
+
+    if (codegen->codegen_jobs > 1) {
+        void** objects = Xvr_LLVMTargetMachineEmitPartitioned(
+            codegen->target_machine, codegen->module, codegen->codegen_jobs,
+            relocatable, out_sizes, out_timing);
+        if (!objects) {
+            set_error(codegen, "failed to emit object code");
+            return NULL;
+        }
+        *out_count = codegen->codegen_jobs;
+        return objects;
+    }
+
+    void** objects = (void**)calloc(1, sizeof(void*));
+    size_t* sizes = (size_t*)calloc(1, sizeof(size_t));
+    if (!objects || !sizes) {
+        free(objects);
+        free(sizes);
+        set_error(codegen, "out of memory");
+        return NULL;
+    }
+    double start = get_time_ms();
+    objects[0] = Xvr_LLVMTargetMachineEmitToMemory(codegen->target_machine,
+                                                   codegen->module, &sizes[0]);
+    if (!objects[0]) {
+        free(objects);
+        free(sizes);
+        set_error(codegen, "failed to emit object code");
+        return NULL;
+    }
+    if (out_timing) {
+        out_timing->wall_ms = get_time_ms() - start;
+        out_timing->cpu_ms = out_timing->wall_ms;
+        out_timing->jobs = 1;
+    }
+    *out_sizes = sizes;
+    *out_count = 1;
+    return objects;
+}
+
+bool Xvr_LLVMCodegenAddToJIT(Xvr_LLVMCodegen* codegen, Xvr_LLVMJIT* jit) {
+    if (!codegen || !jit) {
         return false;
     }
 
     LLVMModuleRef module = Xvr_LLVMModuleManagerGetModule(codegen->module);
-    if (!module) {
+    if (!module || !prepare_module(codegen)) {
+        return false;
+    }
+
+    if (!Xvr_LLVMJITAddModule(jit, module)) {
+        set_error(codegen, Xvr_LLVMJITGetError(jit));
+        return false;
+    }
+    return true;
+}
+
+bool Xvr_LLVMCodegenExecuteJIT(Xvr_LLVMCodegen* codegen,
+                               Xvr_LLVMJITStats* out_stats) {
+    if (!codegen) {
+        return false;
+    }
+
+    Xvr_LLVMJITStats stats = {0.0, 0.0, 0};
+    double setup_start = get_time_ms();
+
+    Xvr_LLVMJIT* jit = Xvr_LLVMJITCreate();
+    if (!jit) {
+        set_error(codegen, "failed to create JIT for host target");
+        return false;
+    }
+
+    if (!Xvr_LLVMCodegenAddToJIT(codegen, jit)) {
+        Xvr_LLVMJITDestroy(jit);
         return false;
     }
 
-    return false;
+    stats.compile_ms = get_time_ms() - setup_start;
+
+    if (!Xvr_LLVMJITRunMain(jit, &stats)) {
+        set_error(codegen, Xvr_LLVMJITGetError(jit));
+        Xvr_LLVMJITDestroy(jit);
+        return false;
+    }
+
+    Xvr_LLVMJITDestroy(jit);
+
+    if (out_stats) {
+        *out_stats = stats;
+    }
+    return true;
 }
 
 bool Xvr_LLVMCodegenHasError(Xvr_LLVMCodegen* codegen) {
@@ -35,9 +35,13 @@ SOFTWARE.
 #include "xvr_llvm_expression_emitter.h"
 #include "xvr_llvm_function_emitter.h"
 #include "xvr_llvm_ir_builder.h"
+#include "xvr_llvm_jit.h"
+#include "xvr_llvm_linker.h"
 #include "xvr_llvm_module_manager.h"
 #include "xvr_llvm_optimizer.h"
+#include "xvr_llvm_precompiled.h"
 #include "xvr_llvm_target.h"
+#include "xvr_llvm_thinlto.h"
 #include "xvr_llvm_type_mapper.h"
 
 #ifdef __cplusplus
@@ -45,19 +49,188 @@ extern "C" {
 #endif
 
 typedef struct Xvr_LLVMCodegen Xvr_LLVMCodegen;
+typedef struct Xvr_CompilerSession Xvr_CompilerSession;
 
 Xvr_LLVMCodegen* Xvr_LLVMCodegenCreate(const char* module_name);
+
+/**
+ * @brief creates a code generator that takes its target, assembly syntax,
+ * optimization level, optimizer knobs and type table from `session` and
+ * reports import syntax errors to it; NULL is Xvr_LLVMCodegenCreate
+ */
+Xvr_LLVMCodegen* Xvr_LLVMCodegenCreateWithSession(
+    const char* module_name, Xvr_CompilerSession* session);
 void Xvr_LLVMCodegenDestroy(Xvr_LLVMCodegen* codegen);
 
+/**
+ * @brief loads the session's profileUse and appends its passPipeline,
+ * which Xvr_LLVMCodegenCreateWithSession leaves out since they can fail
+ * @return false with an error set
+ */
+bool Xvr_LLVMCodegenApplySessionPipeline(Xvr_LLVMCodegen* codegen);
+
 bool Xvr_LLVMCodegenSetOptimizationLevel(Xvr_LLVMCodegen* codegen,
                                          Xvr_LLVMOptimizationLevel level);
+bool Xvr_LLVMCodegenSetLoopVectorize(Xvr_LLVMCodegen* codegen, bool enable);
+bool Xvr_LLVMCodegenSetSLPVectorize(Xvr_LLVMCodegen* codegen, bool enable);
+bool Xvr_LLVMCodegenSetLoopUnrolling(Xvr_LLVMCodegen* codegen, bool enable);
+bool Xvr_LLVMCodegenSetInlinerThreshold(Xvr_LLVMCodegen* codegen,
+                                        int threshold);
+
+/**
+ * @brief profile-guided optimization, see Xvr_LLVMOptimizerSetProfileGenerate
+ * and Xvr_LLVMOptimizerSetProfileUse
+ * @return false with an error set if the profile cannot be used
+ */
+bool Xvr_LLVMCodegenSetProfileGenerate(Xvr_LLVMCodegen* codegen,
+                                       const char* raw_profile_path);
+bool Xvr_LLVMCodegenSetProfileUse(Xvr_LLVMCodegen* codegen,
+                                  const char* profile_path);
+
+/**
+ * @brief appends a textual pass pipeline fragment, see
+ * Xvr_LLVMOptimizerAddPass
+ * @return false with an "invalid pass pipeline" error set if it does not
+ * parse
+ */
+bool Xvr_LLVMCodegenAddPasses(Xvr_LLVMCodegen* codegen, const char* pipeline);
+bool Xvr_LLVMCodegenAddStandardPasses(Xvr_LLVMCodegen* codegen);
+
+/**
+ * @brief the expanded pipeline Xvr_LLVMCodegenRunOptimizer will run
+ * @return string owned by the codegen, or NULL with an error set
+ */
+const char* Xvr_LLVMCodegenGetPipeline(Xvr_LLVMCodegen* codegen);
+
+/**
+ * @brief sets the bitcode library linked in before optimizing at -O1 and up
+ * defaults to Xvr_LLVMLinkerFindRuntimeBitcode(), NULL keeps runtime calls
+ * external
+ */
+bool Xvr_LLVMCodegenSetRuntimeBitcode(Xvr_LLVMCodegen* codegen,
+                                      const char* path);
+
+/**
+ * @brief compiles imports separately for a ThinLTO link
+ * imported procs are only declared and each resolved module is recorded
+ * (Xvr_LLVMCodegenGetImport) so the caller can compile it as a library
+ * unit of its own; the level's pipeline becomes its ThinLTO pre-link half
+ */
+bool Xvr_LLVMCodegenSetThinLTO(Xvr_LLVMCodegen* codegen, bool enable);
 
+/**
+ * @brief compiles imports separately without ThinLTO
+ * imports are declared and recorded as with Xvr_LLVMCodegenSetThinLTO, the
+ * pipeline stays the level's own; for programs linked from native objects
+ */
+bool Xvr_LLVMCodegenSetSeparateImports(Xvr_LLVMCodegen* codegen,
+                                       bool enable);
+
+/**
+ * @brief splits object emission across `jobs` threads (-j), 0 or 1 emits
+ * the module in one piece. also caps the backend threads of a thin link
+ * configured from this codegen and the threads parsing imports
+ */
+bool Xvr_LLVMCodegenSetCodegenJobs(Xvr_LLVMCodegen* codegen, unsigned jobs);
+
+/**
+ * @brief compiles a module that is imported rather than run
+ * only procs are emitted and no main is created, top-level statements are
+ * left to the importing program. imports are declared as with ThinLTO
+ */
+bool Xvr_LLVMCodegenSetLibraryUnit(Xvr_LLVMCodegen* codegen, bool enable);
+
+/**
+ * @brief resolves and parses everything the program's top-level imports
+ * need before emission starts, so independent modules are parsed
+ * concurrently instead of one by one as their imports are reached
+ * (see Xvr_ModuleGraph). optional, imports are loaded on demand otherwise
+ */
+bool Xvr_LLVMCodegenPreloadImports(Xvr_LLVMCodegen* codegen,
+                                   Xvr_ASTNode** nodes, int count);
+
+/**
+ * @brief declares the procs among `nodes` without emitting them
+ * for procs another unit of the same program defines; other nodes are
+ * ignored
+ */
+bool Xvr_LLVMCodegenDeclareProcs(Xvr_LLVMCodegen* codegen,
+                                 Xvr_ASTNode** nodes, int count);
+
+/**
+ * @brief gives a program its main even if it emits no statements, for a
+ * unit whose procs are all compiled elsewhere; library units have none
+ */
+bool Xvr_LLVMCodegenEnsureMain(Xvr_LLVMCodegen* codegen);
+
+/**
+ * @brief a top-level variable that outlives the REPL entry declaring it,
+ * kept in the global `symbol`; `type` spells the global's value type
+ */
+typedef struct {
+    char* name;
+    char* symbol;
+    char* type;
+    Xvr_LiteralType var_type;
+    int array_count;
+} Xvr_LLVMReplVar;
+
+/**
+ * @brief compiles one entry of a REPL session (see Xvr_LLVMRepl)
+ * top-level statements go into the function `entry` instead of main, which
+ * loads `vars` from their globals as it starts. when it returns, those and
+ * the top-level variables the entry declares are stored back to globals
+ */
+bool Xvr_LLVMCodegenSetReplEntry(Xvr_LLVMCodegen* codegen, const char* entry,
+                                 const Xvr_LLVMReplVar* vars, size_t count);
+
+/**
+ * @brief the top-level variables a REPL entry declared, each defined as a
+ * global of its module; variables of a type no global can carry stay local
+ * @return array owned by the codegen, NULL if there are none
+ */
+const Xvr_LLVMReplVar* Xvr_LLVMCodegenGetReplVars(Xvr_LLVMCodegen* codegen,
+                                                  size_t* out_count);
+
+/**
+ * @brief resolved paths of every imported module, nested imports included,
+ * in import order and without duplicates; owned by the codegen. with
+ * separate-module imports these are the modules left to compile
+ */
+size_t Xvr_LLVMCodegenGetImportCount(Xvr_LLVMCodegen* codegen);
+const char* Xvr_LLVMCodegenGetImport(Xvr_LLVMCodegen* codegen, size_t index);
+
+/**
+ * @brief verifies the module, then runs the pipeline for the current level
+ * @return false with an error set if the IR is malformed or a pass fails
+ */
 bool Xvr_LLVMCodegenRunOptimizer(Xvr_LLVMCodegen* codegen);
 
+/**
+ * @brief finalizes main and runs the LLVM module verifier
+ * @return false with an "invalid IR" error set if verification fails
+ */
+bool Xvr_LLVMCodegenVerify(Xvr_LLVMCodegen* codegen);
+
+/**
+ * @brief Xvr_LLVMCodegenRunOptimizer when there are passes to run (-O1 and
+ * up, or the session's pipeline and profiles), Xvr_LLVMCodegenVerify at
+ * plain -O0
+ */
+bool Xvr_LLVMCodegenOptimize(Xvr_LLVMCodegen* codegen);
+
+/**
+ * @brief retargets the codegen, rebuilding its target machine
+ * a CPU of "native" selects the host CPU together with its features;
+ * features are a comma separated "+feature,-feature" list
+ * @return false, keeping the previous target, if no machine can be built
+ */
 bool Xvr_LLVMCodegenSetTargetTriple(Xvr_LLVMCodegen* codegen,
                                     const char* triple);
 
 bool Xvr_LLVMCodegenSetTargetCPU(Xvr_LLVMCodegen* codegen, const char* cpu);
+bool Xvr_LLVMCodegenSetTargetFeatures(Xvr_LLVMCodegen* codegen,
+                                      const char* features);
 
 bool Xvr_LLVMCodegenEmitAST(Xvr_LLVMCodegen* codegen, Xvr_ASTNode* ast);
 
@@ -69,7 +242,68 @@ bool Xvr_LLVMCodegenWriteBitcode(Xvr_LLVMCodegen* codegen,
 bool Xvr_LLVMCodegenWriteObjectFile(Xvr_LLVMCodegen* codegen,
                                     const char* filepath, int filetype);
 
-bool Xvr_LLVMCodegenExecuteJIT(Xvr_LLVMCodegen* codegen);
+/**
+ * @brief writes a library unit as a precompiled module (.xvrm), see
+ * Xvr_LLVMPrecompiledWrite. importers link it instead of parsing the
+ * module for as long as `source` is what the .xvr file holds
+ * @return false with an error set if the module has top-level statements
+ * or the IR does not verify
+ */
+bool Xvr_LLVMCodegenWritePrecompiled(Xvr_LLVMCodegen* codegen,
+                                     const void* source, size_t source_size,
+                                     const char* output_path);
+
+/**
+ * @brief emits the module as a native object into memory
+ * @param codegen codegen holding a finished module
+ * @param out_size receives the object size in bytes
+ * @return malloc'd object bytes (caller frees), or NULL on failure
+ */
+void* Xvr_LLVMCodegenEmitObject(Xvr_LLVMCodegen* codegen, size_t* out_size);
+
+/**
+ * @brief emits the module as one native object per codegen job
+ * @param relocatable keep local symbols local, for objects that are merged
+ * into one relocatable object rather than linked into an executable
+ * @param out_sizes receives a malloc'd array of object sizes
+ * @param out_count receives the number of objects
+ * @param out_timing receives the emission time, may be NULL
+ * @return malloc'd array of malloc'd objects (caller frees), or NULL with
+ * an error set
+ */
+void** Xvr_LLVMCodegenEmitObjects(Xvr_LLVMCodegen* codegen, bool relocatable,
+                                  size_t** out_sizes, size_t* out_count,
+                                  Xvr_LLVMCodegenTiming* out_timing);
+
+/**
+ * @brief emits the module as ThinLTO bitcode (summary and hash included)
+ * @param out_size receives the bitcode size in bytes
+ * @return malloc'd bitcode (caller frees), or NULL with an error set
+ */
+void* Xvr_LLVMCodegenEmitThinLTOBitcode(Xvr_LLVMCodegen* codegen,
+                                        size_t* out_size);
+
+/**
+ * @brief gives a thin link this codegen's CPU, features and level
+ */
+bool Xvr_LLVMCodegenConfigureThinLink(Xvr_LLVMCodegen* codegen,
+                                      Xvr_LLVMThinLink* link);
+
+/**
+ * @brief copies the finished module into an engine that outlives the
+ * codegen, for a session whose modules resolve each other by symbol
+ * @return false with an error set if the engine rejects it
+ */
+bool Xvr_LLVMCodegenAddToJIT(Xvr_LLVMCodegen* codegen, Xvr_LLVMJIT* jit);
+
+/**
+ * @brief runs the module's main in-process through ORC LLJIT
+ * @param codegen codegen holding a finished module
+ * @param out_stats optional compile/execute timing and main's return value
+ * @return true if main ran, false with an error set otherwise
+ */
+bool Xvr_LLVMCodegenExecuteJIT(Xvr_LLVMCodegen* codegen,
+                               Xvr_LLVMJITStats* out_stats);
 
 bool Xvr_LLVMCodegenHasError(Xvr_LLVMCodegen* codegen);
 const char* Xvr_LLVMCodegenGetError(Xvr_LLVMCodegen* codegen);
@@ -59,6 +59,14 @@ void Xvr_LLVMContextDestroy(Xvr_LLVMContext* ctx) {
     free(ctx);
 }
 
+void Xvr_LLVMContextAbandon(Xvr_LLVMContext* ctx) {
+    if (!ctx) {
+        return;
+    }
+    free(ctx->error_message);
+    free(ctx);
+}
+
 LLVMContextRef Xvr_LLVMContextGetLLVMContext(Xvr_LLVMContext* ctx) {
     if (!ctx) {
         return NULL;
@@ -69,6 +69,15 @@ Xvr_LLVMContext* Xvr_LLVMContextCreate(void);
  */
 void Xvr_LLVMContextDestroy(Xvr_LLVMContext* ctx);
 
+/**
+ * @brief Frees the wrapper but leaves the LLVM context and its modules
+ * @param ctx Context to release (can be NULL)
+ *
+ * For a context holding a module that failed verification, which LLVM
+ * can't tear down
+ */
+void Xvr_LLVMContextAbandon(Xvr_LLVMContext* ctx);
+
 /**
  * @brief Gets the underlying LLVM context reference
  * @param ctx Our context wrapper
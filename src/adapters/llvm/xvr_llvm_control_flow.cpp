@@ -554,6 +554,19 @@ bool Xvr_LLVMControlFlowEmitFor(Xvr_LLVMControlFlow* cf,
     return true;
 }
 
+/* code after a break or continue is unreachable but still has to land in a
+ * block of its own, otherwise it trails the branch terminator */
+static void begin_dead_block(Xvr_LLVMControlFlow* cf) {
+    LLVMValueRef current_fn =
+        Xvr_LLVMExpressionEmitterGetCurrentFunction(cf->expr_emitter);
+    if (!current_fn) {
+        return;
+    }
+    LLVMBasicBlockRef dead = Xvr_LLVMIRBuilderCreateBlockInFunction(
+        cf->builder, current_fn, "unreachable");
+    Xvr_LLVMIRBuilderSetInsertPoint(cf->builder, dead);
+}
+
 bool Xvr_LLVMControlFlowEmitBreak(Xvr_LLVMControlFlow* cf) {
     if (!cf) {
         set_error(cf, "internal error: null pointer passed to EmitBreak");
@@ -571,6 +584,7 @@ bool Xvr_LLVMControlFlowEmitBreak(Xvr_LLVMControlFlow* cf) {
 
     LLVMBasicBlockRef end_block = cf->loop_end_stack[cf->loop_stack_depth - 1];
     Xvr_LLVMIRBuilderCreateBr(cf->builder, end_block);
+    begin_dead_block(cf);
     return true;
 }
 
@@ -592,6 +606,7 @@ bool Xvr_LLVMControlFlowEmitContinue(Xvr_LLVMControlFlow* cf) {
     LLVMBasicBlockRef cond_block =
         cf->loop_cond_stack[cf->loop_stack_depth - 1];
     Xvr_LLVMIRBuilderCreateBr(cf->builder, cond_block);
+    begin_dead_block(cf);
     return true;
 }
 
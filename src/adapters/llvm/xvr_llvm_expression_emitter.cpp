@@ -58,6 +58,7 @@ struct Xvr_LLVMExpressionEmitter {
     Xvr_LLVMTypeMapper* type_mapper;
     Xvr_LLVMControlFlow* control_flow;
     Xvr_LLVMCastEmitter* cast_emitter;
+    Xvr_TypeTable* type_table;
     void* fn_emitter;
 };
 
@@ -111,6 +112,14 @@ void Xvr_LLVMExpressionEmitterSetControlFlow(Xvr_LLVMExpressionEmitter* emitter,
     emitter->control_flow = cf;
 }
 
+void Xvr_LLVMExpressionEmitterSetTypeTable(Xvr_LLVMExpressionEmitter* emitter,
+                                           Xvr_TypeTable* table) {
+    if (!emitter) {
+        return;
+    }
+    emitter->type_table = table;
+}
+
 LLVMValueRef Xvr_LLVMExpressionEmitterGetCurrentFunction(
     Xvr_LLVMExpressionEmitter* emitter) {
     if (!emitter || !emitter->fn_emitter) {
@@ -796,14 +805,12 @@ LLVMValueRef Xvr_LLVMExpressionEmitterEmitBinary(
                         LLVMTypeKind kind = LLVMGetTypeKind(target_type);
 
                         if (kind == LLVMPointerTypeKind) {
-                            LLVMTypeRef elem_type = NULL;
-                            LLVMTypeRef alloc_type =
-                                LLVMGetAllocatedType(target_value);
-                            if (alloc_type) {
-                                elem_type = alloc_type;
-                            } else {
-                                elem_type = LLVMGetElementType(target_type);
-                            }
+                            /* only an alloca has an allocated type, a string
+                             * constant is a GEP */
+                            LLVMTypeRef elem_type =
+                                LLVMIsAAllocaInst(target_value)
+                                    ? LLVMGetAllocatedType(target_value)
+                                    : LLVMGetElementType(target_type);
                             if (elem_type && LLVMGetTypeKind(elem_type) ==
                                                  LLVMArrayTypeKind) {
                                 unsigned elem_count =
@@ -817,7 +824,8 @@ LLVMValueRef Xvr_LLVMExpressionEmitterEmitBinary(
                                 emitter->builder);
                             const char* len_fn_name = "xvr_str_len";
                             LLVMTypeRef str_len_param_types[] = {
-                                LLVMInt8TypeInContext(ctx)};
+                                LLVMPointerType(LLVMInt8TypeInContext(ctx),
+                                                0)};
                             LLVMTypeRef len_fn_type = LLVMFunctionType(
                                 LLVMInt32TypeInContext(ctx),
                                 str_len_param_types, 1, false);
@@ -1535,12 +1543,7 @@ static LLVMValueRef emit_printf(Xvr_LLVMExpressionEmitter* emitter,
                 LLVMValueRef fmt_global =
                     LLVMBuildGlobalStringPtr(llvm_builder, fmt_str, "fmt_str");
                 LLVMValueRef all_args[2] = {fmt_global, print_arg};
-                LLVMTypeRef printf_param_types[] = {
-                    LLVMPointerType(LLVMInt8TypeInContext(llvm_ctx), 0),
-                    arg_type};
-                LLVMTypeRef printf_type = LLVMFunctionType(
-                    LLVMInt32TypeInContext(llvm_ctx),
-                    printf_param_types, 2, true);
+                LLVMTypeRef printf_type = LLVMGlobalGetValueType(printf_fn);
                 LLVMBuildCall2(llvm_builder, printf_type, printf_fn, all_args,
                                2, "printf_call");
             }
@@ -1620,36 +1623,18 @@ static LLVMValueRef emit_printf(Xvr_LLVMExpressionEmitter* emitter,
                     }
                 }
 
-                LLVMTypeRef* param_types =
-                    (LLVMTypeRef*)malloc(sizeof(LLVMTypeRef) * (arg_count + 1));
-                param_types[0] =
-                    LLVMPointerType(LLVMInt8TypeInContext(llvm_ctx), 0);
-                for (int i = 0; i < arg_count; i++) {
-                    LLVMValueRef arg = call_args[i];
-                    LLVMTypeRef arg_type = LLVMTypeOf(arg);
-                    if (LLVMGetTypeKind(arg_type) == LLVMFloatTypeKind) {
-                        param_types[i + 1] = LLVMDoubleTypeInContext(llvm_ctx);
-                    } else {
-                        param_types[i + 1] = arg_type;
-                    }
-                }
-
-                LLVMTypeRef printf_type =
-                    LLVMFunctionType(LLVMInt32TypeInContext(llvm_ctx),
-                                     param_types, arg_count + 1, true);
+                LLVMTypeRef printf_type = LLVMGlobalGetValueType(printf_fn);
                 LLVMBuildCall2(llvm_builder, printf_type, printf_fn, all_args,
                                arg_count + 1, "printf_call");
 
                 free(all_args);
-                free(param_types);
                 free(printf_fmt);
                 free(arg_types);
                 XvrFormatStringFree(fmt);
             } else {
                 LLVMValueRef fmt_global =
                     LLVMBuildGlobalStringPtr(llvm_builder, "%s", "fmt_str");
-                LLVMTypeRef printf_type = LLVMFunctionType(
-                    LLVMInt32TypeInContext(llvm_ctx), NULL, 0, true);
+                LLVMTypeRef printf_type = LLVMGlobalGetValueType(printf_fn);
                 LLVMBuildCall2(llvm_builder, printf_type, printf_fn,
                                &fmt_global, 1, "printf_call");
                 if (fmt) {
@@ -1676,34 +1661,16 @@ static LLVMValueRef emit_printf(Xvr_LLVMExpressionEmitter* emitter,
                     }
                 }
 
-                LLVMTypeRef* param_types =
-                    (LLVMTypeRef*)malloc(sizeof(LLVMTypeRef) * (arg_count + 1));
-                param_types[0] =
-                    LLVMPointerType(LLVMInt8TypeInContext(llvm_ctx), 0);
-                for (int i = 0; i < arg_count; i++) {
-                    LLVMValueRef arg = call_args[i];
-                    LLVMTypeRef arg_type = LLVMTypeOf(arg);
-                    if (LLVMGetTypeKind(arg_type) == LLVMFloatTypeKind) {
-                        param_types[i + 1] = LLVMDoubleTypeInContext(llvm_ctx);
-                    } else {
-                        param_types[i + 1] = arg_type;
-                    }
-                }
-
-                LLVMTypeRef printf_type =
-                    LLVMFunctionType(LLVMInt32TypeInContext(llvm_ctx),
-                                     param_types, arg_count + 1, true);
+                LLVMTypeRef printf_type = LLVMGlobalGetValueType(printf_fn);
                 LLVMBuildCall2(llvm_builder, printf_type, printf_fn, all_args,
                                arg_count + 1, "printf_call");
 
-                free(param_types);
                 free(all_args);
             } else {
                 LLVMValueRef fmt_global = LLVMBuildGlobalStringPtr(
                     llvm_builder, format_str ? format_str : "%s", "fmt_str");
                 if (has_format_string || !format_node) {
-                    LLVMTypeRef printf_type = LLVMFunctionType(
-                        LLVMInt32TypeInContext(llvm_ctx), NULL, 0, true);
+                    LLVMTypeRef printf_type = LLVMGlobalGetValueType(printf_fn);
                     LLVMBuildCall2(llvm_builder, printf_type, printf_fn,
                                    &fmt_global, 1, "printf_call");
                 } else {
@@ -1711,13 +1678,8 @@ static LLVMValueRef emit_printf(Xvr_LLVMExpressionEmitter* emitter,
                         Xvr_LLVMExpressionEmitterEmit(emitter, format_node);
                     if (arg_val) {
                         LLVMValueRef all_args[2] = {fmt_global, arg_val};
-                        LLVMTypeRef printf_param_types[] = {
-                            LLVMPointerType(LLVMInt8TypeInContext(llvm_ctx),
-                                            0),
-                            LLVMTypeOf(arg_val)};
-                        LLVMTypeRef printf_type = LLVMFunctionType(
-                            LLVMInt32TypeInContext(llvm_ctx),
-                            printf_param_types, 2, true);
+                        LLVMTypeRef printf_type =
+                            LLVMGlobalGetValueType(printf_fn);
                         LLVMBuildCall2(llvm_builder, printf_type, printf_fn,
                                        all_args, 2, "printf_call");
                     }
@@ -1851,12 +1813,7 @@ static LLVMValueRef emit_printfln(Xvr_LLVMExpressionEmitter* emitter,
             LLVMValueRef fmt_global =
                 LLVMBuildGlobalStringPtr(llvm_builder, fmt_str, "fmt_str");
             LLVMValueRef all_args[2] = {fmt_global, print_arg};
-            LLVMTypeRef println_param_types[] = {
-                LLVMPointerType(LLVMInt8TypeInContext(llvm_ctx), 0),
-                arg_type};
-            LLVMTypeRef printf_type = LLVMFunctionType(
-                LLVMInt32TypeInContext(llvm_ctx),
-                println_param_types, 2, true);
+            LLVMTypeRef printf_type = LLVMGlobalGetValueType(printf_fn);
             LLVMBuildCall2(llvm_builder, printf_type, printf_fn, all_args, 2,
                            "printf_call");
         }
@@ -2010,38 +1967,11 @@ static LLVMValueRef emit_printfln(Xvr_LLVMExpressionEmitter* emitter,
             }
         }
 
-        LLVMTypeRef* param_types =
-            (LLVMTypeRef*)malloc(sizeof(LLVMTypeRef) * (arg_count + 1));
-        if (!param_types) {
-            Xvr_LLVMContextSetError(emitter->context,
-                                    "println: memory allocation failed");
-            free(all_args);
-            free(printf_fmt_final);
-            free(printf_fmt_with_newline);
-            free(arg_types);
-            XvrFormatStringFree(fmt);
-            free(call_args);
-            return NULL;
-        }
-
-        param_types[0] = LLVMPointerType(LLVMInt8TypeInContext(llvm_ctx), 0);
-        for (int i = 0; i < arg_count; i++) {
-            LLVMValueRef arg = call_args[i];
-            LLVMTypeRef arg_type = LLVMTypeOf(arg);
-            if (LLVMGetTypeKind(arg_type) == LLVMFloatTypeKind) {
-                param_types[i + 1] = LLVMDoubleTypeInContext(llvm_ctx);
-            } else {
-                param_types[i + 1] = arg_type;
-            }
-        }
-
-        LLVMTypeRef printf_type = LLVMFunctionType(
-            LLVMInt32TypeInContext(llvm_ctx), param_types, arg_count + 1, true);
+        LLVMTypeRef printf_type = LLVMGlobalGetValueType(printf_fn);
         LLVMBuildCall2(llvm_builder, printf_type, printf_fn, all_args,
                        arg_count + 1, "printf_call");
 
         free(all_args);
-        free(param_types);
         free(printf_fmt);
         free(printf_fmt_final);
         free(printf_fmt_with_newline);
@@ -2072,8 +2002,7 @@ static LLVMValueRef emit_printfln(Xvr_LLVMExpressionEmitter* emitter,
         }
         LLVMValueRef fmt_global =
             LLVMBuildGlobalStringPtr(llvm_builder, final_fmt, "fmt_str");
-        LLVMTypeRef printf_type =
-            LLVMFunctionType(LLVMInt32TypeInContext(llvm_ctx), NULL, 0, true);
+        LLVMTypeRef printf_type = LLVMGlobalGetValueType(printf_fn);
         LLVMBuildCall2(llvm_builder, printf_type, printf_fn, &fmt_global, 1,
                        "printf_call");
         free(final_fmt);
@@ -3827,6 +3756,7 @@ static LLVMValueRef emit_unary_op(Xvr_LLVMExpressionEmitter* emitter,
         if (!callee) {
             callee = LLVMAddFunction(module, "printf", printf_type);
         }
+        printf_type = LLVMGlobalGetValueType(callee);
 
         /* Create format string based on operand type */
         LLVMTypeRef operand_type = LLVMTypeOf(operand);
@@ -4156,7 +4086,11 @@ LLVMValueRef Xvr_LLVMExpressionEmitterEmit(Xvr_LLVMExpressionEmitter* emitter,
             source_literal_type = XVR_LITERAL_STRING;
         }
 
-        Xvr_Type* from_type = Xvr_TypeGetFromLiteral(source_literal_type);
+        Xvr_Type* from_type =
+            emitter->type_table
+                ? Xvr_TypeTableGetFromLiteral(emitter->type_table,
+                                              source_literal_type)
+                : Xvr_TypeGetFromLiteral(source_literal_type);
 
         Xvr_LiteralType target_type;
         if (target_type_literal.type == XVR_LITERAL_TYPE) {
@@ -4164,7 +4098,10 @@ LLVMValueRef Xvr_LLVMExpressionEmitterEmit(Xvr_LLVMExpressionEmitter* emitter,
         } else {
             target_type = target_type_literal.type;
         }
-        Xvr_Type* to_type = Xvr_TypeGetFromLiteral(target_type);
+        Xvr_Type* to_type =
+            emitter->type_table
+                ? Xvr_TypeTableGetFromLiteral(emitter->type_table, target_type)
+                : Xvr_TypeGetFromLiteral(target_type);
 
         if (!from_type || !to_type) {
             return NULL;
@@ -39,6 +39,7 @@ extern "C" {
 
 typedef struct Xvr_LLVMControlFlow Xvr_LLVMControlFlow;
 typedef struct Xvr_BuiltinRegistry Xvr_BuiltinRegistry;
+typedef struct Xvr_TypeTable Xvr_TypeTable;
 
 /**
  * @brief Opaque structure for expression emitter
@@ -82,6 +83,14 @@ void Xvr_LLVMExpressionEmitterSetFnEmitter(Xvr_LLVMExpressionEmitter* emitter,
 void Xvr_LLVMExpressionEmitterSetControlFlow(Xvr_LLVMExpressionEmitter* emitter,
                                              Xvr_LLVMControlFlow* cf);
 
+/**
+ * @brief Sets the type table casts intern their types in
+ * @param emitter Expression emitter
+ * @param table Type table, NULL for the process-wide one
+ */
+void Xvr_LLVMExpressionEmitterSetTypeTable(Xvr_LLVMExpressionEmitter* emitter,
+                                           Xvr_TypeTable* table);
+
 /**
  * @brief Sets the builtin registry reference
  * @param emitter Expression emitter
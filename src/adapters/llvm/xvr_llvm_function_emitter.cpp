@@ -303,27 +303,26 @@ static bool check_return_type_compatibility(Xvr_LLVMFunctionEmitter* emitter,
     return true;
 }
 
-static bool emit_function_body(Xvr_LLVMFunctionEmitter* emitter,
-                               Xvr_NodeFnDecl* fn_decl) {
-    Xvr_LLVMIRBuilder* builder = emitter->builder;
-    Xvr_LLVMExpressionEmitter* expr_emitter = emitter->expr_emitter;
-    Xvr_LLVMModuleManager* module = emitter->module;
-    Xvr_LLVMContext* context = emitter->context;
-
-    if (!fn_decl->block) {
-        Xvr_LLVMContextSetError(context, "function has no body");
-        return false;
-    }
-
-    clear_local_vars(emitter);
+typedef struct {
+    LLVMTypeRef return_type;
+    LLVMTypeRef function_type;
+    bool is_void;
+    const char* name;
+    int param_count;
+    LLVMTypeRef param_types[32];
+    const char* param_names[32];
+    Xvr_LiteralType param_types_xvr[32];
+} Xvr_LLVMSignature;
 
-    Xvr_NodeBlock* block = (Xvr_NodeBlock*)&fn_decl->block->block;
+static bool resolve_signature(Xvr_LLVMFunctionEmitter* emitter,
+                              Xvr_NodeFnDecl* fn_decl,
+                              Xvr_LLVMSignature* sig) {
+    Xvr_LLVMContext* context = emitter->context;
     LLVMContextRef llvm_ctx = Xvr_LLVMContextGetLLVMContext(context);
 
-    LLVMTypeRef return_type = LLVMInt32TypeInContext(llvm_ctx);
-    bool is_void_function = false;
-    bool has_explicit_return = false;
-    Xvr_LiteralType declared_return_type = XVR_LITERAL_INTEGER;
+    sig->return_type = LLVMInt32TypeInContext(llvm_ctx);
+    sig->is_void = false;
+    sig->param_count = 0;
 
     if (fn_decl->returns &&
         fn_decl->returns->type == XVR_AST_NODE_FN_COLLECTION) {
@@ -333,16 +332,17 @@ static bool emit_function_body(Xvr_LLVMFunctionEmitter* emitter,
             if (firstReturn && firstReturn->type == XVR_AST_NODE_LITERAL) {
                 Xvr_Literal typeLiteral = firstReturn->atomic.literal;
                 if (typeLiteral.type == XVR_LITERAL_TYPE) {
-                    declared_return_type = XVR_AS_TYPE(typeLiteral).typeOf;
+                    Xvr_LiteralType declared_return_type =
+                        XVR_AS_TYPE(typeLiteral).typeOf;
                     if (declared_return_type == XVR_LITERAL_VOID) {
-                        is_void_function = true;
-                        return_type = LLVMVoidTypeInContext(llvm_ctx);
+                        sig->is_void = true;
+                        sig->return_type = LLVMVoidTypeInContext(llvm_ctx);
                     } else if (declared_return_type == XVR_LITERAL_ANY) {
-                        return_type = LLVMInt32TypeInContext(llvm_ctx);
+                        sig->return_type = LLVMInt32TypeInContext(llvm_ctx);
                     } else {
-                        return_type = Xvr_LLVMTypeMapperGetType(
+                        sig->return_type = Xvr_LLVMTypeMapperGetType(
                             emitter->type_mapper, declared_return_type);
-                        if (!return_type) {
+                        if (!sig->return_type) {
                             char error_msg[256];
                             snprintf(error_msg, sizeof(error_msg),
                                      "unsupported return type: %s",
@@ -356,11 +356,6 @@ static bool emit_function_body(Xvr_LLVMFunctionEmitter* emitter,
         }
     }
 
-    LLVMTypeRef param_types[32];
-    int param_count = 0;
-    const char* param_names[32];
-    Xvr_LiteralType param_types_xvr[32];
-
     if (fn_decl->arguments &&
         fn_decl->arguments->type == XVR_AST_NODE_FN_COLLECTION) {
         Xvr_NodeFnCollection* args = &fn_decl->arguments->fnCollection;
@@ -368,41 +363,77 @@ static bool emit_function_body(Xvr_LLVMFunctionEmitter* emitter,
             Xvr_ASTNode* arg = &args->nodes[i];
             if (arg->type == XVR_AST_NODE_VAR_DECL) {
                 Xvr_NodeVarDecl* varDecl = &arg->varDecl;
+                int index = sig->param_count;
                 if (varDecl->identifier.type == XVR_LITERAL_IDENTIFIER &&
                     varDecl->identifier.as.string.ptr) {
-                    param_names[param_count] =
+                    sig->param_names[index] =
                         (const char*)varDecl->identifier.as.string.ptr->data;
                 } else {
-                    param_names[param_count] = "arg";
+                    sig->param_names[index] = "arg";
                 }
                 Xvr_LiteralType varType = XVR_LITERAL_ANY;
                 if (varDecl->typeLiteral.type == XVR_LITERAL_TYPE) {
                     varType = XVR_AS_TYPE(varDecl->typeLiteral).typeOf;
                 }
-                param_types_xvr[param_count] = varType;
+                sig->param_types_xvr[index] = varType;
                 LLVMTypeRef arg_type =
                     Xvr_LLVMTypeMapperGetType(emitter->type_mapper, varType);
                 if (!arg_type) {
                     arg_type = LLVMInt32TypeInContext(llvm_ctx);
                 }
-                param_types[param_count] = arg_type;
-                param_count++;
+                sig->param_types[index] = arg_type;
+                sig->param_count++;
             }
         }
     }
 
-    LLVMTypeRef function_type =
-        LLVMFunctionType(return_type, param_types, param_count, false);
+    sig->function_type = LLVMFunctionType(
+        sig->return_type, sig->param_types, sig->param_count, false);
 
-    const char* fn_name = "xvr_fn";
+    sig->name = "xvr_fn";
     if (fn_decl->identifier.as.string.ptr) {
-        fn_name = (const char*)fn_decl->identifier.as.string.ptr->data;
+        sig->name = (const char*)fn_decl->identifier.as.string.ptr->data;
     }
+    return true;
+}
 
-    LLVMValueRef function = LLVMAddFunction(
-        Xvr_LLVMModuleManagerGetModule(module), fn_name, function_type);
+static bool emit_function_body(Xvr_LLVMFunctionEmitter* emitter,
+                               Xvr_NodeFnDecl* fn_decl) {
+    Xvr_LLVMIRBuilder* builder = emitter->builder;
+    Xvr_LLVMExpressionEmitter* expr_emitter = emitter->expr_emitter;
+    Xvr_LLVMModuleManager* module = emitter->module;
+    Xvr_LLVMContext* context = emitter->context;
 
-    Xvr_LLVMModuleManagerRegisterFunctionType(module, fn_name, function_type);
+    if (!fn_decl->block) {
+        Xvr_LLVMContextSetError(context, "function has no body");
+        return false;
+    }
+
+    clear_local_vars(emitter);
+
+    Xvr_NodeBlock* block = (Xvr_NodeBlock*)&fn_decl->block->block;
+    LLVMContextRef llvm_ctx = Xvr_LLVMContextGetLLVMContext(context);
+
+    Xvr_LLVMSignature sig;
+    if (!resolve_signature(emitter, fn_decl, &sig)) {
+        return false;
+    }
+    LLVMTypeRef return_type = sig.return_type;
+    bool is_void_function = sig.is_void;
+    bool has_explicit_return = false;
+    int param_count = sig.param_count;
+    const char* fn_name = sig.name;
+
+    /* a prototype from Xvr_LLVMFunctionEmitterDeclare gets its body here */
+    LLVMModuleRef llvm_module = Xvr_LLVMModuleManagerGetModule(module);
+    LLVMValueRef function = LLVMGetNamedFunction(llvm_module, fn_name);
+    if (!function || !LLVMIsDeclaration(function) ||
+        LLVMGlobalGetValueType(function) != sig.function_type) {
+        function = LLVMAddFunction(llvm_module, fn_name, sig.function_type);
+    }
+
+    Xvr_LLVMModuleManagerRegisterFunctionType(module, fn_name,
+                                              sig.function_type);
 
     emitter->current_function = function;
 
@@ -412,14 +443,15 @@ static bool emit_function_body(Xvr_LLVMFunctionEmitter* emitter,
 
     for (int i = 0; i < param_count; i++) {
         LLVMValueRef param = LLVMGetParam(function, i);
-        LLVMSetValueName(param, param_names[i]);
+        LLVMSetValueName(param, sig.param_names[i]);
 
         LLVMTypeRef param_type = LLVMTypeOf(param);
-        LLVMValueRef alloca =
-            Xvr_LLVMIRBuilderCreateAlloca(builder, param_type, param_names[i]);
+        LLVMValueRef alloca = Xvr_LLVMIRBuilderCreateAlloca(
+            builder, param_type, sig.param_names[i]);
         Xvr_LLVMIRBuilderCreateStore(builder, param, alloca);
 
-        add_local_var(emitter, param_names[i], alloca, param_types_xvr[i], 0);
+        add_local_var(emitter, sig.param_names[i], alloca,
+                      sig.param_types_xvr[i], 0);
     }
 
     LLVMValueRef return_value = NULL;
@@ -519,8 +551,44 @@ bool Xvr_LLVMFunctionEmitterEmit(Xvr_LLVMFunctionEmitter* emitter,
         return false;
     }
 
+    /* a proc emitted between top-level statements leaves main's variables
+     * as they were */
+    Xvr_LLVMVariable saved_vars[MAX_LOCAL_VARS];
+    int saved_count = emitter->local_var_count;
+    int saved_depth = emitter->scope_depth;
+    LLVMValueRef saved_function = emitter->current_function;
+    memcpy(saved_vars, emitter->local_vars,
+           (size_t)saved_count * sizeof(Xvr_LLVMVariable));
+
     Xvr_NodeFnDecl* decl = &fn_decl->fnDecl;
-    return emit_function_body(emitter, decl);
+    bool emitted = emit_function_body(emitter, decl);
+
+    memcpy(emitter->local_vars, saved_vars,
+           (size_t)saved_count * sizeof(Xvr_LLVMVariable));
+    emitter->local_var_count = saved_count;
+    emitter->scope_depth = saved_depth;
+    emitter->current_function = saved_function;
+    return emitted;
+}
+
+bool Xvr_LLVMFunctionEmitterDeclare(Xvr_LLVMFunctionEmitter* emitter,
+                                    Xvr_ASTNode* fn_decl) {
+    if (!emitter || !fn_decl || fn_decl->type != XVR_AST_NODE_FN_DECL) {
+        return false;
+    }
+
+    Xvr_LLVMSignature sig;
+    if (!resolve_signature(emitter, &fn_decl->fnDecl, &sig)) {
+        return false;
+    }
+
+    LLVMModuleRef module = Xvr_LLVMModuleManagerGetModule(emitter->module);
+    if (!LLVMGetNamedFunction(module, sig.name)) {
+        LLVMAddFunction(module, sig.name, sig.function_type);
+    }
+    Xvr_LLVMModuleManagerRegisterFunctionType(emitter->module, sig.name,
+                                              sig.function_type);
+    return true;
 }
 
 bool Xvr_LLVMFunctionEmitterEmitCollection(Xvr_LLVMFunctionEmitter* emitter,
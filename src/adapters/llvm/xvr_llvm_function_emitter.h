@@ -52,6 +52,17 @@ bool Xvr_LLVMFunctionEmitterEmit(Xvr_LLVMFunctionEmitter* emitter,
 bool Xvr_LLVMFunctionEmitterEmitCollection(Xvr_LLVMFunctionEmitter* emitter,
                                            Xvr_ASTNode* fn_collection);
 
+/**
+ * @brief adds an external prototype for a function defined in another module
+ * @param emitter Function emitter
+ * @param fn_decl Function declaration, its body is not emitted
+ * @return true if the prototype exists afterwards
+ *
+ * a later Xvr_LLVMFunctionEmitterEmit of the same function fills it in
+ */
+bool Xvr_LLVMFunctionEmitterDeclare(Xvr_LLVMFunctionEmitter* emitter,
+                                    Xvr_ASTNode* fn_decl);
+
 /**
  * @brief Looks up a local variable by name
  * @param emitter Function emitter
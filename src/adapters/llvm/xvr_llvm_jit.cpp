@@ -0,0 +1,260 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_llvm_jit.h"
+
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Error.h>
+#include <llvm-c/LLJIT.h>
+#include <llvm-c/Orc.h>
+#include <llvm-c/Target.h>
+#include <llvm/Config/llvm-config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "xvr_common.h"
+#include "xvr_runtime.h"
+
+struct Xvr_LLVMJIT {
+    LLVMOrcLLJITRef lljit;
+    char* error_message;
+};
+
+typedef struct {
+    const char* name;
+    void* address;
+} Xvr_JITRuntimeSymbol;
+
+static const Xvr_JITRuntimeSymbol runtime_symbols[] = {
+    {"xvr_string_concat", (void*)&xvr_string_concat},
+    {"xvr_str_len", (void*)&xvr_str_len},
+    {"xvr_array_create_int", (void*)&xvr_array_create_int},
+    {"xvr_array_insert_int", (void*)&xvr_array_insert_int},
+    {"xvr_array_len", (void*)&xvr_array_len},
+    {"xvr_array_get_int", (void*)&xvr_array_get_int},
+    {"xvr_array_set_int", (void*)&xvr_array_set_int},
+};
+
+#define RUNTIME_SYMBOL_COUNT \
+    (sizeof(runtime_symbols) / sizeof(runtime_symbols[0]))
+
+static double get_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void set_error(Xvr_LLVMJIT* jit, const char* message) {
+    free(jit->error_message);
+    jit->error_message = message ? Xvr_strdup(message) : NULL;
+}
+
+/* consumes err */
+static bool consume_error(Xvr_LLVMJIT* jit, LLVMErrorRef err) {
+    if (!err) {
+        return true;
+    }
+    char* message = LLVMGetErrorMessage(err);
+    set_error(jit, message);
+    LLVMDisposeErrorMessage(message);
+    return false;
+}
+
+static bool define_runtime_symbols(Xvr_LLVMJIT* jit) {
+    LLVMOrcCSymbolMapPairs pairs = (LLVMOrcCSymbolMapPairs)calloc(
+        RUNTIME_SYMBOL_COUNT, sizeof(*pairs));
+    if (!pairs) {
+        set_error(jit, "out of memory binding runtime symbols");
+        return false;
+    }
+
+    for (size_t i = 0; i < RUNTIME_SYMBOL_COUNT; i++) {
+        pairs[i].Name =
+            LLVMOrcLLJITMangleAndIntern(jit->lljit, runtime_symbols[i].name);
+        pairs[i].Sym.Address =
+            (LLVMOrcExecutorAddress)(uintptr_t)runtime_symbols[i].address;
+        pairs[i].Sym.Flags.GenericFlags = LLVMJITSymbolGenericFlagsExported |
+                                          LLVMJITSymbolGenericFlagsCallable;
+        pairs[i].Sym.Flags.TargetFlags = 0;
+    }
+
+    LLVMOrcMaterializationUnitRef mu =
+        LLVMOrcAbsoluteSymbols(pairs, RUNTIME_SYMBOL_COUNT);
+    free(pairs);
+
+    LLVMOrcJITDylibRef dylib = LLVMOrcLLJITGetMainJITDylib(jit->lljit);
+    LLVMErrorRef err = LLVMOrcJITDylibDefine(dylib, mu);
+    if (err) {
+        LLVMOrcDisposeMaterializationUnit(mu);
+        return consume_error(jit, err);
+    }
+    return true;
+}
+
+Xvr_LLVMJIT* Xvr_LLVMJITCreate(void) {
+    if (LLVMInitializeNativeTarget() || LLVMInitializeNativeAsmPrinter()) {
+        return NULL;
+    }
+
+    Xvr_LLVMJIT* jit = (Xvr_LLVMJIT*)calloc(1, sizeof(Xvr_LLVMJIT));
+    if (!jit) {
+        return NULL;
+    }
+
+    LLVMErrorRef err = LLVMOrcCreateLLJIT(&jit->lljit, NULL);
+    if (err) {
+        LLVMConsumeError(err);
+        free(jit);
+        return NULL;
+    }
+
+    LLVMOrcDefinitionGeneratorRef generator = NULL;
+    err = LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(
+        &generator, LLVMOrcLLJITGetGlobalPrefix(jit->lljit), NULL, NULL);
+    if (err) {
+        LLVMConsumeError(err);
+        LLVMOrcDisposeLLJIT(jit->lljit);
+        free(jit);
+        return NULL;
+    }
+    LLVMOrcJITDylibAddGenerator(LLVMOrcLLJITGetMainJITDylib(jit->lljit),
+                                generator);
+
+    if (!define_runtime_symbols(jit)) {
+        Xvr_LLVMJITDestroy(jit);
+        return NULL;
+    }
+
+    return jit;
+}
+
+void Xvr_LLVMJITDestroy(Xvr_LLVMJIT* jit) {
+    if (!jit) {
+        return;
+    }
+    if (jit->lljit) {
+        LLVMErrorRef err = LLVMOrcDisposeLLJIT(jit->lljit);
+        if (err) {
+            LLVMConsumeError(err);
+        }
+    }
+    free(jit->error_message);
+    free(jit);
+}
+
+bool Xvr_LLVMJITAddModule(Xvr_LLVMJIT* jit, LLVMModuleRef module) {
+    if (!jit || !module) {
+        return false;
+    }
+
+    /* round-trip through bitcode so the engine owns an independent copy */
+    LLVMMemoryBufferRef bitcode = LLVMWriteBitcodeToMemoryBuffer(module);
+    if (!bitcode) {
+        set_error(jit, "failed to serialize module for JIT");
+        return false;
+    }
+
+#if LLVM_VERSION_MAJOR >= 21
+    LLVMContextRef llvm_ctx = LLVMContextCreate();
+    LLVMOrcThreadSafeContextRef ts_ctx =
+        LLVMOrcCreateNewThreadSafeContextFromLLVMContext(llvm_ctx);
+#else
+    LLVMOrcThreadSafeContextRef ts_ctx = LLVMOrcCreateNewThreadSafeContext();
+    LLVMContextRef llvm_ctx = LLVMOrcThreadSafeContextGetContext(ts_ctx);
+#endif
+
+    LLVMModuleRef copy = NULL;
+    bool parse_failed = LLVMParseBitcodeInContext2(llvm_ctx, bitcode, &copy);
+    LLVMDisposeMemoryBuffer(bitcode);
+    if (parse_failed || !copy) {
+        LLVMOrcDisposeThreadSafeContext(ts_ctx);
+        set_error(jit, "failed to load module into JIT context");
+        return false;
+    }
+
+    LLVMOrcThreadSafeModuleRef ts_module =
+        LLVMOrcCreateNewThreadSafeModule(copy, ts_ctx);
+    /* the module keeps the context alive from here on */
+    LLVMOrcDisposeThreadSafeContext(ts_ctx);
+
+    LLVMOrcJITDylibRef dylib = LLVMOrcLLJITGetMainJITDylib(jit->lljit);
+    LLVMErrorRef err = LLVMOrcLLJITAddLLVMIRModule(jit->lljit, dylib, ts_module);
+    if (err) {
+        LLVMOrcDisposeThreadSafeModule(ts_module);
+        return consume_error(jit, err);
+    }
+    return true;
+}
+
+bool Xvr_LLVMJITLookup(Xvr_LLVMJIT* jit, const char* name,
+                       uint64_t* out_address) {
+    if (!jit || !name || !out_address) {
+        return false;
+    }
+
+    LLVMOrcExecutorAddress address = 0;
+    if (!consume_error(jit, LLVMOrcLLJITLookup(jit->lljit, &address, name))) {
+        return false;
+    }
+    *out_address = (uint64_t)address;
+    return address != 0;
+}
+
+bool Xvr_LLVMJITRunMain(Xvr_LLVMJIT* jit, Xvr_LLVMJITStats* out_stats) {
+    if (!jit) {
+        return false;
+    }
+
+    double compile_start = get_time_ms();
+    uint64_t address = 0;
+    if (!Xvr_LLVMJITLookup(jit, "main", &address)) {
+        if (!jit->error_message) {
+            set_error(jit, "JIT module does not define main");
+        }
+        return false;
+    }
+    double compile_end = get_time_ms();
+
+    int (*main_fn)(void) = (int (*)(void))(uintptr_t)address;
+    int exit_code = main_fn();
+    fflush(stdout);
+    double exec_end = get_time_ms();
+
+    if (out_stats) {
+        out_stats->compile_ms += compile_end - compile_start;
+        out_stats->exec_ms = exec_end - compile_end;
+        out_stats->exit_code = exit_code;
+    }
+    return true;
+}
+
+const char* Xvr_LLVMJITGetError(Xvr_LLVMJIT* jit) {
+    if (!jit) {
+        return NULL;
+    }
+    return jit->error_message;
+}
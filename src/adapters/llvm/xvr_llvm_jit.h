@@ -0,0 +1,100 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_LLVM_JIT_H
+#define XVR_LLVM_JIT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <llvm-c/Core.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief in-process execution engine built on ORC LLJIT
+ *
+ * each module added to the engine is copied into a JIT-owned context, so the
+ * caller keeps ownership of its own module. runtime helpers from
+ * xvr_runtime.h are bound directly, everything else (libc, libm) is resolved
+ * from the host process
+ *
+ * Thread safety: not thread-safe, one engine per thread
+ */
+typedef struct Xvr_LLVMJIT Xvr_LLVMJIT;
+
+/**
+ * @brief timing and result of a single JIT run
+ *
+ * compile_ms covers engine setup, module hand-off and materialization of
+ * `main` (Xvr_LLVMJITRunMain adds to whatever the caller already measured);
+ * exec_ms covers only the call into `main`
+ */
+typedef struct {
+    double compile_ms;
+    double exec_ms;
+    int exit_code;
+} Xvr_LLVMJITStats;
+
+/**
+ * @brief creates an engine targeting the host
+ * @return new engine, or NULL if the host target is unavailable
+ */
+Xvr_LLVMJIT* Xvr_LLVMJITCreate(void);
+void Xvr_LLVMJITDestroy(Xvr_LLVMJIT* jit);
+
+/**
+ * @brief copies a module into the engine
+ * @param jit engine to add to
+ * @param module module to copy (not consumed)
+ * @return true on success, false with an error set otherwise
+ */
+bool Xvr_LLVMJITAddModule(Xvr_LLVMJIT* jit, LLVMModuleRef module);
+
+/**
+ * @brief looks up (and compiles on demand) a symbol
+ * @param jit engine to search
+ * @param name unmangled symbol name
+ * @param out_address receives the executable address
+ * @return true if the symbol resolved
+ */
+bool Xvr_LLVMJITLookup(Xvr_LLVMJIT* jit, const char* name,
+                       uint64_t* out_address);
+
+/**
+ * @brief compiles and calls `int main(void)`
+ * @param jit engine holding a module that defines main
+ * @param out_stats optional timing and exit code
+ * @return true if main was found and called
+ */
+bool Xvr_LLVMJITRunMain(Xvr_LLVMJIT* jit, Xvr_LLVMJITStats* out_stats);
+
+const char* Xvr_LLVMJITGetError(Xvr_LLVMJIT* jit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
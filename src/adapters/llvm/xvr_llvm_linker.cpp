@@ -0,0 +1,399 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_llvm_linker.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <spawn.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "xvr_common.h"
+
+#ifdef XVR_HAVE_LLD
+#    include <lld/Common/Driver.h>
+#    include <llvm/Support/raw_ostream.h>
+
+#    include <string>
+#    include <vector>
+
+#    include "xvr_link_config.h"
+
+LLD_HAS_DRIVER(elf)
+#endif
+
+#ifndef XVR_LINK_DRIVER
+#    define XVR_LINK_DRIVER "cc"
+#endif
+
+extern char** environ;
+
+typedef struct {
+    int fd;
+    char path[PATH_MAX];
+    bool unlink_on_close;
+} Xvr_LinkObject;
+
+static void set_link_error(char** out_error, const char* format, ...) {
+    if (!out_error) {
+        return;
+    }
+    char buffer[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    free(*out_error);
+    *out_error = Xvr_strdup(buffer);
+}
+
+static bool write_all(int fd, const void* data, size_t size) {
+    const char* cursor = (const char*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, cursor, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        cursor += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+/* the object lives in an anonymous memory file where the platform has one,
+ * otherwise in a private mkstemps() file; neither is shared between runs */
+static bool open_link_object(const void* object, size_t object_size,
+                             Xvr_LinkObject* out) {
+    out->fd = -1;
+    out->unlink_on_close = false;
+
+#if defined(__linux__)
+    /* no MFD_CLOEXEC: a spawned driver and its linker inherit the fd */
+    int fd = memfd_create("xvr-object", 0);
+    if (fd >= 0) {
+        if (write_all(fd, object, object_size)) {
+            out->fd = fd;
+            snprintf(out->path, sizeof(out->path), "/proc/self/fd/%d", fd);
+            return true;
+        }
+        close(fd);
+    }
+#endif
+
+    const char* tmpdir = getenv("TMPDIR"); /* Flawfinder: ignore */
+    if (!tmpdir || !*tmpdir) {
+        tmpdir = "/tmp";
+    }
+    snprintf(out->path, sizeof(out->path), "%s/xvr-XXXXXX.o", tmpdir);
+    int tmp_fd = mkstemps(out->path, 2);
+    if (tmp_fd < 0) {
+        return false;
+    }
+    if (!write_all(tmp_fd, object, object_size)) {
+        close(tmp_fd);
+        unlink(out->path);
+        return false;
+    }
+    out->fd = tmp_fd;
+    out->unlink_on_close = true;
+    return true;
+}
+
+static void close_link_object(Xvr_LinkObject* object) {
+    if (object->fd >= 0) {
+        close(object->fd);
+    }
+    if (object->unlink_on_close) {
+        unlink(object->path);
+    }
+}
+
+const char* Xvr_LLVMLinkerFindRuntimeLibrary(void) {
+    const char* override_path = getenv("XVR_RUNTIME_LIB"); /* Flawfinder: ignore */
+    if (override_path && *override_path) {
+        return override_path;
+    }
+
+    static const char* const candidates[] = {
+#ifdef XVR_RUNTIME_LIB_BUILD_PATH
+        XVR_RUNTIME_LIB_BUILD_PATH,
+#endif
+#ifdef XVR_RUNTIME_LIB_INSTALL_PATH
+        XVR_RUNTIME_LIB_INSTALL_PATH,
+#endif
+        NULL,
+    };
+
+    for (int i = 0; candidates[i]; i++) {
+        if (access(candidates[i], R_OK) == 0) {
+            return candidates[i];
+        }
+    }
+    return NULL;
+}
+
+const char* Xvr_LLVMLinkerFindRuntimeBitcode(void) {
+    const char* override_path = getenv("XVR_RUNTIME_BITCODE"); /* Flawfinder: ignore */
+    if (override_path) {
+        return *override_path ? override_path : NULL;
+    }
+
+    static const char* const candidates[] = {
+#ifdef XVR_RUNTIME_BITCODE_BUILD_PATH
+        XVR_RUNTIME_BITCODE_BUILD_PATH,
+#endif
+#ifdef XVR_RUNTIME_BITCODE_INSTALL_PATH
+        XVR_RUNTIME_BITCODE_INSTALL_PATH,
+#endif
+        NULL,
+    };
+
+    for (int i = 0; candidates[i]; i++) {
+        if (access(candidates[i], R_OK) == 0) {
+            return candidates[i];
+        }
+    }
+    return NULL;
+}
+
+const char* Xvr_LLVMLinkerFindProfileRuntime(void) {
+    const char* override_path = getenv("XVR_PROFILE_RUNTIME"); /* Flawfinder: ignore */
+    if (override_path && *override_path) {
+        return override_path;
+    }
+
+#ifdef XVR_PROFILE_RUNTIME_PATH
+    if (access(XVR_PROFILE_RUNTIME_PATH, R_OK) == 0) {
+        return XVR_PROFILE_RUNTIME_PATH;
+    }
+#endif
+    return NULL;
+}
+
+#ifdef XVR_HAVE_LLD
+static bool link_with_lld(const Xvr_LinkObject* objects, size_t object_count,
+                          const char* runtime_lib, const char* profile_runtime,
+                          bool relocatable, const char* output_path,
+                          char** out_error) {
+    std::vector<const char*> args;
+    args.push_back("ld.lld");
+    if (relocatable) {
+        args.push_back("-r");
+    } else {
+        for (int i = 0; xvr_link_args_before[i]; i++) {
+            args.push_back(xvr_link_args_before[i]);
+        }
+    }
+    args.push_back("-o");
+    args.push_back(output_path);
+    for (size_t i = 0; i < object_count; i++) {
+        args.push_back(objects[i].path);
+    }
+    if (runtime_lib) {
+        args.push_back(runtime_lib);
+    }
+    if (profile_runtime) {
+        args.push_back("-u");
+        args.push_back("__llvm_profile_runtime");
+        args.push_back(profile_runtime);
+    }
+    for (int i = 0; !relocatable && xvr_link_args_after[i]; i++) {
+        args.push_back(xvr_link_args_after[i]);
+    }
+
+    std::string diagnostics;
+    llvm::raw_string_ostream diag_stream(diagnostics);
+    lld::Result result = lld::lldMain(args, llvm::outs(), diag_stream,
+                                      {{lld::Gnu, &lld::elf::link}});
+    diag_stream.flush();
+
+    if (result.retCode != 0) {
+        set_link_error(out_error, "%s",
+                       diagnostics.empty() ? "lld failed" : diagnostics.c_str());
+        return false;
+    }
+    return true;
+}
+#endif
+
+static bool link_with_driver(const Xvr_LinkObject* objects,
+                             size_t object_count, const char* runtime_lib,
+                             const char* profile_runtime, bool relocatable,
+                             const char* output_path, char** out_error) {
+    const char** args =
+        (const char**)malloc((object_count + 11) * sizeof(const char*));
+    if (!args) {
+        set_link_error(out_error, "out of memory building the link line");
+        return false;
+    }
+    int argc = 0;
+    args[argc++] = XVR_LINK_DRIVER;
+    if (relocatable) {
+        args[argc++] = "-r";
+        args[argc++] = "-nostdlib";
+    }
+    for (size_t i = 0; i < object_count; i++) {
+        args[argc++] = objects[i].path;
+    }
+    args[argc++] = "-o";
+    args[argc++] = output_path;
+    if (runtime_lib) {
+        args[argc++] = runtime_lib;
+    }
+    if (profile_runtime) {
+        /* instrprof leaves the runtime hook to the link line on linux */
+        args[argc++] = "-u";
+        args[argc++] = "__llvm_profile_runtime";
+        args[argc++] = profile_runtime;
+    }
+    if (!relocatable) {
+        args[argc++] = "-lm";
+    }
+    args[argc++] = NULL;
+
+    pid_t pid;
+    int rc = posix_spawnp(&pid, XVR_LINK_DRIVER, NULL, NULL,
+                          (char* const*)args, environ);
+    free(args);
+    if (rc != 0) {
+        set_link_error(out_error, "failed to start linker '%s': %s",
+                       XVR_LINK_DRIVER, strerror(rc));
+        return false;
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            set_link_error(out_error, "failed to wait for linker: %s",
+                           strerror(errno));
+            return false;
+        }
+    }
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        set_link_error(out_error, "linker '%s' exited with status %d",
+                       XVR_LINK_DRIVER,
+                       WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+        return false;
+    }
+    return true;
+}
+
+static bool link_executable(const void* const* objects,
+                            const size_t* object_sizes, size_t object_count,
+                            const char* profile_runtime, bool relocatable,
+                            const char* output_path, char** out_error) {
+    if (!objects || object_count == 0 || !output_path) {
+        set_link_error(out_error, "no object to link");
+        return false;
+    }
+
+    Xvr_LinkObject* link_objects =
+        (Xvr_LinkObject*)calloc(object_count, sizeof(Xvr_LinkObject));
+    if (!link_objects) {
+        set_link_error(out_error, "out of memory staging objects");
+        return false;
+    }
+
+    size_t staged = 0;
+    for (; staged < object_count; staged++) {
+        if (!objects[staged] || object_sizes[staged] == 0) {
+            set_link_error(out_error, "no object to link");
+            break;
+        }
+        if (!open_link_object(objects[staged], object_sizes[staged],
+                              &link_objects[staged])) {
+            set_link_error(out_error,
+                           "failed to stage object for linking: %s",
+                           strerror(errno));
+            break;
+        }
+    }
+
+    bool linked = false;
+    if (staged == object_count) {
+        const char* runtime_lib =
+            relocatable ? NULL : Xvr_LLVMLinkerFindRuntimeLibrary();
+#ifdef XVR_HAVE_LLD
+        linked = link_with_lld(link_objects, object_count, runtime_lib,
+                               profile_runtime, relocatable, output_path,
+                               out_error);
+#else
+        linked = link_with_driver(link_objects, object_count, runtime_lib,
+                                  profile_runtime, relocatable, output_path,
+                                  out_error);
+#endif
+    }
+
+    for (size_t i = 0; i < staged; i++) {
+        close_link_object(&link_objects[i]);
+    }
+    free(link_objects);
+    return linked;
+}
+
+bool Xvr_LLVMLinkerLinkExecutable(const void* object, size_t object_size,
+                                  const char* output_path, char** out_error) {
+    return link_executable(&object, &object_size, 1, NULL, false,
+                           output_path, out_error);
+}
+
+bool Xvr_LLVMLinkerLinkExecutables(const void* const* objects,
+                                   const size_t* object_sizes,
+                                   size_t object_count,
+                                   const char* output_path, char** out_error) {
+    return link_executable(objects, object_sizes, object_count, NULL, false,
+                           output_path, out_error);
+}
+
+bool Xvr_LLVMLinkerLinkRelocatable(const void* const* objects,
+                                   const size_t* object_sizes,
+                                   size_t object_count,
+                                   const char* output_path, char** out_error) {
+    return link_executable(objects, object_sizes, object_count, NULL, true,
+                           output_path, out_error);
+}
+
+bool Xvr_LLVMLinkerLinkInstrumentedExecutable(const void* object,
+                                              size_t object_size,
+                                              const char* output_path,
+                                              char** out_error) {
+    const char* profile_runtime = Xvr_LLVMLinkerFindProfileRuntime();
+    if (!profile_runtime) {
+        set_link_error(out_error,
+                       "profile runtime (libclang_rt.profile) not found");
+        return false;
+    }
+    return link_executable(&object, &object_size, 1, profile_runtime, false,
+                           output_path, out_error);
+}
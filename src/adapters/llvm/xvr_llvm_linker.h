@@ -0,0 +1,112 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_LLVM_LINKER_H
+#define XVR_LLVM_LINKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief locates the runtime archive (libxvr.a) to link against
+ * @return absolute path, or NULL if no runtime archive exists
+ *
+ * the lookup order is fixed: the XVR_RUNTIME_LIB environment variable, the
+ * archive produced by this build, then the install location. the current
+ * working directory is never consulted
+ *
+ * the returned string is static or owned by the environment, do not free
+ */
+const char* Xvr_LLVMLinkerFindRuntimeLibrary(void);
+
+/**
+ * @brief links an in-memory object into an executable
+ * @param object object file bytes (e.g. from Xvr_LLVMCodegenEmitObject)
+ * @param object_size size of the object in bytes
+ * @param output_path executable to write
+ * @param out_error receives a malloc'd message on failure (may be NULL)
+ * @return true if the executable was written
+ *
+ * the object is handed to the linker through an anonymous memory file, so
+ * nothing is written to a shared temporary path. when built with LLD the link
+ * runs in-process; otherwise the configured system compiler driver is spawned
+ */
+bool Xvr_LLVMLinkerLinkExecutable(const void* object, size_t object_size,
+                                  const char* output_path, char** out_error);
+
+/**
+ * @brief links several in-memory objects, e.g. the per-module objects of a
+ * ThinLTO link, into one executable
+ * @see Xvr_LLVMLinkerLinkExecutable
+ */
+bool Xvr_LLVMLinkerLinkExecutables(const void* const* objects,
+                                   const size_t* object_sizes,
+                                   size_t object_count,
+                                   const char* output_path, char** out_error);
+
+/**
+ * @brief merges in-memory objects into one relocatable object (`ld -r`),
+ * without the runtime, e.g. the partitions of a -j build written with -c
+ */
+bool Xvr_LLVMLinkerLinkRelocatable(const void* const* objects,
+                                   const size_t* object_sizes,
+                                   size_t object_count,
+                                   const char* output_path, char** out_error);
+
+/**
+ * @brief locates the runtime compiled to LLVM bitcode (xvr_runtime.bc)
+ * @return path, or NULL if none was built or it is disabled
+ *
+ * same order as the archive: XVR_RUNTIME_BITCODE (set but empty disables
+ * it), this build's copy, then the install location. the bitcode is only
+ * built when a clang matching the LLVM version is available
+ */
+const char* Xvr_LLVMLinkerFindRuntimeBitcode(void);
+
+/**
+ * @brief locates compiler-rt's profile runtime for instrumented executables
+ * @return the XVR_PROFILE_RUNTIME environment variable, else the archive
+ * found next to LLVM at configure time, else NULL
+ */
+const char* Xvr_LLVMLinkerFindProfileRuntime(void);
+
+/**
+ * @brief like Xvr_LLVMLinkerLinkExecutable, also linking the profile runtime
+ * that writes the raw profile of a --profile-generate build at exit
+ * @return false with an error set if no profile runtime is available
+ */
+bool Xvr_LLVMLinkerLinkInstrumentedExecutable(const void* object,
+                                              size_t object_size,
+                                              const char* output_path,
+                                              char** out_error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -25,10 +25,29 @@ SOFTWARE.
 #include "xvr_llvm_module_manager.h"
 
 #include <llvm-c/BitWriter.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/ModuleSummaryIndex.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Transforms/IPO/Internalize.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "xvr_common.h"
 #include "../../xvr_string_utils.h"
 #include "xvr_llvm_context.h"
 
@@ -76,6 +95,10 @@ void Xvr_LLVMModuleManagerDestroy(Xvr_LLVMModuleManager* mgr) {
     free(mgr);
 }
 
+void Xvr_LLVMModuleManagerAbandon(Xvr_LLVMModuleManager* mgr) {
+    free(mgr);
+}
+
 LLVMModuleRef Xvr_LLVMModuleManagerGetModule(Xvr_LLVMModuleManager* mgr) {
     if (!mgr) {
         return NULL;
@@ -188,14 +211,13 @@ char* Xvr_LLVMModuleManagerPrintIR(Xvr_LLVMModuleManager* mgr,
         return NULL;
     }
 
-    size_t ir_len = xvr_safe_strlen(ir, 4096);
+    /* LLVM always terminates the printed module; a bounded length here used
+     * to cut off every module larger than 4 KiB */
+    size_t ir_len = strlen(ir);
     *out_len = ir_len + 1;
     char* result = (char*)malloc(*out_len);
-    if (result && ir_len > 0 && ir_len < *out_len) {
-        for (size_t i = 0; i < ir_len; i++) {
-            result[i] = ir[i];
-        }
-        result[ir_len] = '\0';
+    if (result && ir_len > 0) {
+        memcpy(result, ir, *out_len);
     } else {
         free(result);
         result = NULL;
@@ -214,9 +236,244 @@ bool Xvr_LLVMModuleManagerWriteBitcode(Xvr_LLVMModuleManager* mgr,
     return (result == 0);
 }
 
+void* Xvr_LLVMModuleManagerEmitSummaryBitcode(Xvr_LLVMModuleManager* mgr,
+                                              size_t* out_size) {
+    if (!mgr || !out_size) {
+        return NULL;
+    }
+
+    llvm::Module* module = llvm::unwrap(mgr->module);
+    /* with profile data in the IR the summary records call edge hotness,
+     * which the thin link uses to import hot callees more eagerly */
+    llvm::ProfileSummaryInfo psi(*module);
+    llvm::ModuleSummaryIndex index =
+        llvm::buildModuleSummaryIndex(*module, nullptr, &psi);
+
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream stream(buffer);
+    /* the module hash keys the thin link's cache */
+    llvm::WriteBitcodeToFile(*module, stream, false, &index, true);
+
+    void* bitcode = malloc(buffer.size());
+    if (!bitcode) {
+        return NULL;
+    }
+    memcpy(bitcode, buffer.data(), buffer.size());
+    *out_size = buffer.size();
+    return bitcode;
+}
+
 bool Xvr_LLVMModuleManagerWriteObjectFile(Xvr_LLVMModuleManager* mgr,
                                           const char* filepath) {
     (void)mgr;
     (void)filepath;
     return false;
 }
+
+static void set_link_error(char** out_error, const char* format, ...) {
+    if (!out_error) {
+        return;
+    }
+    char message[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    *out_error = Xvr_strdup(message);
+}
+
+/* the default handler exits the process on a link error */
+static void capture_link_diagnostic(LLVMDiagnosticInfoRef info,
+                                    void* context) {
+    std::string* first_error = (std::string*)context;
+    if (LLVMGetDiagInfoSeverity(info) != LLVMDSError ||
+        !first_error->empty()) {
+        return;
+    }
+    char* description = LLVMGetDiagInfoDescription(info);
+    *first_error = description;
+    LLVMDisposeMessage(description);
+}
+
+/* functions named by a constant, seen through casts and nested constants */
+static void collect_functions(const llvm::Constant* constant,
+                              std::vector<llvm::Function*>* out) {
+    if (const llvm::Function* fn = llvm::dyn_cast<llvm::Function>(constant)) {
+        out->push_back(const_cast<llvm::Function*>(fn));
+        return;
+    }
+    if (llvm::isa<llvm::GlobalValue>(constant)) {
+        return;
+    }
+    for (const llvm::Use& operand : constant->operands()) {
+        if (const llvm::Constant* inner =
+                llvm::dyn_cast<llvm::Constant>(operand.get())) {
+            collect_functions(inner, out);
+        }
+    }
+}
+
+size_t Xvr_LLVMModuleManagerStripUnreachable(Xvr_LLVMModuleManager* mgr) {
+    if (!mgr || !mgr->module) {
+        return 0;
+    }
+    llvm::Module& module = *llvm::unwrap(mgr->module);
+
+    /* anything visible outside the module is a root, main among them */
+    std::vector<llvm::Function*> worklist;
+    for (llvm::Function& fn : module) {
+        if (!fn.isDeclaration() && !fn.hasLocalLinkage()) {
+            worklist.push_back(&fn);
+        }
+    }
+    for (llvm::GlobalVariable& global : module.globals()) {
+        if (global.hasInitializer()) {
+            collect_functions(global.getInitializer(), &worklist);
+        }
+    }
+
+    llvm::SmallPtrSet<llvm::Function*, 32> reached;
+    while (!worklist.empty()) {
+        llvm::Function* fn = worklist.back();
+        worklist.pop_back();
+        if (!reached.insert(fn).second) {
+            continue;
+        }
+        for (llvm::BasicBlock& block : *fn) {
+            for (llvm::Instruction& inst : block) {
+                for (llvm::Use& operand : inst.operands()) {
+                    if (llvm::Constant* constant =
+                            llvm::dyn_cast<llvm::Constant>(operand.get())) {
+                        collect_functions(constant, &worklist);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<llvm::Function*> dead;
+    for (llvm::Function& fn : module) {
+        if (!fn.isDeclaration() && fn.hasLocalLinkage() &&
+            !reached.count(&fn)) {
+            dead.push_back(&fn);
+        }
+    }
+    /* dead functions may call each other, so all bodies go first */
+    for (llvm::Function* fn : dead) {
+        fn->dropAllReferences();
+    }
+    for (llvm::Function* fn : dead) {
+        fn->replaceAllUsesWith(llvm::UndefValue::get(fn->getType()));
+        fn->eraseFromParent();
+    }
+    return dead.size();
+}
+
+/* only_needed pulls in just the definitions the module references */
+static bool link_library(Xvr_LLVMModuleManager* mgr,
+                         std::unique_ptr<llvm::Module> library,
+                         const char* name, bool only_needed,
+                         char** out_error) {
+    /* the library is built once for the host; it may only be retargeted
+     * within the same architecture */
+    LLVMModuleRef library_ref = llvm::wrap(library.get());
+    std::string library_triple = LLVMGetTarget(library_ref);
+    std::string module_triple = LLVMGetTarget(mgr->module);
+    if (library_triple.substr(0, library_triple.find('-')) !=
+        module_triple.substr(0, module_triple.find('-'))) {
+        set_link_error(out_error, "'%s' is built for %s, not %s", name,
+                       LLVMGetTarget(library_ref), LLVMGetTarget(mgr->module));
+        return false;
+    }
+    LLVMSetTarget(library_ref, LLVMGetTarget(mgr->module));
+    LLVMSetDataLayout(library_ref, LLVMGetDataLayoutStr(mgr->module));
+
+    /* the library's CPU and features come from the compiler that built it,
+     * the caller re-applies the module's own so the inliner sees matching
+     * targets on both sides of a call */
+    for (llvm::Function& fn : *library) {
+        fn.removeFnAttr("target-cpu");
+        fn.removeFnAttr("target-features");
+        fn.removeFnAttr("tune-cpu");
+    }
+
+    std::string first_error;
+    LLVMContextRef ctx = LLVMGetModuleContext(mgr->module);
+    LLVMDiagnosticHandler handler = LLVMContextGetDiagnosticHandler(ctx);
+    void* handler_context = LLVMContextGetDiagnosticContext(ctx);
+    LLVMContextSetDiagnosticHandler(ctx, capture_link_diagnostic,
+                                    &first_error);
+
+    /* a library linked on demand becomes internal so unused definitions can
+     * be dropped once calls are inlined */
+    llvm::Module& dest = *llvm::unwrap(mgr->module);
+    bool failed =
+        only_needed
+            ? llvm::Linker::linkModules(
+                  dest, std::move(library),
+                  llvm::Linker::Flags::LinkOnlyNeeded,
+                  [](llvm::Module& module, const llvm::StringSet<>& linked) {
+                      llvm::internalizeModule(
+                          module, [&linked](const llvm::GlobalValue& value) {
+                              return !value.hasName() ||
+                                     !linked.count(value.getName());
+                          });
+                  })
+            : llvm::Linker::linkModules(dest, std::move(library));
+
+    LLVMContextSetDiagnosticHandler(ctx, handler, handler_context);
+
+    if (failed) {
+        set_link_error(out_error, "cannot link '%s': %s", name,
+                       first_error.empty() ? "link failed"
+                                           : first_error.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Xvr_LLVMModuleManagerLinkBitcode(Xvr_LLVMModuleManager* mgr,
+                                      const char* filepath, char** out_error) {
+    if (!mgr || !mgr->module || !filepath) {
+        set_link_error(out_error, "no module or bitcode file");
+        return false;
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+        llvm::MemoryBuffer::getFile(filepath);
+    if (!buffer) {
+        set_link_error(out_error, "cannot read '%s': %s", filepath,
+                       buffer.getError().message().c_str());
+        return false;
+    }
+
+    llvm::Module& dest = *llvm::unwrap(mgr->module);
+    llvm::Expected<std::unique_ptr<llvm::Module>> parsed =
+        llvm::parseBitcodeFile(buffer.get()->getMemBufferRef(),
+                               dest.getContext());
+    if (!parsed) {
+        set_link_error(out_error, "cannot load '%s': %s", filepath,
+                       llvm::toString(parsed.takeError()).c_str());
+        return false;
+    }
+
+    return link_library(mgr, std::move(*parsed), filepath, true, out_error);
+}
+
+bool Xvr_LLVMModuleManagerLinkModule(Xvr_LLVMModuleManager* mgr,
+                                     LLVMModuleRef library, const char* name,
+                                     char** out_error) {
+    if (!mgr || !mgr->module || !library) {
+        set_link_error(out_error, "no module to link");
+        return false;
+    }
+    if (LLVMGetModuleContext(library) != LLVMGetModuleContext(mgr->module)) {
+        LLVMDisposeModule(library);
+        set_link_error(out_error, "'%s' belongs to another context",
+                       name ? name : "module");
+        return false;
+    }
+    std::unique_ptr<llvm::Module> owned(llvm::unwrap(library));
+    return link_library(mgr, std::move(owned), name ? name : "module", false,
+                        out_error);
+}
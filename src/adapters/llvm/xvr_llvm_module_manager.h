@@ -40,6 +40,9 @@ typedef struct Xvr_LLVMModuleManager Xvr_LLVMModuleManager;
 Xvr_LLVMModuleManager* Xvr_LLVMModuleManagerCreate(Xvr_LLVMContext* ctx,
                                                    const char* name);
 void Xvr_LLVMModuleManagerDestroy(Xvr_LLVMModuleManager* mgr);
+/* frees the manager but leaves its module, which LLVM can't dispose once the
+ * IR is invalid */
+void Xvr_LLVMModuleManagerAbandon(Xvr_LLVMModuleManager* mgr);
 
 LLVMModuleRef Xvr_LLVMModuleManagerGetModule(Xvr_LLVMModuleManager* mgr);
 bool Xvr_LLVMModuleManagerAddFunction(Xvr_LLVMModuleManager* mgr,
@@ -63,6 +66,52 @@ bool Xvr_LLVMModuleManagerWriteBitcode(Xvr_LLVMModuleManager* mgr,
 bool Xvr_LLVMModuleManagerWriteObjectFile(Xvr_LLVMModuleManager* mgr,
                                           const char* filepath);
 
+/**
+ * @brief deletes internal functions no visible function can reach
+ * @return number of functions deleted
+ *
+ * reachability follows calls and address-taken functions from every
+ * definition with external linkage (main included) and from global
+ * initializers, so procs a module keeps private and nothing calls are
+ * never emitted, even at -O0
+ */
+size_t Xvr_LLVMModuleManagerStripUnreachable(Xvr_LLVMModuleManager* mgr);
+
+/**
+ * @brief serializes the module as ThinLTO bitcode
+ * @param out_size receives the size in bytes
+ * @return malloc'd bitcode (caller frees), or NULL on failure
+ *
+ * the bitcode carries a module summary and a module hash, the inputs
+ * Xvr_LLVMThinLinkRun needs to plan cross-module imports and cache results
+ */
+void* Xvr_LLVMModuleManagerEmitSummaryBitcode(Xvr_LLVMModuleManager* mgr,
+                                              size_t* out_size);
+
+/**
+ * @brief links the definitions the module uses from a bitcode library
+ * @param filepath bitcode file, e.g. the runtime's xvr_runtime.bc
+ * @param out_error receives a malloc'd message on failure (may be NULL)
+ * @return true if the library was linked
+ *
+ * only referenced symbols are linked and each becomes internal, so the
+ * optimizer can inline them and drop what is left over
+ */
+bool Xvr_LLVMModuleManagerLinkBitcode(Xvr_LLVMModuleManager* mgr,
+                                      const char* filepath, char** out_error);
+
+/**
+ * @brief links every definition of another module in the same context
+ * @param library module to link, consumed even on failure
+ * @param name names the library in error messages
+ *
+ * retargeted as with Xvr_LLVMModuleManagerLinkBitcode, but linkage is
+ * kept, as if the library had been emitted into this module
+ */
+bool Xvr_LLVMModuleManagerLinkModule(Xvr_LLVMModuleManager* mgr,
+                                     LLVMModuleRef library, const char* name,
+                                     char** out_error);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,527 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_llvm_object_cache.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/SHA256.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+#include "xvr_common.h"
+
+#define XVR_OBJECT_CACHE_DEFAULT_SIZE (1ull << 30)
+
+/* bump when the entry layout changes, old entries then simply miss */
+#define XVR_OBJECT_CACHE_FORMAT "xvr-object-cache-1"
+
+/* a temporary file this old belongs to a compiler that died mid-store */
+#define XVR_OBJECT_CACHE_STALE_TMP_SECONDS (10 * 60)
+
+static const char entry_magic[4] = {'X', 'V', 'R', 'O'};
+
+struct Xvr_LLVMObjectCache {
+    char* dir;
+    uint64_t max_bytes;
+    mode_t file_mode; /* 0644 under the umask, mkstemp alone gives 0600 */
+};
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t evictions;
+} Xvr_CacheCounters;
+
+static std::string hash_hex(const std::string& data) {
+    std::array<uint8_t, 32> digest = llvm::SHA256::hash(llvm::ArrayRef<uint8_t>(
+        reinterpret_cast<const uint8_t*>(data.data()), data.size()));
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(digest.size() * 2);
+    for (uint8_t byte : digest) {
+        hex.push_back(digits[byte >> 4]);
+        hex.push_back(digits[byte & 0xf]);
+    }
+    return hex;
+}
+
+static bool read_whole_file(const std::string& path, std::string* out) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    out->clear();
+    char buffer[65536];
+    for (;;) {
+        ssize_t got = read(fd, buffer, sizeof(buffer));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close(fd);
+            return false;
+        }
+        if (got == 0) {
+            break;
+        }
+        out->append(buffer, (size_t)got);
+    }
+    close(fd);
+    return true;
+}
+
+static bool write_all(int fd, const void* data, size_t size) {
+    const char* cursor = (const char*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, cursor, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        cursor += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+/* readers see either the old file or the complete new one */
+static bool write_atomically(const Xvr_LLVMObjectCache* cache,
+                             const std::string& path,
+                             const std::string& contents) {
+    std::string tmp = std::string(cache->dir) + "/.tmp-XXXXXX";
+    int fd = mkstemp(&tmp[0]);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = fchmod(fd, cache->file_mode) == 0 &&
+              write_all(fd, contents.data(), contents.size());
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+static std::string entry_path(const Xvr_LLVMObjectCache* cache,
+                              const std::string& key, const char* suffix) {
+    return std::string(cache->dir) + "/" + key + suffix;
+}
+
+/* the counters file is shared by every compiler using the directory, so
+ * each update is a locked read-modify-write */
+static bool update_counters(const Xvr_LLVMObjectCache* cache,
+                            const Xvr_CacheCounters* delta,
+                            Xvr_CacheCounters* out) {
+    std::string path = std::string(cache->dir) + "/stats";
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        return false;
+    }
+
+    Xvr_CacheCounters counters = {0, 0, 0, 0};
+    char text[256] = {0};
+    ssize_t got = pread(fd, text, sizeof(text) - 1, 0);
+    if (got > 0) {
+        unsigned long long hits = 0, misses = 0, stores = 0, evictions = 0;
+        if (sscanf(text, "hits %llu misses %llu stores %llu evictions %llu",
+                   &hits, &misses, &stores, &evictions) == 4) {
+            counters = {hits, misses, stores, evictions};
+        }
+    }
+
+    bool ok = true;
+    if (delta) {
+        counters.hits += delta->hits;
+        counters.misses += delta->misses;
+        counters.stores += delta->stores;
+        counters.evictions += delta->evictions;
+        int len = snprintf(text, sizeof(text),
+                           "hits %llu misses %llu stores %llu evictions %llu\n",
+                           (unsigned long long)counters.hits,
+                           (unsigned long long)counters.misses,
+                           (unsigned long long)counters.stores,
+                           (unsigned long long)counters.evictions);
+        ok = ftruncate(fd, 0) == 0 &&
+             pwrite(fd, text, (size_t)len, 0) == (ssize_t)len;
+    }
+    if (out) {
+        *out = counters;
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+    return ok;
+}
+
+static void count_event(const Xvr_LLVMObjectCache* cache, uint64_t hits,
+                        uint64_t misses, uint64_t stores, uint64_t evictions) {
+    Xvr_CacheCounters delta = {hits, misses, stores, evictions};
+    update_counters(cache, &delta, NULL);
+}
+
+typedef struct {
+    std::string path;
+    off_t size;
+    struct timespec used;
+} Xvr_CacheEntry;
+
+static bool is_entry_name(const char* name) {
+    size_t len = strlen(name);
+    return (len > 4 && strcmp(name + len - 4, ".obj") == 0) ||
+           (len > 9 && strcmp(name + len - 9, ".manifest") == 0);
+}
+
+static bool is_stale_tmp(const std::string& path, time_t now) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 &&
+           now - st.st_mtim.tv_sec > XVR_OBJECT_CACHE_STALE_TMP_SECONDS;
+}
+
+/* with `sweep`, temporary files left by killed compilers go as well */
+static std::vector<Xvr_CacheEntry> list_entries(
+    const Xvr_LLVMObjectCache* cache, bool sweep) {
+    std::vector<Xvr_CacheEntry> entries;
+    DIR* dir = opendir(cache->dir);
+    if (!dir) {
+        return entries;
+    }
+    time_t now = time(NULL);
+    struct dirent* item;
+    while ((item = readdir(dir)) != NULL) {
+        if (sweep && strncmp(item->d_name, ".tmp-", 5) == 0) {
+            std::string path = std::string(cache->dir) + "/" + item->d_name;
+            if (is_stale_tmp(path, now)) {
+                unlink(path.c_str());
+            }
+            continue;
+        }
+        if (!is_entry_name(item->d_name)) {
+            continue;
+        }
+        Xvr_CacheEntry entry;
+        entry.path = std::string(cache->dir) + "/" + item->d_name;
+        struct stat st;
+        if (stat(entry.path.c_str(), &st) != 0) {
+            continue; /* evicted by another compiler meanwhile */
+        }
+        entry.size = st.st_size;
+        entry.used = st.st_mtim;
+        entries.push_back(entry);
+    }
+    closedir(dir);
+    return entries;
+}
+
+/* hits refresh the mtime, so the oldest mtime is the least recently used.
+ * trimming to 90% of the limit keeps every store from scanning again */
+static void evict(const Xvr_LLVMObjectCache* cache) {
+    std::vector<Xvr_CacheEntry> entries = list_entries(cache, true);
+    uint64_t total = 0;
+    for (const Xvr_CacheEntry& entry : entries) {
+        total += (uint64_t)entry.size;
+    }
+    if (total <= cache->max_bytes) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Xvr_CacheEntry& a, const Xvr_CacheEntry& b) {
+                  if (a.used.tv_sec != b.used.tv_sec) {
+                      return a.used.tv_sec < b.used.tv_sec;
+                  }
+                  if (a.used.tv_nsec != b.used.tv_nsec) {
+                      return a.used.tv_nsec < b.used.tv_nsec;
+                  }
+                  return a.path < b.path;
+              });
+
+    uint64_t target = cache->max_bytes / 10 * 9;
+    uint64_t evicted = 0;
+    for (const Xvr_CacheEntry& entry : entries) {
+        if (total <= target) {
+            break;
+        }
+        if (unlink(entry.path.c_str()) == 0) {
+            evicted++;
+        }
+        total -= (uint64_t)entry.size;
+    }
+    if (evicted > 0) {
+        count_event(cache, 0, 0, 0, evicted);
+    }
+}
+
+static std::string manifest_key(const char* fingerprint, const void* source,
+                                size_t source_size) {
+    std::string data = XVR_OBJECT_CACHE_FORMAT;
+    char version[128];
+    snprintf(version, sizeof(version), "%d.%d.%d %s llvm %s",
+             XVR_VERSION_MAJOR, XVR_VERSION_MINOR, XVR_VERSION_PATCH,
+             XVR_VERSION_BUILD, LLVM_VERSION_STRING);
+    data.push_back('\0');
+    data += version;
+    data.push_back('\0');
+    data += fingerprint ? fingerprint : "";
+    data.push_back('\0');
+    data.append((const char*)source, source_size);
+    return hash_hex(data);
+}
+
+/* manifest lines are "<content hash> <path>"; true while every dependency
+ * on disk still hashes to what the manifest recorded */
+static bool manifest_current(const std::string& manifest) {
+    size_t start = 0;
+    while (start < manifest.size()) {
+        size_t end = manifest.find('\n', start);
+        if (end == std::string::npos) {
+            return false;
+        }
+        size_t space = manifest.find(' ', start);
+        if (space == std::string::npos || space > end) {
+            return false;
+        }
+        std::string path = manifest.substr(space + 1, end - space - 1);
+        std::string contents;
+        if (!read_whole_file(path, &contents) ||
+            manifest.compare(start, space - start, hash_hex(contents)) != 0) {
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+/* the object key covers the manifest key and the recorded hashes, so it
+ * only needs the manifest once that is known to be current */
+static std::string object_key(const std::string& manifest,
+                              const std::string& key) {
+    std::string data = key;
+    data.push_back('\0');
+    data += manifest;
+    return hash_hex(data);
+}
+
+Xvr_LLVMObjectCache* Xvr_LLVMObjectCacheCreate(const char* dir,
+                                               uint64_t max_bytes) {
+    if (!dir || !*dir || llvm::sys::fs::create_directories(dir)) {
+        return NULL;
+    }
+    Xvr_LLVMObjectCache* cache =
+        (Xvr_LLVMObjectCache*)calloc(1, sizeof(Xvr_LLVMObjectCache));
+    if (!cache) {
+        return NULL;
+    }
+    cache->dir = strdup(dir);
+    if (!cache->dir) {
+        free(cache);
+        return NULL;
+    }
+    cache->max_bytes = max_bytes ? max_bytes : XVR_OBJECT_CACHE_DEFAULT_SIZE;
+    mode_t mask = umask(0);
+    umask(mask);
+    cache->file_mode = 0644 & ~mask;
+    return cache;
+}
+
+void Xvr_LLVMObjectCacheDestroy(Xvr_LLVMObjectCache* cache) {
+    if (!cache) {
+        return;
+    }
+    free(cache->dir);
+    free(cache);
+}
+
+/* an entry is the magic, the object count, their sizes, then the objects;
+ * a truncated or foreign file fails the size check and counts as a miss */
+static void** unpack_entry(const std::string& entry, size_t** out_sizes,
+                           size_t* out_count) {
+    if (entry.size() < 8 || memcmp(entry.data(), entry_magic, 4) != 0) {
+        return NULL;
+    }
+    uint32_t count;
+    memcpy(&count, entry.data() + 4, sizeof(count));
+    size_t offset = 8 + (size_t)count * sizeof(uint64_t);
+    if (count == 0 || offset > entry.size()) {
+        return NULL;
+    }
+
+    void** objects = (void**)calloc(count, sizeof(void*));
+    size_t* sizes = (size_t*)calloc(count, sizeof(size_t));
+    bool ok = objects && sizes;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        uint64_t size;
+        memcpy(&size, entry.data() + 8 + i * sizeof(uint64_t), sizeof(size));
+        ok = size <= entry.size() - offset;
+        if (ok) {
+            objects[i] = malloc(size ? size : 1);
+            ok = objects[i] != NULL;
+        }
+        if (ok) {
+            memcpy(objects[i], entry.data() + offset, size);
+            sizes[i] = size;
+            offset += size;
+        }
+    }
+    if (!ok || offset != entry.size()) {
+        for (uint32_t i = 0; objects && i < count; i++) {
+            free(objects[i]);
+        }
+        free(objects);
+        free(sizes);
+        return NULL;
+    }
+    *out_sizes = sizes;
+    *out_count = count;
+    return objects;
+}
+
+void** Xvr_LLVMObjectCacheLookup(Xvr_LLVMObjectCache* cache,
+                                 const char* fingerprint, const void* source,
+                                 size_t source_size, size_t** out_sizes,
+                                 size_t* out_count) {
+    if (!cache || !source || !out_sizes || !out_count) {
+        return NULL;
+    }
+
+    std::string key = manifest_key(fingerprint, source, source_size);
+    std::string manifest_path = entry_path(cache, key, ".manifest");
+    std::string manifest;
+    std::string entry;
+    void** objects = NULL;
+    if (read_whole_file(manifest_path, &manifest) &&
+        manifest_current(manifest)) {
+        std::string object_path =
+            entry_path(cache, object_key(manifest, key), ".obj");
+        if (read_whole_file(object_path, &entry)) {
+            objects = unpack_entry(entry, out_sizes, out_count);
+        }
+        if (objects) {
+            utimensat(AT_FDCWD, manifest_path.c_str(), NULL, 0);
+            utimensat(AT_FDCWD, object_path.c_str(), NULL, 0);
+        }
+    }
+
+    count_event(cache, objects ? 1 : 0, objects ? 0 : 1, 0, 0);
+    return objects;
+}
+
+bool Xvr_LLVMObjectCacheStore(Xvr_LLVMObjectCache* cache,
+                              const char* fingerprint, const void* source,
+                              size_t source_size, const char* const* deps,
+                              size_t dep_count, const void* const* objects,
+                              const size_t* sizes, size_t count) {
+    if (!cache || !source || !objects || !sizes || count == 0 ||
+        count > UINT32_MAX) {
+        return false;
+    }
+
+    std::string manifest;
+    for (size_t i = 0; i < dep_count; i++) {
+        std::string contents;
+        if (!deps[i] || strchr(deps[i], '\n') ||
+            !read_whole_file(deps[i], &contents)) {
+            return false;
+        }
+        manifest += hash_hex(contents);
+        manifest.push_back(' ');
+        manifest += deps[i];
+        manifest.push_back('\n');
+    }
+
+    std::string key = manifest_key(fingerprint, source, source_size);
+    std::string objects_key = object_key(manifest, key);
+
+    std::string entry(entry_magic, sizeof(entry_magic));
+    uint32_t count32 = (uint32_t)count;
+    entry.append((const char*)&count32, sizeof(count32));
+    for (size_t i = 0; i < count; i++) {
+        uint64_t size = sizes[i];
+        entry.append((const char*)&size, sizeof(size));
+    }
+    for (size_t i = 0; i < count; i++) {
+        entry.append((const char*)objects[i], sizes[i]);
+    }
+
+    /* the objects go first: a manifest never points at a missing entry
+     * unless eviction removed it, which is a plain miss */
+    if (!write_atomically(cache, entry_path(cache, objects_key, ".obj"),
+                          entry) ||
+        !write_atomically(cache, entry_path(cache, key, ".manifest"),
+                          manifest)) {
+        return false;
+    }
+    count_event(cache, 0, 0, 1, 0);
+    evict(cache);
+    return true;
+}
+
+bool Xvr_LLVMObjectCacheGetStats(Xvr_LLVMObjectCache* cache,
+                                 Xvr_LLVMObjectCacheStats* out_stats) {
+    if (!cache || !out_stats) {
+        return false;
+    }
+    Xvr_CacheCounters counters;
+    if (!update_counters(cache, NULL, &counters)) {
+        return false;
+    }
+    out_stats->hits = counters.hits;
+    out_stats->misses = counters.misses;
+    out_stats->stores = counters.stores;
+    out_stats->evictions = counters.evictions;
+    out_stats->entries = 0;
+    out_stats->bytes = 0;
+    for (const Xvr_CacheEntry& entry : list_entries(cache, false)) {
+        if (entry.path.size() > 4 &&
+            entry.path.compare(entry.path.size() - 4, 4, ".obj") == 0) {
+            out_stats->entries++;
+        }
+        out_stats->bytes += (uint64_t)entry.size;
+    }
+    return true;
+}
+
+const char* Xvr_LLVMObjectCacheGetDirectory(Xvr_LLVMObjectCache* cache) {
+    return cache ? cache->dir : NULL;
+}
@@ -22,31 +22,58 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
-/* FIXME: Optimizer crashes when integrated into codegen pipeline.
- * The PassBuilder pipeline causes SIGSEGV (exit code 139) when
- * Xvr_LLVMCodegenRunOptimizer is called after EmitAST.
- *
- * TODO: Debug target machine configuration - the triple may not be
- * properly initialized when LLVMRunPasses is called.
- *
- * TODO: Consider using a simpler optimization approach or deferring
- * optimization until object file emission.
+/* runs the new pass manager pipeline for the selected level over a module.
+ * the module must already be verified: the pipelines assume well-formed IR
+ * and crash on, e.g., a block without a terminator.
  */
 
 #include "xvr_llvm_optimizer.h"
 
 #include <llvm-c/Core.h>
+#include <llvm-c/DebugInfo.h>
 #include <llvm-c/Error.h>
 #include <llvm-c/Transforms/PassBuilder.h>
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Transforms/Instrumentation/PGOInstrumentation.h>
+#include <string>
+
+#include "xvr_common.h"
 #include "xvr_llvm_module_manager.h"
 #include "xvr_llvm_target.h"
 
 struct Xvr_LLVMOptimizer {
     Xvr_LLVMOptimizationLevel level;
     LLVMTargetMachineRef target_machine;
+    char* error_message;
+    /* -1 follows the level, otherwise an explicit on/off override */
+    int loop_vectorize;
+    int slp_vectorize;
+    int loop_unroll;
+    /* -1 uses the level's default threshold */
+    int inliner_threshold;
+    /* user pipeline fragments in order; a NULL entry stands for the level's
+     * default pipeline. empty means the default pipeline alone */
+    char** passes;
+    size_t pass_count;
+    size_t pass_capacity;
+    char* pipeline_text;
+    /* raw profile path baked into instrumented code, NULL when off */
+    char* profile_generate;
+    char* profile_use;
+    /* the level runs as its ThinLTO pre-link half, see SetThinLTOPreLink */
+    bool thin_lto_prelink;
 };
 
 Xvr_LLVMOptimizer* Xvr_LLVMOptimizerCreate(void) {
@@ -56,10 +83,39 @@ Xvr_LLVMOptimizer* Xvr_LLVMOptimizerCreate(void) {
     }
     opt->level = XVR_LLVM_OPT_O2;
     opt->target_machine = NULL;
+    opt->loop_vectorize = -1;
+    opt->slp_vectorize = -1;
+    opt->loop_unroll = -1;
+    opt->inliner_threshold = -1;
     return opt;
 }
 
-void Xvr_LLVMOptimizerDestroy(Xvr_LLVMOptimizer* opt) { free(opt); }
+void Xvr_LLVMOptimizerDestroy(Xvr_LLVMOptimizer* opt) {
+    if (!opt) {
+        return;
+    }
+    for (size_t i = 0; i < opt->pass_count; i++) {
+        free(opt->passes[i]);
+    }
+    free(opt->passes);
+    free(opt->pipeline_text);
+    free(opt->profile_generate);
+    free(opt->profile_use);
+    free(opt->error_message);
+    free(opt);
+}
+
+static void set_error(Xvr_LLVMOptimizer* opt, const char* message) {
+    free(opt->error_message);
+    opt->error_message = message ? Xvr_strdup(message) : NULL;
+}
+
+const char* Xvr_LLVMOptimizerGetError(Xvr_LLVMOptimizer* opt) {
+    if (!opt) {
+        return NULL;
+    }
+    return opt->error_message;
+}
 
 bool Xvr_LLVMOptimizerSetLevel(Xvr_LLVMOptimizer* opt,
                                Xvr_LLVMOptimizationLevel level) {
@@ -79,24 +135,402 @@ bool Xvr_LLVMOptimizerSetTargetMachine(Xvr_LLVMOptimizer* opt,
     return true;
 }
 
-static const char* get_pass_pipeline(Xvr_LLVMOptimizationLevel level) {
+bool Xvr_LLVMOptimizerSetLoopVectorize(Xvr_LLVMOptimizer* opt, bool enable) {
+    if (!opt) {
+        return false;
+    }
+    opt->loop_vectorize = enable ? 1 : 0;
+    return true;
+}
+
+bool Xvr_LLVMOptimizerSetSLPVectorize(Xvr_LLVMOptimizer* opt, bool enable) {
+    if (!opt) {
+        return false;
+    }
+    opt->slp_vectorize = enable ? 1 : 0;
+    return true;
+}
+
+bool Xvr_LLVMOptimizerSetLoopUnrolling(Xvr_LLVMOptimizer* opt, bool enable) {
+    if (!opt) {
+        return false;
+    }
+    opt->loop_unroll = enable ? 1 : 0;
+    return true;
+}
+
+bool Xvr_LLVMOptimizerSetInlinerThreshold(Xvr_LLVMOptimizer* opt,
+                                          int threshold) {
+    if (!opt || threshold < 0) {
+        return false;
+    }
+    opt->inliner_threshold = threshold;
+    return true;
+}
+
+bool Xvr_LLVMOptimizerSetThinLTOPreLink(Xvr_LLVMOptimizer* opt, bool enable) {
+    if (!opt) {
+        return false;
+    }
+    opt->thin_lto_prelink = enable;
+    return true;
+}
+
+bool Xvr_LLVMOptimizerSetProfileGenerate(Xvr_LLVMOptimizer* opt,
+                                         const char* raw_profile_path) {
+    if (!opt) {
+        return false;
+    }
+    char* path = NULL;
+    if (raw_profile_path) {
+        path = Xvr_strdup(raw_profile_path[0] ? raw_profile_path
+                                              : "default_%m.profraw");
+        if (!path) {
+            return false;
+        }
+    }
+    free(opt->profile_generate);
+    opt->profile_generate = path;
+    return true;
+}
+
+/* the first bytes of llvm-profdata's indexed format and of the .profraw
+ * files instrumented programs write */
+static const char indexed_profile_magic[8] = {'\xff', 'l', 'p', 'r',
+                                              'o',    'f', 'i', '\x81'};
+static const char raw_profile_magic[8] = {'\xff', 'l', 'p', 'r',
+                                          'o',    'f', 'r', '\x81'};
+
+bool Xvr_LLVMOptimizerSetProfileUse(Xvr_LLVMOptimizer* opt,
+                                    const char* profile_path) {
+    if (!opt) {
+        return false;
+    }
+    if (!profile_path) {
+        free(opt->profile_use);
+        opt->profile_use = NULL;
+        return true;
+    }
+
+    /* checked here, a profile the use pass cannot read is a hard error
+     * reported only after the whole module has been generated */
+    char magic[8] = {0};
+    FILE* file = fopen(profile_path, "rb"); /* Flawfinder: ignore */
+    if (!file) {
+        char message[1024];
+        snprintf(message, sizeof(message), "cannot open profile '%s': %s",
+                 profile_path, strerror(errno));
+        set_error(opt, message);
+        return false;
+    }
+    size_t read = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    if (read != sizeof(magic) ||
+        memcmp(magic, indexed_profile_magic, sizeof(magic)) != 0) {
+        bool raw = read == sizeof(magic) &&
+                   memcmp(magic, raw_profile_magic, sizeof(magic)) == 0;
+        char message[1024];
+        snprintf(message, sizeof(message),
+                 raw ? "'%s' is a raw profile, merge it with "
+                       "'llvm-profdata merge -o <file>.profdata' first"
+                     : "'%s' is not an indexed profile",
+                 profile_path);
+        set_error(opt, message);
+        return false;
+    }
+
+    char* path = Xvr_strdup(profile_path);
+    if (!path) {
+        return false;
+    }
+    free(opt->profile_use);
+    opt->profile_use = path;
+    set_error(opt, NULL);
+    return true;
+}
+
+/* the size levels trade the code growth of vector bodies and their scalar
+ * epilogues away, O1 keeps compile time low */
+static bool level_vectorizes(Xvr_LLVMOptimizationLevel level) {
+    return level == XVR_LLVM_OPT_O2 || level == XVR_LLVM_OPT_O3;
+}
+
+static bool block_precedes(LLVMBasicBlockRef target, LLVMBasicBlockRef block) {
+    for (LLVMBasicBlockRef bb = target; bb; bb = LLVMGetNextBasicBlock(bb)) {
+        if (bb == block) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* some LLVM releases ignore the pipeline's loop vectorization knob, so an
+ * explicit "off" is also written onto every loop as llvm.loop metadata. the
+ * emitter lays blocks out in source order, so a branch to an earlier block
+ * is a loop latch */
+static void disable_loop_vectorize_hints(LLVMModuleRef module) {
+    LLVMContextRef ctx = LLVMGetModuleContext(module);
+    unsigned loop_kind = LLVMGetMDKindIDInContext(ctx, "llvm.loop", 9);
+
+    const char* name = "llvm.loop.vectorize.enable";
+    LLVMMetadataRef hint_ops[2] = {
+        LLVMMDStringInContext2(ctx, name, strlen(name)),
+        LLVMValueAsMetadata(LLVMConstInt(LLVMInt1TypeInContext(ctx), 0, 0))};
+    LLVMMetadataRef hint = LLVMMDNodeInContext2(ctx, hint_ops, 2);
+
+    for (LLVMValueRef fn = LLVMGetFirstFunction(module); fn;
+         fn = LLVMGetNextFunction(fn)) {
+        for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(fn); bb;
+             bb = LLVMGetNextBasicBlock(bb)) {
+            LLVMValueRef term = LLVMGetBasicBlockTerminator(bb);
+            if (!term || LLVMGetInstructionOpcode(term) != LLVMBr) {
+                continue;
+            }
+
+            bool latch = false;
+            unsigned count = LLVMGetNumSuccessors(term);
+            for (unsigned i = 0; i < count && !latch; i++) {
+                latch = block_precedes(LLVMGetSuccessor(term, i), bb);
+            }
+            if (!latch) {
+                continue;
+            }
+
+            /* a loop id is a node whose first operand is itself; the
+             * replace frees the temporary placeholder, which must not be
+             * disposed again */
+            LLVMMetadataRef self = LLVMTemporaryMDNode(ctx, NULL, 0);
+            LLVMMetadataRef loop_ops[2] = {self, hint};
+            LLVMMetadataRef loop_id = LLVMMDNodeInContext2(ctx, loop_ops, 2);
+            LLVMMetadataReplaceAllUsesWith(self, loop_id);
+            self = NULL;
+            LLVMSetMetadata(term, loop_kind,
+                            LLVMMetadataAsValue(ctx, loop_id));
+        }
+    }
+}
+
+static const char* get_pass_pipeline(Xvr_LLVMOptimizationLevel level,
+                                     bool thin_lto_prelink) {
+    /* the pre-link pipelines stop before the passes that only pay off once
+     * cross-module imports are in, the ThinLTO backend runs those */
     switch (level) {
     case XVR_LLVM_OPT_NONE:
         return "";
     case XVR_LLVM_OPT_LEGACY:
     case XVR_LLVM_OPT_O1:
-        return "default<O1>";
+        return thin_lto_prelink ? "thinlto-pre-link<O1>" : "default<O1>";
     case XVR_LLVM_OPT_O2:
-        return "default<O2>";
+        return thin_lto_prelink ? "thinlto-pre-link<O2>" : "default<O2>";
+    case XVR_LLVM_OPT_O3:
+        return thin_lto_prelink ? "thinlto-pre-link<O3>" : "default<O3>";
+    case XVR_LLVM_OPT_OS:
+        return thin_lto_prelink ? "thinlto-pre-link<Os>" : "default<Os>";
+    case XVR_LLVM_OPT_OZ:
+        return thin_lto_prelink ? "thinlto-pre-link<Oz>" : "default<Oz>";
+    default:
+        return thin_lto_prelink ? "thinlto-pre-link<O2>" : "default<O2>";
+    }
+}
+
+/* the thresholds clang passes for each level */
+static int level_inliner_threshold(Xvr_LLVMOptimizationLevel level) {
+    switch (level) {
     case XVR_LLVM_OPT_O3:
-        return "default<O3>";
+        return 250;
     case XVR_LLVM_OPT_OS:
-        return "default<Os>";
+        return 75;
     case XVR_LLVM_OPT_OZ:
-        return "default<Oz>";
+        return 25;
     default:
-        return "default<O2>";
+        return 225;
+    }
+}
+
+struct Xvr_PipelineSettings {
+    bool loop_vectorize;
+    bool slp_vectorize;
+    bool loop_unroll;
+    int inliner_threshold;
+};
+
+static Xvr_PipelineSettings resolve_settings(const Xvr_LLVMOptimizer* opt) {
+    bool by_level = level_vectorizes(opt->level);
+    Xvr_PipelineSettings settings;
+    settings.loop_vectorize =
+        opt->loop_vectorize < 0 ? by_level : opt->loop_vectorize == 1;
+    settings.slp_vectorize =
+        opt->slp_vectorize < 0 ? by_level : opt->slp_vectorize == 1;
+    settings.loop_unroll = opt->loop_unroll != 0;
+    settings.inliner_threshold = opt->inliner_threshold < 0
+                                     ? level_inliner_threshold(opt->level)
+                                     : opt->inliner_threshold;
+    return settings;
+}
+
+/* joins the fragments into the textual pipeline LLVMRunPasses parses, a
+ * standard entry expands to the level's default<..> pipeline */
+static std::string build_pipeline(const Xvr_LLVMOptimizer* opt) {
+    /* counters go in before any optimization, so the instrumented and the
+     * profile-use builds see the same CFG and their function hashes match */
+    std::string pipeline = opt->profile_generate ? "pgo-instr-gen,instrprof"
+                                                 : "";
+    if (opt->pass_count == 0) {
+        const char* level =
+            get_pass_pipeline(opt->level, opt->thin_lto_prelink);
+        if (level[0] && !pipeline.empty()) {
+            pipeline += ',';
+        }
+        return pipeline + level;
     }
+
+    for (size_t i = 0; i < opt->pass_count; i++) {
+        const char* part =
+            opt->passes[i]
+                ? opt->passes[i]
+                : get_pass_pipeline(opt->level, opt->thin_lto_prelink);
+        if (!part[0]) {
+            continue;
+        }
+        if (!pipeline.empty()) {
+            pipeline += ',';
+        }
+        pipeline += part;
+    }
+    return pipeline;
+}
+
+static bool push_pass(Xvr_LLVMOptimizer* opt, char* pass) {
+    if (opt->pass_count == opt->pass_capacity) {
+        size_t capacity = opt->pass_capacity ? opt->pass_capacity * 2 : 4;
+        char** grown =
+            (char**)realloc(opt->passes, capacity * sizeof(char*));
+        if (!grown) {
+            return false;
+        }
+        opt->passes = grown;
+        opt->pass_capacity = capacity;
+    }
+    opt->passes[opt->pass_count++] = pass;
+    return true;
+}
+
+/* parses a pipeline the same way LLVMRunPasses does, without running it.
+ * on success the expanded pipeline is written to out when given */
+static bool parse_pipeline(Xvr_LLVMOptimizer* opt, const std::string& text,
+                           std::string* out) {
+    Xvr_PipelineSettings settings = resolve_settings(opt);
+    llvm::PipelineTuningOptions tuning;
+    tuning.LoopVectorization = settings.loop_vectorize;
+    tuning.SLPVectorization = settings.slp_vectorize;
+    tuning.LoopUnrolling = settings.loop_unroll;
+    tuning.LoopInterleaving = true;
+#if LLVM_VERSION_MAJOR >= 17
+    tuning.InlinerThreshold = settings.inliner_threshold;
+#endif
+
+    /* the builder only records class -> pass name mappings while the
+     * print-pipeline-passes option is set, without them the listing shows
+     * C++ class names that --passes would not accept */
+    llvm::cl::opt<bool>* names = NULL;
+    if (out) {
+        llvm::StringMap<llvm::cl::Option*>& registered =
+            llvm::cl::getRegisteredOptions();
+        auto found = registered.find("print-pipeline-passes");
+        if (found != registered.end()) {
+            names = static_cast<llvm::cl::opt<bool>*>(found->second);
+        }
+    }
+    bool names_were_set = names && *names;
+    if (names) {
+        names->setValue(true);
+    }
+
+    llvm::PassInstrumentationCallbacks callbacks;
+    llvm::PassBuilder builder(
+        reinterpret_cast<llvm::TargetMachine*>(opt->target_machine), tuning,
+        {}, &callbacks);
+
+    if (names) {
+        names->setValue(names_were_set);
+    }
+
+    llvm::ModulePassManager passes;
+    if (llvm::Error err = builder.parsePassPipeline(passes, text)) {
+        set_error(opt, llvm::toString(std::move(err)).c_str());
+        return false;
+    }
+
+    if (out) {
+        llvm::raw_string_ostream stream(*out);
+        passes.printPipeline(stream, [&](llvm::StringRef name) {
+            llvm::StringRef pass = callbacks.getPassNameForClassName(name);
+            return pass.empty() ? name : pass;
+        });
+        stream.flush();
+    }
+    return true;
+}
+
+/* LLVM exits the process on an error diagnostic unless a handler is set,
+ * so errors from the profile passes are captured here instead */
+static void capture_diagnostic(LLVMDiagnosticInfoRef info, void* context) {
+    Xvr_LLVMOptimizer* opt = (Xvr_LLVMOptimizer*)context;
+    LLVMDiagnosticSeverity severity = LLVMGetDiagInfoSeverity(info);
+    if (severity != LLVMDSError && severity != LLVMDSWarning) {
+        return;
+    }
+
+    char* description = LLVMGetDiagInfoDescription(info);
+    if (severity == LLVMDSWarning) {
+        fprintf(stderr, "warning: %s\n", description);
+    } else if (!opt->error_message) {
+        set_error(opt, description);
+    }
+    LLVMDisposeMessage(description);
+}
+
+/* the profile runtime writes to the path in this variable, where clang
+ * would pass it through -fprofile-generate=<path>. %m and %p are expanded
+ * at run time, LLVM_PROFILE_FILE still takes precedence */
+static void set_profile_filename(LLVMModuleRef module, const char* path) {
+    const char* name = "__llvm_profile_filename";
+    if (LLVMGetNamedGlobal(module, name)) {
+        return;
+    }
+
+    LLVMContextRef ctx = LLVMGetModuleContext(module);
+    LLVMValueRef value =
+        LLVMConstStringInContext(ctx, path, (unsigned)strlen(path), 0);
+    LLVMValueRef global = LLVMAddGlobal(module, LLVMTypeOf(value), name);
+    LLVMSetInitializer(global, value);
+    LLVMSetGlobalConstant(global, 1);
+    LLVMSetLinkage(global, LLVMWeakAnyLinkage);
+    LLVMSetVisibility(global, LLVMHiddenVisibility);
+}
+
+/* attaches the profile before the level pipeline runs: entry counts and
+ * branch weights from the counters, then promotion of hot indirect call
+ * targets recorded by value profiling */
+static void apply_profile(Xvr_LLVMOptimizer* opt, LLVMModuleRef module) {
+    llvm::LoopAnalysisManager loops;
+    llvm::FunctionAnalysisManager functions;
+    llvm::CGSCCAnalysisManager cgscc;
+    llvm::ModuleAnalysisManager modules;
+
+    llvm::PassBuilder builder(
+        reinterpret_cast<llvm::TargetMachine*>(opt->target_machine));
+    builder.registerModuleAnalyses(modules);
+    builder.registerCGSCCAnalyses(cgscc);
+    builder.registerFunctionAnalyses(functions);
+    builder.registerLoopAnalyses(loops);
+    builder.crossRegisterProxies(loops, functions, cgscc, modules);
+
+    llvm::ModulePassManager passes;
+    passes.addPass(llvm::PGOInstrumentationUse(opt->profile_use));
+    passes.addPass(llvm::PGOIndirectCallPromotion());
+    passes.run(*llvm::unwrap(module), modules);
 }
 
 bool Xvr_LLVMOptimizerRun(Xvr_LLVMOptimizer* opt,
@@ -105,7 +539,8 @@ bool Xvr_LLVMOptimizerRun(Xvr_LLVMOptimizer* opt,
         return false;
     }
 
-    if (opt->level == XVR_LLVM_OPT_NONE) {
+    std::string pipeline = build_pipeline(opt);
+    if (pipeline.empty() && !opt->profile_use) {
         return true;
     }
 
@@ -114,35 +549,29 @@ bool Xvr_LLVMOptimizerRun(Xvr_LLVMOptimizer* opt,
         return false;
     }
 
-    const char* pipeline = get_pass_pipeline(opt->level);
-    if (!pipeline || pipeline[0] == '\0') {
-        return true;
+    set_error(opt, NULL);
+    if (opt->profile_generate) {
+        set_profile_filename(llvm_module, opt->profile_generate);
     }
-
-    LLVMTargetMachineRef tm = NULL;
-    if (opt->target_machine) {
-        tm = opt->target_machine;
-    } else {
-        Xvr_LLVMTargetConfig* config = Xvr_LLVMTargetConfigCreate();
-        if (!config) {
+    if (opt->profile_use) {
+        LLVMContextRef ctx = LLVMGetModuleContext(llvm_module);
+        LLVMDiagnosticHandler handler = LLVMContextGetDiagnosticHandler(ctx);
+        void* handler_context = LLVMContextGetDiagnosticContext(ctx);
+        LLVMContextSetDiagnosticHandler(ctx, capture_diagnostic, opt);
+        apply_profile(opt, llvm_module);
+        LLVMContextSetDiagnosticHandler(ctx, handler, handler_context);
+        if (opt->error_message) {
             return false;
         }
-        Xvr_LLVMTargetConfigSetTriple(config, "x86_64-pc-linux-gnu");
-        Xvr_LLVMTargetConfigSetReloc(config, "PIC");
-        Xvr_LLVMTargetConfigSetCodeModel(config, "jitdefault");
-        Xvr_LLVMTargetMachine* xvr_tm = Xvr_LLVMTargetMachineCreate(config);
-        Xvr_LLVMTargetConfigDestroy(config);
-        if (!xvr_tm) {
-            return false;
-        }
-        tm = Xvr_LLVMTargetMachineGetLLVMTargetMachine(xvr_tm);
-        Xvr_LLVMTargetMachineDestroy(xvr_tm);
     }
-
-    if (!tm) {
-        return false;
+    if (pipeline.empty()) {
+        return true;
     }
 
+    /* without a target machine the passes fall back to generic target info;
+     * the codegen always supplies its own so cost models match emission */
+    LLVMTargetMachineRef tm = opt->target_machine;
+
     LLVMPassBuilderOptionsRef options = LLVMCreatePassBuilderOptions();
     if (!options) {
         return false;
@@ -151,38 +580,80 @@ bool Xvr_LLVMOptimizerRun(Xvr_LLVMOptimizer* opt,
     LLVMPassBuilderOptionsSetVerifyEach(options, 0);
     LLVMPassBuilderOptionsSetDebugLogging(options, 0);
     LLVMPassBuilderOptionsSetLoopInterleaving(options, 1);
-    LLVMPassBuilderOptionsSetLoopVectorization(options, 0);
-    LLVMPassBuilderOptionsSetSLPVectorization(options, 0);
-    LLVMPassBuilderOptionsSetLoopUnrolling(options, 1);
+    Xvr_PipelineSettings settings = resolve_settings(opt);
+    if (!settings.loop_vectorize) {
+        disable_loop_vectorize_hints(llvm_module);
+    }
+
+    LLVMPassBuilderOptionsSetLoopVectorization(options,
+                                               settings.loop_vectorize);
+    LLVMPassBuilderOptionsSetSLPVectorization(options, settings.slp_vectorize);
+    LLVMPassBuilderOptionsSetLoopUnrolling(options, settings.loop_unroll);
     LLVMPassBuilderOptionsSetMergeFunctions(options, 0);
     LLVMPassBuilderOptionsSetCallGraphProfile(options, 0);
-    LLVMPassBuilderOptionsSetInlinerThreshold(options, 225);
+    LLVMPassBuilderOptionsSetInlinerThreshold(options,
+                                              settings.inliner_threshold);
 
-    LLVMErrorRef err = LLVMRunPasses(llvm_module, pipeline, tm, options);
+    LLVMErrorRef err =
+        LLVMRunPasses(llvm_module, pipeline.c_str(), tm, options);
 
     LLVMDisposePassBuilderOptions(options);
 
     if (err) {
         char* err_msg = LLVMGetErrorMessage(err);
-        LLVMConsumeError(err);
-        if (err_msg) {
-            free(err_msg);
-        }
+        set_error(opt, err_msg);
+        LLVMDisposeErrorMessage(err_msg);
         return false;
     }
 
+    set_error(opt, NULL);
     return true;
 }
 
 bool Xvr_LLVMOptimizerAddPass(Xvr_LLVMOptimizer* opt, const char* pass_name) {
-    (void)opt;
-    (void)pass_name;
-    return false;
+    if (!opt || !pass_name || !pass_name[0]) {
+        return false;
+    }
+
+    /* reject typos here rather than after the whole module is generated */
+    if (!parse_pipeline(opt, pass_name, NULL)) {
+        return false;
+    }
+
+    char* pass = Xvr_strdup(pass_name);
+    if (!pass || !push_pass(opt, pass)) {
+        free(pass);
+        return false;
+    }
+    set_error(opt, NULL);
+    return true;
 }
 
 bool Xvr_LLVMOptimizerAddStandardPasses(Xvr_LLVMOptimizer* opt) {
     if (!opt) {
         return false;
     }
-    return true;
+    return push_pass(opt, NULL);
+}
+
+const char* Xvr_LLVMOptimizerGetPipeline(Xvr_LLVMOptimizer* opt) {
+    if (!opt) {
+        return NULL;
+    }
+
+    std::string pipeline = build_pipeline(opt);
+    std::string expanded;
+    if (!pipeline.empty() && !parse_pipeline(opt, pipeline, &expanded)) {
+        return NULL;
+    }
+
+    /* the profile is attached by a separate run ahead of the pipeline */
+    if (opt->profile_use) {
+        expanded = expanded.empty() ? "pgo-instr-use,pgo-icall-prom"
+                                    : "pgo-instr-use,pgo-icall-prom," + expanded;
+    }
+
+    free(opt->pipeline_text);
+    opt->pipeline_text = Xvr_strdup(expanded.c_str());
+    return opt->pipeline_text;
 }
@@ -56,10 +56,68 @@ bool Xvr_LLVMOptimizerSetTargetMachine(Xvr_LLVMOptimizer* opt,
                                        LLVMTargetMachineRef tm);
 bool Xvr_LLVMOptimizerRun(Xvr_LLVMOptimizer* opt,
                           Xvr_LLVMModuleManager* module);
+const char* Xvr_LLVMOptimizerGetError(Xvr_LLVMOptimizer* opt);
 
+/**
+ * @brief overrides the per-level vectorization policy
+ * loop and SLP vectorization follow the level unless overridden: on at
+ * O2/O3, off at O1/Os/Oz
+ */
+bool Xvr_LLVMOptimizerSetLoopVectorize(Xvr_LLVMOptimizer* opt, bool enable);
+bool Xvr_LLVMOptimizerSetSLPVectorize(Xvr_LLVMOptimizer* opt, bool enable);
+
+/**
+ * @brief loop unrolling is on unless disabled, the inliner threshold
+ * defaults to clang's value for the level (225, 250 at O3, 75/25 at Os/Oz)
+ */
+bool Xvr_LLVMOptimizerSetLoopUnrolling(Xvr_LLVMOptimizer* opt, bool enable);
+bool Xvr_LLVMOptimizerSetInlinerThreshold(Xvr_LLVMOptimizer* opt,
+                                          int threshold);
+
+/**
+ * @brief instruments the module for profile-guided optimization
+ * counters for function entries and branches plus value profiles of
+ * indirect call targets are inserted before the level's pipeline; the
+ * program writes them to raw_profile_path at exit ("" picks
+ * default_%m.profraw, NULL turns instrumentation off). the executable must
+ * be linked with Xvr_LLVMLinkerLinkInstrumentedExecutable
+ */
+bool Xvr_LLVMOptimizerSetProfileGenerate(Xvr_LLVMOptimizer* opt,
+                                         const char* raw_profile_path);
+
+/**
+ * @brief swaps the level's default<..> pipeline for thinlto-pre-link<..>
+ * for modules that are written as ThinLTO bitcode and optimized again
+ * once Xvr_LLVMThinLinkRun has imported across module boundaries
+ */
+bool Xvr_LLVMOptimizerSetThinLTOPreLink(Xvr_LLVMOptimizer* opt, bool enable);
+
+/**
+ * @brief optimizes with an indexed profile from `llvm-profdata merge`
+ * entry counts, branch weights and indirect call promotion are applied
+ * before the level's pipeline. the file is checked here, so a missing file
+ * or an unmerged .profraw fails with the reason in Xvr_LLVMOptimizerGetError
+ */
+bool Xvr_LLVMOptimizerSetProfileUse(Xvr_LLVMOptimizer* opt,
+                                    const char* profile_path);
+
+/**
+ * @brief appends a textual new pass manager pipeline fragment, e.g.
+ * "function(sroa,instcombine)" or "inline,gvn"
+ * once a fragment is added only the listed passes run, call
+ * Xvr_LLVMOptimizerAddStandardPasses to keep the level's default pipeline
+ * in front of (or behind) them. fragments are parsed on entry, so unknown
+ * pass names fail here with the reason in Xvr_LLVMOptimizerGetError
+ */
 bool Xvr_LLVMOptimizerAddPass(Xvr_LLVMOptimizer* opt, const char* pass_name);
 bool Xvr_LLVMOptimizerAddStandardPasses(Xvr_LLVMOptimizer* opt);
 
+/**
+ * @brief the fully expanded pipeline Xvr_LLVMOptimizerRun would execute,
+ * empty when nothing runs. owned by the optimizer until the next call
+ */
+const char* Xvr_LLVMOptimizerGetPipeline(Xvr_LLVMOptimizer* opt);
+
 #ifdef __cplusplus
 }
 #endif
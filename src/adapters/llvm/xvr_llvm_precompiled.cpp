@@ -0,0 +1,312 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_llvm_precompiled.h"
+
+#include <errno.h>
+#include <llvm/Config/llvm-config.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Metadata.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/raw_ostream.h>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "xvr_common.h"
+
+/* bump when the layout of the tables changes, old files then go stale */
+#define XVR_PRECOMPILED_FORMAT "xvr-precompiled-1"
+
+#define HEADER_METADATA "xvr.precompiled"
+#define PROCS_METADATA "xvr.procs"
+#define IMPORTS_METADATA "xvr.imports"
+
+struct Xvr_LLVMPrecompiledModule {
+    std::string path;
+    std::unique_ptr<llvm::Module> module;
+    std::vector<std::string> procs;
+    std::vector<std::string> imports;
+};
+
+static void set_error(char** out_error, const char* format, ...) {
+    if (!out_error) {
+        return;
+    }
+    char message[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    *out_error = Xvr_strdup(message);
+}
+
+static std::string compiler_version(void) {
+    char version[128];
+    snprintf(version, sizeof(version), "%d.%d.%d %s llvm %s",
+             XVR_VERSION_MAJOR, XVR_VERSION_MINOR, XVR_VERSION_PATCH,
+             XVR_VERSION_BUILD, LLVM_VERSION_STRING);
+    return version;
+}
+
+static std::string hash_hex(const void* data, size_t size) {
+    std::array<uint8_t, 32> digest = llvm::SHA256::hash(
+        llvm::ArrayRef<uint8_t>((const uint8_t*)data, size));
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(digest.size() * 2);
+    for (uint8_t byte : digest) {
+        hex.push_back(digits[byte >> 4]);
+        hex.push_back(digits[byte & 0xf]);
+    }
+    return hex;
+}
+
+static void add_strings(llvm::Module& module, const char* name,
+                        const std::vector<std::string>& strings) {
+    llvm::LLVMContext& ctx = module.getContext();
+    llvm::NamedMDNode* table = module.getOrInsertNamedMetadata(name);
+    for (const std::string& string : strings) {
+        table->addOperand(
+            llvm::MDNode::get(ctx, llvm::MDString::get(ctx, string)));
+    }
+}
+
+/* each operand of a table is a node holding strings */
+static std::vector<std::string> read_strings(llvm::NamedMDNode* table) {
+    std::vector<std::string> strings;
+    if (!table) {
+        return strings;
+    }
+    for (llvm::MDNode* node : table->operands()) {
+        for (const llvm::MDOperand& operand : node->operands()) {
+            if (llvm::MDString* string =
+                    llvm::dyn_cast_or_null<llvm::MDString>(operand.get())) {
+                strings.push_back(string->getString().str());
+            }
+        }
+    }
+    return strings;
+}
+
+static void remove_tables(llvm::Module& module) {
+    for (const char* name : {HEADER_METADATA, PROCS_METADATA, IMPORTS_METADATA}) {
+        if (llvm::NamedMDNode* table = module.getNamedMetadata(name)) {
+            module.eraseNamedMetadata(table);
+        }
+    }
+}
+
+static bool write_all(int fd, const void* data, size_t size) {
+    const char* cursor = (const char*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, cursor, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        cursor += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+char* Xvr_LLVMPrecompiledPath(const char* source_path) {
+    if (!source_path) {
+        return NULL;
+    }
+    size_t length = strlen(source_path);
+    char* path = (char*)malloc(length + 2);
+    if (!path) {
+        return NULL;
+    }
+    memcpy(path, source_path, length);
+    path[length] = 'm';
+    path[length + 1] = '\0';
+    return path;
+}
+
+bool Xvr_LLVMPrecompiledWrite(Xvr_LLVMModuleManager* mgr, const void* source,
+                              size_t source_size,
+                              const char* const* imports,
+                              size_t import_count, const char* output_path,
+                              char** out_error) {
+    if (!mgr || !source || !output_path) {
+        set_error(out_error, "no module to precompile");
+        return false;
+    }
+    llvm::Module& module = *llvm::unwrap(Xvr_LLVMModuleManagerGetModule(mgr));
+
+    std::vector<std::string> procs;
+    for (llvm::Function& fn : module) {
+        if (!fn.isDeclaration() && !fn.hasLocalLinkage()) {
+            procs.push_back(fn.getName().str());
+        }
+    }
+    std::vector<std::string> import_names;
+    for (size_t i = 0; i < import_count; i++) {
+        import_names.push_back(imports[i]);
+    }
+
+    add_strings(module, HEADER_METADATA,
+                {XVR_PRECOMPILED_FORMAT, compiler_version(),
+                 hash_hex(source, source_size)});
+    add_strings(module, PROCS_METADATA, procs);
+    add_strings(module, IMPORTS_METADATA, import_names);
+
+    std::string bitcode;
+    llvm::raw_string_ostream stream(bitcode);
+    llvm::WriteBitcodeToFile(module, stream);
+    stream.flush();
+    remove_tables(module);
+
+    /* importers see either the old file or the complete new one */
+    std::string tmp = std::string(output_path) + ".tmp-XXXXXX";
+    int fd = mkstemp(&tmp[0]);
+    if (fd < 0) {
+        set_error(out_error, "cannot write '%s': %s", output_path,
+                  strerror(errno));
+        return false;
+    }
+    bool ok = fchmod(fd, 0644) == 0 &&
+              write_all(fd, bitcode.data(), bitcode.size());
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), output_path) != 0) {
+        set_error(out_error, "cannot write '%s': %s", output_path,
+                  strerror(errno));
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+Xvr_LLVMPrecompiledModule* Xvr_LLVMPrecompiledLoad(LLVMContextRef ctx,
+                                                   const char* source_path) {
+    if (!ctx || !source_path) {
+        return NULL;
+    }
+    char* path = Xvr_LLVMPrecompiledPath(source_path);
+    if (!path) {
+        return NULL;
+    }
+    std::string precompiled_path = path;
+    free(path);
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> bitcode =
+        llvm::MemoryBuffer::getFile(precompiled_path);
+    if (!bitcode) {
+        return NULL;
+    }
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> source =
+        llvm::MemoryBuffer::getFile(source_path);
+    if (!source) {
+        return NULL;
+    }
+
+    llvm::Expected<std::unique_ptr<llvm::Module>> parsed =
+        llvm::parseBitcodeFile(bitcode.get()->getMemBufferRef(),
+                               *llvm::unwrap(ctx));
+    if (!parsed) {
+        llvm::consumeError(parsed.takeError());
+        return NULL;
+    }
+    std::unique_ptr<llvm::Module> module = std::move(*parsed);
+
+    std::vector<std::string> header =
+        read_strings(module->getNamedMetadata(HEADER_METADATA));
+    if (header.size() != 3 || header[0] != XVR_PRECOMPILED_FORMAT ||
+        header[1] != compiler_version() ||
+        header[2] != hash_hex(source.get()->getBufferStart(),
+                              source.get()->getBufferSize())) {
+        return NULL;
+    }
+
+    Xvr_LLVMPrecompiledModule* precompiled =
+        new (std::nothrow) Xvr_LLVMPrecompiledModule();
+    if (!precompiled) {
+        return NULL;
+    }
+    precompiled->path = precompiled_path;
+    precompiled->procs =
+        read_strings(module->getNamedMetadata(PROCS_METADATA));
+    precompiled->imports =
+        read_strings(module->getNamedMetadata(IMPORTS_METADATA));
+    remove_tables(*module);
+    precompiled->module = std::move(module);
+    return precompiled;
+}
+
+void Xvr_LLVMPrecompiledDestroy(Xvr_LLVMPrecompiledModule* module) {
+    delete module;
+}
+
+size_t Xvr_LLVMPrecompiledGetProcCount(Xvr_LLVMPrecompiledModule* module) {
+    return module ? module->procs.size() : 0;
+}
+
+const char* Xvr_LLVMPrecompiledGetProc(Xvr_LLVMPrecompiledModule* module,
+                                       size_t index) {
+    if (!module || index >= module->procs.size()) {
+        return NULL;
+    }
+    return module->procs[index].c_str();
+}
+
+size_t Xvr_LLVMPrecompiledGetImportCount(Xvr_LLVMPrecompiledModule* module) {
+    return module ? module->imports.size() : 0;
+}
+
+const char* Xvr_LLVMPrecompiledGetImport(Xvr_LLVMPrecompiledModule* module,
+                                         size_t index) {
+    if (!module || index >= module->imports.size()) {
+        return NULL;
+    }
+    return module->imports[index].c_str();
+}
+
+bool Xvr_LLVMPrecompiledLink(Xvr_LLVMPrecompiledModule* module,
+                             Xvr_LLVMModuleManager* mgr, char** out_error) {
+    if (!module || !module->module) {
+        set_error(out_error, "precompiled module already linked");
+        return false;
+    }
+    return Xvr_LLVMModuleManagerLinkModule(
+        mgr, llvm::wrap(module->module.release()), module->path.c_str(),
+        out_error);
+}
@@ -0,0 +1,512 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_llvm_repl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../../sema/xvr_builtin.h"
+#include "../../xvr_compiler_session.h"
+#include "xvr_ast_node.h"
+#include "xvr_console_colors.h"
+#include "xvr_lexer.h"
+#include "xvr_llvm_codegen.h"
+#include "xvr_parser.h"
+
+namespace {
+
+/* the latest top-level variable of a name, see Xvr_LLVMReplVar */
+struct ReplVar {
+    std::string name;
+    std::string symbol;
+    std::string type;
+    Xvr_LiteralType var_type;
+    int array_count;
+};
+
+double get_time_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+const char* proc_name(Xvr_ASTNode* node) {
+    Xvr_Literal* ident = &node->fnDecl.identifier;
+    if (ident->type != XVR_LITERAL_IDENTIFIER || !ident->as.identifier.ptr) {
+        return NULL;
+    }
+    return ident->as.identifier.ptr->data;
+}
+
+/* the procs among top-level nodes, members of a collection included */
+void collect_procs(Xvr_ASTNode** nodes, int count,
+                   std::vector<Xvr_ASTNode*>* out) {
+    for (int i = 0; i < count; i++) {
+        if (nodes[i]->type == XVR_AST_NODE_FN_DECL) {
+            out->push_back(nodes[i]);
+        } else if (nodes[i]->type == XVR_AST_NODE_FN_COLLECTION) {
+            for (int j = 0; j < nodes[i]->fnCollection.count; j++) {
+                out->push_back(&nodes[i]->fnCollection.nodes[j]);
+            }
+        }
+    }
+}
+
+bool is_proc(Xvr_ASTNode* node) {
+    return node->type == XVR_AST_NODE_FN_DECL ||
+           node->type == XVR_AST_NODE_FN_COLLECTION;
+}
+
+void free_nodes(Xvr_ASTNode** nodes, int count) {
+    for (int i = 0; i < count; i++) {
+        Xvr_freeASTNode(nodes[i]);
+    }
+    free(nodes);
+}
+
+Xvr_ASTNode** parse_entry(Xvr_CompilerSession* session, const char* source,
+                          int* out_count) {
+    Xvr_Lexer lexer;
+    Xvr_Parser parser;
+    Xvr_initLexerWithSession(&lexer, source, session);
+    Xvr_initParser(&parser, &lexer);
+
+    std::vector<Xvr_ASTNode*> nodes;
+    bool failed = false;
+    for (Xvr_ASTNode* node = Xvr_scanParser(&parser); node;
+         node = Xvr_scanParser(&parser)) {
+        failed = failed || node->type == XVR_AST_NODE_ERROR;
+        nodes.push_back(node);
+    }
+    Xvr_freeParser(&parser);
+
+    Xvr_ASTNode** out = failed ? NULL
+                               : (Xvr_ASTNode**)calloc(nodes.size() + 1,
+                                                       sizeof(Xvr_ASTNode*));
+    if (!out) {
+        for (Xvr_ASTNode* node : nodes) {
+            Xvr_freeASTNode(node);
+        }
+        return NULL;
+    }
+    for (size_t i = 0; i < nodes.size(); i++) {
+        out[i] = nodes[i];
+    }
+    *out_count = (int)nodes.size();
+    return out;
+}
+
+/* every identifier the entry spells, what it may load or call */
+std::unordered_set<std::string> entry_names(const char* source) {
+    std::unordered_set<std::string> names;
+    Xvr_Lexer lexer;
+    Xvr_initLexer(&lexer, source);
+    for (;;) {
+        Xvr_Token token = Xvr_private_scanLexer(&lexer);
+        if (token.type == XVR_TOKEN_EOF || token.type == XVR_TOKEN_ERROR) {
+            break;
+        }
+        if (token.type == XVR_TOKEN_IDENTIFIER) {
+            names.emplace(token.lexeme, (size_t)token.length);
+        }
+    }
+    return names;
+}
+
+}  // namespace
+
+struct Xvr_LLVMRepl {
+    Xvr_CompilerSession* session = nullptr;
+    Xvr_LLVMJIT* jit = nullptr;
+    Xvr_ModuleResolver* resolver = nullptr;
+    unsigned entries = 0;
+
+    std::unordered_map<std::string, ReplVar> vars;
+    /* declarations of the procs in the engine, for the entries naming
+     * them; `kept` owns the nodes they point into */
+    std::unordered_map<std::string, Xvr_ASTNode*> procs;
+    std::vector<Xvr_ASTNode*> kept;
+    /* imported modules already in the engine */
+    std::unordered_set<std::string> modules;
+};
+
+static void report(Xvr_LLVMRepl* repl, const char* message) {
+    Xvr_CompilerSessionReport(repl->session, 0, message);
+    if (Xvr_CompilerSessionPrintsDiagnostics(repl->session)) {
+        fprintf(stderr, "%serror%s: %s\n", XVR_CC_FONT_RED, XVR_CC_RESET,
+                message);
+    }
+}
+
+static void report_codegen(Xvr_LLVMRepl* repl, Xvr_LLVMCodegen* codegen,
+                           const char* fallback) {
+    const char* err = Xvr_LLVMCodegenGetError(codegen);
+    report(repl, err ? err : fallback);
+}
+
+static Xvr_LLVMCodegen* create_codegen(Xvr_LLVMRepl* repl, const char* name) {
+    Xvr_LLVMCodegen* codegen =
+        Xvr_LLVMCodegenCreateWithSession(name, repl->session);
+    if (!codegen) {
+        report(repl, "failed to initialize code generator");
+        return NULL;
+    }
+    /* runtime helpers are bound by the engine, a copy per module would
+     * define them twice */
+    Xvr_LLVMCodegenSetRuntimeBitcode(codegen, NULL);
+    Xvr_LLVMCodegenSetCodegenJobs(codegen, 1);
+    return codegen;
+}
+
+static bool finish_module(Xvr_LLVMRepl* repl, Xvr_LLVMCodegen* codegen) {
+    const Xvr_CompilerOptions* options =
+        Xvr_CompilerSessionGetOptions(repl->session);
+    bool ok = options->optimizationLevel > 0
+                  ? Xvr_LLVMCodegenRunOptimizer(codegen)
+                  : Xvr_LLVMCodegenVerify(codegen);
+    ok = ok && Xvr_LLVMCodegenAddToJIT(codegen, repl->jit);
+    if (!ok) {
+        report_codegen(repl, codegen, "failed to compile the entry");
+    }
+    return ok;
+}
+
+/* keeps the procs of `nodes` for later declarations and frees the rest */
+static void keep_procs(Xvr_LLVMRepl* repl, Xvr_ASTNode** nodes, int count) {
+    std::vector<Xvr_ASTNode*> procs;
+    collect_procs(nodes, count, &procs);
+    for (Xvr_ASTNode* proc : procs) {
+        const char* name = proc_name(proc);
+        if (name) {
+            repl->procs[name] = proc;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (is_proc(nodes[i])) {
+            repl->kept.push_back(nodes[i]);
+        } else {
+            Xvr_freeASTNode(nodes[i]);
+        }
+    }
+    free(nodes);
+}
+
+/* an imported module joins the engine once, as a library unit */
+static bool compile_module(Xvr_LLVMRepl* repl, const char* path) {
+    int count = 0;
+    Xvr_ASTNode** nodes = NULL;
+    if (!Xvr_ModuleResolverLoadModule(repl->resolver, path, &nodes,
+                                      &count)) {
+        std::string message = std::string("could not load module ") + path;
+        report(repl, message.c_str());
+        return false;
+    }
+
+    std::vector<Xvr_ASTNode*> procs;
+    collect_procs(nodes, count, &procs);
+    for (Xvr_ASTNode* proc : procs) {
+        const char* name = proc_name(proc);
+        if (name && repl->procs.count(name)) {
+            std::string message = std::string("proc '") + name +
+                                  "' of " + path + " is already defined";
+            report(repl, message.c_str());
+            free_nodes(nodes, count);
+            return false;
+        }
+    }
+
+    Xvr_LLVMCodegen* codegen = create_codegen(repl, "xvr_repl_module");
+    if (!codegen) {
+        free_nodes(nodes, count);
+        return false;
+    }
+    bool ok = Xvr_LLVMCodegenSetLibraryUnit(codegen, true);
+    for (int i = 0; ok && i < count; i++) {
+        ok = Xvr_LLVMCodegenEmitAST(codegen, nodes[i]);
+    }
+    if (!ok) {
+        report_codegen(repl, codegen, "failed to compile module");
+    }
+    ok = ok && finish_module(repl, codegen);
+    Xvr_LLVMCodegenDestroy(codegen);
+    if (!ok) {
+        free_nodes(nodes, count);
+        return false;
+    }
+    repl->modules.insert(path);
+    keep_procs(repl, nodes, count);
+    return true;
+}
+
+Xvr_LLVMRepl* Xvr_LLVMReplCreate(Xvr_CompilerSession* session) {
+    if (!session) {
+        return NULL;
+    }
+    Xvr_LLVMRepl* repl = new (std::nothrow) Xvr_LLVMRepl();
+    if (!repl) {
+        return NULL;
+    }
+    repl->session = session;
+    repl->jit = Xvr_LLVMJITCreate();
+    repl->resolver = Xvr_ModuleResolverCreate(
+        Xvr_CompilerSessionGetOptions(session)->stdlibPath);
+    if (!repl->jit || !repl->resolver) {
+        Xvr_LLVMReplDestroy(repl);
+        return NULL;
+    }
+    Xvr_ModuleResolverSetSession(repl->resolver, session);
+    return repl;
+}
+
+void Xvr_LLVMReplDestroy(Xvr_LLVMRepl* repl) {
+    if (!repl) {
+        return;
+    }
+    Xvr_LLVMJITDestroy(repl->jit);
+    if (repl->resolver) {
+        Xvr_ModuleResolverDestroy(repl->resolver);
+    }
+    for (Xvr_ASTNode* node : repl->kept) {
+        Xvr_freeASTNode(node);
+    }
+    delete repl;
+}
+
+bool Xvr_LLVMReplIsComplete(const char* source) {
+    if (!source) {
+        return false;
+    }
+    Xvr_Lexer lexer;
+    Xvr_initLexer(&lexer, source);
+    int depth = 0;
+    Xvr_TokenType last = XVR_TOKEN_EOF;
+    for (;;) {
+        Xvr_Token token = Xvr_private_scanLexer(&lexer);
+        if (token.type == XVR_TOKEN_EOF) {
+            break;
+        }
+        /* the parser reports what the lexer cannot read */
+        if (token.type == XVR_TOKEN_ERROR) {
+            return true;
+        }
+        switch (token.type) {
+        case XVR_TOKEN_PAREN_LEFT:
+        case XVR_TOKEN_BRACKET_LEFT:
+        case XVR_TOKEN_BRACE_LEFT:
+            depth++;
+            break;
+        case XVR_TOKEN_PAREN_RIGHT:
+        case XVR_TOKEN_BRACKET_RIGHT:
+        case XVR_TOKEN_BRACE_RIGHT:
+            depth--;
+            break;
+        default:
+            break;
+        }
+        last = token.type;
+    }
+    return depth <= 0 &&
+           (last == XVR_TOKEN_SEMICOLON || last == XVR_TOKEN_BRACE_RIGHT);
+}
+
+bool Xvr_LLVMReplEval(Xvr_LLVMRepl* repl, const char* source,
+                      Xvr_LLVMJITStats* out_stats) {
+    if (!repl || !source) {
+        return false;
+    }
+    double start = get_time_ms();
+
+    int count = 0;
+    Xvr_ASTNode** nodes = parse_entry(repl->session, source, &count);
+    if (!nodes) {
+        Xvr_CompilerSessionReport(repl->session, 0, "parsing failed");
+        return false;
+    }
+
+    /* the engine holds one definition of each symbol */
+    std::vector<Xvr_ASTNode*> defined;
+    collect_procs(nodes, count, &defined);
+    std::unordered_set<std::string> defined_names;
+    for (Xvr_ASTNode* proc : defined) {
+        const char* name = proc_name(proc);
+        if (name &&
+            (repl->procs.count(name) || !defined_names.insert(name).second)) {
+            std::string message =
+                std::string("proc '") + name + "' is already defined";
+            report(repl, message.c_str());
+            free_nodes(nodes, count);
+            return false;
+        }
+    }
+
+    /* only what the entry names is loaded or declared, so an entry costs
+     * the same however long the session has run */
+    std::unordered_set<std::string> names = entry_names(source);
+    std::vector<Xvr_LLVMReplVar> bound;
+    std::vector<Xvr_ASTNode*> declared;
+    for (const std::string& name : names) {
+        auto var = repl->vars.find(name);
+        if (var != repl->vars.end()) {
+            ReplVar& found = var->second;
+            bound.push_back({(char*)found.name.c_str(),
+                             (char*)found.symbol.c_str(),
+                             (char*)found.type.c_str(), found.var_type,
+                             found.array_count});
+        }
+        auto proc = repl->procs.find(name);
+        if (proc != repl->procs.end()) {
+            declared.push_back(proc->second);
+        }
+    }
+
+    char entry[32];
+    snprintf(entry, sizeof(entry), "xvr_repl_%u", ++repl->entries);
+    Xvr_LLVMCodegen* codegen = create_codegen(repl, entry);
+    if (!codegen) {
+        free_nodes(nodes, count);
+        return false;
+    }
+    bool ok = Xvr_LLVMCodegenSetSeparateImports(codegen, true) &&
+              Xvr_LLVMCodegenSetReplEntry(codegen, entry, bound.data(),
+                                          bound.size()) &&
+              Xvr_LLVMCodegenDeclareProcs(codegen, declared.data(),
+                                          (int)declared.size());
+    for (int i = 0; ok && i < count; i++) {
+        ok = Xvr_LLVMCodegenEmitAST(codegen, nodes[i]);
+    }
+    ok = ok && Xvr_LLVMCodegenEnsureMain(codegen);
+    if (!ok) {
+        report_codegen(repl, codegen, "failed to compile the entry");
+    }
+
+    for (size_t i = 0; ok && i < Xvr_LLVMCodegenGetImportCount(codegen);
+         i++) {
+        const char* path = Xvr_LLVMCodegenGetImport(codegen, i);
+        if (!repl->modules.count(path)) {
+            ok = compile_module(repl, path);
+        }
+    }
+    ok = ok && finish_module(repl, codegen);
+    if (!ok) {
+        Xvr_LLVMCodegenDestroy(codegen);
+        free_nodes(nodes, count);
+        return false;
+    }
+
+    /* the module is in the engine now, its definitions with it */
+    size_t var_count = 0;
+    const Xvr_LLVMReplVar* vars = Xvr_LLVMCodegenGetReplVars(codegen,
+                                                             &var_count);
+    for (size_t i = 0; i < var_count; i++) {
+        repl->vars[vars[i].name] = {vars[i].name, vars[i].symbol,
+                                    vars[i].type, vars[i].var_type,
+                                    vars[i].array_count};
+    }
+    Xvr_LLVMCodegenDestroy(codegen);
+    keep_procs(repl, nodes, count);
+
+    Xvr_LLVMJITStats stats = {0.0, 0.0, 0};
+    uint64_t address = 0;
+    if (!Xvr_LLVMJITLookup(repl->jit, entry, &address)) {
+        const char* err = Xvr_LLVMJITGetError(repl->jit);
+        report(repl, err ? err : "the entry did not link");
+        return false;
+    }
+    double compiled = get_time_ms();
+    stats.compile_ms = compiled - start;
+
+    int (*run)(void) = (int (*)(void))(uintptr_t)address;
+    stats.exit_code = run();
+    fflush(stdout);
+    stats.exec_ms = get_time_ms() - compiled;
+
+    if (out_stats) {
+        *out_stats = stats;
+    }
+    return true;
+}
+
+bool Xvr_LLVMReplRun(Xvr_LLVMRepl* repl, FILE* in, FILE* prompt,
+                     FILE* timing) {
+    if (!repl || !in) {
+        return false;
+    }
+    std::string entry;
+    char* line = NULL;
+    size_t line_capacity = 0;
+    bool ok = true;
+    for (;;) {
+        if (prompt) {
+            fputs(entry.empty() ? "xvr> " : "...> ", prompt);
+            fflush(prompt);
+        }
+        ssize_t read = getline(&line, &line_capacity, in);
+        bool at_end = read < 0;
+        if (!at_end) {
+            try {
+                entry.append(line, (size_t)read);
+            } catch (...) {
+                ok = false;
+                break;
+            }
+        }
+        if (entry.find_first_not_of(" \t\r\n") == std::string::npos) {
+            entry.clear();
+        }
+        if (entry.empty() ||
+            (!at_end && !Xvr_LLVMReplIsComplete(entry.c_str()))) {
+            if (at_end) {
+                break;
+            }
+            continue;
+        }
+
+        Xvr_LLVMJITStats stats = {0.0, 0.0, 0};
+        if (!Xvr_LLVMReplEval(repl, entry.c_str(), &stats)) {
+            ok = ok && prompt;
+        } else if (timing) {
+            fprintf(timing, "[compile %.2f ms, run %.2f ms]\n",
+                    stats.compile_ms, stats.exec_ms);
+        }
+        Xvr_CompilerSessionClearDiagnostics(repl->session);
+        entry.clear();
+        if (at_end) {
+            break;
+        }
+    }
+    if (prompt) {
+        fputc('\n', prompt);
+    }
+    free(line);
+    return ok;
+}
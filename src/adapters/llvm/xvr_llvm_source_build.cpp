@@ -0,0 +1,428 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_llvm_source_build.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "optimizer/xvr_ast_optimizer.h"
+#include "xvr_ast_node.h"
+#include "xvr_llvm_codegen.h"
+#include "xvr_source_file.h"
+#include "xvr_unused.h"
+
+typedef struct {
+    std::string path;
+    bool input;
+    const char* source;
+    size_t size;
+    Xvr_ASTNode** nodes;
+    int node_count;
+    /* each unit compiles on its own thread with a session of its own */
+    Xvr_CompilerSession* session;
+    Xvr_LLVMCodegen* codegen;
+    void* object;
+    size_t object_size;
+    char* message;
+} Xvr_SourceUnit;
+
+typedef bool (*Xvr_SourceStep)(Xvr_LLVMSourceBuild* build,
+                               Xvr_SourceUnit* unit);
+
+struct Xvr_LLVMSourceBuild {
+    /* holds the options every unit's session is created with */
+    Xvr_CompilerSession* options;
+    unsigned jobs;
+    std::vector<Xvr_SourceUnit> units;
+    size_t input_count;
+    const char* error;
+};
+
+Xvr_LLVMSourceBuild* Xvr_LLVMSourceBuildCreate(
+    const Xvr_CompilerOptions* options, unsigned jobs) {
+    Xvr_LLVMSourceBuild* build = new (std::nothrow) Xvr_LLVMSourceBuild();
+    if (!build) {
+        return NULL;
+    }
+    build->options = Xvr_CompilerSessionCreate(options);
+    if (!build->options) {
+        delete build;
+        return NULL;
+    }
+    build->jobs = jobs ? jobs : std::thread::hardware_concurrency();
+    build->jobs = std::max(1u, build->jobs);
+    build->input_count = 0;
+    build->error = NULL;
+    return build;
+}
+
+static void source_unit_release(Xvr_SourceUnit* unit) {
+    Xvr_LLVMCodegenDestroy(unit->codegen);
+    unit->codegen = NULL;
+    Xvr_CompilerSessionDestroy(unit->session);
+    unit->session = NULL;
+    for (int i = 0; i < unit->node_count; i++) Xvr_freeASTNode(unit->nodes[i]);
+    free(unit->nodes);
+    unit->nodes = NULL;
+    unit->node_count = 0;
+    Xvr_unmapSourceFile(unit->source, unit->size);
+    unit->source = NULL;
+}
+
+void Xvr_LLVMSourceBuildDestroy(Xvr_LLVMSourceBuild* build) {
+    if (!build) {
+        return;
+    }
+    for (Xvr_SourceUnit& unit : build->units) {
+        source_unit_release(&unit);
+        free(unit.object);
+        free(unit.message);
+    }
+    Xvr_CompilerSessionDestroy(build->options);
+    delete build;
+}
+
+static bool source_build_add(Xvr_LLVMSourceBuild* build, const char* path,
+                             bool input) {
+    for (const Xvr_SourceUnit& unit : build->units) {
+        if (unit.path == path) {
+            return true;
+        }
+    }
+    try {
+        Xvr_SourceUnit unit = {};
+        unit.path = path;
+        unit.input = input;
+        build->units.push_back(std::move(unit));
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+bool Xvr_LLVMSourceBuildAddInput(Xvr_LLVMSourceBuild* build,
+                                 const char* path) {
+    if (!build || !path || build->units.size() != build->input_count) {
+        return false;
+    }
+    if (!source_build_add(build, path, true)) {
+        build->error = "out of memory";
+        return false;
+    }
+    build->input_count = build->units.size();
+    return true;
+}
+
+/* runs `step` over units [first, end), the calling thread is one of the
+ * workers */
+static void run_source_step(Xvr_LLVMSourceBuild* build, Xvr_SourceStep step,
+                            size_t first, size_t end) {
+    unsigned threads = std::min<unsigned>(build->jobs, (unsigned)(end - first));
+    std::atomic<size_t> next(first);
+    auto work = [build, step, end, &next]() {
+        for (size_t i = next++; i < end; i = next++) {
+            step(build, &build->units[i]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+static bool source_unit_fail(Xvr_SourceUnit* unit, const char* message) {
+    if (!unit->message) {
+        unit->message = strdup(message);
+    }
+    return false;
+}
+
+static bool parse_source_unit(Xvr_LLVMSourceBuild* build,
+                              Xvr_SourceUnit* unit) {
+    unit->session =
+        Xvr_CompilerSessionCreate(Xvr_CompilerSessionGetOptions(build->options));
+    if (!unit->session) {
+        return source_unit_fail(unit, "failed to create a compiler session");
+    }
+    unit->source = Xvr_mapSourceFile(unit->path.c_str(), &unit->size);
+    if (!unit->source) {
+        return source_unit_fail(unit, "could not read source file");
+    }
+    unit->nodes = Xvr_CompilerSessionParse(unit->session, unit->source,
+                                           &unit->node_count);
+    if (!unit->nodes) {
+        return source_unit_fail(unit, "parsing failed - check syntax");
+    }
+    return true;
+}
+
+/* the other files are libraries, checked no more than imported modules */
+static bool check_unused_program(Xvr_SourceUnit* program) {
+    Xvr_UnusedChecker checker;
+    Xvr_initUnusedCheckerWithSource(&checker, program->source);
+    Xvr_checkUnusedBegin(&checker);
+    for (int i = 0; i < program->node_count; i++) {
+        Xvr_checkUnusedNode(&checker, program->nodes[i]);
+    }
+    bool used = Xvr_checkUnusedEnd(&checker);
+    Xvr_freeUnusedChecker(&checker);
+    return used;
+}
+
+/* `include std;` parses as the identifier `include` cast onto the module */
+static bool is_include(Xvr_ASTNode* node) {
+    if (node->type != XVR_AST_NODE_BINARY ||
+        node->binary.opcode != XVR_OP_TYPE_CAST ||
+        node->binary.left->type != XVR_AST_NODE_LITERAL) {
+        return false;
+    }
+    Xvr_Literal* ident = &node->binary.left->atomic.literal;
+    return ident->type == XVR_LITERAL_IDENTIFIER && ident->as.identifier.ptr &&
+           strcmp(ident->as.identifier.ptr->data, "include") == 0;
+}
+
+/* only the first file may have statements of its own, the others are
+ * linked in as libraries */
+static bool check_library_input(Xvr_SourceUnit* unit) {
+    for (int i = 0; i < unit->node_count; i++) {
+        Xvr_ASTNodeType type = unit->nodes[i]->type;
+        if (type != XVR_AST_NODE_FN_DECL &&
+            type != XVR_AST_NODE_FN_COLLECTION &&
+            type != XVR_AST_NODE_IMPORT && !is_include(unit->nodes[i])) {
+            return source_unit_fail(unit,
+                                    "top-level statements are only allowed "
+                                    "in the first source file");
+        }
+    }
+    return true;
+}
+
+/* the program unit compiles its imports separately, every other unit is
+ * a library linked into it */
+static bool configure_unit_codegen(Xvr_LLVMCodegen* codegen, bool program) {
+    /* units are compiled side by side rather than split further */
+    Xvr_LLVMCodegenSetCodegenJobs(codegen, 1);
+    if (program) {
+        Xvr_LLVMCodegenSetSeparateImports(codegen, true);
+    } else {
+        Xvr_LLVMCodegenSetLibraryUnit(codegen, true);
+    }
+    return Xvr_LLVMCodegenApplySessionPipeline(codegen);
+}
+
+/* codegens are created on the calling thread, each declares the procs of
+ * the other files so calls between them resolve at link time */
+static bool create_source_codegen(Xvr_LLVMSourceBuild* build, size_t index) {
+    Xvr_SourceUnit* unit = &build->units[index];
+    char* name = Xvr_sourceFileStem(unit->path.c_str());
+    unit->codegen = Xvr_LLVMCodegenCreateWithSession(name ? name : "module",
+                                                     unit->session);
+    free(name);
+    if (!unit->codegen) {
+        return source_unit_fail(unit,
+                                "could not create a code generator for the "
+                                "requested CPU and features");
+    }
+
+    Xvr_LLVMCodegen* codegen = unit->codegen;
+    bool ok = configure_unit_codegen(codegen, index == 0);
+    for (size_t i = 0; ok && unit->input && i < build->input_count; i++) {
+        if (i != index) {
+            ok = Xvr_LLVMCodegenDeclareProcs(codegen, build->units[i].nodes,
+                                             build->units[i].node_count);
+        }
+    }
+    if (!ok) {
+        const char* err = Xvr_LLVMCodegenGetError(codegen);
+        return source_unit_fail(
+            unit, err ? err : "could not create a target machine for the "
+                              "requested CPU and features");
+    }
+    return true;
+}
+
+static bool compile_source_unit(Xvr_LLVMSourceBuild* build,
+                                Xvr_SourceUnit* unit) {
+    (void)build;
+    Xvr_LLVMCodegen* codegen = unit->codegen;
+    int level = Xvr_CompilerSessionGetOptions(unit->session)->optimizationLevel;
+    if (unit->input && level > 0) {
+        Xvr_ASTOptimizer* ast_opt = Xvr_ASTOptimizerCreate();
+        if (ast_opt) {
+            Xvr_ASTOptimizerSetLevel(ast_opt,
+                                     Xvr_OptimizationLevelFromInt(level));
+            Xvr_ASTOptimizerAddStandardPasses(ast_opt);
+            Xvr_ASTOptimizerRun(ast_opt, unit->nodes, unit->node_count);
+            Xvr_ASTOptimizerDestroy(ast_opt);
+        }
+    }
+    Xvr_LLVMCodegenPreloadImports(codegen, unit->nodes, unit->node_count);
+    bool ok = true;
+    for (int i = 0; ok && i < unit->node_count; i++) {
+        ok = Xvr_LLVMCodegenEmitAST(codegen, unit->nodes[i]);
+    }
+    if (ok) {
+        ok = Xvr_LLVMCodegenOptimize(codegen);
+    }
+    if (ok) {
+        unit->object = Xvr_LLVMCodegenEmitObject(codegen, &unit->object_size);
+        ok = unit->object != NULL;
+    }
+    if (!ok) {
+        const char* err = Xvr_LLVMCodegenGetError(codegen);
+        return source_unit_fail(unit, err ? err : "failed to emit object code");
+    }
+    return true;
+}
+
+static bool source_wave_failed(Xvr_LLVMSourceBuild* build, size_t first,
+                               size_t end) {
+    bool failed = false;
+    for (size_t i = first; i < end; i++) {
+        failed = failed || build->units[i].message != NULL;
+    }
+    return failed;
+}
+
+bool Xvr_LLVMSourceBuildRun(Xvr_LLVMSourceBuild* build) {
+    if (!build || build->input_count == 0) {
+        return false;
+    }
+
+    bool ok = true;
+    size_t first = 0;
+    while (ok && first < build->units.size()) {
+        size_t end = build->units.size();
+        run_source_step(build, parse_source_unit, first, end);
+        for (size_t i = first; i < end; i++) {
+            if (i > 0 && build->units[i].input && !build->units[i].message) {
+                check_library_input(&build->units[i]);
+            }
+        }
+        if (source_wave_failed(build, first, end)) {
+            return false;
+        }
+        /* the checker reports what it finds itself */
+        if (first == 0 && !check_unused_program(&build->units[0])) {
+            return false;
+        }
+        for (size_t i = first; i < end; i++) {
+            create_source_codegen(build, i);
+        }
+        if (source_wave_failed(build, first, end)) {
+            return false;
+        }
+        run_source_step(build, compile_source_unit, first, end);
+
+        for (size_t i = first; ok && i < end; i++) {
+            Xvr_LLVMCodegen* codegen = build->units[i].codegen;
+            size_t import_count = Xvr_LLVMCodegenGetImportCount(codegen);
+            for (size_t j = 0; ok && j < import_count; j++) {
+                ok = source_build_add(
+                    build, Xvr_LLVMCodegenGetImport(codegen, j), false);
+            }
+        }
+        /* the next wave only needs the files' ASTs for declarations */
+        for (size_t i = first; i < end; i++) {
+            if (!build->units[i].input) {
+                source_unit_release(&build->units[i]);
+            }
+        }
+        if (source_wave_failed(build, first, end)) {
+            return false;
+        }
+        first = end;
+    }
+    if (!ok) {
+        build->error = "out of memory";
+    }
+    return ok;
+}
+
+size_t Xvr_LLVMSourceBuildGetUnitCount(Xvr_LLVMSourceBuild* build) {
+    return build ? build->units.size() : 0;
+}
+
+const char* Xvr_LLVMSourceBuildGetUnitPath(Xvr_LLVMSourceBuild* build,
+                                           size_t index) {
+    if (!build || index >= build->units.size()) {
+        return NULL;
+    }
+    return build->units[index].path.c_str();
+}
+
+const char* Xvr_LLVMSourceBuildGetUnitMessage(Xvr_LLVMSourceBuild* build,
+                                              size_t index) {
+    if (!build || index >= build->units.size()) {
+        return NULL;
+    }
+    return build->units[index].message;
+}
+
+void** Xvr_LLVMSourceBuildTakeObjects(Xvr_LLVMSourceBuild* build,
+                                      size_t** out_sizes, size_t* out_count) {
+    *out_sizes = NULL;
+    *out_count = 0;
+    if (!build || build->units.empty()) {
+        return NULL;
+    }
+    size_t count = build->units.size();
+    void** objects = (void**)calloc(count, sizeof(void*));
+    size_t* sizes = (size_t*)calloc(count, sizeof(size_t));
+    if (!objects || !sizes) {
+        free(objects);
+        free(sizes);
+        build->error = "out of memory";
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        objects[i] = build->units[i].object;
+        sizes[i] = build->units[i].object_size;
+        build->units[i].object = NULL;
+    }
+    *out_sizes = sizes;
+    *out_count = count;
+    return objects;
+}
+
+unsigned Xvr_LLVMSourceBuildGetJobs(Xvr_LLVMSourceBuild* build) {
+    return build ? build->jobs : 0;
+}
+
+const char* Xvr_LLVMSourceBuildGetError(Xvr_LLVMSourceBuild* build) {
+    return build ? build->error : NULL;
+}
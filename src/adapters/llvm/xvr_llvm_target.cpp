@@ -26,11 +26,26 @@ SOFTWARE.
 
 #include <llvm-c/Target.h>
 #include <llvm-c/TargetMachine.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/MC/MCSubtargetInfo.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "../../xvr_string_utils.h"
 
 typedef enum {
@@ -85,6 +100,29 @@ static bool set_string_field(char** field, const char* value) {
     return (*field != NULL);
 }
 
+Xvr_LLVMTargetConfig* Xvr_LLVMTargetConfigClone(
+    const Xvr_LLVMTargetConfig* config) {
+    if (!config) {
+        return NULL;
+    }
+    Xvr_LLVMTargetConfig* copy = Xvr_LLVMTargetConfigCreate();
+    if (!copy) {
+        return NULL;
+    }
+    if ((config->triple && !set_string_field(&copy->triple, config->triple)) ||
+        (config->cpu && !set_string_field(&copy->cpu, config->cpu)) ||
+        (config->features &&
+         !set_string_field(&copy->features, config->features)) ||
+        (config->reloc && !set_string_field(&copy->reloc, config->reloc)) ||
+        (config->code_model &&
+         !set_string_field(&copy->code_model, config->code_model))) {
+        Xvr_LLVMTargetConfigDestroy(copy);
+        return NULL;
+    }
+    copy->asm_syntax = config->asm_syntax;
+    return copy;
+}
+
 bool Xvr_LLVMTargetConfigSetTriple(Xvr_LLVMTargetConfig* config,
                                    const char* triple) {
     return set_string_field(&config->triple, triple);
@@ -132,56 +170,78 @@ struct Xvr_LLVMTargetMachine {
     Xvr_LLVMTargetConfig* config;
     LLVMTargetMachineRef target_machine;
     LLVMTargetRef target;
+    char* triple;
+    char* cpu;
+    char* features;
+    LLVMRelocMode reloc_mode;
+    LLVMCodeModel code_model;
 };
 
-Xvr_LLVMTargetMachine* Xvr_LLVMTargetMachineCreate(
-    Xvr_LLVMTargetConfig* config) {
-    if (!config) {
-        return NULL;
-    }
-
-    LLVMTargetRef target;
-    char* error = NULL;
-
-    if (!config->triple) {
+void Xvr_LLVMTargetInitializeAll(void) {
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
         LLVMInitializeAllTargetInfos();
         LLVMInitializeAllTargets();
         LLVMInitializeAllTargetMCs();
         LLVMInitializeAllAsmPrinters();
         LLVMInitializeAllAsmParsers();
+    });
+}
 
-        const char* defaultTriple = LLVMGetDefaultTargetTriple();
-        if (!LLVMGetTargetFromTriple(defaultTriple, &target, &error)) {
-            free(error);
-            error = NULL;
-        } else {
-            free(error);
-            error = NULL;
-            if (!LLVMGetTargetFromTriple("x86_64-pc-linux-gnu", &target,
-                                         &error)) {
-                free(error);
-            } else {
-                free(error);
-                LLVMDisposeMessage((char*)defaultTriple);
-                return NULL;
-            }
-        }
-        LLVMDisposeMessage((char*)defaultTriple);
+void Xvr_LLVMTargetWarmUp(void) {
+    Xvr_LLVMTargetInitializeAll();
+    Xvr_LLVMTargetMachineGetHostCPU();
+    Xvr_LLVMTargetMachineGetHostFeatures();
+    Xvr_LLVMTargetConfig* config = Xvr_LLVMTargetConfigCreate();
+    Xvr_LLVMTargetMachine* tm = Xvr_LLVMTargetMachineCreate(config);
+    if (tm) {
+        Xvr_LLVMTargetMachineDestroy(tm);
     } else {
-        LLVMInitializeAllTargetInfos();
-        LLVMInitializeAllTargets();
-        LLVMInitializeAllTargetMCs();
-        LLVMInitializeAllAsmPrinters();
-        LLVMInitializeAllAsmParsers();
+        Xvr_LLVMTargetConfigDestroy(config);
+    }
+}
 
-        if (!LLVMGetTargetFromTriple(config->triple, &target, &error)) {
-            free(error);
-            return NULL;
-        }
+/* "native" resolves to the host CPU and its features; explicit features
+ * are appended so they override what the host reports */
+static char* resolve_features(const char* cpu, const char* features) {
+    bool native = cpu && strcmp(cpu, "native") == 0;
+    const char* host = native ? Xvr_LLVMTargetMachineGetHostFeatures() : "";
+    const char* extra = features ? features : "";
+
+    size_t len = strlen(host) + strlen(extra) + 2;
+    char* result = (char*)malloc(len);
+    if (!result) {
+        return NULL;
+    }
+    snprintf(result, len, "%s%s%s", host, (*host && *extra) ? "," : "",
+             extra);
+    return result;
+}
+
+Xvr_LLVMTargetMachine* Xvr_LLVMTargetMachineCreate(
+    Xvr_LLVMTargetConfig* config) {
+    if (!config) {
+        return NULL;
+    }
+
+    Xvr_LLVMTargetInitializeAll();
+
+    const char* triple = config->triple
+                             ? config->triple
+                             : Xvr_LLVMTargetMachineGetDefaultTargetTriple();
+
+    LLVMTargetRef target;
+    char* error = NULL;
+    if (LLVMGetTargetFromTriple(triple, &target, &error)) {
+        LLVMDisposeMessage(error);
+        return NULL;
     }
 
-    const char* cpu = config->cpu ? config->cpu : "generic";
-    const char* features = config->features ? config->features : "";
+    const char* cpu = config->cpu ? config->cpu
+                                  : Xvr_LLVMTargetMachineGetDefaultCPU();
+    if (strcmp(cpu, "native") == 0) {
+        cpu = Xvr_LLVMTargetMachineGetHostCPU();
+    }
     const char* reloc = config->reloc ? config->reloc : "default";
     const char* model = config->code_model ? config->code_model : "jitdefault";
 
@@ -203,23 +263,47 @@ Xvr_LLVMTargetMachine* Xvr_LLVMTargetMachineCreate(
         code_model = LLVMCodeModelLarge;
     }
 
-    LLVMTargetMachineRef tm = LLVMCreateTargetMachine(
-        target, config->triple ? config->triple : "x86_64-pc-linux-gnu", cpu,
-        features, LLVMCodeGenLevelDefault, reloc_mode, code_model);
-
-    if (!tm) {
+    Xvr_LLVMTargetMachine* result =
+        (Xvr_LLVMTargetMachine*)calloc(1, sizeof(Xvr_LLVMTargetMachine));
+    if (!result) {
+        return NULL;
+    }
+    result->triple = strdup(triple);
+    result->cpu = strdup(cpu);
+    result->features = resolve_features(config->cpu, config->features);
+    if (!result->triple || !result->cpu || !result->features) {
+        free(result->triple);
+        free(result->cpu);
+        free(result->features);
+        free(result);
         return NULL;
     }
 
-    Xvr_LLVMTargetMachine* result = (Xvr_LLVMTargetMachine*)calloc(1, sizeof(Xvr_LLVMTargetMachine));
-    if (!result) {
+    LLVMTargetMachineRef tm = LLVMCreateTargetMachine(
+        target, result->triple, result->cpu, result->features,
+        LLVMCodeGenLevelDefault, reloc_mode, code_model);
+
+    /* LLVM only warns about an unknown CPU and then aborts in the backend,
+     * so reject it while the caller can still report it */
+    if (tm && !reinterpret_cast<llvm::TargetMachine*>(tm)
+                   ->getMCSubtargetInfo()
+                   ->isCPUStringValid(result->cpu)) {
         LLVMDisposeTargetMachine(tm);
+        tm = NULL;
+    }
+    if (!tm) {
+        free(result->triple);
+        free(result->cpu);
+        free(result->features);
+        free(result);
         return NULL;
     }
 
     result->config = config;
     result->target_machine = tm;
     result->target = target;
+    result->reloc_mode = reloc_mode;
+    result->code_model = code_model;
 
     return result;
 }
@@ -232,6 +316,9 @@ void Xvr_LLVMTargetMachineDestroy(Xvr_LLVMTargetMachine* tm) {
         LLVMDisposeTargetMachine(tm->target_machine);
     }
     Xvr_LLVMTargetConfigDestroy(tm->config);
+    free(tm->triple);
+    free(tm->cpu);
+    free(tm->features);
     free(tm);
 }
 
@@ -339,14 +426,18 @@ void* Xvr_LLVMTargetMachineEmitToMemory(Xvr_LLVMTargetMachine* tm,
     char* error = NULL;
     LLVMMemoryBufferRef buffer = NULL;
 
-    bool success = LLVMTargetMachineEmitToMemoryBuffer(
+    /* LLVMBool: non-zero means failure */
+    LLVMBool failed = LLVMTargetMachineEmitToMemoryBuffer(
         machine, mod, LLVMObjectFile, &error, &buffer);
 
     if (error) {
-        free(error);
+        if (failed) {
+            fprintf(stderr, "error: failed to emit object: %s\n", error);
+        }
+        LLVMDisposeMessage(error);
     }
 
-    if (!success || !buffer) {
+    if (failed || !buffer) {
         return NULL;
     }
 
@@ -370,12 +461,201 @@ void* Xvr_LLVMTargetMachineEmitToMemory(Xvr_LLVMTargetMachine* tm,
     return data;
 }
 
+/* one partition of a split module; the thread owns everything in here */
+typedef struct {
+    llvm::SmallVector<char, 0> bitcode;
+    void* object;
+    size_t object_size;
+    double ms;
+    std::string error;
+} Xvr_CodegenPartition;
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+/* cpu time, so threads waiting for a core do not count as work */
+static double thread_cpu_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* runs on a worker: LLVM contexts and target machines are not shared
+ * between threads, so the part is reparsed into a context of its own */
+static void emit_partition(const Xvr_LLVMTargetMachine* tm,
+                           Xvr_CodegenPartition* part) {
+    double start = thread_cpu_ms();
+    llvm::LLVMContext context;
+    llvm::Expected<std::unique_ptr<llvm::Module>> module =
+        llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(
+                llvm::StringRef(part->bitcode.data(), part->bitcode.size()),
+                "partition"),
+            context);
+    if (!module) {
+        part->error = llvm::toString(module.takeError());
+        return;
+    }
+
+    LLVMTargetMachineRef machine = LLVMCreateTargetMachine(
+        tm->target, tm->triple, tm->cpu, tm->features, LLVMCodeGenLevelDefault,
+        tm->reloc_mode, tm->code_model);
+    if (!machine) {
+        part->error = "failed to create target machine";
+        return;
+    }
+
+    char* error = NULL;
+    LLVMMemoryBufferRef buffer = NULL;
+    if (LLVMTargetMachineEmitToMemoryBuffer(
+            machine, llvm::wrap(module->get()), LLVMObjectFile, &error,
+            &buffer)) {
+        part->error = error ? error : "failed to emit object";
+    } else {
+        part->object_size = LLVMGetBufferSize(buffer);
+        part->object = malloc(part->object_size ? part->object_size : 1);
+        if (part->object) {
+            memcpy(part->object, LLVMGetBufferStart(buffer),
+                   part->object_size);
+        } else {
+            part->error = "out of memory";
+        }
+        LLVMDisposeMemoryBuffer(buffer);
+    }
+    LLVMDisposeMessage(error);
+    LLVMDisposeTargetMachine(machine);
+    part->ms = thread_cpu_ms() - start;
+}
+
+void** Xvr_LLVMTargetMachineEmitPartitioned(Xvr_LLVMTargetMachine* tm,
+                                            Xvr_LLVMModuleManager* module,
+                                            unsigned jobs,
+                                            bool preserve_locals,
+                                            size_t** out_sizes,
+                                            Xvr_LLVMCodegenTiming* out_timing) {
+    if (!tm || !module || jobs == 0 || !out_sizes) {
+        return NULL;
+    }
+    LLVMModuleRef mod = Xvr_LLVMModuleManagerGetModule(module);
+    if (!mod) {
+        return NULL;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    /* SplitModule groups functions by a hash of their names, so the same
+     * module and job count always yield the same partitions */
+    std::vector<Xvr_CodegenPartition> parts(jobs);
+    unsigned split = 0;
+    llvm::SplitModule(
+        *llvm::unwrap(mod), jobs,
+        [&](std::unique_ptr<llvm::Module> part) {
+            llvm::raw_svector_ostream os(parts[split].bitcode);
+            llvm::WriteBitcodeToFile(*part, os);
+            split++;
+        },
+        preserve_locals);
+
+    std::vector<std::thread> workers;
+    workers.reserve(jobs);
+    for (unsigned i = 0; i < jobs; i++) {
+        workers.emplace_back(emit_partition, tm, &parts[i]);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    void** objects = (void**)calloc(jobs, sizeof(void*));
+    size_t* sizes = (size_t*)calloc(jobs, sizeof(size_t));
+    bool ok = objects && sizes;
+    double cpu_ms = 0.0;
+    for (unsigned i = 0; i < jobs; i++) {
+        if (!parts[i].error.empty()) {
+            fprintf(stderr, "error: failed to emit object: %s\n",
+                    parts[i].error.c_str());
+            ok = false;
+        }
+        cpu_ms += parts[i].ms;
+        if (ok) {
+            objects[i] = parts[i].object;
+            sizes[i] = parts[i].object_size;
+        } else {
+            free(parts[i].object);
+        }
+    }
+
+    if (!ok) {
+        if (objects) {
+            for (unsigned i = 0; i < jobs; i++) {
+                free(objects[i]);
+            }
+        }
+        free(objects);
+        free(sizes);
+        return NULL;
+    }
+
+    if (out_timing) {
+        out_timing->wall_ms = elapsed_ms(start);
+        out_timing->cpu_ms = cpu_ms;
+        out_timing->jobs = jobs;
+    }
+    *out_sizes = sizes;
+    return objects;
+}
+
+/* host queries are answered once per process and kept for its lifetime */
 const char* Xvr_LLVMTargetMachineGetDefaultTargetTriple(void) {
-    return "x86_64-pc-linux-gnu";
+    static char* triple = LLVMGetDefaultTargetTriple();
+    return triple;
 }
 
 const char* Xvr_LLVMTargetMachineGetDefaultCPU(void) { return "generic"; }
 
+const char* Xvr_LLVMTargetMachineGetHostCPU(void) {
+    static char* cpu = LLVMGetHostCPUName();
+    return cpu;
+}
+
+const char* Xvr_LLVMTargetMachineGetHostFeatures(void) {
+    static char* features = LLVMGetHostCPUFeatures();
+    return features;
+}
+
+const char* Xvr_LLVMTargetMachineGetTriple(Xvr_LLVMTargetMachine* tm) {
+    return tm ? tm->triple : NULL;
+}
+
+const char* Xvr_LLVMTargetMachineGetCPU(Xvr_LLVMTargetMachine* tm) {
+    return tm ? tm->cpu : NULL;
+}
+
+const char* Xvr_LLVMTargetMachineGetFeatures(Xvr_LLVMTargetMachine* tm) {
+    return tm ? tm->features : NULL;
+}
+
+Xvr_LLVMTargetConfig* Xvr_LLVMTargetMachineGetConfig(
+    Xvr_LLVMTargetMachine* tm) {
+    return tm ? tm->config : NULL;
+}
+
+bool Xvr_LLVMTargetMachineApplyToModule(Xvr_LLVMTargetMachine* tm,
+                                        LLVMModuleRef module) {
+    if (!tm || !module) {
+        return false;
+    }
+    LLVMSetTarget(module, tm->triple);
+    LLVMTargetDataRef data = LLVMCreateTargetDataLayout(tm->target_machine);
+    char* layout = LLVMCopyStringRepOfTargetData(data);
+    LLVMSetDataLayout(module, layout);
+    LLVMDisposeMessage(layout);
+    LLVMDisposeTargetData(data);
+    return true;
+}
+
 LLVMTargetMachineRef Xvr_LLVMTargetMachineGetLLVMTargetMachine(
     Xvr_LLVMTargetMachine* tm) {
     if (!tm) {
@@ -0,0 +1,403 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_llvm_thin_build.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xvr_ast_node.h"
+#include "xvr_compiler_session.h"
+#include "xvr_source_file.h"
+
+typedef struct {
+    char* path;
+    void* bitcode;
+    size_t size;
+} Xvr_LLVMThinModule;
+
+struct Xvr_LLVMThinBuild {
+    Xvr_CompilerSession* session;
+    Xvr_LLVMThinModule* modules;
+    size_t count;
+    size_t capacity;
+    char error[1024];
+};
+
+static bool thin_build_fail(Xvr_LLVMThinBuild* build, const char* message) {
+    snprintf(build->error, sizeof(build->error), "%s", message);
+    return false;
+}
+
+Xvr_LLVMThinBuild* Xvr_LLVMThinBuildCreate(Xvr_CompilerSession* session) {
+    Xvr_LLVMThinBuild* build =
+        (Xvr_LLVMThinBuild*)calloc(1, sizeof(Xvr_LLVMThinBuild));
+    if (build) {
+        build->session = session;
+    }
+    return build;
+}
+
+void Xvr_LLVMThinBuildDestroy(Xvr_LLVMThinBuild* build) {
+    if (!build) {
+        return;
+    }
+    for (size_t i = 0; i < build->count; i++) {
+        free(build->modules[i].path);
+        free(build->modules[i].bitcode);
+    }
+    free(build->modules);
+    free(build);
+}
+
+static bool thin_build_add(Xvr_LLVMThinBuild* build, const char* path) {
+    for (size_t i = 0; i < build->count; i++) {
+        if (strcmp(build->modules[i].path, path) == 0) {
+            return true;
+        }
+    }
+    if (build->count == build->capacity) {
+        size_t capacity = build->capacity ? build->capacity * 2 : 4;
+        Xvr_LLVMThinModule* grown = (Xvr_LLVMThinModule*)realloc(
+            build->modules, capacity * sizeof(Xvr_LLVMThinModule));
+        if (!grown) {
+            return false;
+        }
+        build->modules = grown;
+        build->capacity = capacity;
+    }
+    char* copy = strdup(path);
+    if (!copy) {
+        return false;
+    }
+    build->modules[build->count].path = copy;
+    build->modules[build->count].bitcode = NULL;
+    build->modules[build->count].size = 0;
+    build->count++;
+    return true;
+}
+
+static bool thin_build_add_imports(Xvr_LLVMThinBuild* build,
+                                   Xvr_LLVMCodegen* codegen) {
+    size_t count = Xvr_LLVMCodegenGetImportCount(codegen);
+    for (size_t i = 0; i < count; i++) {
+        if (!thin_build_add(build, Xvr_LLVMCodegenGetImport(codegen, i))) {
+            return thin_build_fail(build, "out of memory");
+        }
+    }
+    return true;
+}
+
+/* compiles modules[index] as a library unit and queues what it imports */
+static bool compile_thin_module(Xvr_LLVMThinBuild* build, size_t index) {
+    const char* path = build->modules[index].path;
+    size_t size = 0;
+    const char* source = Xvr_mapSourceFile(path, &size);
+    if (!source) {
+        snprintf(build->error, sizeof(build->error),
+                 "could not read module '%s'", path);
+        return false;
+    }
+
+    int node_count = 0;
+    Xvr_ASTNode** nodes =
+        Xvr_CompilerSessionParse(build->session, source, &node_count);
+    if (!nodes) {
+        snprintf(build->error, sizeof(build->error),
+                 "%s: parsing failed - check syntax", path);
+        Xvr_unmapSourceFile(source, size);
+        return false;
+    }
+
+    char* name = Xvr_sourceFileStem(path);
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreateWithSession(
+        name ? name : "module", build->session);
+    free(name);
+
+    bool ok = codegen && Xvr_LLVMCodegenSetLibraryUnit(codegen, true) &&
+              Xvr_LLVMCodegenApplySessionPipeline(codegen);
+    for (int i = 0; ok && i < node_count; i++) {
+        ok = Xvr_LLVMCodegenEmitAST(codegen, nodes[i]);
+    }
+    if (ok) {
+        ok = Xvr_LLVMCodegenOptimize(codegen);
+    }
+    if (ok) {
+        Xvr_LLVMThinModule* module = &build->modules[index];
+        module->bitcode =
+            Xvr_LLVMCodegenEmitThinLTOBitcode(codegen, &module->size);
+        ok = module->bitcode != NULL;
+    }
+    if (ok) {
+        ok = thin_build_add_imports(build, codegen);
+    } else {
+        const char* err = codegen ? Xvr_LLVMCodegenGetError(codegen) : NULL;
+        snprintf(build->error, sizeof(build->error), "%s: %s", path,
+                 err ? err : "failed to initialize code generator");
+    }
+
+    Xvr_LLVMCodegenDestroy(codegen);
+    for (int i = 0; i < node_count; i++) Xvr_freeASTNode(nodes[i]);
+    free(nodes);
+    Xvr_unmapSourceFile(source, size);
+    return ok;
+}
+
+bool Xvr_LLVMThinBuildAddProgram(Xvr_LLVMThinBuild* build, const char* path,
+                                 Xvr_LLVMCodegen* codegen) {
+    if (!build || !path || !codegen || build->count > 0) {
+        return false;
+    }
+    if (!thin_build_add(build, path)) {
+        return thin_build_fail(build, "out of memory");
+    }
+    build->modules[0].bitcode =
+        Xvr_LLVMCodegenEmitThinLTOBitcode(codegen, &build->modules[0].size);
+    if (!build->modules[0].bitcode) {
+        const char* err = Xvr_LLVMCodegenGetError(codegen);
+        return thin_build_fail(build,
+                               err ? err : "failed to write ThinLTO bitcode");
+    }
+
+    /* imports of imports are queued as each module is compiled */
+    bool ok = thin_build_add_imports(build, codegen);
+    for (size_t i = 1; ok && i < build->count; i++) {
+        ok = compile_thin_module(build, i);
+    }
+    return ok;
+}
+
+size_t Xvr_LLVMThinBuildGetModuleCount(Xvr_LLVMThinBuild* build) {
+    return build ? build->count : 0;
+}
+
+const char* Xvr_LLVMThinBuildGetModulePath(Xvr_LLVMThinBuild* build,
+                                           size_t index) {
+    if (!build || index >= build->count) {
+        return NULL;
+    }
+    return build->modules[index].path;
+}
+
+const void* Xvr_LLVMThinBuildGetModuleBitcode(Xvr_LLVMThinBuild* build,
+                                              size_t index, size_t* out_size) {
+    if (!build || index >= build->count || !out_size) {
+        return NULL;
+    }
+    *out_size = build->modules[index].size;
+    return build->modules[index].bitcode;
+}
+
+static Xvr_LLVMThinLink* create_thin_link(Xvr_LLVMCodegen* codegen,
+                                          const char* cache_dir) {
+    Xvr_LLVMThinLink* link = Xvr_LLVMThinLinkCreate();
+    if (!link) {
+        return NULL;
+    }
+    Xvr_LLVMCodegenConfigureThinLink(codegen, link);
+    if (cache_dir) {
+        Xvr_LLVMThinLinkSetCacheDir(link, cache_dir);
+    }
+    return link;
+}
+
+Xvr_LLVMThinLink* Xvr_LLVMThinBuildLink(Xvr_LLVMThinBuild* build,
+                                        Xvr_LLVMCodegen* codegen,
+                                        const char* cache_dir) {
+    if (!build || !codegen) {
+        return NULL;
+    }
+    Xvr_LLVMThinLink* link = create_thin_link(codegen, cache_dir);
+    if (!link) {
+        thin_build_fail(build, "out of memory");
+        return NULL;
+    }
+    bool ok = true;
+    for (size_t i = 0; ok && i < build->count; i++) {
+        ok = Xvr_LLVMThinLinkAddModule(link, build->modules[i].path,
+                                       build->modules[i].bitcode,
+                                       build->modules[i].size);
+    }
+    if (!ok || !Xvr_LLVMThinLinkRun(link)) {
+        const char* err = Xvr_LLVMThinLinkGetError(link);
+        thin_build_fail(build, err ? err : "ThinLTO link failed");
+        Xvr_LLVMThinLinkDestroy(link);
+        return NULL;
+    }
+    return link;
+}
+
+static bool write_file(const char* output_path, const void* data,
+                       size_t size) {
+    FILE* f = fopen(output_path, "wb");
+    if (!f) {
+        return false;
+    }
+    bool written = fwrite(data, 1, size, f) == size;
+    return fclose(f) == 0 && written;
+}
+
+/* an import's bitcode goes next to the program's output */
+static char* thin_module_output(const char* program_output,
+                                const char* module_path) {
+    char* stem = Xvr_sourceFileStem(module_path);
+    if (!stem) {
+        return NULL;
+    }
+    const char* slash = strrchr(program_output, '/');
+    int dir_len = slash ? (int)(slash - program_output) + 1 : 0;
+    char* result = NULL;
+    if (asprintf(&result, "%.*s%s.o", dir_len, program_output, stem) < 0) {
+        result = NULL;
+    }
+    free(stem);
+    return result;
+}
+
+bool Xvr_LLVMThinBuildWrite(Xvr_LLVMThinBuild* build,
+                            const char* output_path) {
+    if (!build || !output_path || build->count == 0) {
+        return false;
+    }
+    bool ok = write_file(output_path, build->modules[0].bitcode,
+                         build->modules[0].size);
+    for (size_t i = 1; ok && i < build->count; i++) {
+        char* module_out =
+            thin_module_output(output_path, build->modules[i].path);
+        ok = module_out && write_file(module_out, build->modules[i].bitcode,
+                                      build->modules[i].size);
+        free(module_out);
+    }
+    return ok || thin_build_fail(build, "failed to write ThinLTO bitcode");
+}
+
+const char* Xvr_LLVMThinBuildGetError(Xvr_LLVMThinBuild* build) {
+    return build && build->error[0] ? build->error : NULL;
+}
+
+bool Xvr_LLVMThinBuildLinkExecutable(Xvr_LLVMThinLink* link,
+                                     const void* const* extra,
+                                     const size_t* extra_sizes,
+                                     size_t extra_count,
+                                     const char* output_path,
+                                     char** out_error) {
+    size_t count = Xvr_LLVMThinLinkGetObjectCount(link);
+    const void** objects =
+        (const void**)malloc((count + extra_count) * sizeof(void*));
+    size_t* sizes = (size_t*)malloc((count + extra_count) * sizeof(size_t));
+    bool linked = false;
+    if (objects && sizes) {
+        for (size_t i = 0; i < count; i++) {
+            objects[i] = Xvr_LLVMThinLinkGetObject(link, i, &sizes[i]);
+        }
+        for (size_t i = 0; i < extra_count; i++) {
+            objects[count + i] = extra[i];
+            sizes[count + i] = extra_sizes[i];
+        }
+        linked = Xvr_LLVMLinkerLinkExecutables(objects, sizes,
+                                               count + extra_count,
+                                               output_path, out_error);
+    } else if (out_error) {
+        *out_error = strdup("out of memory");
+    }
+    free(objects);
+    free(sizes);
+    return linked;
+}
+
+/* bitcode starts with its magic, anything else is a native object */
+static bool is_bitcode(const char* data, size_t size) {
+    return size >= 4 && data[0] == 'B' && data[1] == 'C' &&
+           (unsigned char)data[2] == 0xC0 && (unsigned char)data[3] == 0xDE;
+}
+
+bool Xvr_LLVMThinBuildLinkInputs(Xvr_CompilerSession* session,
+                                 const char* const* paths, size_t count,
+                                 const char* cache_dir,
+                                 const char* output_path, char** out_error) {
+    const char** contents = (const char**)calloc(count, sizeof(char*));
+    size_t* content_sizes = (size_t*)calloc(count, sizeof(size_t));
+    const void** natives = (const void**)calloc(count, sizeof(void*));
+    size_t* native_sizes = (size_t*)calloc(count, sizeof(size_t));
+    Xvr_LLVMCodegen* codegen =
+        Xvr_LLVMCodegenCreateWithSession("link", session);
+    Xvr_LLVMThinLink* link = NULL;
+    size_t native_count = 0;
+    size_t bitcode_count = 0;
+    char* message = NULL;
+    bool ok = contents && content_sizes && natives && native_sizes && codegen;
+    if (ok) {
+        link = create_thin_link(codegen, cache_dir);
+        ok = link != NULL;
+    }
+
+    for (size_t i = 0; ok && i < count; i++) {
+        contents[i] = Xvr_readSourceFile(paths[i], &content_sizes[i]);
+        if (!contents[i]) {
+            if (asprintf(&message, "could not read '%s'", paths[i]) < 0) {
+                message = NULL;
+            }
+            ok = false;
+            break;
+        }
+        if (is_bitcode(contents[i], content_sizes[i])) {
+            ok = Xvr_LLVMThinLinkAddModule(link, paths[i], contents[i],
+                                           content_sizes[i]);
+            bitcode_count++;
+        } else {
+            natives[native_count] = contents[i];
+            native_sizes[native_count++] = content_sizes[i];
+        }
+    }
+
+    if (ok && bitcode_count > 0) {
+        ok = Xvr_LLVMThinLinkRun(link);
+    }
+    if (!ok && !message) {
+        const char* err = link ? Xvr_LLVMThinLinkGetError(link) : NULL;
+        message = strdup(err ? err : "failed to set up the link");
+    }
+    if (ok) {
+        ok = Xvr_LLVMThinBuildLinkExecutable(link, natives, native_sizes,
+                                             native_count, output_path,
+                                             &message);
+    }
+
+    if (out_error) {
+        *out_error = message;
+    } else {
+        free(message);
+    }
+    Xvr_LLVMThinLinkDestroy(link);
+    Xvr_LLVMCodegenDestroy(codegen);
+    for (size_t i = 0; contents && i < count; i++) {
+        Xvr_unmapSourceFile(contents[i], content_sizes[i]);
+    }
+    free(contents);
+    free(content_sizes);
+    free(natives);
+    free(native_sizes);
+    return ok;
+}
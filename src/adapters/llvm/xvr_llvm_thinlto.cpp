@@ -0,0 +1,415 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_llvm_thinlto.h"
+
+#include <llvm-c/Target.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/DiagnosticPrinter.h>
+#include <llvm/LTO/Config.h>
+#include <llvm/LTO/LTO.h>
+#include <llvm/Support/Caching.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "xvr_common.h"
+
+struct Xvr_LLVMThinLink {
+    std::string cpu;
+    std::vector<std::string> features;
+    Xvr_LLVMOptimizationLevel level = XVR_LLVM_OPT_O2;
+    unsigned jobs = 0;
+    std::string cache_dir;
+
+    std::vector<std::string> identifiers;
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> inputs;
+    std::vector<std::string> objects;
+
+    char* error_message = nullptr;
+};
+
+static void set_error(Xvr_LLVMThinLink* link, const std::string& message) {
+    free(link->error_message);
+    link->error_message = Xvr_strdup(message.c_str());
+}
+
+Xvr_LLVMThinLink* Xvr_LLVMThinLinkCreate(void) {
+    if (LLVMInitializeNativeTarget() || LLVMInitializeNativeAsmPrinter()) {
+        return NULL;
+    }
+    return new (std::nothrow) Xvr_LLVMThinLink();
+}
+
+void Xvr_LLVMThinLinkDestroy(Xvr_LLVMThinLink* link) {
+    if (!link) {
+        return;
+    }
+    free(link->error_message);
+    delete link;
+}
+
+bool Xvr_LLVMThinLinkSetTarget(Xvr_LLVMThinLink* link, const char* cpu,
+                               const char* features) {
+    if (!link) {
+        return false;
+    }
+    link->cpu = cpu ? cpu : "";
+    link->features.clear();
+    for (const char* cursor = features; cursor && *cursor;) {
+        const char* comma = strchr(cursor, ',');
+        size_t length = comma ? (size_t)(comma - cursor) : strlen(cursor);
+        if (length > 0) {
+            link->features.emplace_back(cursor, length);
+        }
+        cursor = comma ? comma + 1 : cursor + length;
+    }
+    return true;
+}
+
+bool Xvr_LLVMThinLinkSetOptimizationLevel(Xvr_LLVMThinLink* link,
+                                          Xvr_LLVMOptimizationLevel level) {
+    if (!link) {
+        return false;
+    }
+    link->level = level;
+    return true;
+}
+
+bool Xvr_LLVMThinLinkSetJobs(Xvr_LLVMThinLink* link, unsigned jobs) {
+    if (!link) {
+        return false;
+    }
+    link->jobs = jobs;
+    return true;
+}
+
+bool Xvr_LLVMThinLinkSetCacheDir(Xvr_LLVMThinLink* link, const char* dir) {
+    if (!link) {
+        return false;
+    }
+    link->cache_dir = dir ? dir : "";
+    return true;
+}
+
+bool Xvr_LLVMThinLinkAddModule(Xvr_LLVMThinLink* link, const char* identifier,
+                               const void* bitcode, size_t size) {
+    if (!link || !identifier || !bitcode || size == 0) {
+        return false;
+    }
+
+    for (const std::string& existing : link->identifiers) {
+        if (existing == identifier) {
+            set_error(link, std::string("module added twice: ") + identifier);
+            return false;
+        }
+    }
+
+    /* checked up front so a missing summary names the module it came from */
+    llvm::MemoryBufferRef ref(
+        llvm::StringRef((const char*)bitcode, size), identifier);
+    llvm::Expected<llvm::BitcodeLTOInfo> info = llvm::getBitcodeLTOInfo(ref);
+    if (!info) {
+        set_error(link, std::string(identifier) + ": " +
+                            llvm::toString(info.takeError()));
+        return false;
+    }
+    if (!info->HasSummary) {
+        set_error(link,
+                  std::string(identifier) + ": bitcode has no module summary");
+        return false;
+    }
+
+    link->identifiers.push_back(identifier);
+    link->inputs.push_back(llvm::MemoryBuffer::getMemBufferCopy(
+        llvm::StringRef((const char*)bitcode, size), identifier));
+    return true;
+}
+
+/* the backends report through the stream and buffer callbacks, whose
+ * signatures gained a module name argument in newer LLVM releases; the
+ * overloads accept both */
+struct Xvr_ThinAddStream {
+    std::vector<llvm::SmallVector<char, 0>>* objects;
+
+    llvm::Expected<std::unique_ptr<llvm::CachedFileStream>> operator()(
+        unsigned task) const {
+        return std::make_unique<llvm::CachedFileStream>(
+            std::make_unique<llvm::raw_svector_ostream>((*objects)[task]));
+    }
+    llvm::Expected<std::unique_ptr<llvm::CachedFileStream>> operator()(
+        unsigned task, const llvm::Twine&) const {
+        return (*this)(task);
+    }
+};
+
+struct Xvr_ThinAddBuffer {
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>>* cached;
+
+    void operator()(unsigned task, std::unique_ptr<llvm::MemoryBuffer> mb) const {
+        (*cached)[task] = std::move(mb);
+    }
+    void operator()(unsigned task, const llvm::Twine&,
+                    std::unique_ptr<llvm::MemoryBuffer> mb) const {
+        (*cached)[task] = std::move(mb);
+    }
+};
+
+static unsigned backend_opt_level(Xvr_LLVMOptimizationLevel level) {
+    switch (level) {
+    case XVR_LLVM_OPT_NONE:
+        return 0;
+    case XVR_LLVM_OPT_LEGACY:
+    case XVR_LLVM_OPT_O1:
+        return 1;
+    case XVR_LLVM_OPT_O3:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+static void configure(Xvr_LLVMThinLink* link, llvm::lto::Config& config,
+                      std::mutex& diag_lock, std::string& errors) {
+    config.CPU = link->cpu;
+    config.MAttrs = link->features;
+    config.OptLevel = backend_opt_level(link->level);
+#if LLVM_VERSION_MAJOR >= 18
+    static const llvm::CodeGenOptLevel cg_levels[] = {
+        llvm::CodeGenOptLevel::None, llvm::CodeGenOptLevel::Less,
+        llvm::CodeGenOptLevel::Default, llvm::CodeGenOptLevel::Aggressive};
+#else
+    static const llvm::CodeGenOpt::Level cg_levels[] = {
+        llvm::CodeGenOpt::None, llvm::CodeGenOpt::Less,
+        llvm::CodeGenOpt::Default, llvm::CodeGenOpt::Aggressive};
+#endif
+    config.CGOptLevel = cg_levels[config.OptLevel];
+
+    /* backends run on several threads, so diagnostics are serialized */
+    config.DiagHandler = [&diag_lock, &errors](const llvm::DiagnosticInfo& di) {
+        std::string message;
+        llvm::raw_string_ostream stream(message);
+        llvm::DiagnosticPrinterRawOStream printer(stream);
+        di.print(printer);
+        stream.flush();
+
+        std::lock_guard<std::mutex> guard(diag_lock);
+        if (di.getSeverity() == llvm::DS_Error) {
+            if (!errors.empty()) {
+                errors += '\n';
+            }
+            errors += message;
+        } else if (di.getSeverity() == llvm::DS_Warning) {
+            fprintf(stderr, "warning: %s\n", message.c_str());
+        }
+    };
+}
+
+/* where a name's prevailing definition lives, as input and symbol index */
+struct Xvr_ThinDefinition {
+    size_t input;
+    size_t symbol;
+    bool weak;
+};
+
+/* every input is part of the program: a strong definition prevails over
+ * weak and linkonce ones, which otherwise go to the first input defining
+ * them, and two strong definitions of a name fail the link like they do in
+ * a native one */
+static bool pick_definitions(
+    Xvr_LLVMThinLink* link,
+    const std::vector<std::unique_ptr<llvm::lto::InputFile>>& files,
+    std::unordered_map<std::string, Xvr_ThinDefinition>& defined) {
+    for (size_t i = 0; i < files.size(); i++) {
+        size_t index = 0;
+        for (const llvm::lto::InputFile::Symbol& symbol : files[i]->symbols()) {
+            size_t current = index++;
+            if (symbol.isUndefined()) {
+                continue;
+            }
+            bool weak = symbol.isWeak() || symbol.isCommon();
+            auto [found, inserted] = defined.try_emplace(
+                symbol.getName().str(), Xvr_ThinDefinition{i, current, weak});
+            if (inserted || weak) {
+                continue;
+            }
+            if (!found->second.weak) {
+                set_error(link,
+                          "duplicate symbol '" + found->first + "' in " +
+                              link->inputs[found->second.input]
+                                  ->getBufferIdentifier()
+                                  .str() +
+                              " and " +
+                              link->inputs[i]->getBufferIdentifier().str());
+                return false;
+            }
+            found->second = Xvr_ThinDefinition{i, current, false};
+        }
+    }
+    return true;
+}
+
+/* only main stays visible to the native link, everything else may be
+ * internalized once imports are done */
+static std::vector<llvm::lto::SymbolResolution> resolve_symbols(
+    llvm::lto::InputFile& input, size_t input_index,
+    const std::unordered_map<std::string, Xvr_ThinDefinition>& defined) {
+    std::vector<llvm::lto::SymbolResolution> resolutions;
+    size_t index = 0;
+    for (const llvm::lto::InputFile::Symbol& symbol : input.symbols()) {
+        llvm::lto::SymbolResolution resolution;
+        llvm::StringRef name = symbol.getName();
+        auto found = defined.find(name.str());
+        if (!symbol.isUndefined() && found != defined.end() &&
+            found->second.input == input_index &&
+            found->second.symbol == index) {
+            resolution.Prevailing = 1;
+            resolution.FinalDefinitionInLinkageUnit = 1;
+        }
+        resolution.VisibleToRegularObj = name == "main" || symbol.isUsed();
+        resolutions.push_back(resolution);
+        index++;
+    }
+    return resolutions;
+}
+
+bool Xvr_LLVMThinLinkRun(Xvr_LLVMThinLink* link) {
+    if (!link) {
+        return false;
+    }
+    link->objects.clear();
+    if (link->inputs.empty()) {
+        set_error(link, "no modules to link");
+        return false;
+    }
+
+    std::mutex diag_lock;
+    std::string errors;
+    llvm::lto::Config config;
+    configure(link, config, diag_lock, errors);
+
+    llvm::lto::ThinBackend backend = llvm::lto::createInProcessThinBackend(
+        llvm::heavyweight_hardware_concurrency(link->jobs));
+    llvm::lto::LTO lto(std::move(config), std::move(backend));
+
+    /* every input is read before any is added, a strong definition in a
+     * later one still prevails over an earlier weak one */
+    std::vector<std::unique_ptr<llvm::lto::InputFile>> files;
+    for (const std::unique_ptr<llvm::MemoryBuffer>& input : link->inputs) {
+        llvm::Expected<std::unique_ptr<llvm::lto::InputFile>> file =
+            llvm::lto::InputFile::create(input->getMemBufferRef());
+        if (!file) {
+            set_error(link, input->getBufferIdentifier().str() + ": " +
+                                llvm::toString(file.takeError()));
+            return false;
+        }
+        files.push_back(std::move(*file));
+    }
+
+    std::unordered_map<std::string, Xvr_ThinDefinition> defined;
+    if (!pick_definitions(link, files, defined)) {
+        return false;
+    }
+    for (size_t i = 0; i < files.size(); i++) {
+        std::vector<llvm::lto::SymbolResolution> resolutions =
+            resolve_symbols(*files[i], i, defined);
+        if (llvm::Error err = lto.add(std::move(files[i]), resolutions)) {
+            set_error(link, link->inputs[i]->getBufferIdentifier().str() +
+                                ": " + llvm::toString(std::move(err)));
+            return false;
+        }
+    }
+
+    unsigned tasks = lto.getMaxTasks();
+    std::vector<llvm::SmallVector<char, 0>> objects(tasks);
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> cached(tasks);
+    Xvr_ThinAddStream add_stream = {&objects};
+    Xvr_ThinAddBuffer add_buffer = {&cached};
+
+    llvm::FileCache cache;
+    if (!link->cache_dir.empty()) {
+        auto local = llvm::localCache("ThinLTO", "xvr-thinlto",
+                                      link->cache_dir, add_buffer);
+        if (!local) {
+            set_error(link, "thinlto cache: " +
+                                llvm::toString(local.takeError()));
+            return false;
+        }
+        cache = std::move(*local);
+    }
+
+    llvm::Error err = lto.run(add_stream, cache);
+    if (err || !errors.empty()) {
+        std::string message =
+            err ? llvm::toString(std::move(err)) : std::string();
+        if (!errors.empty()) {
+            message = message.empty() ? errors : message + "\n" + errors;
+        }
+        set_error(link, message);
+        return false;
+    }
+
+    /* a cache hit (or a miss once committed) arrives as a buffer, a run
+     * without cache writes straight into the task's stream */
+    for (unsigned task = 0; task < tasks; task++) {
+        if (cached[task]) {
+            link->objects.push_back(cached[task]->getBuffer().str());
+        } else if (!objects[task].empty()) {
+            link->objects.emplace_back(objects[task].data(),
+                                       objects[task].size());
+        }
+    }
+    return true;
+}
+
+size_t Xvr_LLVMThinLinkGetObjectCount(Xvr_LLVMThinLink* link) {
+    return link ? link->objects.size() : 0;
+}
+
+const void* Xvr_LLVMThinLinkGetObject(Xvr_LLVMThinLink* link, size_t index,
+                                      size_t* out_size) {
+    if (!link || !out_size || index >= link->objects.size()) {
+        return NULL;
+    }
+    *out_size = link->objects[index].size();
+    return link->objects[index].data();
+}
+
+const char* Xvr_LLVMThinLinkGetError(Xvr_LLVMThinLink* link) {
+    return link ? link->error_message : NULL;
+}
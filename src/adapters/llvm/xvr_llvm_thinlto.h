@@ -0,0 +1,106 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_LLVM_THINLTO_H
+#define XVR_LLVM_THINLTO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "xvr_llvm_optimizer.h"
+
+/**
+ * @brief ThinLTO link over separately compiled modules
+ *
+ * each input is ThinLTO bitcode (Xvr_LLVMCodegenEmitThinLTOBitcode). the
+ * run merges the module summaries, imports callees across module
+ * boundaries (hot call edges get a larger budget when the modules were
+ * built with a profile), internalizes everything but `main`, then optimizes
+ * and code generates every module in parallel. the result is one native
+ * object per module, ready for Xvr_LLVMLinkerLinkExecutables
+ *
+ * with a cache directory, a module whose bitcode, imports and settings are
+ * unchanged reuses its object from the previous run
+ *
+ * Thread safety: not thread-safe, the backend threads are internal
+ */
+typedef struct Xvr_LLVMThinLink Xvr_LLVMThinLink;
+
+Xvr_LLVMThinLink* Xvr_LLVMThinLinkCreate(void);
+void Xvr_LLVMThinLinkDestroy(Xvr_LLVMThinLink* link);
+
+/**
+ * @brief backend settings, normally those of the codegen that produced the
+ * inputs (see Xvr_LLVMCodegenConfigureThinLink)
+ * @param cpu target CPU, NULL for the generic one
+ * @param features comma separated "+feature,-feature" list, may be NULL
+ */
+bool Xvr_LLVMThinLinkSetTarget(Xvr_LLVMThinLink* link, const char* cpu,
+                               const char* features);
+bool Xvr_LLVMThinLinkSetOptimizationLevel(Xvr_LLVMThinLink* link,
+                                          Xvr_LLVMOptimizationLevel level);
+
+/**
+ * @brief number of backend threads, 0 (the default) uses every core
+ */
+bool Xvr_LLVMThinLinkSetJobs(Xvr_LLVMThinLink* link, unsigned jobs);
+
+/**
+ * @brief caches per-module objects in dir, NULL disables the cache
+ */
+bool Xvr_LLVMThinLinkSetCacheDir(Xvr_LLVMThinLink* link, const char* dir);
+
+/**
+ * @brief adds a module to the link, the bitcode is copied
+ * @param identifier unique module name, e.g. its source path
+ * @return false with an error set if the bitcode has no summary
+ */
+bool Xvr_LLVMThinLinkAddModule(Xvr_LLVMThinLink* link, const char* identifier,
+                               const void* bitcode, size_t size);
+
+/**
+ * @brief runs the thin link and the per-module backends
+ * @return true if every module produced an object
+ */
+bool Xvr_LLVMThinLinkRun(Xvr_LLVMThinLink* link);
+
+size_t Xvr_LLVMThinLinkGetObjectCount(Xvr_LLVMThinLink* link);
+
+/**
+ * @brief an object produced by the last run, owned by the link
+ */
+const void* Xvr_LLVMThinLinkGetObject(Xvr_LLVMThinLink* link, size_t index,
+                                      size_t* out_size);
+
+const char* Xvr_LLVMThinLinkGetError(Xvr_LLVMThinLink* link);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
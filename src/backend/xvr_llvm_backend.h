@@ -32,8 +32,12 @@ SOFTWARE.
 #include "xvr_llvm_function_emitter.h"
 #include "xvr_llvm_ir_builder.h"
 #include "xvr_llvm_module_manager.h"
+#include "xvr_llvm_object_cache.h"
 #include "xvr_llvm_optimizer.h"
+#include "xvr_llvm_precompiled.h"
+#include "xvr_llvm_repl.h"
 #include "xvr_llvm_target.h"
+#include "xvr_llvm_thinlto.h"
 #include "xvr_llvm_type_mapper.h"
 
 #endif
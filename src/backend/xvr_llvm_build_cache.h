@@ -0,0 +1,88 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_LLVM_BUILD_CACHE_H
+#define XVR_LLVM_BUILD_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "xvr_compiler_session.h"
+#include "xvr_llvm_codegen.h"
+#include "xvr_llvm_object_cache.h"
+
+/**
+ * @brief whole builds of one source in an Xvr_LLVMObjectCache: the objects
+ * linked into an executable, or the single object of -c
+ *
+ * the fingerprint holds the module name, the kind of output, the target
+ * and every option that changes the objects; a store lists the imports,
+ * the runtime bitcode and the profile the compile read as its
+ * dependencies
+ *
+ * Thread safety: one cache per thread
+ */
+typedef struct Xvr_LLVMBuildCache Xvr_LLVMBuildCache;
+
+/**
+ * @brief where builds are cached: `dir`, else $XVR_CACHE_DIR
+ * @return NULL when neither is set
+ */
+const char* Xvr_LLVMBuildCacheDirectory(const char* dir);
+
+/**
+ * @brief opens the cache for builds of `module_name` with `options`
+ * @param dir cache directory, NULL for $XVR_CACHE_DIR
+ * @param max_bytes size limit, 0 for the object cache's default
+ * @param executable whether the objects are linked into an executable
+ * @return NULL when there is no directory or it can't be opened
+ */
+Xvr_LLVMBuildCache* Xvr_LLVMBuildCacheCreate(
+    const char* dir, uint64_t max_bytes, const Xvr_CompilerOptions* options,
+    const char* module_name, bool executable);
+void Xvr_LLVMBuildCacheDestroy(Xvr_LLVMBuildCache* cache);
+
+/**
+ * @brief the objects of a previous build of `source`
+ * @return as Xvr_LLVMObjectCacheLookup, NULL on a miss
+ */
+void** Xvr_LLVMBuildCacheLookup(Xvr_LLVMBuildCache* cache, const void* source,
+                                size_t source_size, size_t** out_sizes,
+                                size_t* out_count);
+
+/**
+ * @brief stores the objects `codegen` built from `source`
+ */
+bool Xvr_LLVMBuildCacheStore(Xvr_LLVMBuildCache* cache, const void* source,
+                             size_t source_size, Xvr_LLVMCodegen* codegen,
+                             const void* const* objects, const size_t* sizes,
+                             size_t count);
+
+/**
+ * @brief the fingerprint builds are keyed by, owned by the cache
+ */
+const char* Xvr_LLVMBuildCacheGetFingerprint(Xvr_LLVMBuildCache* cache);
+
+#endif
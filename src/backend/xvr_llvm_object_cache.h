@@ -0,0 +1,99 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_LLVM_OBJECT_CACHE_H
+#define XVR_LLVM_OBJECT_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief on-disk cache of compiled objects, keyed by content
+ *
+ * a lookup hashes the source, a fingerprint of the compile options and the
+ * compiler version into a manifest key. the manifest lists the files the
+ * last compile of that source read (imports, profiles, runtime bitcode) with
+ * the hash of their contents; while those still match the files on disk it
+ * completes the key of the cached objects, so a hit needs no lexing or
+ * parsing
+ *
+ * entries are written to a temporary file and renamed into place, so
+ * compilers sharing a directory never see a partial entry. once the
+ * directory outgrows its size limit the least recently used entries are
+ * removed, along with temporary files a killed compiler left behind
+ *
+ * Thread safety: one cache per thread, processes may share a directory
+ */
+typedef struct Xvr_LLVMObjectCache Xvr_LLVMObjectCache;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t evictions;
+    uint64_t entries;
+    uint64_t bytes;
+} Xvr_LLVMObjectCacheStats;
+
+/**
+ * @brief opens (creating it if needed) a cache directory
+ * @param max_bytes size limit, 0 for the default of 1 GiB
+ */
+Xvr_LLVMObjectCache* Xvr_LLVMObjectCacheCreate(const char* dir,
+                                               uint64_t max_bytes);
+void Xvr_LLVMObjectCacheDestroy(Xvr_LLVMObjectCache* cache);
+
+/**
+ * @brief looks up the objects of a previous compile
+ * @param fingerprint every compile option that changes the output
+ * @param out_sizes receives a malloc'd array of object sizes
+ * @param out_count receives the number of objects
+ * @return malloc'd array of malloc'd objects on a hit, NULL on a miss
+ */
+void** Xvr_LLVMObjectCacheLookup(Xvr_LLVMObjectCache* cache,
+                                 const char* fingerprint, const void* source,
+                                 size_t source_size, size_t** out_sizes,
+                                 size_t* out_count);
+
+/**
+ * @brief stores the objects of a compile
+ * @param deps paths of every file besides the source the output depends on
+ */
+bool Xvr_LLVMObjectCacheStore(Xvr_LLVMObjectCache* cache,
+                              const char* fingerprint, const void* source,
+                              size_t source_size, const char* const* deps,
+                              size_t dep_count, const void* const* objects,
+                              const size_t* sizes, size_t count);
+
+/**
+ * @brief hit/miss counters of the directory, shared by every compiler
+ * using it, and its current contents
+ */
+bool Xvr_LLVMObjectCacheGetStats(Xvr_LLVMObjectCache* cache,
+                                 Xvr_LLVMObjectCacheStats* out_stats);
+
+const char* Xvr_LLVMObjectCacheGetDirectory(Xvr_LLVMObjectCache* cache);
+
+#endif
@@ -0,0 +1,88 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_LLVM_PRECOMPILED_H
+#define XVR_LLVM_PRECOMPILED_H
+
+#include <llvm-c/Core.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "xvr_llvm_module_manager.h"
+
+/**
+ * @brief a module compiled ahead of time from its .xvr source
+ *
+ * the file next to "name.xvr" is "name.xvrm": bitcode of the module built
+ * as a library unit, carrying the SHA-256 of the source it came from, the
+ * compiler version, a declaration table of its procs and the modules it
+ * imports. a loaded module is only handed out while the source still
+ * hashes the same, anything else is left to the source
+ */
+typedef struct Xvr_LLVMPrecompiledModule Xvr_LLVMPrecompiledModule;
+
+/**
+ * @brief precompiled path for a module source, "math.xvr" -> "math.xvrm"
+ * @return malloc'd path (caller frees), or NULL on allocation failure
+ */
+char* Xvr_LLVMPrecompiledPath(const char* source_path);
+
+/**
+ * @brief writes the manager's module as a precompiled module
+ * @param source the .xvr text the module was compiled from
+ * @param imports names of the modules it imports, loaded before it
+ * @param out_error receives a malloc'd message on failure (may be NULL)
+ *
+ * every defined function is listed in the declaration table
+ */
+bool Xvr_LLVMPrecompiledWrite(Xvr_LLVMModuleManager* mgr, const void* source,
+                              size_t source_size,
+                              const char* const* imports,
+                              size_t import_count, const char* output_path,
+                              char** out_error);
+
+/**
+ * @brief loads the precompiled module of source_path into ctx
+ * @return NULL if there is none, it is unreadable, was built by another
+ * compiler, or the source changed since
+ */
+Xvr_LLVMPrecompiledModule* Xvr_LLVMPrecompiledLoad(LLVMContextRef ctx,
+                                                   const char* source_path);
+void Xvr_LLVMPrecompiledDestroy(Xvr_LLVMPrecompiledModule* module);
+
+size_t Xvr_LLVMPrecompiledGetProcCount(Xvr_LLVMPrecompiledModule* module);
+const char* Xvr_LLVMPrecompiledGetProc(Xvr_LLVMPrecompiledModule* module,
+                                       size_t index);
+size_t Xvr_LLVMPrecompiledGetImportCount(Xvr_LLVMPrecompiledModule* module);
+const char* Xvr_LLVMPrecompiledGetImport(Xvr_LLVMPrecompiledModule* module,
+                                         size_t index);
+
+/**
+ * @brief links every proc of the module into mgr, see
+ * Xvr_LLVMModuleManagerLinkModule; the module is left empty
+ */
+bool Xvr_LLVMPrecompiledLink(Xvr_LLVMPrecompiledModule* module,
+                             Xvr_LLVMModuleManager* mgr, char** out_error);
+
+#endif
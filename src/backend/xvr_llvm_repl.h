@@ -0,0 +1,86 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_LLVM_REPL_H
+#define XVR_LLVM_REPL_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "xvr_llvm_jit.h"
+
+typedef struct Xvr_CompilerSession Xvr_CompilerSession;
+
+/**
+ * @brief interactive session over one persistent JIT
+ *
+ * each entry is parsed and emitted into a small module of its own and added
+ * to the engine; nothing an earlier entry compiled is emitted again. procs
+ * and imported modules stay in the engine and later entries only declare
+ * the ones they name. top-level variables live in globals between entries,
+ * an entry loads the ones it names when it starts and stores them back
+ * when it returns
+ *
+ * Thread safety: not thread-safe, one session per thread
+ */
+typedef struct Xvr_LLVMRepl Xvr_LLVMRepl;
+
+/**
+ * @brief creates a session compiling with `session`'s options, which must
+ * outlive it; errors are reported to `session`
+ * @return new session, or NULL if no JIT can be created for the host
+ */
+Xvr_LLVMRepl* Xvr_LLVMReplCreate(Xvr_CompilerSession* session);
+void Xvr_LLVMReplDestroy(Xvr_LLVMRepl* repl);
+
+/**
+ * @brief whether `source` holds a whole entry yet: its brackets are closed
+ * and it ends in `;` or `}`
+ */
+bool Xvr_LLVMReplIsComplete(const char* source);
+
+/**
+ * @brief compiles `source`, one or more statements or procs, and runs it
+ * @param out_stats optional compile and execute time and the entry's
+ * return value
+ * @return false with the reason reported to the session if it did not
+ * compile or redefines a proc, earlier definitions are left as they were
+ */
+bool Xvr_LLVMReplEval(Xvr_LLVMRepl* repl, const char* source,
+                      Xvr_LLVMJITStats* out_stats);
+
+/**
+ * @brief evaluates what `in` holds until it ends, lines being gathered
+ * until they make a whole entry; diagnostics are cleared after each entry
+ * @param prompt where "xvr> " and "...> " are written before each line,
+ * NULL for none
+ * @param timing where each entry's compile and run time is written, NULL
+ * for none
+ * @return false when out of memory or, without a prompt, when an entry
+ * failed
+ */
+bool Xvr_LLVMReplRun(Xvr_LLVMRepl* repl, FILE* in, FILE* prompt,
+                     FILE* timing);
+
+#endif
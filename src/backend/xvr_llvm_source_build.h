@@ -0,0 +1,90 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_LLVM_SOURCE_BUILD_H
+#define XVR_LLVM_SOURCE_BUILD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "xvr_compiler_session.h"
+
+/**
+ * @brief xvr a.xvr b.xvr: every file and every module they import compiled
+ * to an object of its own, one codegen (and LLVM context) per unit on a
+ * pool of threads
+ *
+ * unit 0 holds the program's top-level statements, the other inputs and
+ * the imports are library units. imports found in one wave are compiled in
+ * the next, in the order they were found, so the objects and their order
+ * are deterministic
+ *
+ * Thread safety: one build per thread, the build starts its own workers
+ */
+typedef struct Xvr_LLVMSourceBuild Xvr_LLVMSourceBuild;
+
+/**
+ * @param options copied into a session of each unit
+ * @param jobs worker threads, 0 for one per core
+ */
+Xvr_LLVMSourceBuild* Xvr_LLVMSourceBuildCreate(
+    const Xvr_CompilerOptions* options, unsigned jobs);
+void Xvr_LLVMSourceBuildDestroy(Xvr_LLVMSourceBuild* build);
+
+/**
+ * @brief adds an input file, the first is the program
+ */
+bool Xvr_LLVMSourceBuildAddInput(Xvr_LLVMSourceBuild* build,
+                                 const char* path);
+
+/**
+ * @brief compiles the inputs and everything they import
+ * @return false when a unit failed (see Xvr_LLVMSourceBuildGetUnitMessage),
+ * the unused checker rejected the program, which it reports itself, or
+ * with an error set
+ */
+bool Xvr_LLVMSourceBuildRun(Xvr_LLVMSourceBuild* build);
+
+size_t Xvr_LLVMSourceBuildGetUnitCount(Xvr_LLVMSourceBuild* build);
+const char* Xvr_LLVMSourceBuildGetUnitPath(Xvr_LLVMSourceBuild* build,
+                                           size_t index);
+
+/**
+ * @return why the unit failed, NULL when it compiled
+ */
+const char* Xvr_LLVMSourceBuildGetUnitMessage(Xvr_LLVMSourceBuild* build,
+                                              size_t index);
+
+/**
+ * @brief hands the object of every unit, in unit order, to the caller
+ * @param out_sizes receives a malloc'd array of object sizes
+ * @return malloc'd array of malloc'd objects, NULL when out of memory
+ */
+void** Xvr_LLVMSourceBuildTakeObjects(Xvr_LLVMSourceBuild* build,
+                                      size_t** out_sizes, size_t* out_count);
+
+unsigned Xvr_LLVMSourceBuildGetJobs(Xvr_LLVMSourceBuild* build);
+const char* Xvr_LLVMSourceBuildGetError(Xvr_LLVMSourceBuild* build);
+
+#endif
@@ -51,9 +51,23 @@ bool Xvr_LLVMTargetConfigSetAsmSyntax(Xvr_LLVMTargetConfig* config,
                                       Xvr_AsmSyntax syntax);
 Xvr_AsmSyntax Xvr_LLVMTargetConfigGetAsmSyntax(
     const Xvr_LLVMTargetConfig* config);
+Xvr_LLVMTargetConfig* Xvr_LLVMTargetConfigClone(
+    const Xvr_LLVMTargetConfig* config);
 
 typedef struct Xvr_LLVMTargetMachine Xvr_LLVMTargetMachine;
 
+/**
+ * @brief registers every LLVM target, once per process; target machines do
+ * this on creation, a long-lived process can do it up front
+ */
+void Xvr_LLVMTargetInitializeAll(void);
+
+/**
+ * @brief also detects the host CPU and its features and builds a default
+ * target machine once, so processes forked afterwards start with LLVM warm
+ */
+void Xvr_LLVMTargetWarmUp(void);
+
 Xvr_LLVMTargetMachine* Xvr_LLVMTargetMachineCreate(
     Xvr_LLVMTargetConfig* config);
 void Xvr_LLVMTargetMachineDestroy(Xvr_LLVMTargetMachine* tm);
@@ -66,8 +80,58 @@ void* Xvr_LLVMTargetMachineEmitToMemory(Xvr_LLVMTargetMachine* tm,
                                         Xvr_LLVMModuleManager* module,
                                         size_t* out_size);
 
+/**
+ * @brief time spent in one object emission; cpu_ms sums the partitions, so
+ * cpu_ms / wall_ms is the speedup over emitting them one after another
+ */
+typedef struct {
+    double wall_ms;
+    double cpu_ms;
+    unsigned jobs;
+} Xvr_LLVMCodegenTiming;
+
+/**
+ * @brief splits the module into `jobs` partitions of function groups and
+ * emits each on its own thread with its own target machine
+ *
+ * partitioning is deterministic, the objects are identical across runs for
+ * the same job count. local symbols are made hidden globals so functions
+ * can land in any partition; with preserve_locals they stay local and are
+ * kept in the partition of their users instead (for relocatable output).
+ * without it the module's own locals are externalized in the process
+ * @return `jobs` malloc'd objects (sizes in *out_sizes), NULL on failure
+ */
+void** Xvr_LLVMTargetMachineEmitPartitioned(Xvr_LLVMTargetMachine* tm,
+                                            Xvr_LLVMModuleManager* module,
+                                            unsigned jobs,
+                                            bool preserve_locals,
+                                            size_t** out_sizes,
+                                            Xvr_LLVMCodegenTiming* out_timing);
+
+/**
+ * @brief host triple, the CPU used when none is configured ("generic"), and
+ * the detected host CPU and features that a CPU of "native" resolves to
+ */
 const char* Xvr_LLVMTargetMachineGetDefaultTargetTriple(void);
 const char* Xvr_LLVMTargetMachineGetDefaultCPU(void);
+const char* Xvr_LLVMTargetMachineGetHostCPU(void);
+const char* Xvr_LLVMTargetMachineGetHostFeatures(void);
+
+/**
+ * @brief the triple, CPU and feature string the machine was created with,
+ * after "native" has been resolved
+ */
+const char* Xvr_LLVMTargetMachineGetTriple(Xvr_LLVMTargetMachine* tm);
+const char* Xvr_LLVMTargetMachineGetCPU(Xvr_LLVMTargetMachine* tm);
+const char* Xvr_LLVMTargetMachineGetFeatures(Xvr_LLVMTargetMachine* tm);
+Xvr_LLVMTargetConfig* Xvr_LLVMTargetMachineGetConfig(
+    Xvr_LLVMTargetMachine* tm);
+
+/**
+ * @brief stamps the module with the machine's triple and data layout
+ */
+bool Xvr_LLVMTargetMachineApplyToModule(Xvr_LLVMTargetMachine* tm,
+                                        LLVMModuleRef module);
 
 LLVMTargetMachineRef Xvr_LLVMTargetMachineGetLLVMTargetMachine(
     Xvr_LLVMTargetMachine* tm);
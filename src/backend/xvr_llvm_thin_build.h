@@ -0,0 +1,106 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_LLVM_THIN_BUILD_H
+#define XVR_LLVM_THIN_BUILD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "xvr_llvm_codegen.h"
+#include "xvr_llvm_thinlto.h"
+
+/**
+ * @brief -flto=thin: a program and every module it imports, each compiled
+ * to ThinLTO bitcode of its own
+ *
+ * module 0 is the program, emitted by the caller's codegen. the modules it
+ * imports, and theirs in turn, are compiled as library units with the
+ * session's options; a thin link then optimizes across all of them
+ *
+ * Thread safety: one build per thread
+ */
+typedef struct Xvr_LLVMThinBuild Xvr_LLVMThinBuild;
+
+Xvr_LLVMThinBuild* Xvr_LLVMThinBuildCreate(Xvr_CompilerSession* session);
+void Xvr_LLVMThinBuildDestroy(Xvr_LLVMThinBuild* build);
+
+/**
+ * @brief emits the program's bitcode from `codegen`, which has been
+ * optimized, then compiles everything it imports
+ * @param path the program's source, which identifies module 0
+ * @return false with an error set
+ */
+bool Xvr_LLVMThinBuildAddProgram(Xvr_LLVMThinBuild* build, const char* path,
+                                 Xvr_LLVMCodegen* codegen);
+
+size_t Xvr_LLVMThinBuildGetModuleCount(Xvr_LLVMThinBuild* build);
+const char* Xvr_LLVMThinBuildGetModulePath(Xvr_LLVMThinBuild* build,
+                                           size_t index);
+const void* Xvr_LLVMThinBuildGetModuleBitcode(Xvr_LLVMThinBuild* build,
+                                              size_t index, size_t* out_size);
+
+/**
+ * @brief runs a thin link over every module, configured from `codegen`
+ * @param cache_dir per-module object cache of the link, NULL for none
+ * @return the link, owned by the caller, or NULL with an error set
+ */
+Xvr_LLVMThinLink* Xvr_LLVMThinBuildLink(Xvr_LLVMThinBuild* build,
+                                        Xvr_LLVMCodegen* codegen,
+                                        const char* cache_dir);
+
+/**
+ * @brief -c: writes the program's bitcode to `output_path` and that of each
+ * import next to it, named after the import's source
+ * @return false with an error set
+ */
+bool Xvr_LLVMThinBuildWrite(Xvr_LLVMThinBuild* build,
+                            const char* output_path);
+
+const char* Xvr_LLVMThinBuildGetError(Xvr_LLVMThinBuild* build);
+
+/**
+ * @brief links the objects of a thin link that has run, and `extra` native
+ * objects after them, into an executable
+ * @see Xvr_LLVMLinkerLinkExecutables
+ */
+bool Xvr_LLVMThinBuildLinkExecutable(Xvr_LLVMThinLink* link,
+                                     const void* const* extra,
+                                     const size_t* extra_sizes,
+                                     size_t extra_count,
+                                     const char* output_path,
+                                     char** out_error);
+
+/**
+ * @brief xvr a.o b.o: links object files into an executable, ThinLTO
+ * bitcode (from `xvr -flto=thin -c`) through a thin link configured from
+ * the session and native objects as they are
+ * @param out_error receives a malloc'd message on failure
+ */
+bool Xvr_LLVMThinBuildLinkInputs(Xvr_CompilerSession* session,
+                                 const char* const* paths, size_t count,
+                                 const char* cache_dir,
+                                 const char* output_path, char** out_error);
+
+#endif
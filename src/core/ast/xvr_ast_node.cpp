@@ -248,14 +248,14 @@ void Xvr_emitASTNodeIndex(Xvr_ASTNode** nodeHandle, Xvr_ASTNode* first,
 
 void Xvr_emitASTNodeVarDecl(Xvr_ASTNode** nodeHandle, Xvr_Literal identifier,
                             Xvr_Literal typeLiteral, Xvr_ASTNode* expression,
-                            int line) {
+                            int offset) {
     Xvr_ASTNode* tmp = XVR_ALLOCATE(Xvr_ASTNode, 1);
 
     tmp->type = XVR_AST_NODE_VAR_DECL;
     tmp->varDecl.identifier = identifier;
     tmp->varDecl.typeLiteral = typeLiteral;
     tmp->varDecl.expression = expression;
-    tmp->varDecl.line = line;
+    tmp->varDecl.offset = offset;
 
     *nodeHandle = tmp;
 }
@@ -273,7 +273,7 @@ void Xvr_emitASTNodeFnCollection(Xvr_ASTNode** nodeHandle) {
 
 void Xvr_emitASTNodeFnDecl(Xvr_ASTNode** nodeHandle, Xvr_Literal identifier,
                            Xvr_ASTNode* arguments, Xvr_ASTNode* returns,
-                           Xvr_ASTNode* block, int line) {
+                           Xvr_ASTNode* block, int offset) {
     Xvr_ASTNode* tmp = XVR_ALLOCATE(Xvr_ASTNode, 1);
 
     tmp->type = XVR_AST_NODE_FN_DECL;
@@ -281,7 +281,7 @@ void Xvr_emitASTNodeFnDecl(Xvr_ASTNode** nodeHandle, Xvr_Literal identifier,
     tmp->fnDecl.arguments = arguments;
     tmp->fnDecl.returns = returns;
     tmp->fnDecl.block = block;
-    tmp->fnDecl.line = line;
+    tmp->fnDecl.offset = offset;
 
     *nodeHandle = tmp;
 }
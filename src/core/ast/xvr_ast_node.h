@@ -238,7 +238,7 @@ typedef struct Xvr_NodeIndex {
 
 void Xvr_emitASTNodeVarDecl(Xvr_ASTNode** nodeHandle, Xvr_Literal identifier,
                             Xvr_Literal typeLiteral, Xvr_ASTNode* expression,
-                            int line);
+                            int offset);
 
 /**
  * @struct Xvr_NodeVarDecl
@@ -251,7 +251,7 @@ typedef struct Xvr_NodeVarDecl {
     Xvr_Literal identifier;   // variable name (XVR_LITERAL_IDENTIFIER)
     Xvr_Literal typeLiteral;  // type annotation
     Xvr_ASTNode* expression;  // initializer expression
-    int line;                 // line number
+    int offset;               // byte offset of the name in the source
 } Xvr_NodeVarDecl;
 
 void Xvr_emitASTNodeFnCollection(Xvr_ASTNode** nodeHandle);
@@ -271,7 +271,7 @@ typedef struct Xvr_NodeFnCollection {
 
 void Xvr_emitASTNodeFnDecl(Xvr_ASTNode** nodeHandle, Xvr_Literal identifier,
                            Xvr_ASTNode* arguments, Xvr_ASTNode* returns,
-                           Xvr_ASTNode* block, int line);
+                           Xvr_ASTNode* block, int offset);
 
 /**
  * @struct Xvr_NodeFnDecl
@@ -286,7 +286,7 @@ typedef struct Xvr_NodeFnDecl {
         arguments;  // parameter list (Xvr_NodeCompound or Xvr_NodeVarDecl)
     Xvr_ASTNode* returns;  // return type
     Xvr_ASTNode* block;    // procedure body
-    int line;              // line number
+    int offset;            // byte offset of the name in the source
 } Xvr_NodeFnDecl;
 
 void Xvr_emitASTNodeFnCall(Xvr_ASTNode** nodeHandle, Xvr_ASTNode* arguments);
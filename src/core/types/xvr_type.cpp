@@ -12,26 +12,70 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "../../xvr_literal.h"
+#include <mutex>
 
-static Xvr_TypeTable g_type_table = {0};
+#include "../../xvr_literal.h"
 
-static Xvr_Type* find_or_create_type(const char* name, Xvr_TypeKind kind) {
-    for (int i = 0; i < g_type_table.count; i++) {
-        if (g_type_table.types[i]->kind == kind &&
-            strcmp(g_type_table.types[i]->name, name) == 0) {
-            return g_type_table.types[i];
+static Xvr_TypeTable g_type_table = {};
+static std::mutex g_type_table_lock;
+
+/* bool, void and string carry no size, one immutable instance serves every
+ * table and thread */
+static Xvr_Type g_bool_type = {XVR_KIND_BOOL, {}, "bool"};
+static Xvr_Type g_void_type = {XVR_KIND_VOID, {}, "void"};
+static Xvr_Type g_string_type = {XVR_KIND_STRING, {}, "string"};
+
+static Xvr_Type* find_type(Xvr_TypeTable* table, const char* name,
+                           Xvr_TypeKind kind) {
+    for (int i = 0; i < table->count; i++) {
+        if (table->types[i]->kind == kind &&
+            strcmp(table->types[i]->name, name) == 0) {
+            return table->types[i];
         }
     }
     return NULL;
 }
 
-Xvr_Type* Xvr_TypeCreateInteger(int size_bits, Xvr_Signedness signedness) {
+/* the table owns every type it hands out, so one it can't record is freed
+ * and the lookup fails rather than returning an untracked duplicate */
+static Xvr_Type* intern_type(Xvr_TypeTable* table, Xvr_Type* type) {
+    if (table->count == table->capacity) {
+        int capacity = table->capacity < 8 ? 8 : table->capacity * 2;
+        Xvr_Type** grown = (Xvr_Type**)realloc(
+            table->types, sizeof(Xvr_Type*) * capacity);
+        if (!grown) {
+            Xvr_TypeDestroy(type);
+            return NULL;
+        }
+        table->types = grown;
+        table->capacity = capacity;
+    }
+    table->types[table->count++] = type;
+    return type;
+}
+
+Xvr_TypeTable* Xvr_TypeTableCreate(void) {
+    return (Xvr_TypeTable*)calloc(1, sizeof(Xvr_TypeTable));
+}
+
+void Xvr_TypeTableDestroy(Xvr_TypeTable* table) {
+    if (!table) return;
+    for (int i = 0; i < table->count; i++) {
+        Xvr_TypeDestroy(table->types[i]);
+    }
+    free(table->types);
+    free(table);
+}
+
+Xvr_Type* Xvr_TypeTableGetInteger(Xvr_TypeTable* table, int size_bits,
+                                  Xvr_Signedness signedness) {
+    if (!table) return NULL;
+
     char name[32];
     snprintf(name, sizeof(name), "int%d_%s", size_bits,
              signedness == XVR_SIGNEDNESS_SIGNED ? "s" : "u");
 
-    Xvr_Type* type = find_or_create_type(name, XVR_KIND_INTEGER);
+    Xvr_Type* type = find_type(table, name, XVR_KIND_INTEGER);
     if (type) return type;
 
     type = (Xvr_Type*)calloc(1, sizeof(Xvr_Type));
@@ -42,18 +86,16 @@ Xvr_Type* Xvr_TypeCreateInteger(int size_bits, Xvr_Signedness signedness) {
     type->data.integer.signedness = signedness;
     type->name = strdup(name);
 
-    if (g_type_table.count < 32) {
-        g_type_table.types[g_type_table.count++] = type;
-    }
-
-    return type;
+    return intern_type(table, type);
 }
 
-Xvr_Type* Xvr_TypeCreateFloat(int size_bits) {
+Xvr_Type* Xvr_TypeTableGetFloat(Xvr_TypeTable* table, int size_bits) {
+    if (!table) return NULL;
+
     char name[32];
     snprintf(name, sizeof(name), "float%d", size_bits);
 
-    Xvr_Type* type = find_or_create_type(name, XVR_KIND_FLOAT);
+    Xvr_Type* type = find_type(table, name, XVR_KIND_FLOAT);
     if (type) return type;
 
     type = (Xvr_Type*)calloc(1, sizeof(Xvr_Type));
@@ -63,93 +105,39 @@ Xvr_Type* Xvr_TypeCreateFloat(int size_bits) {
     type->data.float_type.size_bits = size_bits;
     type->name = strdup(name);
 
-    if (g_type_table.count < 32) {
-        g_type_table.types[g_type_table.count++] = type;
-    }
-
-    return type;
-}
-
-Xvr_Type* Xvr_TypeCreatePointer(Xvr_Type* pointee) {
-    Xvr_Type* type = (Xvr_Type*)calloc(1, sizeof(Xvr_Type));
-    if (!type) return NULL;
-
-    type->kind = XVR_KIND_POINTER;
-    type->data.pointer.pointee_type = pointee;
-    type->name = "pointer";
-
-    return type;
+    return intern_type(table, type);
 }
 
-Xvr_Type* Xvr_TypeCreateBool(void) {
-    static Xvr_Type* bool_type = NULL;
-    if (bool_type) return bool_type;
-
-    bool_type = (Xvr_Type*)calloc(1, sizeof(Xvr_Type));
-    if (!bool_type) return NULL;
-
-    bool_type->kind = XVR_KIND_BOOL;
-    bool_type->name = "bool";
-
-    return bool_type;
-}
-
-Xvr_Type* Xvr_TypeCreateVoid(void) {
-    static Xvr_Type* void_type = NULL;
-    if (void_type) return void_type;
-
-    void_type = (Xvr_Type*)calloc(1, sizeof(Xvr_Type));
-    if (!void_type) return NULL;
-
-    void_type->kind = XVR_KIND_VOID;
-    void_type->name = "void";
-
-    return void_type;
-}
-
-Xvr_Type* Xvr_TypeCreateString(void) {
-    static Xvr_Type* string_type = NULL;
-    if (string_type) return string_type;
-
-    string_type = (Xvr_Type*)calloc(1, sizeof(Xvr_Type));
-    if (!string_type) return NULL;
-
-    string_type->kind = XVR_KIND_STRING;
-    string_type->name = "string";
-
-    return string_type;
-}
-
-Xvr_Type* Xvr_TypeGetFromLiteral(int literal_type) {
+Xvr_Type* Xvr_TypeTableGetFromLiteral(Xvr_TypeTable* table, int literal_type) {
     switch (literal_type) {
     case XVR_LITERAL_BOOLEAN:
         return Xvr_TypeCreateBool();
     case XVR_LITERAL_INTEGER:
-        return Xvr_TypeCreateInteger(32, XVR_SIGNEDNESS_SIGNED);
+        return Xvr_TypeTableGetInteger(table, 32, XVR_SIGNEDNESS_SIGNED);
     case XVR_LITERAL_INT8:
-        return Xvr_TypeCreateInteger(8, XVR_SIGNEDNESS_SIGNED);
+        return Xvr_TypeTableGetInteger(table, 8, XVR_SIGNEDNESS_SIGNED);
     case XVR_LITERAL_INT16:
-        return Xvr_TypeCreateInteger(16, XVR_SIGNEDNESS_SIGNED);
+        return Xvr_TypeTableGetInteger(table, 16, XVR_SIGNEDNESS_SIGNED);
     case XVR_LITERAL_INT32:
-        return Xvr_TypeCreateInteger(32, XVR_SIGNEDNESS_SIGNED);
+        return Xvr_TypeTableGetInteger(table, 32, XVR_SIGNEDNESS_SIGNED);
     case XVR_LITERAL_INT64:
-        return Xvr_TypeCreateInteger(64, XVR_SIGNEDNESS_SIGNED);
+        return Xvr_TypeTableGetInteger(table, 64, XVR_SIGNEDNESS_SIGNED);
     case XVR_LITERAL_UINT8:
-        return Xvr_TypeCreateInteger(8, XVR_SIGNEDNESS_UNSIGNED);
+        return Xvr_TypeTableGetInteger(table, 8, XVR_SIGNEDNESS_UNSIGNED);
     case XVR_LITERAL_UINT16:
-        return Xvr_TypeCreateInteger(16, XVR_SIGNEDNESS_UNSIGNED);
+        return Xvr_TypeTableGetInteger(table, 16, XVR_SIGNEDNESS_UNSIGNED);
     case XVR_LITERAL_UINT32:
-        return Xvr_TypeCreateInteger(32, XVR_SIGNEDNESS_UNSIGNED);
+        return Xvr_TypeTableGetInteger(table, 32, XVR_SIGNEDNESS_UNSIGNED);
     case XVR_LITERAL_UINT64:
-        return Xvr_TypeCreateInteger(64, XVR_SIGNEDNESS_UNSIGNED);
+        return Xvr_TypeTableGetInteger(table, 64, XVR_SIGNEDNESS_UNSIGNED);
     case XVR_LITERAL_FLOAT:
-        return Xvr_TypeCreateFloat(32);
+        return Xvr_TypeTableGetFloat(table, 32);
     case XVR_LITERAL_FLOAT16:
-        return Xvr_TypeCreateFloat(16);
+        return Xvr_TypeTableGetFloat(table, 16);
     case XVR_LITERAL_FLOAT32:
-        return Xvr_TypeCreateFloat(32);
+        return Xvr_TypeTableGetFloat(table, 32);
     case XVR_LITERAL_FLOAT64:
-        return Xvr_TypeCreateFloat(64);
+        return Xvr_TypeTableGetFloat(table, 64);
     case XVR_LITERAL_STRING:
         return Xvr_TypeCreateString();
     default:
@@ -157,6 +145,38 @@ Xvr_Type* Xvr_TypeGetFromLiteral(int literal_type) {
     }
 }
 
+Xvr_Type* Xvr_TypeCreateInteger(int size_bits, Xvr_Signedness signedness) {
+    std::lock_guard<std::mutex> guard(g_type_table_lock);
+    return Xvr_TypeTableGetInteger(&g_type_table, size_bits, signedness);
+}
+
+Xvr_Type* Xvr_TypeCreateFloat(int size_bits) {
+    std::lock_guard<std::mutex> guard(g_type_table_lock);
+    return Xvr_TypeTableGetFloat(&g_type_table, size_bits);
+}
+
+Xvr_Type* Xvr_TypeCreatePointer(Xvr_Type* pointee) {
+    Xvr_Type* type = (Xvr_Type*)calloc(1, sizeof(Xvr_Type));
+    if (!type) return NULL;
+
+    type->kind = XVR_KIND_POINTER;
+    type->data.pointer.pointee_type = pointee;
+    type->name = "pointer";
+
+    return type;
+}
+
+Xvr_Type* Xvr_TypeCreateBool(void) { return &g_bool_type; }
+
+Xvr_Type* Xvr_TypeCreateVoid(void) { return &g_void_type; }
+
+Xvr_Type* Xvr_TypeCreateString(void) { return &g_string_type; }
+
+Xvr_Type* Xvr_TypeGetFromLiteral(int literal_type) {
+    std::lock_guard<std::mutex> guard(g_type_table_lock);
+    return Xvr_TypeTableGetFromLiteral(&g_type_table, literal_type);
+}
+
 int Xvr_TypeGetSizeBits(const Xvr_Type* type) {
     if (!type) return 0;
 
@@ -230,7 +250,7 @@ bool Xvr_TypeEquals(const Xvr_Type* a, const Xvr_Type* b) {
 }
 
 const char* Xvr_TypeToString(const Xvr_Type* type) {
-    static char buffer[64];
+    static thread_local char buffer[64];
 
     if (!type) return "unknown";
 
@@ -259,7 +279,10 @@ const char* Xvr_TypeToString(const Xvr_Type* type) {
 }
 
 void Xvr_TypeDestroy(Xvr_Type* type) {
-    if (!type) return;
+    if (!type || type == &g_bool_type || type == &g_void_type ||
+        type == &g_string_type) {
+        return;
+    }
     free((void*)type->name);
     free(type);
 }
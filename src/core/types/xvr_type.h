@@ -78,10 +78,20 @@ typedef struct Xvr_Type {
 } Xvr_Type;
 
 typedef struct Xvr_TypeTable {
-    Xvr_Type* types[32];
+    Xvr_Type** types;
     int count;
+    int capacity;
 } Xvr_TypeTable;
 
+/* a table interns the sized types of one compilation; the Xvr_TypeCreate*
+ * functions below share a process-wide table */
+Xvr_TypeTable* Xvr_TypeTableCreate(void);
+void Xvr_TypeTableDestroy(Xvr_TypeTable* table);
+Xvr_Type* Xvr_TypeTableGetInteger(Xvr_TypeTable* table, int size_bits,
+                                  Xvr_Signedness signedness);
+Xvr_Type* Xvr_TypeTableGetFloat(Xvr_TypeTable* table, int size_bits);
+Xvr_Type* Xvr_TypeTableGetFromLiteral(Xvr_TypeTable* table, int literal_type);
+
 Xvr_Type* Xvr_TypeCreateInteger(int size_bits, Xvr_Signedness signedness);
 Xvr_Type* Xvr_TypeCreateFloat(int size_bits);
 Xvr_Type* Xvr_TypeCreatePointer(Xvr_Type* pointee);
@@ -8,8 +8,18 @@
 #include "xvr_literal.h"
 
 #ifdef XVR_EXPORT_LLVM
+#    include <dirent.h>
+#    include <limits.h>
+
+#    include <cstddef>
+#    include <mutex>
+#    include <string>
+#    include <vector>
+
+#    include "xvr_compiler_session.h"
 #    include "xvr_lexer.h"
 #    include "xvr_parser.h"
+#    include "xvr_source_file.h"
 #endif
 
 #define XVR_BUILTIN_MAX 64
@@ -22,6 +32,7 @@ struct Xvr_BuiltinRegistry {
 
 struct Xvr_ModuleResolver {
     char* stdlib_path;
+    Xvr_CompilerSession* session;
 };
 
 static LLVMValueRef handle_sizeof(void* context, LLVMBuilderRef builder,
@@ -284,43 +295,9 @@ bool Xvr_ModuleResolverResolve(Xvr_ModuleResolver* resolver,
     return true;
 }
 
-static const unsigned char* read_file(const char* path, size_t* size) {
-    FILE* f = fopen(path, "rb");
-    if (!f) {
-        return NULL;
-    }
-
-    fseek(f, 0, SEEK_END);
-    long len = ftell(f);
-    fseek(f, 0, SEEK_SET);
-
-    if (len < 0) {
-        fclose(f);
-        return NULL;
-    }
-
-    unsigned char* buffer = (unsigned char*)malloc(len + 1);
-    if (!buffer) {
-        fclose(f);
-        return NULL;
-    }
-
-    size_t read = fread(buffer, 1, len, f);
-    buffer[read] = '\0';
-    fclose(f);
-
-    *size = read;
-    return buffer;
-}
-
-bool Xvr_ModuleResolverLoadModule(Xvr_ModuleResolver* resolver,
-                                  const char* module_path,
-                                  Xvr_ASTNode*** out_nodes, int* out_count) {
 #ifdef XVR_EXPORT_LLVM
-    if (!resolver || !module_path || !out_nodes || !out_count) {
-        return false;
-    }
-
+static bool parse_module(const char* module_path, Xvr_CompilerSession* session,
+                         Xvr_ASTNode*** out_nodes, int* out_count) {
     FILE* test = fopen(module_path, "r");
     if (!test) {
         return false;
@@ -328,7 +305,7 @@ bool Xvr_ModuleResolverLoadModule(Xvr_ModuleResolver* resolver,
     fclose(test);
 
     size_t file_size = 0;
-    const unsigned char* source = read_file(module_path, &file_size);
+    const char* source = Xvr_mapSourceFile(module_path, &file_size);
     if (!source) {
         return false;
     }
@@ -336,7 +313,7 @@ bool Xvr_ModuleResolverLoadModule(Xvr_ModuleResolver* resolver,
     Xvr_Lexer lexer;
     Xvr_Parser parser;
 
-    Xvr_initLexer(&lexer, (const char*)source);
+    Xvr_initLexerWithSession(&lexer, source, session);
     Xvr_initParser(&parser, &lexer);
 
     Xvr_ASTNode** nodes = NULL;
@@ -353,22 +330,22 @@ bool Xvr_ModuleResolverLoadModule(Xvr_ModuleResolver* resolver,
             }
             free(nodes);
             Xvr_freeParser(&parser);
-            free((void*)source);
+            Xvr_unmapSourceFile(source, file_size);
             *out_count = 0;
             return false;
         }
 
         if (node_count >= node_capacity) {
             node_capacity = node_capacity < 8 ? 8 : node_capacity * 2;
-            Xvr_ASTNode** new_nodes =
-                realloc(nodes, sizeof(Xvr_ASTNode*) * node_capacity);
+            Xvr_ASTNode** new_nodes = (Xvr_ASTNode**)realloc(
+                nodes, sizeof(Xvr_ASTNode*) * node_capacity);
             if (!new_nodes) {
                 for (int i = 0; i < node_count; i++) {
                     Xvr_freeASTNode(nodes[i]);
                 }
                 free(nodes);
                 Xvr_freeParser(&parser);
-                free((void*)source);
+                Xvr_unmapSourceFile(source, file_size);
                 *out_nodes = NULL;
                 *out_count = 0;
                 return false;
@@ -380,11 +357,119 @@ bool Xvr_ModuleResolverLoadModule(Xvr_ModuleResolver* resolver,
     }
 
     Xvr_freeParser(&parser);
-    free((void*)source);
+    Xvr_unmapSourceFile(source, file_size);
 
     *out_nodes = nodes;
     *out_count = node_count;
     return true;
+}
+
+// modules parsed ahead of time, keyed by their real path; a compile server
+// fills this once and every forked request starts with the stdlib parsed
+struct Xvr_PreloadedModule {
+    std::string path;
+    time_t mtime;
+    off_t size;
+    Xvr_ASTNode** nodes;
+    int count;
+};
+
+static std::mutex g_preload_mutex;
+static std::vector<Xvr_PreloadedModule> g_preloaded;
+
+static void free_module_nodes(Xvr_ASTNode** nodes, int count) {
+    for (int i = 0; i < count; i++) {
+        Xvr_freeASTNode(nodes[i]);
+    }
+    free(nodes);
+}
+
+static bool take_preloaded(const char* module_path, Xvr_ASTNode*** out_nodes,
+                           int* out_count) {
+    char real[PATH_MAX];
+    struct stat st;
+    if (!realpath(module_path, real) || stat(real, &st) != 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_preload_mutex);
+    for (size_t i = 0; i < g_preloaded.size(); i++) {
+        Xvr_PreloadedModule& module = g_preloaded[i];
+        if (module.path != real) {
+            continue;
+        }
+
+        // the nodes belong to the caller from here on, either way
+        bool fresh = module.mtime == st.st_mtime && module.size == st.st_size;
+        if (fresh) {
+            *out_nodes = module.nodes;
+            *out_count = module.count;
+        } else {
+            free_module_nodes(module.nodes, module.count);
+        }
+        g_preloaded.erase(g_preloaded.begin() + (std::ptrdiff_t)i);
+        return fresh;
+    }
+    return false;
+}
+
+static bool preload_module(const char* module_path) {
+    char real[PATH_MAX];
+    struct stat st;
+    if (!realpath(module_path, real) || stat(real, &st) != 0) {
+        return false;
+    }
+
+    // nobody asked for this module yet, its syntax errors surface when an
+    // import parses it again
+    Xvr_CompilerOptions options;
+    Xvr_CompilerOptionsInit(&options);
+    options.printDiagnostics = false;
+    Xvr_CompilerSession* quiet = Xvr_CompilerSessionCreate(&options);
+    if (!quiet) {
+        return false;
+    }
+
+    Xvr_PreloadedModule module;
+    module.path = real;
+    module.mtime = st.st_mtime;
+    module.size = st.st_size;
+    module.nodes = NULL;
+    module.count = 0;
+    bool parsed = parse_module(real, quiet, &module.nodes, &module.count);
+    Xvr_CompilerSessionDestroy(quiet);
+    if (!parsed) {
+        return false;
+    }
+
+    Xvr_ASTNode** stale_nodes = NULL;
+    int stale_count = 0;
+    take_preloaded(real, &stale_nodes, &stale_count);
+    free_module_nodes(stale_nodes, stale_count);
+
+    std::lock_guard<std::mutex> lock(g_preload_mutex);
+    g_preloaded.push_back(module);
+    return true;
+}
+#endif
+
+bool Xvr_ModuleResolverLoadModule(Xvr_ModuleResolver* resolver,
+                                  const char* module_path,
+                                  Xvr_ASTNode*** out_nodes, int* out_count) {
+#ifdef XVR_EXPORT_LLVM
+    if (!resolver || !module_path || !out_nodes || !out_count) {
+        return false;
+    }
+
+    // --dump-tokens wants to see the module lexed
+    const Xvr_CompilerOptions* options =
+        Xvr_CompilerSessionGetOptions(resolver->session);
+    if (!options->dumpTokens &&
+        take_preloaded(module_path, out_nodes, out_count)) {
+        return true;
+    }
+
+    return parse_module(module_path, resolver->session, out_nodes, out_count);
 #else
     (void)resolver;
     (void)module_path;
@@ -394,6 +479,39 @@ bool Xvr_ModuleResolverLoadModule(Xvr_ModuleResolver* resolver,
 #endif
 }
 
+int Xvr_ModuleResolverPreloadStdlib(Xvr_ModuleResolver* resolver) {
+#ifdef XVR_EXPORT_LLVM
+    if (!resolver || !resolver->stdlib_path) {
+        return 0;
+    }
+
+    DIR* dir = opendir(resolver->stdlib_path);
+    if (!dir) {
+        return 0;
+    }
+
+    int preloaded = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len <= 4 || strcmp(entry->d_name + len - 4, ".xvr") != 0) {
+            continue;
+        }
+
+        std::string path = std::string(resolver->stdlib_path) + "/" +
+                           entry->d_name;
+        if (preload_module(path.c_str())) {
+            preloaded++;
+        }
+    }
+    closedir(dir);
+    return preloaded;
+#else
+    (void)resolver;
+    return 0;
+#endif
+}
+
 const char* Xvr_ModuleResolverGetStdlibPath(Xvr_ModuleResolver* resolver) {
     return resolver ? resolver->stdlib_path : NULL;
 }
@@ -407,3 +525,12 @@ void Xvr_ModuleResolverSetStdlibPath(Xvr_ModuleResolver* resolver,
     free(resolver->stdlib_path);
     resolver->stdlib_path = path ? strdup(path) : strdup("./lib/std");
 }
+
+void Xvr_ModuleResolverSetSession(Xvr_ModuleResolver* resolver,
+                                  Xvr_CompilerSession* session) {
+    if (!resolver) {
+        return;
+    }
+
+    resolver->session = session;
+}
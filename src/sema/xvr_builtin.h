@@ -79,6 +79,7 @@ bool Xvr_BuiltinRegistryIsBuiltin(Xvr_BuiltinRegistry* registry,
 void Xvr_BuiltinRegistryInitDefaults(Xvr_BuiltinRegistry* registry);
 
 typedef struct Xvr_ModuleResolver Xvr_ModuleResolver;
+typedef struct Xvr_CompilerSession Xvr_CompilerSession;
 
 Xvr_ModuleResolver* Xvr_ModuleResolverCreate(const char* stdlib_path);
 void Xvr_ModuleResolverDestroy(Xvr_ModuleResolver* resolver);
@@ -94,6 +95,16 @@ const char* Xvr_ModuleResolverGetStdlibPath(Xvr_ModuleResolver* resolver);
 void Xvr_ModuleResolverSetStdlibPath(Xvr_ModuleResolver* resolver,
                                      const char* path);
 
+/* parses every .xvr in the stdlib directory now; the next load of each file
+ * takes its nodes instead of parsing it again, as long as the file did not
+ * change. returns the number of modules parsed */
+int Xvr_ModuleResolverPreloadStdlib(Xvr_ModuleResolver* resolver);
+
+/* imported modules are parsed with the session's options and report their
+ * syntax errors to it */
+void Xvr_ModuleResolverSetSession(Xvr_ModuleResolver* resolver,
+                                  Xvr_CompilerSession* session);
+
 #ifdef __cplusplus
 }
 #endif
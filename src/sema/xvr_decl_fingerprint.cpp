@@ -0,0 +1,194 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_decl_fingerprint.h"
+
+#include <string.h>
+
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "xvr_lexer.h"
+
+namespace {
+
+/* FNV-1a, the fingerprints only need to be stable within one process */
+constexpr uint64_t kHashSeed = 14695981039346656037ull;
+constexpr uint64_t kHashPrime = 1099511628211ull;
+
+void hash_bytes(uint64_t* hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        *hash = (*hash ^ bytes[i]) * kHashPrime;
+    }
+}
+
+void hash_token(uint64_t* hash, const Xvr_Token& token) {
+    int type = static_cast<int>(token.type);
+    hash_bytes(hash, &type, sizeof(type));
+    hash_bytes(hash, token.lexeme, static_cast<size_t>(token.length));
+}
+
+void hash_value(uint64_t* hash, uint64_t value) {
+    hash_bytes(hash, &value, sizeof(value));
+}
+
+/* a top-level proc, or the rest of the program when name is empty */
+struct Declaration {
+    std::string name;
+    uint64_t signature = kHashSeed;
+    uint64_t tokens = kHashSeed;
+    std::vector<std::string> names;  // identifiers it uses, in order
+    uint64_t fingerprint = 0;
+    bool duplicate = false;
+};
+
+}  // namespace
+
+struct Xvr_DeclFingerprints {
+    Declaration program;
+    std::vector<Declaration> procs;
+    std::unordered_map<std::string, size_t> by_name;
+};
+
+Xvr_DeclFingerprints* Xvr_DeclFingerprintsCreate(const char* source) {
+    if (!source) {
+        return NULL;
+    }
+    Xvr_DeclFingerprints* fingerprints = new (std::nothrow)
+        Xvr_DeclFingerprints();
+    if (!fingerprints) {
+        return NULL;
+    }
+
+    Xvr_Lexer lexer;
+    Xvr_initLexer(&lexer, source);
+    uint64_t imports = kHashSeed;
+    bool in_import = false;
+    int depth = 0;
+    Declaration* proc = NULL;
+    bool in_body = false;
+
+    for (;;) {
+        Xvr_Token token = Xvr_private_scanLexer(&lexer);
+        if (token.type == XVR_TOKEN_EOF || token.type == XVR_TOKEN_ERROR) {
+            break;
+        }
+
+        if (!proc && depth == 0 && token.type == XVR_TOKEN_FUNCTION) {
+            fingerprints->procs.emplace_back();
+            proc = &fingerprints->procs.back();
+            in_body = false;
+        }
+
+        Declaration* owner = proc ? proc : &fingerprints->program;
+        hash_token(&owner->tokens, token);
+        if (token.type == XVR_TOKEN_IDENTIFIER) {
+            std::string name(token.lexeme, static_cast<size_t>(token.length));
+            if (proc && proc->name.empty() && !in_body) {
+                proc->name = name;
+            } else {
+                owner->names.push_back(name);
+            }
+        }
+        if (proc && !in_body) {
+            hash_token(&proc->signature, token);
+        }
+
+        if (!proc && depth == 0 &&
+            (in_import || token.type == XVR_TOKEN_IMPORT)) {
+            hash_token(&imports, token);
+            in_import = token.type != XVR_TOKEN_SEMICOLON;
+        }
+
+        if (token.type == XVR_TOKEN_BRACE_LEFT) {
+            depth++;
+            in_body = proc != NULL;
+        } else if (token.type == XVR_TOKEN_BRACE_RIGHT && depth > 0) {
+            depth--;
+        }
+        // a proc ends with its body, or with a ';' if it has none
+        if (proc && depth == 0 &&
+            (token.type == XVR_TOKEN_BRACE_RIGHT ||
+             (!in_body && token.type == XVR_TOKEN_SEMICOLON))) {
+            proc = NULL;
+        }
+    }
+
+    std::vector<Declaration>& procs = fingerprints->procs;
+    for (size_t i = 0; i < procs.size(); i++) {
+        auto inserted = fingerprints->by_name.emplace(procs[i].name, i);
+        if (!inserted.second) {
+            procs[inserted.first->second].duplicate = true;
+        }
+    }
+
+    auto finish = [&](Declaration& declaration, bool with_imports) {
+        uint64_t hash = declaration.tokens;
+        if (with_imports) {
+            hash_value(&hash, imports);
+        }
+        for (const std::string& name : declaration.names) {
+            auto found = fingerprints->by_name.find(name);
+            if (found != fingerprints->by_name.end() &&
+                procs[found->second].name != declaration.name) {
+                hash_value(&hash, procs[found->second].signature);
+            }
+        }
+        declaration.fingerprint = hash;
+    };
+    finish(fingerprints->program, false);
+    for (Declaration& declaration : procs) {
+        finish(declaration, true);
+    }
+    return fingerprints;
+}
+
+void Xvr_DeclFingerprintsDestroy(Xvr_DeclFingerprints* fingerprints) {
+    delete fingerprints;
+}
+
+bool Xvr_DeclFingerprintsGetProc(const Xvr_DeclFingerprints* fingerprints,
+                                 const char* name, uint64_t* out) {
+    if (!fingerprints || !name || !out) {
+        return false;
+    }
+    auto found = fingerprints->by_name.find(name);
+    if (found == fingerprints->by_name.end()) {
+        return false;
+    }
+    const Declaration& proc = fingerprints->procs[found->second];
+    if (proc.duplicate) {
+        return false;
+    }
+    *out = proc.fingerprint;
+    return true;
+}
+
+uint64_t Xvr_DeclFingerprintsGetProgram(
+    const Xvr_DeclFingerprints* fingerprints) {
+    return fingerprints ? fingerprints->program.fingerprint : 0;
+}
@@ -0,0 +1,64 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_DECL_FINGERPRINT_H
+#define XVR_DECL_FINGERPRINT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief a hash per top-level proc of a source file, for rebuilding only
+ * what an edit touched
+ *
+ * a proc's fingerprint covers its own tokens, the file's import statements
+ * and the signature of every other proc it names, so editing a signature
+ * changes the fingerprints of its callers too. whatever is not a proc
+ * (imports and top-level statements) shares one program fingerprint.
+ * tokens are hashed, not text, so whitespace and comments do not count
+ */
+typedef struct Xvr_DeclFingerprints Xvr_DeclFingerprints;
+
+Xvr_DeclFingerprints* Xvr_DeclFingerprintsCreate(const char* source);
+void Xvr_DeclFingerprintsDestroy(Xvr_DeclFingerprints* fingerprints);
+
+/**
+ * @brief the fingerprint of the proc named `name`
+ * @return false if the source defines no such proc, or more than one
+ */
+bool Xvr_DeclFingerprintsGetProc(const Xvr_DeclFingerprints* fingerprints,
+                                 const char* name, uint64_t* out);
+
+uint64_t Xvr_DeclFingerprintsGetProgram(
+    const Xvr_DeclFingerprints* fingerprints);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
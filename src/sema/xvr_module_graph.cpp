@@ -0,0 +1,352 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_module_graph.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "xvr_common.h"
+
+typedef struct {
+    std::string name;
+    std::string path;
+    std::vector<std::string> import_names;
+    std::vector<size_t> imports;
+    Xvr_ASTNode** nodes = nullptr;
+    int node_count = 0;
+    bool prebuilt = false;
+    bool emitted = false;
+} Xvr_GraphModule;
+
+struct Xvr_ModuleGraph {
+    Xvr_ModuleResolver* resolver;
+    unsigned jobs = 0;
+    Xvr_ModuleGraphPrebuiltFn prebuilt = nullptr;
+    void* prebuilt_context = nullptr;
+
+    std::vector<Xvr_GraphModule> modules;
+    std::unordered_map<std::string, size_t> by_path;
+    size_t parse_count = 0;
+
+    char* error_message = nullptr;
+};
+
+static void set_error(Xvr_ModuleGraph* graph, const std::string& message) {
+    free(graph->error_message);
+    graph->error_message = Xvr_strdup(message.c_str());
+}
+
+static void free_nodes(Xvr_GraphModule* module) {
+    for (int i = 0; i < module->node_count; i++) {
+        Xvr_freeASTNode(module->nodes[i]);
+    }
+    free(module->nodes);
+    module->nodes = nullptr;
+    module->node_count = 0;
+}
+
+Xvr_ModuleGraph* Xvr_ModuleGraphCreate(Xvr_ModuleResolver* resolver) {
+    if (!resolver) {
+        return NULL;
+    }
+    Xvr_ModuleGraph* graph = new (std::nothrow) Xvr_ModuleGraph();
+    if (graph) {
+        graph->resolver = resolver;
+    }
+    return graph;
+}
+
+void Xvr_ModuleGraphDestroy(Xvr_ModuleGraph* graph) {
+    if (!graph) {
+        return;
+    }
+    for (Xvr_GraphModule& module : graph->modules) {
+        free_nodes(&module);
+    }
+    free(graph->error_message);
+    delete graph;
+}
+
+void Xvr_ModuleGraphSetJobs(Xvr_ModuleGraph* graph, unsigned jobs) {
+    if (graph) {
+        graph->jobs = jobs;
+    }
+}
+
+void Xvr_ModuleGraphSetPrebuilt(Xvr_ModuleGraph* graph,
+                                Xvr_ModuleGraphPrebuiltFn prebuilt,
+                                void* context) {
+    if (graph) {
+        graph->prebuilt = prebuilt;
+        graph->prebuilt_context = context;
+    }
+}
+
+/* returns the module's index, adding it to `wave` if it is new */
+static bool find_or_add(Xvr_ModuleGraph* graph, const char* name,
+                        std::vector<size_t>* wave, size_t* out_index) {
+    char* path = NULL;
+    if (!Xvr_ModuleResolverResolve(graph->resolver, name, &path)) {
+        return false;
+    }
+    auto found = graph->by_path.find(path);
+    if (found != graph->by_path.end()) {
+        *out_index = found->second;
+        free(path);
+        return true;
+    }
+    Xvr_GraphModule module;
+    module.name = name;
+    module.path = path;
+    free(path);
+    *out_index = graph->modules.size();
+    graph->by_path.emplace(module.path, *out_index);
+    graph->modules.push_back(std::move(module));
+    wave->push_back(*out_index);
+    return true;
+}
+
+/* each module is parsed by whichever thread takes it next */
+static void parse_wave(Xvr_ModuleGraph* graph,
+                       const std::vector<size_t>& wave) {
+    unsigned threads =
+        graph->jobs ? graph->jobs : std::thread::hardware_concurrency();
+    threads = std::max(1u, std::min<unsigned>(threads, (unsigned)wave.size()));
+
+    std::atomic<size_t> next(0);
+    auto parse = [graph, &wave, &next]() {
+        for (size_t i = next++; i < wave.size(); i = next++) {
+            Xvr_GraphModule& module = graph->modules[wave[i]];
+            if (!Xvr_ModuleResolverLoadModule(graph->resolver,
+                                              module.path.c_str(),
+                                              &module.nodes,
+                                              &module.node_count)) {
+                module.nodes = nullptr;
+                module.node_count = 0;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(parse);
+    }
+    parse();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void Xvr_ModuleGraphAdd(Xvr_ModuleGraph* graph, const char* const* names,
+                        size_t count) {
+    if (!graph || (!names && count > 0)) {
+        return;
+    }
+    std::vector<size_t> wave;
+    for (size_t i = 0; i < count; i++) {
+        size_t index = 0;
+        find_or_add(graph, names[i], &wave, &index);
+    }
+
+    while (!wave.empty()) {
+        std::vector<size_t> to_parse;
+        for (size_t index : wave) {
+            Xvr_GraphModule& module = graph->modules[index];
+            char** imports = NULL;
+            size_t import_count = 0;
+            if (graph->prebuilt &&
+                graph->prebuilt(graph->prebuilt_context, module.path.c_str(),
+                                &imports, &import_count)) {
+                module.prebuilt = true;
+                for (size_t i = 0; i < import_count; i++) {
+                    module.import_names.push_back(imports[i]);
+                    free(imports[i]);
+                }
+                free(imports);
+            } else {
+                to_parse.push_back(index);
+            }
+        }
+        parse_wave(graph, to_parse);
+        graph->parse_count += to_parse.size();
+
+        for (size_t index : to_parse) {
+            Xvr_GraphModule& module = graph->modules[index];
+            for (int i = 0; i < module.node_count; i++) {
+                Xvr_ASTNode* node = module.nodes[i];
+                Xvr_Literal* ident = &node->import.identifier;
+                if (node->type == XVR_AST_NODE_IMPORT &&
+                    ident->type == XVR_LITERAL_IDENTIFIER &&
+                    ident->as.identifier.ptr) {
+                    module.import_names.push_back(
+                        ident->as.identifier.ptr->data);
+                }
+            }
+        }
+
+        std::vector<size_t> next_wave;
+        for (size_t index : wave) {
+            std::vector<std::string> import_names =
+                graph->modules[index].import_names;
+            for (const std::string& name : import_names) {
+                size_t import = 0;
+                if (find_or_add(graph, name.c_str(), &next_wave, &import)) {
+                    graph->modules[index].imports.push_back(import);
+                }
+            }
+        }
+        wave.swap(next_wave);
+    }
+}
+
+bool Xvr_ModuleGraphRequire(Xvr_ModuleGraph* graph, const char* name,
+                            size_t* out_index) {
+    if (!graph || !name || !out_index) {
+        return false;
+    }
+    Xvr_ModuleGraphAdd(graph, &name, 1);
+    char* path = NULL;
+    if (!Xvr_ModuleResolverResolve(graph->resolver, name, &path)) {
+        return false;
+    }
+    auto found = graph->by_path.find(path);
+    free(path);
+    if (found == graph->by_path.end()) {
+        return false;
+    }
+    *out_index = found->second;
+    return true;
+}
+
+typedef enum { UNVISITED, VISITING, VISITED } Xvr_VisitState;
+
+/* depth first, a module still on the stack when reached again closes a
+ * cycle */
+static bool visit(Xvr_ModuleGraph* graph, size_t index,
+                  std::vector<Xvr_VisitState>& state,
+                  std::vector<size_t>& stack, std::vector<size_t>& order) {
+    if (state[index] == VISITED || graph->modules[index].emitted) {
+        return true;
+    }
+    if (state[index] == VISITING) {
+        std::string cycle = "import cycle: ";
+        auto start = std::find(stack.begin(), stack.end(), index);
+        for (auto it = start; it != stack.end(); ++it) {
+            cycle += graph->modules[*it].name + " -> ";
+        }
+        cycle += graph->modules[index].name;
+        set_error(graph, cycle);
+        return false;
+    }
+    state[index] = VISITING;
+    stack.push_back(index);
+    for (size_t import : graph->modules[index].imports) {
+        if (!visit(graph, import, state, stack, order)) {
+            return false;
+        }
+    }
+    stack.pop_back();
+    state[index] = VISITED;
+    order.push_back(index);
+    return true;
+}
+
+size_t* Xvr_ModuleGraphOrder(Xvr_ModuleGraph* graph, size_t index,
+                             size_t* out_count) {
+    if (!graph || !out_count || index >= graph->modules.size()) {
+        return NULL;
+    }
+    std::vector<Xvr_VisitState> state(graph->modules.size(), UNVISITED);
+    std::vector<size_t> stack;
+    std::vector<size_t> order;
+    if (!visit(graph, index, state, stack, order)) {
+        return NULL;
+    }
+
+    size_t* indices = (size_t*)malloc((order.size() + 1) * sizeof(size_t));
+    if (!indices) {
+        return NULL;
+    }
+    for (size_t i = 0; i < order.size(); i++) {
+        indices[i] = order[i];
+        graph->modules[order[i]].emitted = true;
+    }
+    *out_count = order.size();
+    return indices;
+}
+
+size_t Xvr_ModuleGraphGetCount(Xvr_ModuleGraph* graph) {
+    return graph ? graph->modules.size() : 0;
+}
+
+const char* Xvr_ModuleGraphGetName(Xvr_ModuleGraph* graph, size_t index) {
+    if (!graph || index >= graph->modules.size()) {
+        return NULL;
+    }
+    return graph->modules[index].name.c_str();
+}
+
+const char* Xvr_ModuleGraphGetPath(Xvr_ModuleGraph* graph, size_t index) {
+    if (!graph || index >= graph->modules.size()) {
+        return NULL;
+    }
+    return graph->modules[index].path.c_str();
+}
+
+bool Xvr_ModuleGraphIsPrebuilt(Xvr_ModuleGraph* graph, size_t index) {
+    return graph && index < graph->modules.size() &&
+           graph->modules[index].prebuilt;
+}
+
+Xvr_ASTNode** Xvr_ModuleGraphGetNodes(Xvr_ModuleGraph* graph, size_t index,
+                                      int* out_count) {
+    if (!graph || !out_count || index >= graph->modules.size()) {
+        return NULL;
+    }
+    *out_count = graph->modules[index].node_count;
+    return graph->modules[index].nodes;
+}
+
+void Xvr_ModuleGraphRelease(Xvr_ModuleGraph* graph, size_t index) {
+    if (graph && index < graph->modules.size()) {
+        free_nodes(&graph->modules[index]);
+    }
+}
+
+size_t Xvr_ModuleGraphGetParseCount(Xvr_ModuleGraph* graph) {
+    return graph ? graph->parse_count : 0;
+}
+
+const char* Xvr_ModuleGraphGetError(Xvr_ModuleGraph* graph) {
+    return graph ? graph->error_message : NULL;
+}
@@ -0,0 +1,122 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_MODULE_GRAPH_H
+#define XVR_MODULE_GRAPH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "xvr_ast_node.h"
+#include "xvr_builtin.h"
+
+/**
+ * @brief the modules a program imports, each resolved and parsed once
+ *
+ * adding a module resolves its imports, then the imports of those, a wave
+ * at a time; the modules of a wave do not depend on each other and are
+ * parsed concurrently. Xvr_ModuleGraphOrder hands out what is left to emit
+ * with dependencies first and reports import cycles
+ *
+ * Thread safety: one graph per thread, it only parses on its own threads
+ */
+typedef struct Xvr_ModuleGraph Xvr_ModuleGraph;
+
+/**
+ * @brief supplies the imports of a module that needs no parsing, such as a
+ * precompiled one
+ * @param out_imports receives a malloc'd array of malloc'd module names
+ * @return false to have the module parsed
+ */
+typedef bool (*Xvr_ModuleGraphPrebuiltFn)(void* context, const char* path,
+                                          char*** out_imports,
+                                          size_t* out_count);
+
+Xvr_ModuleGraph* Xvr_ModuleGraphCreate(Xvr_ModuleResolver* resolver);
+void Xvr_ModuleGraphDestroy(Xvr_ModuleGraph* graph);
+
+/**
+ * @brief caps the parsing threads, 0 uses one per hardware thread
+ */
+void Xvr_ModuleGraphSetJobs(Xvr_ModuleGraph* graph, unsigned jobs);
+void Xvr_ModuleGraphSetPrebuilt(Xvr_ModuleGraph* graph,
+                                Xvr_ModuleGraphPrebuiltFn prebuilt,
+                                void* context);
+
+/**
+ * @brief adds modules by import name together with everything they import
+ * names that do not resolve are skipped, as are modules already added
+ */
+void Xvr_ModuleGraphAdd(Xvr_ModuleGraph* graph, const char* const* names,
+                        size_t count);
+
+/**
+ * @brief adds one module, see Xvr_ModuleGraphAdd
+ * @return false if the name does not resolve
+ */
+bool Xvr_ModuleGraphRequire(Xvr_ModuleGraph* graph, const char* name,
+                            size_t* out_index);
+
+/**
+ * @brief the modules `index` needs that are not emitted yet, itself
+ * included, dependencies first; each is marked emitted
+ * @return malloc'd indices (caller frees), or NULL with an error set on an
+ * import cycle. an empty order is a non-NULL array with *out_count of 0
+ */
+size_t* Xvr_ModuleGraphOrder(Xvr_ModuleGraph* graph, size_t index,
+                             size_t* out_count);
+
+size_t Xvr_ModuleGraphGetCount(Xvr_ModuleGraph* graph);
+const char* Xvr_ModuleGraphGetName(Xvr_ModuleGraph* graph, size_t index);
+const char* Xvr_ModuleGraphGetPath(Xvr_ModuleGraph* graph, size_t index);
+bool Xvr_ModuleGraphIsPrebuilt(Xvr_ModuleGraph* graph, size_t index);
+
+/**
+ * @brief the parsed top-level nodes of a module, owned by the graph
+ * @return NULL for a prebuilt module or one that failed to parse
+ */
+Xvr_ASTNode** Xvr_ModuleGraphGetNodes(Xvr_ModuleGraph* graph, size_t index,
+                                      int* out_count);
+
+/**
+ * @brief frees a module's nodes once it has been emitted
+ */
+void Xvr_ModuleGraphRelease(Xvr_ModuleGraph* graph, size_t index);
+
+/**
+ * @brief number of files parsed so far, every module counts at most once
+ */
+size_t Xvr_ModuleGraphGetParseCount(Xvr_ModuleGraph* graph);
+
+const char* Xvr_ModuleGraphGetError(Xvr_ModuleGraph* graph);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_module_manifest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct Xvr_ModuleManifest {
+    std::string name;
+    std::vector<std::string> exports;
+    std::vector<std::string> natives;
+    std::unordered_set<std::string> visible;
+};
+
+static bool is_name_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+/* the identifier that follows a keyword, e.g. "sqrt_f64" in
+ * "native sqrt_f64(float64): float64" */
+static std::string read_name(const std::string& line, size_t start) {
+    while (start < line.size() && (line[start] == ' ' || line[start] == '\t')) {
+        start++;
+    }
+    size_t end = start;
+    while (end < line.size() && is_name_char(line[end])) {
+        end++;
+    }
+    return line.substr(start, end - start);
+}
+
+static bool starts_with_keyword(const std::string& line, const char* keyword) {
+    size_t length = strlen(keyword);
+    return line.compare(0, length, keyword) == 0 && line.size() > length &&
+           (line[length] == ' ' || line[length] == '\t');
+}
+
+Xvr_ModuleManifest* Xvr_ModuleManifestParse(const char* text, size_t length) {
+    if (!text) {
+        return NULL;
+    }
+    Xvr_ModuleManifest* manifest = new (std::nothrow) Xvr_ModuleManifest();
+    if (!manifest) {
+        return NULL;
+    }
+
+    size_t cursor = 0;
+    while (cursor < length) {
+        const char* newline =
+            (const char*)memchr(text + cursor, '\n', length - cursor);
+        size_t end = newline ? (size_t)(newline - text) : length;
+        std::string line(text + cursor, end - cursor);
+        cursor = end + 1;
+
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            continue;
+        }
+        line.erase(0, first);
+
+        /* unknown declarations are left for newer compilers */
+        if (starts_with_keyword(line, "module")) {
+            manifest->name = read_name(line, 6);
+        } else if (starts_with_keyword(line, "export")) {
+            std::string name = read_name(line, 6);
+            if (!name.empty()) {
+                manifest->exports.push_back(name);
+                manifest->visible.insert(name);
+            }
+        } else if (starts_with_keyword(line, "native")) {
+            std::string name = read_name(line, 6);
+            if (!name.empty()) {
+                manifest->natives.push_back(name);
+                manifest->visible.insert(name);
+            }
+        }
+    }
+    return manifest;
+}
+
+Xvr_ModuleManifest* Xvr_ModuleManifestLoad(const char* module_path) {
+    if (!module_path) {
+        return NULL;
+    }
+    std::string path = module_path;
+    size_t dot = path.rfind('.');
+    size_t slash = path.rfind('/');
+    if (dot != std::string::npos &&
+        (slash == std::string::npos || dot > slash)) {
+        path.erase(dot);
+    }
+    path += ".mod";
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return NULL;
+    }
+    std::string text;
+    char buffer[4096];
+    size_t got = 0;
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, got);
+    }
+    bool failed = ferror(file) != 0;
+    fclose(file);
+    if (failed) {
+        return NULL;
+    }
+    return Xvr_ModuleManifestParse(text.data(), text.size());
+}
+
+void Xvr_ModuleManifestDestroy(Xvr_ModuleManifest* manifest) {
+    delete manifest;
+}
+
+const char* Xvr_ModuleManifestGetName(Xvr_ModuleManifest* manifest) {
+    return manifest ? manifest->name.c_str() : NULL;
+}
+
+size_t Xvr_ModuleManifestGetExportCount(Xvr_ModuleManifest* manifest) {
+    return manifest ? manifest->exports.size() : 0;
+}
+
+const char* Xvr_ModuleManifestGetExport(Xvr_ModuleManifest* manifest,
+                                        size_t index) {
+    if (!manifest || index >= manifest->exports.size()) {
+        return NULL;
+    }
+    return manifest->exports[index].c_str();
+}
+
+size_t Xvr_ModuleManifestGetNativeCount(Xvr_ModuleManifest* manifest) {
+    return manifest ? manifest->natives.size() : 0;
+}
+
+const char* Xvr_ModuleManifestGetNative(Xvr_ModuleManifest* manifest,
+                                        size_t index) {
+    if (!manifest || index >= manifest->natives.size()) {
+        return NULL;
+    }
+    return manifest->natives[index].c_str();
+}
+
+bool Xvr_ModuleManifestIsExported(Xvr_ModuleManifest* manifest,
+                                  const char* name) {
+    if (!manifest || !name) {
+        return false;
+    }
+    return manifest->exports.empty() || manifest->visible.count(name) > 0;
+}
@@ -0,0 +1,79 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_MODULE_MANIFEST_H
+#define XVR_MODULE_MANIFEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief the .mod file that describes a module, "math.xvr" -> "math.mod"
+ *
+ * one declaration per line, '#' starts a comment:
+ *   module <name>
+ *   export <name>                 a proc importers may use
+ *   native <name>(<types>)[: <type>]  a symbol implemented outside xvr
+ *   const <name>: <type> = <value>
+ *
+ * without export lines every proc is exported. with them, only the listed
+ * procs and the natives are, the rest is private to the module
+ */
+typedef struct Xvr_ModuleManifest Xvr_ModuleManifest;
+
+/**
+ * @brief loads the manifest that sits next to a module's source
+ * @return NULL if the module has none or it cannot be read
+ */
+Xvr_ModuleManifest* Xvr_ModuleManifestLoad(const char* module_path);
+Xvr_ModuleManifest* Xvr_ModuleManifestParse(const char* text, size_t length);
+void Xvr_ModuleManifestDestroy(Xvr_ModuleManifest* manifest);
+
+/**
+ * @brief the name given by the module line, "" if there is none
+ */
+const char* Xvr_ModuleManifestGetName(Xvr_ModuleManifest* manifest);
+
+size_t Xvr_ModuleManifestGetExportCount(Xvr_ModuleManifest* manifest);
+const char* Xvr_ModuleManifestGetExport(Xvr_ModuleManifest* manifest,
+                                        size_t index);
+size_t Xvr_ModuleManifestGetNativeCount(Xvr_ModuleManifest* manifest);
+const char* Xvr_ModuleManifestGetNative(Xvr_ModuleManifest* manifest,
+                                        size_t index);
+
+/**
+ * @brief whether importers may see `name`, see the export rules above
+ */
+bool Xvr_ModuleManifestIsExported(Xvr_ModuleManifest* manifest,
+                                  const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
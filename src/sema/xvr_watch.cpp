@@ -0,0 +1,483 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_watch.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+#include <string>
+#include <vector>
+
+#include "adapters/llvm/xvr_llvm_codegen.h"
+#include "optimizer/xvr_ast_optimizer.h"
+#include "xvr_ast_node.h"
+#include "xvr_decl_fingerprint.h"
+#include "xvr_source_file.h"
+#include "xvr_unused.h"
+
+typedef struct {
+    std::string name; /* the proc, "" for the program, the path of an import */
+    bool import = false;
+    uint64_t key = 0;
+    void* object = nullptr;
+    size_t object_size = 0;
+    std::vector<std::string> imports;
+    bool used = false; /* part of the latest build */
+} Xvr_WatchFragment;
+
+struct Xvr_Watch {
+    /* holds the options every build's session is created with */
+    Xvr_CompilerSession* options = nullptr;
+    std::string path;
+    std::vector<Xvr_WatchFragment> fragments;
+    size_t compiled = 0;
+
+    /* the build in progress */
+    Xvr_CompilerSession* session = nullptr;
+    std::string error;
+    std::string error_path;
+};
+
+static void set_error(Xvr_Watch* watch, const std::string& path,
+                      const char* message) {
+    if (watch->error.empty()) {
+        watch->error = message;
+        watch->error_path = path;
+    }
+}
+
+static uint64_t content_hash(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static void fragment_clear(Xvr_WatchFragment* fragment) {
+    free(fragment->object);
+    fragment->object = nullptr;
+    fragment->object_size = 0;
+    fragment->imports.clear();
+}
+
+static void free_nodes(Xvr_ASTNode** nodes, int count) {
+    for (int i = 0; i < count; i++) {
+        Xvr_freeASTNode(nodes[i]);
+    }
+    free(nodes);
+}
+
+Xvr_Watch* Xvr_WatchCreate(const Xvr_CompilerOptions* options,
+                           const char* path) {
+    if (!path) {
+        return NULL;
+    }
+    Xvr_Watch* watch = new (std::nothrow) Xvr_Watch();
+    if (!watch) {
+        return NULL;
+    }
+    watch->options = Xvr_CompilerSessionCreate(options);
+    if (!watch->options) {
+        delete watch;
+        return NULL;
+    }
+    watch->path = path;
+    return watch;
+}
+
+void Xvr_WatchDestroy(Xvr_Watch* watch) {
+    if (!watch) {
+        return;
+    }
+    for (Xvr_WatchFragment& fragment : watch->fragments) {
+        fragment_clear(&fragment);
+    }
+    Xvr_CompilerSessionDestroy(watch->options);
+    delete watch;
+}
+
+/* the index of the fragment named `name`, added if it is new. *stale is
+ * set when its object has to be compiled again */
+static size_t watch_fragment(Xvr_Watch* watch, const std::string& name,
+                             bool import, uint64_t key, bool* stale) {
+    size_t index = 0;
+    while (index < watch->fragments.size() &&
+           (watch->fragments[index].import != import ||
+            watch->fragments[index].name != name)) {
+        index++;
+    }
+    if (index == watch->fragments.size()) {
+        Xvr_WatchFragment fragment;
+        fragment.name = name;
+        fragment.import = import;
+        watch->fragments.push_back(std::move(fragment));
+    }
+
+    Xvr_WatchFragment* fragment = &watch->fragments[index];
+    fragment->used = true;
+    *stale = !fragment->object || fragment->key != key;
+    if (*stale) {
+        fragment_clear(fragment);
+        fragment->key = key;
+    }
+    return index;
+}
+
+/* the program fragment compiles its imports separately, every other
+ * fragment is a library linked into it */
+static bool configure_fragment_codegen(Xvr_LLVMCodegen* codegen,
+                                       bool program) {
+    /* fragments are compiled one after another rather than split */
+    Xvr_LLVMCodegenSetCodegenJobs(codegen, 1);
+    if (program) {
+        Xvr_LLVMCodegenSetSeparateImports(codegen, true);
+    } else {
+        Xvr_LLVMCodegenSetLibraryUnit(codegen, true);
+    }
+    return Xvr_LLVMCodegenApplySessionPipeline(codegen);
+}
+
+/* declares `declared`, emits `emitted` and keeps the object and the
+ * imports the fragment needs */
+static bool compile_fragment(Xvr_Watch* watch, Xvr_WatchFragment* fragment,
+                             Xvr_ASTNode** declared, int declared_count,
+                             Xvr_ASTNode** emitted, int emitted_count) {
+    bool program = !fragment->import && fragment->name.empty();
+    char* name = program ? Xvr_sourceFileStem(watch->path.c_str()) : NULL;
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreateWithSession(
+        name                ? name
+        : fragment->import ? "module"
+                           : fragment->name.c_str(),
+        watch->session);
+    free(name);
+    if (!codegen) {
+        set_error(watch, watch->path, "failed to initialize code generator");
+        return false;
+    }
+
+    bool ok = configure_fragment_codegen(codegen, program) &&
+              Xvr_LLVMCodegenDeclareProcs(codegen, declared, declared_count) &&
+              (!program || Xvr_LLVMCodegenEnsureMain(codegen));
+    int level =
+        Xvr_CompilerSessionGetOptions(watch->session)->optimizationLevel;
+    if (ok && !fragment->import && level > 0) {
+        Xvr_ASTOptimizer* ast_opt = Xvr_ASTOptimizerCreate();
+        if (ast_opt) {
+            Xvr_ASTOptimizerSetLevel(ast_opt,
+                                     Xvr_OptimizationLevelFromInt(level));
+            Xvr_ASTOptimizerAddStandardPasses(ast_opt);
+            Xvr_ASTOptimizerRun(ast_opt, emitted, emitted_count);
+            Xvr_ASTOptimizerDestroy(ast_opt);
+        }
+    }
+    if (ok) {
+        Xvr_LLVMCodegenPreloadImports(codegen, emitted, emitted_count);
+    }
+    for (int i = 0; ok && i < emitted_count; i++) {
+        ok = Xvr_LLVMCodegenEmitAST(codegen, emitted[i]);
+    }
+    if (ok) {
+        ok = Xvr_LLVMCodegenOptimize(codegen);
+    }
+    if (ok) {
+        fragment->object =
+            Xvr_LLVMCodegenEmitObject(codegen, &fragment->object_size);
+        ok = fragment->object != NULL;
+    }
+    size_t import_count = ok ? Xvr_LLVMCodegenGetImportCount(codegen) : 0;
+    for (size_t i = 0; i < import_count; i++) {
+        fragment->imports.push_back(Xvr_LLVMCodegenGetImport(codegen, i));
+    }
+
+    if (!ok) {
+        const char* err = Xvr_LLVMCodegenGetError(codegen);
+        set_error(watch, fragment->import ? fragment->name : watch->path,
+                  err ? err : "failed to emit object code");
+        fragment_clear(fragment);
+    }
+    Xvr_LLVMCodegenDestroy(codegen);
+    return ok;
+}
+
+bool Xvr_WatchImportsChanged(Xvr_Watch* watch) {
+    if (!watch) {
+        return false;
+    }
+    for (const Xvr_WatchFragment& fragment : watch->fragments) {
+        if (!fragment.import) {
+            continue;
+        }
+        size_t size = 0;
+        const char* source = Xvr_readSourceFile(fragment.name.c_str(), &size);
+        /* one being rewritten is picked up once it can be read again */
+        bool changed = source && content_hash(source, size) != fragment.key;
+        Xvr_unmapSourceFile(source, size);
+        if (changed) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool compile_import(Xvr_Watch* watch, const std::string& path) {
+    size_t size = 0;
+    /* copied, not mapped: a file truncated by an editor mid-parse would
+     * fault a mapping */
+    const char* source = Xvr_readSourceFile(path.c_str(), &size);
+    if (!source) {
+        set_error(watch, path, "could not read source file");
+        return false;
+    }
+
+    bool stale = false;
+    size_t index =
+        watch_fragment(watch, path, true, content_hash(source, size), &stale);
+    bool ok = true;
+    if (stale) {
+        int node_count = 0;
+        Xvr_ASTNode** nodes =
+            Xvr_CompilerSessionParse(watch->session, source, &node_count);
+        if (!nodes) {
+            set_error(watch, path, "parsing failed - check syntax");
+        }
+        ok = nodes != NULL && compile_fragment(watch, &watch->fragments[index],
+                                               NULL, 0, nodes, node_count);
+        free_nodes(nodes, node_count);
+        watch->compiled++;
+    }
+    Xvr_unmapSourceFile(source, size);
+    return ok;
+}
+
+static const char* proc_name(Xvr_ASTNode* node) {
+    Xvr_Literal* ident = &node->fnDecl.identifier;
+    if (ident->type != XVR_LITERAL_IDENTIFIER || !ident->as.identifier.ptr) {
+        return NULL;
+    }
+    return ident->as.identifier.ptr->data;
+}
+
+/* the program fragment, one per proc and the imports they reach */
+static bool compile_fragments(Xvr_Watch* watch,
+                              const Xvr_DeclFingerprints* fingerprints,
+                              Xvr_ASTNode** nodes, int node_count) {
+    std::vector<Xvr_ASTNode*> procs;
+    std::vector<Xvr_ASTNode*> rest;
+    for (int i = 0; i < node_count; i++) {
+        if (nodes[i]->type == XVR_AST_NODE_FN_DECL) {
+            procs.push_back(nodes[i]);
+        } else {
+            rest.push_back(nodes[i]);
+        }
+    }
+
+    bool stale = false;
+    size_t index = watch_fragment(
+        watch, "", false, Xvr_DeclFingerprintsGetProgram(fingerprints), &stale);
+    bool ok = true;
+    if (stale) {
+        ok = compile_fragment(watch, &watch->fragments[index], procs.data(),
+                              (int)procs.size(), rest.data(),
+                              (int)rest.size());
+        watch->compiled++;
+    }
+
+    for (size_t i = 0; ok && i < procs.size(); i++) {
+        /* a proc without a fingerprint of its own always compiles */
+        const char* name = proc_name(procs[i]);
+        uint64_t key = 0;
+        bool known =
+            name && Xvr_DeclFingerprintsGetProc(fingerprints, name, &key);
+        index = watch_fragment(watch, name ? name : "", false, key, &stale);
+        if (!known) {
+            fragment_clear(&watch->fragments[index]);
+            stale = true;
+        }
+        if (!stale) {
+            continue;
+        }
+
+        /* it sees the others' declarations and the file's imports */
+        std::vector<Xvr_ASTNode*> declared;
+        std::vector<Xvr_ASTNode*> emitted;
+        for (int j = 0; j < node_count; j++) {
+            if (nodes[j] != procs[i]) {
+                declared.push_back(nodes[j]);
+            }
+            if (nodes[j]->type == XVR_AST_NODE_IMPORT) {
+                emitted.push_back(nodes[j]);
+            }
+        }
+        emitted.push_back(procs[i]);
+        ok = compile_fragment(watch, &watch->fragments[index], declared.data(),
+                              (int)declared.size(), emitted.data(),
+                              (int)emitted.size());
+        watch->compiled++;
+    }
+
+    /* imports are added while this walks the fragments */
+    for (size_t i = 0; ok && i < watch->fragments.size(); i++) {
+        for (size_t j = 0; ok && watch->fragments[i].used &&
+                           j < watch->fragments[i].imports.size();
+             j++) {
+            std::string path = watch->fragments[i].imports[j];
+            ok = compile_import(watch, path);
+        }
+    }
+    return ok;
+}
+
+/* the checker reports what it finds itself */
+static bool check_unused_program(const char* source, Xvr_ASTNode** nodes,
+                                 int node_count) {
+    Xvr_UnusedChecker checker;
+    Xvr_initUnusedCheckerWithSource(&checker, source);
+    Xvr_checkUnusedBegin(&checker);
+    for (int i = 0; i < node_count; i++) {
+        Xvr_checkUnusedNode(&checker, nodes[i]);
+    }
+    bool used = Xvr_checkUnusedEnd(&checker);
+    Xvr_freeUnusedChecker(&checker);
+    return used;
+}
+
+static bool build_fragments(Xvr_Watch* watch, const char* source) {
+    int node_count = 0;
+    Xvr_ASTNode** nodes =
+        Xvr_CompilerSessionParse(watch->session, source, &node_count);
+    if (!nodes) {
+        set_error(watch, watch->path, "parsing failed - check syntax");
+        return false;
+    }
+    Xvr_DeclFingerprints* fingerprints = Xvr_DeclFingerprintsCreate(source);
+    bool ok = fingerprints != NULL &&
+              check_unused_program(source, nodes, node_count);
+    if (ok) {
+        /* the file's procs are declared from its imports, so an edited
+         * import compiles everything again */
+        bool imports_changed = Xvr_WatchImportsChanged(watch);
+        for (Xvr_WatchFragment& fragment : watch->fragments) {
+            if (imports_changed && !fragment.import) {
+                fragment_clear(&fragment);
+            }
+            fragment.used = false;
+        }
+        ok = compile_fragments(watch, fingerprints, nodes, node_count);
+    }
+    Xvr_DeclFingerprintsDestroy(fingerprints);
+    free_nodes(nodes, node_count);
+    return ok;
+}
+
+bool Xvr_WatchBuild(Xvr_Watch* watch) {
+    if (!watch) {
+        return false;
+    }
+    watch->compiled = 0;
+    watch->error.clear();
+    watch->error_path.clear();
+
+    size_t size = 0;
+    const char* source = Xvr_readSourceFile(watch->path.c_str(), &size);
+    if (!source) {
+        set_error(watch, watch->path, "could not read source file");
+        return false;
+    }
+    watch->session =
+        Xvr_CompilerSessionCreate(Xvr_CompilerSessionGetOptions(watch->options));
+    bool ok = watch->session != NULL && build_fragments(watch, source);
+    if (!watch->session) {
+        set_error(watch, watch->path, "failed to create a compiler session");
+    }
+    Xvr_CompilerSessionDestroy(watch->session);
+    watch->session = nullptr;
+    Xvr_unmapSourceFile(source, size);
+    if (!ok) {
+        return false;
+    }
+
+    /* the program's main comes first, procs and imports follow */
+    std::vector<Xvr_WatchFragment> used;
+    for (Xvr_WatchFragment& fragment : watch->fragments) {
+        if (fragment.used) {
+            used.push_back(std::move(fragment));
+        } else {
+            fragment_clear(&fragment);
+        }
+    }
+    watch->fragments = std::move(used);
+    return true;
+}
+
+void** Xvr_WatchCopyObjects(Xvr_Watch* watch, size_t** out_sizes,
+                            size_t* out_count) {
+    *out_sizes = NULL;
+    *out_count = 0;
+    size_t count = watch ? watch->fragments.size() : 0;
+    void** objects = (void**)calloc(count + 1, sizeof(void*));
+    size_t* sizes = (size_t*)calloc(count + 1, sizeof(size_t));
+    bool ok = objects && sizes;
+    for (size_t i = 0; ok && i < count; i++) {
+        /* the link consumes its objects, the fragments keep theirs */
+        const Xvr_WatchFragment& fragment = watch->fragments[i];
+        objects[i] = malloc(fragment.object_size);
+        ok = objects[i] != NULL;
+        if (ok) {
+            memcpy(objects[i], fragment.object, fragment.object_size);
+            sizes[i] = fragment.object_size;
+        }
+    }
+    if (!ok) {
+        for (size_t i = 0; objects && i < count; i++) {
+            free(objects[i]);
+        }
+        free(objects);
+        free(sizes);
+        return NULL;
+    }
+    *out_sizes = sizes;
+    *out_count = count;
+    return objects;
+}
+
+size_t Xvr_WatchGetCompiledCount(Xvr_Watch* watch) {
+    return watch ? watch->compiled : 0;
+}
+
+size_t Xvr_WatchGetFragmentCount(Xvr_Watch* watch) {
+    return watch ? watch->fragments.size() : 0;
+}
+
+const char* Xvr_WatchGetError(Xvr_Watch* watch) {
+    return watch && !watch->error.empty() ? watch->error.c_str() : NULL;
+}
+
+const char* Xvr_WatchGetErrorPath(Xvr_Watch* watch) {
+    return watch && !watch->error.empty() ? watch->error_path.c_str() : NULL;
+}
@@ -0,0 +1,96 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_WATCH_H
+#define XVR_WATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "xvr_compiler_session.h"
+
+/**
+ * @brief xvr --watch: a source file rebuilt fragment by fragment
+ *
+ * every top-level proc, the rest of the file and each imported module
+ * compile to an object of their own. after an edit only the fragments whose
+ * fingerprint changed (see Xvr_DeclFingerprints) compile again, the others
+ * keep the objects of the last build; an edited import compiles everything
+ * again, the file's procs are declared from it
+ *
+ * Thread safety: one watch per thread
+ */
+typedef struct Xvr_Watch Xvr_Watch;
+
+/**
+ * @param options copied into the session of each build
+ */
+Xvr_Watch* Xvr_WatchCreate(const Xvr_CompilerOptions* options,
+                           const char* path);
+void Xvr_WatchDestroy(Xvr_Watch* watch);
+
+/**
+ * @brief one build of the watched file
+ * @return false when it failed, with an error set unless the unused checker
+ * rejected the program, which it reports itself. the objects of the last
+ * good build are kept
+ */
+bool Xvr_WatchBuild(Xvr_Watch* watch);
+
+/**
+ * @brief copies of the objects of the last good build, the program's main
+ * first, for the link to consume
+ * @param out_sizes receives a malloc'd array of object sizes
+ * @return malloc'd array of malloc'd objects, NULL when out of memory
+ */
+void** Xvr_WatchCopyObjects(Xvr_Watch* watch, size_t** out_sizes,
+                            size_t* out_count);
+
+/**
+ * @brief fragments the last build compiled, and those it linked
+ */
+size_t Xvr_WatchGetCompiledCount(Xvr_Watch* watch);
+size_t Xvr_WatchGetFragmentCount(Xvr_Watch* watch);
+
+/**
+ * @brief whether an import of the last build changed on disk
+ */
+bool Xvr_WatchImportsChanged(Xvr_Watch* watch);
+
+/**
+ * @brief why the last build failed and the file it failed in, NULL when
+ * there is nothing to report
+ */
+const char* Xvr_WatchGetError(Xvr_Watch* watch);
+const char* Xvr_WatchGetErrorPath(Xvr_Watch* watch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -58,27 +58,62 @@ STATIC_ASSERT(sizeof(unsigned int) == 4);
 
 #ifndef XVR_EXPORT
 
-Xvr_CommandLine Xvr_commandLine = {.error = false,
-                                   .help = false,
-                                   .version = false,
-                                   .sourceFile = NULL,
-                                   .compileFile = NULL,
-                                   .outFile = NULL,
-                                   .source = NULL,
-                                   .initialfile = NULL,
-                                   .enablePrintNewline = true,
-                                   .verbose = false,
-                                   .dumpTokens = false,
-                                   .dumpAST = false,
-                                   .dumpLLVM = false,
-                                   .compileOnly = false,
-                                   .compileAndRun = true,
-                                   .showTiming = false,
-                                   .emitType = NULL,
-                                   .asmSyntax = "att",
-                                   .optimizationLevel = 0};
+static const Xvr_CommandLine commandLineDefaults = {.error = false,
+                                                    .help = false,
+                                                    .version = false,
+                                                    .sourceFile = NULL,
+                                                    .compileFile = NULL,
+                                                    .outFile = NULL,
+                                                    .source = NULL,
+                                                    .initialfile = NULL,
+                                                    .enablePrintNewline = true,
+                                                    .verbose = false,
+                                                    .dumpTokens = false,
+                                                    .dumpAST = false,
+                                                    .dumpLLVM = false,
+                                                    .compileOnly = false,
+                                                    .compileAndRun = true,
+                                                    .showTiming = false,
+                                                    .runJIT = false,
+                                                    .emitType = NULL,
+                                                    .asmSyntax = "att",
+                                                    .targetCPU = NULL,
+                                                    .targetFeatures = NULL,
+                                                    .optimizationLevel = 0,
+                                                    .sizeLevel = 0,
+                                                    .vectorizeLoops = -1,
+                                                    .vectorizeSLP = -1,
+                                                    .unrollLoops = -1,
+                                                    .inlineThreshold = -1,
+                                                    .passPipeline = NULL,
+                                                    .printPipeline = false,
+                                                    .profileGenerate = NULL,
+                                                    .profileUse = NULL,
+                                                    .runtimeBitcode = true,
+                                                    .thinLTO = false,
+                                                    .thinLTOCacheDir = NULL,
+                                                    .jobs = 0,
+                                                    .cacheDir = NULL,
+                                                    .cacheMaxSize = 0,
+                                                    .cacheStats = false,
+                                                    .precompile = false,
+                                                    .linkInputs = NULL,
+                                                    .linkInputCount = 0,
+                                                    .sourceFiles = NULL,
+                                                    .sourceFileCount = 0,
+                                                    .server = false,
+                                                    .serverSocket = NULL,
+                                                    .watch = false,
+                                                    .repl = false};
+
+Xvr_CommandLine Xvr_commandLine = commandLineDefaults;
 
 void Xvr_initCommandLine(int argc, const char* argv[]) {
+    // a compile server parses one command line per request
+    free((void*)Xvr_commandLine.sourceFiles);
+    free((void*)Xvr_commandLine.linkInputs);
+    Xvr_commandLine = commandLineDefaults;
+
     for (int i = 1; i < argc; i++) {  // start at 1 to skip the program name
         Xvr_commandLine.error =
             true;  // error state by default, set to false by successful flags
@@ -186,12 +221,40 @@ void Xvr_initCommandLine(int argc, const char* argv[]) {
             continue;
         }
 
+        if (!strncmp(argv[i], "-march=", 7) && argv[i][7] != '\0') {
+            Xvr_commandLine.targetCPU = (char*)argv[i] + 7;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--target-cpu") && i + 1 < argc) {
+            Xvr_commandLine.targetCPU = (char*)argv[i + 1];
+            i++;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--target-features") && i + 1 < argc) {
+            Xvr_commandLine.targetFeatures = (char*)argv[i + 1];
+            i++;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
         if (!strcmp(argv[i], "-S")) {
             Xvr_commandLine.dumpLLVM = true;
             Xvr_commandLine.error = false;
             continue;
         }
 
+        if (!strcmp(argv[i], "-Os") || !strcmp(argv[i], "-Oz")) {
+            // size levels build on the -O2 pipeline, as in clang
+            Xvr_commandLine.optimizationLevel = 2;
+            Xvr_commandLine.sizeLevel = argv[i][2] == 's' ? 1 : 2;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
         if (xvr_safe_strlen_bounded(argv[i], 256) >= 2 && argv[i][0] == '-' &&
             argv[i][1] == 'O') {
             char* endptr;
@@ -202,6 +265,177 @@ void Xvr_initCommandLine(int argc, const char* argv[]) {
                 return;
             }
             Xvr_commandLine.optimizationLevel = (int)optLevel;
+            Xvr_commandLine.sizeLevel = 0;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-fvectorize") ||
+            !strcmp(argv[i], "-fno-vectorize")) {
+            Xvr_commandLine.vectorizeLoops = argv[i][2] != 'n';
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-fslp-vectorize") ||
+            !strcmp(argv[i], "-fno-slp-vectorize")) {
+            Xvr_commandLine.vectorizeSLP = argv[i][2] != 'n';
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-funroll-loops") ||
+            !strcmp(argv[i], "-fno-unroll-loops")) {
+            Xvr_commandLine.unrollLoops = argv[i][2] != 'n';
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-fno-runtime-bitcode")) {
+            Xvr_commandLine.runtimeBitcode = false;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-flto=thin") || !strcmp(argv[i], "-fno-lto")) {
+            Xvr_commandLine.thinLTO = argv[i][2] != 'n';
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strncmp(argv[i], "--thinlto-cache-dir=", 20) &&
+            argv[i][20] != '\0') {
+            Xvr_commandLine.thinLTOCacheDir = (char*)argv[i] + 20;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strncmp(argv[i], "-j", 2) || !strncmp(argv[i], "--jobs=", 7)) {
+            const char* value = argv[i][1] == 'j' ? argv[i] + 2 : argv[i] + 7;
+            if (*value == '\0' && argv[i][1] == 'j' && i + 1 < argc) {
+                value = argv[++i];
+            }
+            char* endptr;
+            long jobs = strtol(value, &endptr, 10);
+            if (*value == '\0' || *endptr != '\0' || jobs < 1 ||
+                jobs > 1024) {
+                fprintf(stderr, "error: job count must be 1-1024\n");
+                Xvr_commandLine.error = true;
+                return;
+            }
+            Xvr_commandLine.jobs = (int)jobs;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strncmp(argv[i], "--cache-dir=", 12) && argv[i][12] != '\0') {
+            Xvr_commandLine.cacheDir = (char*)argv[i] + 12;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strncmp(argv[i], "--cache-max-size=", 17)) {
+            char* endptr;
+            long long size = strtoll(argv[i] + 17, &endptr, 10);
+            long long unit = 1;
+            const char* suffixes = "KMG";
+            const char* suffix = *endptr ? strchr(suffixes, *endptr) : NULL;
+            if (suffix) {
+                unit = 1LL << (10 * (suffix - suffixes + 1));
+                endptr++;
+            }
+            if (argv[i][17] == '\0' || *endptr != '\0' || size <= 0 ||
+                size > (1LL << 50) / unit) {
+                fprintf(stderr,
+                        "error: cache size must be a positive number with "
+                        "an optional K, M or G suffix\n");
+                Xvr_commandLine.error = true;
+                return;
+            }
+            Xvr_commandLine.cacheMaxSize = size * unit;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--cache-stats")) {
+            Xvr_commandLine.cacheStats = true;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--precompile")) {
+            Xvr_commandLine.precompile = true;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--watch")) {
+            Xvr_commandLine.watch = true;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--repl")) {
+            Xvr_commandLine.repl = true;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--server")) {
+            Xvr_commandLine.server = true;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--socket") && i + 1 < argc) {
+            Xvr_commandLine.serverSocket = (char*)argv[i + 1];
+            i++;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strncmp(argv[i], "--inline-threshold=", 19)) {
+            char* endptr;
+            long threshold = strtol(argv[i] + 19, &endptr, 10);
+            if (argv[i][19] == '\0' || *endptr != '\0' || threshold < 0 ||
+                threshold > 100000) {
+                fprintf(stderr,
+                        "error: inline threshold must be 0-100000\n");
+                Xvr_commandLine.error = true;
+                return;
+            }
+            Xvr_commandLine.inlineThreshold = (int)threshold;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strncmp(argv[i], "--passes=", 9) && argv[i][9] != '\0') {
+            Xvr_commandLine.passPipeline = (char*)argv[i] + 9;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--profile-generate")) {
+            Xvr_commandLine.profileGenerate = (char*)"";
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strncmp(argv[i], "--profile-generate=", 19) &&
+            argv[i][19] != '\0') {
+            Xvr_commandLine.profileGenerate = (char*)argv[i] + 19;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strncmp(argv[i], "--profile-use=", 14) && argv[i][14] != '\0') {
+            Xvr_commandLine.profileUse = (char*)argv[i] + 14;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
+        if (!strcmp(argv[i], "--print-pipeline")) {
+            Xvr_commandLine.printPipeline = true;
             Xvr_commandLine.error = false;
             continue;
         }
@@ -224,6 +458,12 @@ void Xvr_initCommandLine(int argc, const char* argv[]) {
             continue;
         }
 
+        if (!strcmp(argv[i], "--jit")) {
+            Xvr_commandLine.runJIT = true;
+            Xvr_commandLine.error = false;
+            continue;
+        }
+
         if (i < argc) {
             size_t len = xvr_safe_strlen_bounded(argv[i], 256);
             if (len >= 4) {
@@ -235,11 +475,36 @@ void Xvr_initCommandLine(int argc, const char* argv[]) {
                     }
                 }
                 if (is_xvr) {
-                    Xvr_commandLine.sourceFile = (char*)argv[i];
+                    if (!Xvr_commandLine.sourceFiles) {
+                        Xvr_commandLine.sourceFiles =
+                            (const char**)calloc((size_t)argc, sizeof(char*));
+                        if (!Xvr_commandLine.sourceFiles) {
+                            return;
+                        }
+                    }
+                    if (!Xvr_commandLine.sourceFile) {
+                        Xvr_commandLine.sourceFile = (char*)argv[i];
+                    }
+                    Xvr_commandLine.sourceFiles
+                        [Xvr_commandLine.sourceFileCount++] = argv[i];
                     Xvr_commandLine.error = false;
                     continue;
                 }
             }
+            const char* ext = len >= 3 ? argv[i] + len - 3 : "";
+            if (len > 2 && (!strcmp(ext + 1, ".o") || !strcmp(ext, ".bc"))) {
+                if (!Xvr_commandLine.linkInputs) {
+                    Xvr_commandLine.linkInputs =
+                        (const char**)calloc((size_t)argc, sizeof(char*));
+                    if (!Xvr_commandLine.linkInputs) {
+                        return;
+                    }
+                }
+                Xvr_commandLine.linkInputs[Xvr_commandLine.linkInputCount++] =
+                    argv[i];
+                Xvr_commandLine.error = false;
+                continue;
+            }
         }
 
         // don't keep reading in an error state
@@ -279,6 +544,18 @@ void Xvr_helpCommandLine(int argc, const char* argv[]) {
         "source.ll)\n");
     printf(
         "  xvr [flags] <source.xvr> -l             Output LLVM IR to stdout\n");
+    printf(
+        "  xvr [flags] <a.xvr> <b.xvr> -o <output>   Compile each file on "
+        "its own thread\n"
+        "                                       and link them, the first "
+        "one runs\n"
+        "                                       (-c without -o writes a.o, "
+        "b.o)\n");
+    printf(
+        "  xvr [flags] <a.o> <b.o> -o <output>   Link objects, ThinLTO "
+        "bitcode is\n"
+        "                                       optimized across modules "
+        "first\n");
     printf("  xvr -i '<code>'                Compile and run inline code\n\n");
 
     printf("OPTIONS:\n");
@@ -297,14 +574,94 @@ void Xvr_helpCommandLine(int argc, const char* argv[]) {
         "  -e, --emit <type>        Emit specific output (llvm-ir, asm, "
         "obj)\n");
     printf("  --asm-syntax <intel|att> Set assembly syntax (default: att)\n");
+    printf(
+        "  -march=<cpu>             Target CPU, 'native' for the host CPU "
+        "and its features\n");
+    printf("  --target-cpu <cpu>       Same as -march=<cpu>\n");
+    printf(
+        "  --target-features <list> Extra target features, e.g. "
+        "+avx2,+fma\n");
     printf("  -t, --initial <file>     Set entry source file\n");
     printf(
         "  -n                        Disable trailing newline in print "
         "statements\n");
-    printf("  -O<0|1|2|3>              Optimization level (default: -O0)\n");
+    printf("  -O<0|1|2|3|s|z>          Optimization level (default: -O0)\n");
+    printf(
+        "  -f[no-]vectorize         Force loop vectorization on or off\n");
+    printf(
+        "  -f[no-]slp-vectorize     Force SLP (straight-line) vectorization "
+        "on or off\n");
+    printf("  -f[no-]unroll-loops      Force loop unrolling on or off\n");
+    printf(
+        "  -fno-runtime-bitcode     Keep runtime helpers as external calls "
+        "instead of\n"
+        "                           linking xvr_runtime.bc for inlining\n");
+    printf(
+        "  -flto=thin               Compile each imported module separately "
+        "and link\n"
+        "                           them with ThinLTO (cross-module "
+        "inlining)\n");
+    printf(
+        "  --thinlto-cache-dir=<dir> Reuse per-module ThinLTO objects "
+        "between builds\n");
+    printf(
+        "  -j, --jobs=<n>           Split code generation across n threads "
+        "(-j 4, -j4),\n"
+        "                           or compile n source files at once\n");
+    printf(
+        "  --cache-dir=<dir>        Reuse objects of unchanged compiles "
+        "(default: $XVR_CACHE_DIR)\n");
+    printf(
+        "  --cache-max-size=<n>[K|M|G]\n"
+        "                           Evict least recently used entries "
+        "beyond this size (1G)\n");
+    printf(
+        "  --cache-stats            Print hit/miss statistics of the cache "
+        "and exit\n");
+    printf(
+        "  --precompile             Write a module's procs as a precompiled "
+        ".xvrm that\n"
+        "                           imports load instead of parsing it "
+        "(default: source.xvrm)\n");
+    printf(
+        "  --watch                  Rebuild and run whenever the file "
+        "changes, compiling\n"
+        "                           only the procs an edit touched (-c "
+        "only links)\n");
+    printf(
+        "  --repl                   Read statements and procs from stdin "
+        "and run each\n"
+        "                           as it is entered, in one JIT session\n");
+    printf(
+        "  --server [--socket <path>]\n"
+        "                           Keep LLVM and the stdlib warm and "
+        "compile the command\n"
+        "                           lines xvr-client forwards "
+        "(default: $XVR_SERVER_SOCKET)\n");
+    printf(
+        "  --inline-threshold=<n>   Inliner cost threshold (default 225, "
+        "250 at -O3)\n");
+    printf(
+        "  --passes=<pipeline>      Append LLVM passes after the -O "
+        "pipeline,\n"
+        "                           e.g. 'function(instcombine),gvn'\n");
+    printf(
+        "  --print-pipeline         Print the expanded LLVM pass pipeline "
+        "to stderr\n");
+    printf(
+        "  --profile-generate[=<path>]\n"
+        "                           Instrument for PGO, the program writes "
+        "a raw\n"
+        "                           profile (default: default_%%m.profraw)\n");
+    printf(
+        "  --profile-use=<file>     Optimize with a profile merged by "
+        "llvm-profdata\n");
     printf("  -Z, --dump-tokens        Dump all lexer tokens to stderr\n");
     printf("  --dump-ast               Dump parsed AST to stderr\n");
-    printf("  --timing                 Show compilation timing breakdown\n\n");
+    printf("  --timing                 Show compilation timing breakdown\n");
+    printf(
+        "  --jit                    Run in-process with the JIT instead of "
+        "linking an executable\n\n");
 
     printf("OUTPUT TYPES:\n");
     printf("  -e asm                   Emit assembly (.s file)\n");
@@ -321,7 +678,12 @@ void Xvr_helpCommandLine(int argc, const char* argv[]) {
     printf("  -O0                      No optimization (fastest compile)\n");
     printf("  -O1                      Basic optimizations\n");
     printf("  -O2                      Balanced optimizations (default)\n");
-    printf("  -O3                      Aggressive optimizations\n\n");
+    printf("  -O3                      Aggressive optimizations\n");
+    printf("  -Os                      Optimize for size\n");
+    printf("  -Oz                      Optimize aggressively for size\n");
+    printf(
+        "  Loop and SLP vectorization are on at -O2/-O3 and off at "
+        "-O1/-Os/-Oz\n\n");
 
     printf("ARGUMENTS:\n");
     printf(
@@ -362,6 +724,9 @@ void Xvr_helpCommandLine(int argc, const char* argv[]) {
     printf("    $ xvr --dump-ast hello.xvr\n\n");
     printf("  Show compilation timing:\n");
     printf("    $ xvr --timing hello.xvr\n\n");
+    printf("  Run without writing an executable (JIT):\n");
+    printf("    $ xvr --jit hello.xvr\n");
+    printf("    $ xvr --jit --timing hello.xvr\n\n");
 
     printf("EMIT TYPES:\n");
     printf("  llvm-ir    Emit LLVM IR (human-readable .ll file)\n");
@@ -155,9 +155,37 @@ typedef struct {
     bool compileOnly;
     bool compileAndRun;
     bool showTiming;
+    bool runJIT;
     char* emitType;
     char* asmSyntax;
+    char* targetCPU;
+    char* targetFeatures;
     int optimizationLevel;
+    int sizeLevel;       // 1 for -Os, 2 for -Oz
+    int vectorizeLoops;  // -1 follows the optimization level
+    int vectorizeSLP;    // -1 follows the optimization level
+    int unrollLoops;     // -1 follows the optimization level
+    int inlineThreshold; // -1 follows the optimization level
+    char* passPipeline;
+    bool printPipeline;
+    char* profileGenerate;  // "" for the default raw profile path
+    char* profileUse;
+    bool runtimeBitcode;
+    bool thinLTO;
+    char* thinLTOCacheDir;
+    int jobs;                 // -j, 0 emits the object in one piece
+    char* cacheDir;           // NULL falls back to $XVR_CACHE_DIR
+    long long cacheMaxSize;   // bytes, 0 for the cache's default
+    bool cacheStats;
+    bool precompile;          // write a .xvrm module instead of compiling
+    const char** linkInputs;  // .o/.bc files linked instead of a source file
+    int linkInputCount;
+    const char** sourceFiles;  // every .xvr input, sourceFile is the first
+    int sourceFileCount;
+    bool server;          // serve compiles for xvr-client over a socket
+    char* serverSocket;   // NULL falls back to $XVR_SERVER_SOCKET
+    bool watch;           // rebuild the edited procs whenever the file changes
+    bool repl;            // read and run entries from stdin through one JIT
 } Xvr_CommandLine;
 
 /**
@@ -0,0 +1,392 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_compiler_session.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "adapters/llvm/xvr_llvm_codegen.h"
+#include "optimizer/xvr_ast_optimizer.h"
+#include "xvr_ast_node.h"
+#include "xvr_lexer.h"
+#include "xvr_parser.h"
+#include "xvr_source_file.h"
+
+struct Xvr_CompilerSession {
+    Xvr_CompilerOptions options;
+    /* owned copies of the option strings */
+    std::string asm_syntax;
+    std::string target_cpu;
+    std::string target_features;
+    std::string stdlib_path;
+    std::string pass_pipeline;
+    std::string profile_generate;
+    std::string profile_use;
+
+    Xvr_TypeTable* type_table = nullptr;
+
+    /* imports are parsed on several threads */
+    std::mutex lock;
+    std::vector<std::string> diagnostics;
+    std::vector<Xvr_TokenBuffer*> token_buffers;  // idle, see AcquireTokens
+};
+
+static const Xvr_CompilerOptions default_options = {
+    false, false, false, 0,  0,     NULL, NULL, NULL, NULL,
+    NULL,  -1,    -1,    -1, -1,    true, false, 0,   NULL,
+    NULL,  NULL,
+};
+
+void Xvr_CompilerOptionsInit(Xvr_CompilerOptions* options) {
+    if (options) {
+        *options = default_options;
+    }
+}
+
+static const char* copy_option(std::string& storage, const char* value) {
+    if (!value) {
+        return NULL;
+    }
+    storage = value;
+    return storage.c_str();
+}
+
+Xvr_CompilerSession* Xvr_CompilerSessionCreate(
+    const Xvr_CompilerOptions* options) {
+    Xvr_CompilerSession* session = new (std::nothrow) Xvr_CompilerSession();
+    if (!session) {
+        return NULL;
+    }
+
+    session->options = options ? *options : default_options;
+    session->options.asmSyntax =
+        copy_option(session->asm_syntax, session->options.asmSyntax);
+    session->options.targetCPU =
+        copy_option(session->target_cpu, session->options.targetCPU);
+    session->options.targetFeatures =
+        copy_option(session->target_features, session->options.targetFeatures);
+    session->options.stdlibPath =
+        copy_option(session->stdlib_path, session->options.stdlibPath);
+    session->options.passPipeline =
+        copy_option(session->pass_pipeline, session->options.passPipeline);
+    session->options.profileGenerate = copy_option(
+        session->profile_generate, session->options.profileGenerate);
+    session->options.profileUse =
+        copy_option(session->profile_use, session->options.profileUse);
+
+    session->type_table = Xvr_TypeTableCreate();
+    if (!session->type_table) {
+        delete session;
+        return NULL;
+    }
+    return session;
+}
+
+void Xvr_CompilerSessionDestroy(Xvr_CompilerSession* session) {
+    if (!session) {
+        return;
+    }
+    Xvr_TypeTableDestroy(session->type_table);
+    for (Xvr_TokenBuffer* tokens : session->token_buffers) {
+        Xvr_TokenBufferDestroy(tokens);
+    }
+    delete session;
+}
+
+const Xvr_CompilerOptions* Xvr_CompilerSessionGetOptions(
+    const Xvr_CompilerSession* session) {
+    return session ? &session->options : &default_options;
+}
+
+Xvr_TypeTable* Xvr_CompilerSessionGetTypeTable(Xvr_CompilerSession* session) {
+    return session ? session->type_table : NULL;
+}
+
+void Xvr_CompilerSessionReport(Xvr_CompilerSession* session, int line,
+                               const char* message) {
+    Xvr_CompilerSessionReportAt(session, line, 0, message);
+}
+
+void Xvr_CompilerSessionReportAt(Xvr_CompilerSession* session, int line,
+                                 int column, const char* message) {
+    if (!session || !message) {
+        return;
+    }
+
+    std::string diagnostic;
+    if (line > 0) {
+        diagnostic = "line " + std::to_string(line);
+        if (column > 0) {
+            diagnostic += ", column " + std::to_string(column);
+        }
+        diagnostic += ": ";
+    }
+    diagnostic += message;
+
+    std::lock_guard<std::mutex> guard(session->lock);
+    session->diagnostics.push_back(std::move(diagnostic));
+}
+
+bool Xvr_CompilerSessionPrintsDiagnostics(
+    const Xvr_CompilerSession* session) {
+    return !session || session->options.printDiagnostics;
+}
+
+size_t Xvr_CompilerSessionGetDiagnosticCount(Xvr_CompilerSession* session) {
+    if (!session) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(session->lock);
+    return session->diagnostics.size();
+}
+
+const char* Xvr_CompilerSessionGetDiagnostic(Xvr_CompilerSession* session,
+                                             size_t index) {
+    if (!session) {
+        return NULL;
+    }
+    std::lock_guard<std::mutex> guard(session->lock);
+    if (index >= session->diagnostics.size()) {
+        return NULL;
+    }
+    return session->diagnostics[index].c_str();
+}
+
+void Xvr_CompilerSessionClearDiagnostics(Xvr_CompilerSession* session) {
+    if (!session) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(session->lock);
+    session->diagnostics.clear();
+}
+
+Xvr_TokenBuffer* Xvr_CompilerSessionAcquireTokens(
+    Xvr_CompilerSession* session) {
+    if (session) {
+        std::lock_guard<std::mutex> guard(session->lock);
+        if (!session->token_buffers.empty()) {
+            Xvr_TokenBuffer* tokens = session->token_buffers.back();
+            session->token_buffers.pop_back();
+            return tokens;
+        }
+    }
+    return Xvr_TokenBufferCreate();
+}
+
+void Xvr_CompilerSessionReleaseTokens(Xvr_CompilerSession* session,
+                                      Xvr_TokenBuffer* tokens) {
+    if (!tokens) {
+        return;
+    }
+    if (session) {
+        std::lock_guard<std::mutex> guard(session->lock);
+        // a few cover the import threads, more would never be reused
+        if (session->token_buffers.size() < 8) {
+            session->token_buffers.push_back(tokens);
+            return;
+        }
+    }
+    Xvr_TokenBufferDestroy(tokens);
+}
+
+static void free_nodes(Xvr_ASTNode** nodes, int count) {
+    for (int i = 0; i < count; i++) {
+        Xvr_freeASTNode(nodes[i]);
+    }
+    free(nodes);
+}
+
+Xvr_ASTNode** Xvr_CompilerSessionParse(Xvr_CompilerSession* session,
+                                       const char* source, int* out_count) {
+    *out_count = 0;
+    Xvr_Lexer lexer;
+    Xvr_Parser parser;
+
+    Xvr_initLexerWithSession(&lexer, source, session);
+    Xvr_initParser(&parser, &lexer);
+
+    Xvr_ASTNode** nodes = NULL;
+    int count = 0;
+    int capacity = 0;
+
+    Xvr_ASTNode* node = Xvr_scanParser(&parser);
+    while (node != NULL) {
+        if (node->type == XVR_AST_NODE_ERROR) {
+            Xvr_freeASTNode(node);
+            free_nodes(nodes, count);
+            Xvr_freeParser(&parser);
+            return NULL;
+        }
+
+        if (count == capacity) {
+            capacity = capacity < 8 ? 8 : capacity * 2;
+            Xvr_ASTNode** grown = (Xvr_ASTNode**)realloc(
+                nodes, sizeof(Xvr_ASTNode*) * capacity);
+            if (!grown) {
+                Xvr_freeASTNode(node);
+                free_nodes(nodes, count);
+                Xvr_freeParser(&parser);
+                return NULL;
+            }
+            nodes = grown;
+        }
+        nodes[count++] = node;
+        node = Xvr_scanParser(&parser);
+    }
+
+    Xvr_freeParser(&parser);
+    *out_count = count;
+    /* an empty program still needs a main */
+    return nodes ? nodes : (Xvr_ASTNode**)calloc(1, sizeof(Xvr_ASTNode*));
+}
+
+static void* compile_nodes(Xvr_CompilerSession* session, Xvr_ASTNode** nodes,
+                           int count, const char* module_name,
+                           size_t* out_size) {
+    int level = session->options.optimizationLevel;
+    if (level > 0) {
+        Xvr_ASTOptimizer* ast_opt = Xvr_ASTOptimizerCreate();
+        if (ast_opt) {
+            Xvr_ASTOptimizerSetLevel(ast_opt,
+                                     Xvr_OptimizationLevelFromInt(level));
+            Xvr_ASTOptimizerAddStandardPasses(ast_opt);
+            Xvr_ASTOptimizerRun(ast_opt, nodes, count);
+            Xvr_ASTOptimizerDestroy(ast_opt);
+        }
+    }
+
+    Xvr_LLVMCodegen* codegen =
+        Xvr_LLVMCodegenCreateWithSession(module_name, session);
+    if (!codegen) {
+        Xvr_CompilerSessionReport(session, 0,
+                                  "failed to initialize code generator");
+        return NULL;
+    }
+
+    bool ok = Xvr_LLVMCodegenApplySessionPipeline(codegen);
+    if (ok) {
+        Xvr_LLVMCodegenPreloadImports(codegen, nodes, count);
+    }
+    for (int i = 0; ok && i < count; i++) {
+        ok = Xvr_LLVMCodegenEmitAST(codegen, nodes[i]);
+    }
+    if (ok) {
+        ok = Xvr_LLVMCodegenOptimize(codegen);
+    }
+    void* object = NULL;
+    if (ok) {
+        object = Xvr_LLVMCodegenEmitObject(codegen, out_size);
+    }
+    if (!object) {
+        const char* err = Xvr_LLVMCodegenGetError(codegen);
+        Xvr_CompilerSessionReport(session, 0,
+                                  err ? err : "failed to emit object code");
+    }
+    Xvr_LLVMCodegenDestroy(codegen);
+    return object;
+}
+
+void* Xvr_CompilerSessionCompile(Xvr_CompilerSession* session,
+                                 const char* source, size_t length,
+                                 const char* module_name, size_t* out_size) {
+    if (!session || !source || !out_size) {
+        return NULL;
+    }
+    *out_size = 0;
+
+    /* the lexer stops at a NUL, which `source` need not have */
+    std::string text(source, length);
+
+    Xvr_MemoryAllocatorFn previous =
+        Xvr_private_setThreadMemoryAllocator(session->options.allocator);
+
+    void* object = NULL;
+    int count = 0;
+    Xvr_ASTNode** nodes =
+        Xvr_CompilerSessionParse(session, text.c_str(), &count);
+    if (!nodes) {
+        Xvr_CompilerSessionReport(session, 0, "parsing failed");
+    } else {
+        object = compile_nodes(session, nodes, count,
+                               module_name ? module_name : "module", out_size);
+        free_nodes(nodes, count);
+    }
+
+    Xvr_private_setThreadMemoryAllocator(previous);
+    return object;
+}
+
+bool Xvr_CompilerSessionPrecompile(Xvr_CompilerSession* session,
+                                   const char* source_path,
+                                   const char* output_path) {
+    if (!session || !source_path || !output_path) {
+        return false;
+    }
+    size_t size = 0;
+    const char* source = Xvr_mapSourceFile(source_path, &size);
+    if (!source) {
+        Xvr_CompilerSessionReport(session, 0, "could not read source file");
+        return false;
+    }
+
+    Xvr_MemoryAllocatorFn previous =
+        Xvr_private_setThreadMemoryAllocator(session->options.allocator);
+
+    int count = 0;
+    Xvr_ASTNode** nodes = Xvr_CompilerSessionParse(session, source, &count);
+    char* name = Xvr_sourceFileStem(source_path);
+    Xvr_LLVMCodegen* codegen =
+        nodes ? Xvr_LLVMCodegenCreateWithSession(name ? name : "module",
+                                                 session)
+              : NULL;
+    free(name);
+    bool ok = codegen && Xvr_LLVMCodegenSetLibraryUnit(codegen, true);
+    for (int i = 0; ok && i < count; i++) {
+        ok = Xvr_LLVMCodegenEmitAST(codegen, nodes[i]);
+    }
+    if (ok) {
+        ok = Xvr_LLVMCodegenWritePrecompiled(codegen, source, size,
+                                             output_path);
+    }
+    if (!nodes) {
+        Xvr_CompilerSessionReport(session, 0, "parsing failed");
+    } else if (!ok) {
+        const char* err = codegen ? Xvr_LLVMCodegenGetError(codegen) : NULL;
+        Xvr_CompilerSessionReport(
+            session, 0, err ? err : "failed to initialize code generator");
+    }
+
+    Xvr_LLVMCodegenDestroy(codegen);
+    free_nodes(nodes, count);
+    Xvr_private_setThreadMemoryAllocator(previous);
+    Xvr_unmapSourceFile(source, size);
+    return ok;
+}
@@ -0,0 +1,187 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XVR_COMPILER_SESSION_H
+#define XVR_COMPILER_SESSION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "core/types/xvr_type.h"
+#include "xvr_ast_node.h"
+#include "xvr_common.h"
+#include "xvr_memory.h"
+#include "xvr_token_buffer.h"
+
+/**
+ * @struct Xvr_CompilerOptions
+ * @brief settings a compilation reads instead of Xvr_commandLine
+ *
+ * strings are copied by Xvr_CompilerSessionCreate, NULL keeps the target
+ * default
+ */
+typedef struct Xvr_CompilerOptions {
+    bool dumpTokens;        // print every token the lexer produces
+    bool verbose;           // report parser recovery
+    bool printDiagnostics;  // also print diagnostics to stderr as they arrive
+    int optimizationLevel;  // 0 to 3, as -O
+    int sizeLevel;          // 1 for -Os, 2 for -Oz
+    const char* asmSyntax;
+    const char* targetCPU;
+    const char* targetFeatures;
+    const char* stdlibPath;           // where imports resolve, "./lib/std"
+    Xvr_MemoryAllocatorFn allocator;  // NULL for the process allocator
+    int vectorizeLoops;               // -1 follows the optimization level
+    int vectorizeSLP;                 // -1 follows the optimization level
+    int unrollLoops;                  // -1 follows the optimization level
+    int inlineThreshold;              // -1 follows the optimization level
+    bool runtimeBitcode;  // link the runtime's bitcode in at -O1 and up
+    bool thinLTO;         // compile for a ThinLTO link, as -flto=thin
+    int jobs;             // object emission threads, 0 emits one piece
+    const char* passPipeline;     // appended to the level's passes
+    const char* profileGenerate;  // "" for the default raw profile path
+    const char* profileUse;       // indexed profile to optimize with
+} Xvr_CompilerOptions;
+
+/**
+ * @brief everything one compilation owns: its options, type table and
+ * diagnostics
+ *
+ * sessions share nothing, so separate threads can each compile with their
+ * own; a single session is used by one compilation at a time
+ */
+typedef struct Xvr_CompilerSession Xvr_CompilerSession;
+
+/**
+ * @brief fills `options` with the defaults, -O0 and no output on stderr,
+ * the level's own passes and the runtime bitcode linked in
+ */
+XVR_API void Xvr_CompilerOptionsInit(Xvr_CompilerOptions* options);
+
+/**
+ * @brief creates a session, NULL options takes the defaults
+ */
+XVR_API Xvr_CompilerSession* Xvr_CompilerSessionCreate(
+    const Xvr_CompilerOptions* options);
+
+XVR_API void Xvr_CompilerSessionDestroy(Xvr_CompilerSession* session);
+
+/**
+ * @brief the session's options, the defaults for a NULL session
+ */
+XVR_API const Xvr_CompilerOptions* Xvr_CompilerSessionGetOptions(
+    const Xvr_CompilerSession* session);
+
+XVR_API Xvr_TypeTable* Xvr_CompilerSessionGetTypeTable(
+    Xvr_CompilerSession* session);
+
+/**
+ * @brief records a diagnostic; line 0 when it has no position
+ *
+ * safe to call from the threads parsing imports for the session
+ */
+XVR_API void Xvr_CompilerSessionReport(Xvr_CompilerSession* session,
+                                       int line, const char* message);
+
+/**
+ * @brief records a diagnostic at a line and column, formatted as
+ * "line N, column M: message"; column 0 leaves the column out
+ */
+XVR_API void Xvr_CompilerSessionReportAt(Xvr_CompilerSession* session,
+                                         int line, int column,
+                                         const char* message);
+
+/**
+ * @brief whether the caller prints a diagnostic it reports, true for a NULL
+ * session so session-less callers keep writing to stderr
+ */
+XVR_API bool Xvr_CompilerSessionPrintsDiagnostics(
+    const Xvr_CompilerSession* session);
+
+XVR_API size_t Xvr_CompilerSessionGetDiagnosticCount(
+    Xvr_CompilerSession* session);
+
+/**
+ * @brief the diagnostic at `index`, formatted as "line N: message"
+ */
+XVR_API const char* Xvr_CompilerSessionGetDiagnostic(
+    Xvr_CompilerSession* session, size_t index);
+
+XVR_API void Xvr_CompilerSessionClearDiagnostics(Xvr_CompilerSession* session);
+
+/**
+ * @brief a token buffer to lex a source into, kept by the session and
+ * reused by its later compilations; give it back with
+ * Xvr_CompilerSessionReleaseTokens
+ *
+ * safe to call from the threads parsing imports for the session, a NULL
+ * session hands out a fresh buffer
+ */
+XVR_API Xvr_TokenBuffer* Xvr_CompilerSessionAcquireTokens(
+    Xvr_CompilerSession* session);
+
+XVR_API void Xvr_CompilerSessionReleaseTokens(Xvr_CompilerSession* session,
+                                              Xvr_TokenBuffer* tokens);
+
+/**
+ * @brief parses a NUL-terminated source, reporting syntax errors to the
+ * session
+ *
+ * @return malloc'd array of `*out_count` nodes, NULL if the source does
+ * not parse; free each with Xvr_freeASTNode and then the array
+ */
+XVR_API Xvr_ASTNode** Xvr_CompilerSessionParse(Xvr_CompilerSession* session,
+                                               const char* source,
+                                               int* out_count);
+
+/**
+ * @brief compiles `length` bytes of source to a relocatable object
+ *
+ * the object is malloc'd and owned by the caller; on failure returns NULL
+ * and the reasons are in the session's diagnostics
+ */
+XVR_API void* Xvr_CompilerSessionCompile(Xvr_CompilerSession* session,
+                                         const char* source, size_t length,
+                                         const char* module_name,
+                                         size_t* out_size);
+
+/**
+ * @brief compiles the module at `source_path` as a library unit and writes
+ * it to `output_path` as a precompiled module (.xvrm)
+ *
+ * @return false with the reasons in the session's diagnostics
+ */
+XVR_API bool Xvr_CompilerSessionPrecompile(Xvr_CompilerSession* session,
+                                           const char* source_path,
+                                           const char* output_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !XVR_COMPILER_SESSION_H
@@ -2,6 +2,8 @@
 
 #include <string.h>
 
+#include <stdint.h>
+
 #include "xvr_common.h"
 #include "xvr_string_utils.h"
 #include "xvr_token_types.h"
@@ -10,7 +12,7 @@
 extern "C" {
 #endif
 
-Xvr_KeywordType Xvr_keywordTypes[] = {
+constexpr Xvr_KeywordType Xvr_keywordTypes[] = {
     // type keywords
     {XVR_TOKEN_NULL, "null"},
     {XVR_TOKEN_VOID, "void"},
@@ -70,7 +72,93 @@ Xvr_KeywordType Xvr_keywordTypes[] = {
     {XVR_TOKEN_EOF, NULL},
 };
 
-char* Xvr_findKeywordByType(Xvr_TokenType type) {
+#ifdef __cplusplus
+}
+#endif
+
+namespace {
+
+/* the keyword table hashed at compile time: a keyword is keyed on its length
+ * and its first, second and last bytes, which are unique across the table,
+ * and a multiply-shift over that key is searched for a seed that gives every
+ * keyword its own slot; the lookup then costs one hash and one memcmp */
+
+constexpr int keywordSlotBits = 7;
+constexpr int keywordSlots = 1 << keywordSlotBits;
+constexpr uint8_t emptySlot = 0xff;
+
+constexpr int keywordLength(const char* keyword) {
+    int length = 0;
+    while (keyword[length] != '\0') length++;
+    return length;
+}
+
+constexpr uint32_t keywordKey(const char* text, int length) {
+    return ((uint32_t)length << 24) | ((uint32_t)(uint8_t)text[0] << 16) |
+           ((uint32_t)(uint8_t)text[length > 1 ? 1 : 0] << 8) |
+           (uint32_t)(uint8_t)text[length - 1];
+}
+
+constexpr uint32_t keywordSlot(uint32_t key, uint32_t seed) {
+    return (key * seed) >> (32 - keywordSlotBits);
+}
+
+struct KeywordHash {
+    uint32_t seed;
+    int min_length;
+    int max_length;
+    uint8_t slots[keywordSlots];    // table index, or emptySlot
+    uint8_t lengths[keywordSlots];  // length of the keyword in the slot
+};
+
+constexpr bool fillKeywordSlots(KeywordHash& hash) {
+    for (int i = 0; i < keywordSlots; i++) {
+        hash.slots[i] = emptySlot;
+        hash.lengths[i] = 0;
+    }
+
+    for (int i = 0; Xvr_keywordTypes[i].keyword; i++) {
+        const char* keyword = Xvr_keywordTypes[i].keyword;
+        const int length = keywordLength(keyword);
+        const uint32_t slot = keywordSlot(keywordKey(keyword, length), hash.seed);
+        if (hash.slots[slot] != emptySlot) {
+            return false;
+        }
+        hash.slots[slot] = (uint8_t)i;
+        hash.lengths[slot] = (uint8_t)length;
+    }
+
+    return true;
+}
+
+constexpr KeywordHash buildKeywordHash() {
+    KeywordHash hash = {0, 64, 0, {}, {}};
+
+    for (int i = 0; Xvr_keywordTypes[i].keyword; i++) {
+        const int length = keywordLength(Xvr_keywordTypes[i].keyword);
+        hash.min_length = length < hash.min_length ? length : hash.min_length;
+        hash.max_length = length > hash.max_length ? length : hash.max_length;
+    }
+
+    // odd multipliers only, so the high bits depend on every key bit
+    for (hash.seed = 0x9e3779b1u; !fillKeywordSlots(hash); hash.seed += 2);
+
+    return hash;
+}
+
+constexpr KeywordHash keywordHash = buildKeywordHash();
+
+static_assert(sizeof(Xvr_keywordTypes) / sizeof(Xvr_keywordTypes[0]) <
+                  emptySlot,
+              "keyword slots hold table indices in a byte");
+
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* Xvr_findKeywordByType(Xvr_TokenType type) {
     if (type == XVR_TOKEN_EOF) {
         return "EOF";
     }
@@ -84,16 +172,34 @@ char* Xvr_findKeywordByType(Xvr_TokenType type) {
     return NULL;
 }
 
-Xvr_TokenType Xvr_findTypeByKeyword(const char* keyword) {
-    const size_t length = xvr_safe_strlen(keyword, 64);
+Xvr_TokenType Xvr_findTypeByKeywordLength(const char* keyword, int length) {
+    if (length < keywordHash.min_length || length > keywordHash.max_length) {
+        return XVR_TOKEN_IDENTIFIER;
+    }
 
-    for (int i = 0; Xvr_keywordTypes[i].keyword; i++) {
-        if (!strncmp(keyword, Xvr_keywordTypes[i].keyword, length)) {
-            return Xvr_keywordTypes[i].type;
-        }
+    const uint32_t slot =
+        keywordSlot(keywordKey(keyword, length), keywordHash.seed);
+    if (keywordHash.slots[slot] == emptySlot ||
+        keywordHash.lengths[slot] != length) {
+        return XVR_TOKEN_IDENTIFIER;
+    }
+
+    // the slot only narrows it down to one candidate, compare all of it
+    const Xvr_KeywordType* candidate = &Xvr_keywordTypes[keywordHash.slots[slot]];
+    if (memcmp(candidate->keyword, keyword, length) != 0) {
+        return XVR_TOKEN_IDENTIFIER;
+    }
+
+    return candidate->type;
+}
+
+Xvr_TokenType Xvr_findTypeByKeyword(const char* keyword) {
+    if (keyword == NULL) {
+        return XVR_TOKEN_EOF;
     }
 
-    return XVR_TOKEN_EOF;
+    return Xvr_findTypeByKeywordLength(
+        keyword, (int)xvr_safe_strlen(keyword, 64));
 }
 
 #ifdef __cplusplus
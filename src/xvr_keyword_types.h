@@ -39,7 +39,7 @@ SOFTWARE.
  */
 typedef struct {
     Xvr_TokenType type;  // token type corresponding to keyword
-    char* keyword;       // null-terminated keyword string (static)
+    const char* keyword;  // null-terminated keyword string (static)
 } Xvr_KeywordType;
 
 /**
@@ -54,7 +54,7 @@ typedef struct {
 extern "C" {
 #endif
 
-extern Xvr_KeywordType Xvr_keywordTypes[];
+extern const Xvr_KeywordType Xvr_keywordTypes[];
 
 /**
  * @brief finds keyword string for given token type
@@ -67,7 +67,7 @@ extern Xvr_KeywordType Xvr_keywordTypes[];
  *
  * @note performance: O(1) -> direct array access using `type` as index
  */
-char* Xvr_findKeywordByType(Xvr_TokenType type);
+const char* Xvr_findKeywordByType(Xvr_TokenType type);
 
 /**
  * @brief find token type for given keyword string
@@ -76,10 +76,21 @@ char* Xvr_findKeywordByType(Xvr_TokenType type);
  * @return token type if found (example XVR_TOKEN_IF) or XVR_TOKEN_IDENTIFIER if
  * keywrod is not reserved word, or XVR_TOKEN_EOF on internal error
  *
- * @note performance: O(n) -> linear search through keyword table (n ~ 20)
+ * @note performance: O(1) -> see Xvr_findTypeByKeywordLength
  */
 Xvr_TokenType Xvr_findTypeByKeyword(const char* keyword);
 
+/**
+ * @brief find token type for the first `length` bytes of `keyword`
+ *
+ * @return token type if those bytes are exactly a keyword, or
+ * XVR_TOKEN_IDENTIFIER, a keyword's prefix or extension is not a keyword
+ *
+ * @note performance: O(1) -> one compile-time perfect hash probe on the
+ * length and first, second and last bytes, then one memcmp
+ */
+Xvr_TokenType Xvr_findTypeByKeywordLength(const char* keyword, int length);
+
 #ifdef __cplusplus
 }
 #endif
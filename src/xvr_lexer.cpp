@@ -30,8 +30,10 @@ SOFTWARE.
 #include <string.h>
 
 #include "xvr_common.h"
+#include "xvr_compiler_session.h"
 #include "xvr_console_colors.h"
 #include "xvr_keyword_types.h"
+#include "xvr_lexer_scan.h"
 #include "xvr_string_utils.h"
 #include "xvr_token_types.h"
 
@@ -39,7 +41,13 @@ static void cleanLexer(Xvr_Lexer* lexer) {
     lexer->source = NULL;
     lexer->start = 0;
     lexer->current = 0;
-    lexer->line = 1;
+    lexer->length = 0;
+    lexer->session = NULL;
+    lexer->error[0] = '\0';
+}
+
+static bool dumpTokens(Xvr_Lexer* lexer) {
+    return Xvr_CompilerSessionGetOptions(lexer->session)->dumpTokens;
 }
 
 static bool isAtEnd(Xvr_Lexer* lexer) {
@@ -58,67 +66,64 @@ static char advance(Xvr_Lexer* lexer) {
         return '\0';
     }
 
-    // new line
-    if (lexer->source[lexer->current] == '\n') {
-        lexer->line++;
-    }
-
     lexer->current++;
     return lexer->source[lexer->current - 1];
 }
 
-static void eatWhitespace(Xvr_Lexer* lexer) {
-    const char c = peek(lexer);
+// skip a whole run of `cls` from `from`
+static void scanFrom(Xvr_Lexer* lexer, Xvr_LexerScanClass cls, int from) {
+    lexer->current =
+        Xvr_private_lexerScan(cls, lexer->source, from, lexer->length);
+}
 
-    switch (c) {
-    case ' ':
-    case '\r':
-    case '\n':
-    case '\t':
-        advance(lexer);
-        break;
+static void eatWhitespace(Xvr_Lexer* lexer) {
+    for (;;) {
+        switch (peek(lexer)) {
+        case ' ':
+        case '\r':
+        case '\n':
+        case '\t':
+            scanFrom(lexer, XVR_LEXER_SCAN_WHITESPACE, lexer->current);
+            continue;
 
-    // INFO: add shebang feature
-    case '#':
-        if (lexer->start == 0 && peekNext(lexer) == '!') {
-            // eat the entire shebang line
-            while (peek(lexer) != '\n' && !isAtEnd(lexer)) {
+        // INFO: add shebang feature
+        case '#':
+            if (lexer->start == 0 && peekNext(lexer) == '!') {
+                // eat the entire shebang line and its newline
+                scanFrom(lexer, XVR_LEXER_SCAN_LINE_COMMENT, lexer->current);
                 advance(lexer);
+                continue;
             }
-            // eat the newline character as well
-            if (peek(lexer) == '\n') {
+            return;
+
+        // comments
+        case '/':
+            // eat the line
+            if (peekNext(lexer) == '/') {
+                scanFrom(lexer, XVR_LEXER_SCAN_LINE_COMMENT,
+                         lexer->current + 2);
                 advance(lexer);
+                continue;
             }
-            break;
-        }
-        return;
 
-    // comments
-    case '/':
-        // eat the line
-        if (peekNext(lexer) == '/') {
-            while (advance(lexer) != '\n' && !isAtEnd(lexer));
-            break;
-        }
-
-        // eat the block
-        if (peekNext(lexer) == '*') {
-            advance(lexer);
-            advance(lexer);
-            while (!(peek(lexer) == '*' && peekNext(lexer) == '/'))
+            // eat the block, an unterminated one runs to the end
+            if (peekNext(lexer) == '*') {
+                scanFrom(lexer, XVR_LEXER_SCAN_BLOCK_COMMENT,
+                         lexer->current + 2);
+                while (!isAtEnd(lexer) && peekNext(lexer) != '/') {
+                    scanFrom(lexer, XVR_LEXER_SCAN_BLOCK_COMMENT,
+                             lexer->current + 1);
+                }
                 advance(lexer);
-            advance(lexer);
-            advance(lexer);
-            break;
-        }
-        return;
+                advance(lexer);
+                continue;
+            }
+            return;
 
-    default:
-        return;
+        default:
+            return;
+        }
     }
-
-    // tail recursion
-    eatWhitespace(lexer);
 }
 
 static bool isDigit(Xvr_Lexer* lexer) {
@@ -153,10 +158,10 @@ static Xvr_Token makeErrorToken(Xvr_Lexer* lexer, char* msg) {
     token.type = XVR_TOKEN_ERROR;
     token.lexeme = msg;
     token.length = xvr_safe_strlen(msg, 256);
-    token.line = lexer->line;
+    token.offset = lexer->start;
 
 #ifndef XVR_EXPORT
-    if (Xvr_commandLine.dumpTokens) {
+    if (dumpTokens(lexer)) {
         printf("err:");
         Xvr_private_printToken(&token);
     }
@@ -171,10 +176,10 @@ static Xvr_Token makeToken(Xvr_Lexer* lexer, Xvr_TokenType type) {
     token.type = type;
     token.length = lexer->current - lexer->start;
     token.lexeme = &lexer->source[lexer->current - token.length];
-    token.line = lexer->line;
+    token.offset = lexer->start;
 
 #ifndef XVR_EXPORT
-    if (Xvr_commandLine.dumpTokens) {
+    if (dumpTokens(lexer)) {
         printf("tok:");
         Xvr_private_printToken(&token);
     }
@@ -186,15 +191,14 @@ static Xvr_Token makeToken(Xvr_Lexer* lexer, Xvr_TokenType type) {
 static Xvr_Token makeIntegerOrFloat(Xvr_Lexer* lexer) {
     Xvr_TokenType type = XVR_TOKEN_LITERAL_INTEGER;  // what am I making?
 
-    while (isDigit(lexer) || peek(lexer) == '_') advance(lexer);
+    scanFrom(lexer, XVR_LEXER_SCAN_DIGITS, lexer->current);
 
     bool is_float = false;
     if (peek(lexer) == '.' &&
         (peekNext(lexer) >= '0' && peekNext(lexer) <= '9')) {
         type = XVR_TOKEN_LITERAL_FLOAT;
         is_float = true;
-        advance(lexer);
-        while (isDigit(lexer) || peek(lexer) == '_') advance(lexer);
+        scanFrom(lexer, XVR_LEXER_SCAN_DIGITS, lexer->current + 1);
     }
 
     // Check for type suffix (e.g., 123i16, 42u8, 1.5f32)
@@ -280,10 +284,10 @@ static Xvr_Token makeIntegerOrFloat(Xvr_Lexer* lexer) {
     token.type = type;
     token.lexeme = &lexer->source[lexer->start];
     token.length = lexer->current - lexer->start;
-    token.line = lexer->line;
+    token.offset = lexer->start;
 
 #ifndef XVR_EXPORT
-    if (Xvr_commandLine.dumpTokens) {
+    if (dumpTokens(lexer)) {
         printf("int:");
     }
 #endif
@@ -303,10 +307,16 @@ static bool isEscapeableCharacter(char c) {
     }
 }
 
-static Xvr_Token makeString(Xvr_Lexer* lexer, char terminator) {
+static Xvr_Token makeString(Xvr_Lexer* lexer) {
     while (!isAtEnd(lexer)) {
+        // jump to the next quote or backslash
+        scanFrom(lexer, XVR_LEXER_SCAN_STRING_BODY, lexer->current);
+        if (isAtEnd(lexer)) {
+            break;
+        }
+
         // actually escape if you've hit the terminator
-        if (peek(lexer) == terminator) {
+        if (peek(lexer) == '"') {
             advance(lexer);  // eat terminator
             break;
         }
@@ -331,10 +341,10 @@ static Xvr_Token makeString(Xvr_Lexer* lexer, char terminator) {
     token.type = XVR_TOKEN_LITERAL_STRING;
     token.lexeme = &lexer->source[lexer->start + 1];
     token.length = lexer->current - lexer->start - 2;
-    token.line = lexer->line;
+    token.offset = lexer->start;
 
 #ifndef XVR_EXPORT
-    if (Xvr_commandLine.dumpTokens) {
+    if (dumpTokens(lexer)) {
         printf("str:");
     }
 #endif
@@ -343,46 +353,20 @@ static Xvr_Token makeString(Xvr_Lexer* lexer, char terminator) {
 }
 
 static Xvr_Token makeKeywordOrIdentifier(Xvr_Lexer* lexer) {
-    advance(lexer);  // first letter can only be alpha
-
-    while (isDigit(lexer) || isAlpha(lexer)) {
-        advance(lexer);
-    }
-
-    // scan for a keyword
-    for (int i = 0; Xvr_keywordTypes[i].keyword; i++) {
-        size_t kw_len = xvr_safe_strlen(Xvr_keywordTypes[i].keyword, 64);
-        if (kw_len == (size_t)(lexer->current - lexer->start) &&
-            !strncmp(Xvr_keywordTypes[i].keyword, &lexer->source[lexer->start],
-                     lexer->current - lexer->start)) {
-            Xvr_Token token;
+    // first letter can only be alpha
+    scanFrom(lexer, XVR_LEXER_SCAN_IDENTIFIER, lexer->current + 1);
 
-            token.type = Xvr_keywordTypes[i].type;
-            token.lexeme = &lexer->source[lexer->start];
-            token.length = lexer->current - lexer->start;
-            token.line = lexer->line;
-
-#ifndef XVR_EXPORT
-            if (Xvr_commandLine.dumpTokens) {
-                printf("kwd:");
-            }
-#endif
-
-            return token;
-        }
-    }
-
-    // return an identifier
     Xvr_Token token;
 
-    token.type = XVR_TOKEN_IDENTIFIER;
+    token.type = Xvr_findTypeByKeywordLength(&lexer->source[lexer->start],
+                                             lexer->current - lexer->start);
     token.lexeme = &lexer->source[lexer->start];
     token.length = lexer->current - lexer->start;
-    token.line = lexer->line;
+    token.offset = lexer->start;
 
 #ifndef XVR_EXPORT
-    if (Xvr_commandLine.dumpTokens) {
-        printf("idf:");
+    if (dumpTokens(lexer)) {
+        printf(token.type == XVR_TOKEN_IDENTIFIER ? "idf:" : "kwd:");
     }
 #endif
 
@@ -394,6 +378,14 @@ void Xvr_initLexer(Xvr_Lexer* lexer, const char* source) {
     cleanLexer(lexer);
 
     lexer->source = source;
+    lexer->length = (int)strlen(source);
+}
+
+void Xvr_initLexerWithSession(Xvr_Lexer* lexer, const char* source,
+                              Xvr_CompilerSession* session) {
+    Xvr_initLexer(lexer, source);
+
+    lexer->session = session;
 }
 
 Xvr_Token Xvr_private_scanLexer(Xvr_Lexer* lexer) {
@@ -483,14 +475,14 @@ Xvr_Token Xvr_private_scanLexer(Xvr_Lexer* lexer) {
         return makeToken(lexer, XVR_TOKEN_DOT);
 
     case '"':
-        return makeString(lexer, c);
+        return makeString(lexer);
         // TODO: possibly support interpolated strings
 
-    default: {
-        char buffer[128];
-        snprintf(buffer, 128, "Unexpected token: %c", c);
-        return makeErrorToken(lexer, buffer);
-    }
+    default:
+        // the token points here, valid until the next error is scanned
+        snprintf(lexer->error, sizeof(lexer->error), "Unexpected token: %c",
+                 c);
+        return makeErrorToken(lexer, lexer->error);
     }
 }
 
@@ -504,12 +496,12 @@ static void trim(char** s, int* l) {  // all this to remove a newline?
 
 void Xvr_private_printToken(Xvr_Token* token) {
     if (token->type == XVR_TOKEN_ERROR) {
-        printf("%sError\t%d\t%.*s\n%s", XVR_CC_ERROR, token->line,
+        printf("%sError\t%d\t%.*s\n%s", XVR_CC_ERROR, token->offset,
                token->length, token->lexeme, XVR_CC_RESET);
         return;
     }
 
-    printf("\t%d\t%d\t", token->type, token->line);
+    printf("\t%d\t%d\t", token->type, token->offset);
 
     if (token->type == XVR_TOKEN_IDENTIFIER ||
         token->type == XVR_TOKEN_LITERAL_INTEGER ||
@@ -517,7 +509,7 @@ void Xvr_private_printToken(Xvr_Token* token) {
         token->type == XVR_TOKEN_LITERAL_STRING) {
         printf("%.*s\t", token->length, token->lexeme);
     } else {
-        char* keyword = Xvr_findKeywordByType(token->type);
+        const char* keyword = Xvr_findKeywordByType(token->type);
 
         if (keyword != NULL) {
             printf("%s", keyword);
@@ -25,11 +25,12 @@ SOFTWARE.
 /**
  * @brief lexical analyzer (tokenizer)
  *
- * Xvr_Lexer implementing character-by-character, single-pass tokenizer
+ * Xvr_Lexer implementing single-pass tokenizer
  * - converting source code string into Xvr_Token stream
  * - recognizes keywords, identifier, literals, operator and punctuation
  * - handle string / number escaping and validation
- * - maintain line / column tracking for error reporting
+ * - tag each token with its byte offset, line and column are resolved from
+ *   it only for diagnostics, see xvr_line_index.h
  *
  * memory management
  *   - lexer borrows source string
@@ -40,6 +41,9 @@ SOFTWARE.
  *   - no thread-safe -> external synchronization required
  *   - no atomic operations on lexer state
  *
+ * runs of whitespace, comment bodies, identifiers, digits and string bodies
+ * are skipped with the vectorized kernels in xvr_lexer_scan.h
+ *
  * using for:
  *   - fast tokenization O(n)
  *   - small memory footprint (no intermediate buffers)
@@ -57,17 +61,21 @@ SOFTWARE.
 extern "C" {
 #endif
 
+typedef struct Xvr_CompilerSession Xvr_CompilerSession;
+
 /**
  * @struct Xvr_Lexer
  * @brief lexer state machine - source code input to token stream
  *
- * @note size: ~24 bytes - designing for stack allocation if needed
+ * @note size: ~160 bytes - designing for stack allocation if needed
  */
 typedef struct {
-    const char* source;  // input source code
-    int start;           // start offset of current token being built
-    int current;         // current character position in source
-    int line;            // current line number
+    const char* source;            // input source code
+    int start;                     // start offset of current token being built
+    int current;                   // current character position in source
+    int length;                    // bytes in source before its terminator
+    Xvr_CompilerSession* session;  // options and diagnostics, NULL for defaults
+    char error[128];               // formatted message of the last error token
 } Xvr_Lexer;
 
 /**
@@ -80,7 +88,7 @@ typedef struct {
     Xvr_TokenType type;  // token classification
     const char* lexeme;  // pointer to original text in source
     int length;          // length of token text in btyes
-    int line;            // line number where token starts
+    int offset;          // byte offset in source where token starts
 } Xvr_Token;
 
 /**
@@ -96,6 +104,13 @@ typedef struct {
  */
 XVR_API void Xvr_initLexer(Xvr_Lexer* lexer, const char* source);
 
+/**
+ * @brief intializes lexer with source code, reading its options from
+ * `session` and reporting to it; the parser on top reports there too
+ */
+XVR_API void Xvr_initLexerWithSession(Xvr_Lexer* lexer, const char* source,
+                                      Xvr_CompilerSession* session);
+
 /**
  * @brief scan next token from source code
  *
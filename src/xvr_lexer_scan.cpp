@@ -0,0 +1,373 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_lexer_scan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#    define XVR_LEXER_SCAN_X86 1
+#    include <immintrin.h>
+#else
+#    define XVR_LEXER_SCAN_X86 0
+#endif
+
+namespace {
+
+typedef int (*ScanFn)(const char* source, int from, int end);
+typedef int (*NewlineFn)(const char* source, int end, int* offsets);
+
+struct ScanTable {
+    Xvr_LexerScanLevel level;
+    ScanFn fns[XVR_LEXER_SCAN_CLASS_COUNT];
+    NewlineFn newlines;
+};
+
+/* runs stop at the first byte outside the class, the rest stop at the first
+ * byte inside it */
+constexpr bool isRun(int cls) {
+    return cls == XVR_LEXER_SCAN_WHITESPACE ||
+           cls == XVR_LEXER_SCAN_IDENTIFIER || cls == XVR_LEXER_SCAN_DIGITS;
+}
+
+template <int Cls>
+inline bool inClass(unsigned char c) {
+    if constexpr (Cls == XVR_LEXER_SCAN_WHITESPACE) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    } else if constexpr (Cls == XVR_LEXER_SCAN_IDENTIFIER) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '_';
+    } else if constexpr (Cls == XVR_LEXER_SCAN_DIGITS) {
+        return (c >= '0' && c <= '9') || c == '_';
+    } else if constexpr (Cls == XVR_LEXER_SCAN_LINE_COMMENT) {
+        return c == '\n';
+    } else if constexpr (Cls == XVR_LEXER_SCAN_BLOCK_COMMENT) {
+        return c == '*';
+    } else {
+        return c == '"' || c == '\\';
+    }
+}
+
+template <int Cls>
+int scanScalar(const char* source, int from, int end) {
+    int i = from;
+    while (i < end && inClass<Cls>((unsigned char)source[i]) == isRun(Cls)) {
+        i++;
+    }
+    return i;
+}
+
+int newlinesFrom(const char* source, int from, int end, int* offsets) {
+    int count = 0;
+    for (int i = from; i < end; i++) {
+        if (source[i] == '\n') {
+            if (offsets) {
+                offsets[count] = i;
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+int newlinesScalar(const char* source, int end, int* offsets) {
+    return newlinesFrom(source, 0, end, offsets);
+}
+
+#if XVR_LEXER_SCAN_X86
+
+/* pcmpestri operands: the class as a set or as byte ranges, a run looks for
+ * the first byte outside of it */
+template <int Cls>
+struct Sse42Needle;
+
+template <>
+struct Sse42Needle<XVR_LEXER_SCAN_WHITESPACE> {
+    static constexpr char bytes[16] = " \t\r\n";
+    static constexpr int length = 4;
+    static constexpr int mode = _SIDD_CMP_EQUAL_ANY;
+};
+
+template <>
+struct Sse42Needle<XVR_LEXER_SCAN_IDENTIFIER> {
+    static constexpr char bytes[16] = "azAZ09__";
+    static constexpr int length = 8;
+    static constexpr int mode = _SIDD_CMP_RANGES;
+};
+
+template <>
+struct Sse42Needle<XVR_LEXER_SCAN_DIGITS> {
+    static constexpr char bytes[16] = "09__";
+    static constexpr int length = 4;
+    static constexpr int mode = _SIDD_CMP_RANGES;
+};
+
+template <>
+struct Sse42Needle<XVR_LEXER_SCAN_LINE_COMMENT> {
+    static constexpr char bytes[16] = "\n";
+    static constexpr int length = 1;
+    static constexpr int mode = _SIDD_CMP_EQUAL_ANY;
+};
+
+template <>
+struct Sse42Needle<XVR_LEXER_SCAN_BLOCK_COMMENT> {
+    static constexpr char bytes[16] = "*";
+    static constexpr int length = 1;
+    static constexpr int mode = _SIDD_CMP_EQUAL_ANY;
+};
+
+template <>
+struct Sse42Needle<XVR_LEXER_SCAN_STRING_BODY> {
+    static constexpr char bytes[16] = "\"\\";
+    static constexpr int length = 2;
+    static constexpr int mode = _SIDD_CMP_EQUAL_ANY;
+};
+
+template <int Cls>
+__attribute__((target("sse4.2,popcnt"))) int scanSse42(const char* source,
+                                                        int from, int end) {
+    typedef Sse42Needle<Cls> Needle;
+    constexpr int mode =
+        _SIDD_UBYTE_OPS | Needle::mode | _SIDD_LEAST_SIGNIFICANT |
+        (isRun(Cls) ? _SIDD_NEGATIVE_POLARITY : _SIDD_POSITIVE_POLARITY);
+
+    const __m128i needle = _mm_loadu_si128((const __m128i*)Needle::bytes);
+
+    int i = from;
+    while (i + 16 <= end) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(source + i));
+        const int stop = _mm_cmpestri(needle, Needle::length, chunk, 16, mode);
+        if (stop < 16) {
+            return i + stop;
+        }
+        i += 16;
+    }
+
+    return scanScalar<Cls>(source, i, end);
+}
+
+/* a newline mask per vector: popcount when only counting, one ctz per
+ * newline when writing the offsets out */
+__attribute__((target("sse4.2,popcnt"))) int newlinesSse42(const char* source,
+                                                            int end,
+                                                            int* offsets) {
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    int count = 0;
+    int i = 0;
+    for (; i + 16 <= end; i += 16) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(source + i));
+        unsigned int mask =
+            (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (!offsets) {
+            count += __builtin_popcount(mask);
+            continue;
+        }
+        for (; mask != 0; mask &= mask - 1) {
+            offsets[count++] = i + __builtin_ctz(mask);
+        }
+    }
+
+    return count +
+           newlinesFrom(source, i, end, offsets ? offsets + count : NULL);
+}
+
+/* byte ranges compared as signed bytes: anything above 0x7f is negative and
+ * falls outside every class */
+__attribute__((target("avx2"))) inline __m256i avx2Range(__m256i chunk,
+                                                         char low, char high) {
+    return _mm256_and_si256(
+        _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8((char)(low - 1))),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(high + 1)), chunk));
+}
+
+__attribute__((target("avx2"))) inline __m256i avx2Byte(__m256i chunk,
+                                                        char byte) {
+    return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(byte));
+}
+
+template <int Cls>
+__attribute__((target("avx2"))) inline __m256i avx2Class(__m256i chunk) {
+    if constexpr (Cls == XVR_LEXER_SCAN_WHITESPACE) {
+        return _mm256_or_si256(
+            _mm256_or_si256(avx2Byte(chunk, ' '), avx2Byte(chunk, '\t')),
+            _mm256_or_si256(avx2Byte(chunk, '\r'), avx2Byte(chunk, '\n')));
+    } else if constexpr (Cls == XVR_LEXER_SCAN_IDENTIFIER) {
+        // folding case maps 'A'-'Z' onto 'a'-'z' and nothing else into it
+        const __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+        return _mm256_or_si256(
+            _mm256_or_si256(avx2Range(folded, 'a', 'z'),
+                            avx2Range(chunk, '0', '9')),
+            avx2Byte(chunk, '_'));
+    } else if constexpr (Cls == XVR_LEXER_SCAN_DIGITS) {
+        return _mm256_or_si256(avx2Range(chunk, '0', '9'),
+                               avx2Byte(chunk, '_'));
+    } else if constexpr (Cls == XVR_LEXER_SCAN_LINE_COMMENT) {
+        return avx2Byte(chunk, '\n');
+    } else if constexpr (Cls == XVR_LEXER_SCAN_BLOCK_COMMENT) {
+        return avx2Byte(chunk, '*');
+    } else {
+        return _mm256_or_si256(avx2Byte(chunk, '"'), avx2Byte(chunk, '\\'));
+    }
+}
+
+template <int Cls>
+__attribute__((target("avx2,popcnt"))) int scanAvx2(const char* source,
+                                                     int from, int end) {
+    int i = from;
+    while (i + 32 <= end) {
+        const __m256i chunk =
+            _mm256_loadu_si256((const __m256i*)(source + i));
+        unsigned int stops =
+            (unsigned int)_mm256_movemask_epi8(avx2Class<Cls>(chunk));
+        if constexpr (isRun(Cls)) {
+            stops = ~stops;
+        }
+
+        if (stops != 0) {
+            return i + __builtin_ctz(stops);
+        }
+        i += 32;
+    }
+
+    // avx2 implies sse4.2, which finishes the tail in one more step or two
+    return scanSse42<Cls>(source, i, end);
+}
+
+__attribute__((target("avx2,popcnt"))) int newlinesAvx2(const char* source,
+                                                         int end,
+                                                         int* offsets) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    int count = 0;
+    int i = 0;
+    for (; i + 32 <= end; i += 32) {
+        const __m256i chunk =
+            _mm256_loadu_si256((const __m256i*)(source + i));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(chunk, newline));
+        if (!offsets) {
+            count += __builtin_popcount(mask);
+            continue;
+        }
+        for (; mask != 0; mask &= mask - 1) {
+            offsets[count++] = i + __builtin_ctz(mask);
+        }
+    }
+
+    return count +
+           newlinesFrom(source, i, end, offsets ? offsets + count : NULL);
+}
+
+#endif  // XVR_LEXER_SCAN_X86
+
+constexpr ScanTable scalarTable = {
+    XVR_LEXER_SCAN_SCALAR,
+    {
+        scanScalar<XVR_LEXER_SCAN_WHITESPACE>,
+        scanScalar<XVR_LEXER_SCAN_IDENTIFIER>,
+        scanScalar<XVR_LEXER_SCAN_DIGITS>,
+        scanScalar<XVR_LEXER_SCAN_LINE_COMMENT>,
+        scanScalar<XVR_LEXER_SCAN_BLOCK_COMMENT>,
+        scanScalar<XVR_LEXER_SCAN_STRING_BODY>,
+    },
+    newlinesScalar,
+};
+
+#if XVR_LEXER_SCAN_X86
+constexpr ScanTable sse42Table = {
+    XVR_LEXER_SCAN_SSE42,
+    {
+        scanSse42<XVR_LEXER_SCAN_WHITESPACE>,
+        scanSse42<XVR_LEXER_SCAN_IDENTIFIER>,
+        scanSse42<XVR_LEXER_SCAN_DIGITS>,
+        scanSse42<XVR_LEXER_SCAN_LINE_COMMENT>,
+        scanSse42<XVR_LEXER_SCAN_BLOCK_COMMENT>,
+        scanSse42<XVR_LEXER_SCAN_STRING_BODY>,
+    },
+    newlinesSse42,
+};
+
+constexpr ScanTable avx2Table = {
+    XVR_LEXER_SCAN_AVX2,
+    {
+        scanAvx2<XVR_LEXER_SCAN_WHITESPACE>,
+        scanAvx2<XVR_LEXER_SCAN_IDENTIFIER>,
+        scanAvx2<XVR_LEXER_SCAN_DIGITS>,
+        scanAvx2<XVR_LEXER_SCAN_LINE_COMMENT>,
+        scanAvx2<XVR_LEXER_SCAN_BLOCK_COMMENT>,
+        scanAvx2<XVR_LEXER_SCAN_STRING_BODY>,
+    },
+    newlinesAvx2,
+};
+#endif
+
+const ScanTable* detectTable() {
+#if XVR_LEXER_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("popcnt")) {
+        if (__builtin_cpu_supports("avx2")) {
+            return &avx2Table;
+        }
+        if (__builtin_cpu_supports("sse4.2")) {
+            return &sse42Table;
+        }
+    }
+#endif
+    return &scalarTable;
+}
+
+const ScanTable* const supportedTable = detectTable();
+const ScanTable* activeTable = supportedTable;
+
+}  // namespace
+
+int Xvr_private_lexerScan(Xvr_LexerScanClass cls, const char* source,
+                          int from, int end) {
+    return activeTable->fns[cls](source, from, end);
+}
+
+int Xvr_private_lexerIndexNewlines(const char* source, int end,
+                                   int* offsets) {
+    return activeTable->newlines(source, end, offsets);
+}
+
+Xvr_LexerScanLevel Xvr_private_lexerScanLevel(void) {
+    return activeTable->level;
+}
+
+Xvr_LexerScanLevel Xvr_private_setLexerScanLevel(Xvr_LexerScanLevel level) {
+    if (level >= supportedTable->level) {
+        activeTable = supportedTable;
+    }
+#if XVR_LEXER_SCAN_X86
+    else if (level == XVR_LEXER_SCAN_SSE42) {
+        activeTable = &sse42Table;
+    }
+#endif
+    else {
+        activeTable = &scalarTable;
+    }
+
+    return activeTable->level;
+}
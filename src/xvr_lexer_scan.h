@@ -0,0 +1,98 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @brief vectorized character-class scanning for the lexer
+ *
+ * every scan starts at `from` and returns the offset of the first byte that
+ * ends the run, never past `end`; the lexer does not track lines, they are
+ * found afterwards from the newline offsets, see xvr_line_index.h
+ *
+ * the kernel is picked once at load time from what the cpu supports: avx2,
+ * sse4.2, or a plain byte loop everywhere else
+ */
+
+#ifndef XVR_LEXER_SCAN_H
+#define XVR_LEXER_SCAN_H
+
+#include "xvr_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    XVR_LEXER_SCAN_WHITESPACE,     // run of ' ', '\t', '\r' and '\n'
+    XVR_LEXER_SCAN_IDENTIFIER,     // run of letters, digits and '_'
+    XVR_LEXER_SCAN_DIGITS,         // run of digits and '_'
+    XVR_LEXER_SCAN_LINE_COMMENT,   // up to the next '\n'
+    XVR_LEXER_SCAN_BLOCK_COMMENT,  // up to the next '*'
+    XVR_LEXER_SCAN_STRING_BODY,    // up to the next '"' or '\\'
+    XVR_LEXER_SCAN_CLASS_COUNT,
+} Xvr_LexerScanClass;
+
+typedef enum {
+    XVR_LEXER_SCAN_SCALAR,
+    XVR_LEXER_SCAN_SSE42,
+    XVR_LEXER_SCAN_AVX2,
+} Xvr_LexerScanLevel;
+
+/**
+ * @brief skip the run of `cls` in `source[from, end)`
+ *
+ * @return offset of the first byte not in the run, or `end`
+ */
+XVR_API int Xvr_private_lexerScan(Xvr_LexerScanClass cls, const char* source,
+                                  int from, int end);
+
+/**
+ * @brief finds every '\n' in `source[0, end)`
+ *
+ * @param[out] offsets receives the offset of each newline in order, or NULL
+ * to only count them with a popcount per vector
+ * @return number of newlines
+ */
+XVR_API int Xvr_private_lexerIndexNewlines(const char* source, int end,
+                                           int* offsets);
+
+/**
+ * @brief the kernel level in use
+ */
+XVR_API Xvr_LexerScanLevel Xvr_private_lexerScanLevel(void);
+
+/**
+ * @brief cap the kernel level, for tests and benchmarks
+ *
+ * @return the level actually in use, never above what the cpu supports
+ *
+ * @warning not thread-safe, call it while no lexer is running
+ */
+XVR_API Xvr_LexerScanLevel Xvr_private_setLexerScanLevel(
+    Xvr_LexerScanLevel level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !XVR_LEXER_SCAN_H
@@ -0,0 +1,90 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_line_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xvr_lexer_scan.h"
+
+bool Xvr_buildLineIndex(Xvr_LineIndex* index, const char* source,
+                        int length) {
+    // count first so the offsets land in one allocation
+    const int count = Xvr_private_lexerIndexNewlines(source, length, NULL);
+
+    if (count > index->capacity) {
+        int* grown = (int*)realloc(index->newlines, sizeof(int) * count);
+        if (!grown) {
+            index->count = 0;
+            return false;
+        }
+        index->newlines = grown;
+        index->capacity = count;
+    }
+
+    index->count = Xvr_private_lexerIndexNewlines(source, length,
+                                                  count ? index->newlines
+                                                        : NULL);
+    return true;
+}
+
+void Xvr_freeLineIndex(Xvr_LineIndex* index) {
+    free(index->newlines);
+    index->newlines = NULL;
+    index->count = 0;
+    index->capacity = 0;
+}
+
+Xvr_SourceLocation Xvr_resolveLineIndex(const Xvr_LineIndex* index,
+                                        int offset) {
+    // newlines before `offset`, the last of them ends the previous line
+    int low = 0;
+    int high = index->count;
+    while (low < high) {
+        const int mid = low + (high - low) / 2;
+        if (index->newlines[mid] < offset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    Xvr_SourceLocation location;
+    location.line = low + 1;
+    location.column = offset - (low > 0 ? index->newlines[low - 1] + 1 : 0) + 1;
+    return location;
+}
+
+Xvr_SourceLocation Xvr_resolveSourceOffset(const char* source, int offset) {
+    Xvr_LineIndex index;
+    memset(&index, 0, sizeof(index));
+
+    Xvr_SourceLocation location = {0, 0};
+    if (source && Xvr_buildLineIndex(&index, source, offset)) {
+        location = Xvr_resolveLineIndex(&index, offset);
+    }
+    Xvr_freeLineIndex(&index);
+    return location;
+}
@@ -0,0 +1,90 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @brief byte offset to line and column, resolved only when asked
+ *
+ * tokens and AST nodes carry the byte offset of their first character; a
+ * diagnostic turns it into a position with a binary search over the offsets
+ * of the source's newlines, found by one vectorized pass when the source is
+ * loaded
+ *
+ * lines and columns are 1-based, columns count bytes
+ */
+
+#ifndef XVR_LINE_INDEX_H
+#define XVR_LINE_INDEX_H
+
+#include "xvr_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int line;
+    int column;
+} Xvr_SourceLocation;
+
+/**
+ * @struct Xvr_LineIndex
+ * @brief offsets of every newline in one source
+ *
+ * @note zeroed memory is an empty index, building into a used one keeps its
+ * capacity
+ */
+typedef struct {
+    int* newlines;
+    int count;
+    int capacity;
+} Xvr_LineIndex;
+
+/**
+ * @brief indexes the newlines of `source[0, length)`
+ *
+ * @return false when out of memory, the index is then empty
+ */
+XVR_API bool Xvr_buildLineIndex(Xvr_LineIndex* index, const char* source,
+                                int length);
+
+XVR_API void Xvr_freeLineIndex(Xvr_LineIndex* index);
+
+/**
+ * @brief line and column of the byte at `offset`
+ */
+XVR_API Xvr_SourceLocation Xvr_resolveLineIndex(const Xvr_LineIndex* index,
+                                                int offset);
+
+/**
+ * @brief builds a throwaway index to resolve one offset, for the rare
+ * diagnostic that has no index at hand
+ */
+XVR_API Xvr_SourceLocation Xvr_resolveSourceOffset(const char* source,
+                                                   int offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !XVR_LINE_INDEX_H
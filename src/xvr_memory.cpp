@@ -5,22 +5,25 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <atomic>
+
 #include "xvr_console_colors.h"
 #include "xvr_refstring.h"
 
 #if XVR_DEBUG_ALLOCATIONS
-static size_t g_alloc_count = 0;
-static size_t g_free_count = 0;
-static size_t g_current_memory = 0;
-static size_t g_peak_memory = 0;
-static int g_initialized = 0;
+// sessions compile on several threads at once
+static std::atomic<size_t> g_alloc_count{0};
+static std::atomic<size_t> g_free_count{0};
+static std::atomic<size_t> g_current_memory{0};
+static std::atomic<size_t> g_peak_memory{0};
+static std::atomic<int> g_initialized{0};
 
 void Xvr_debugPrintMemoryStats(void) {
     fprintf(stderr,
             "%s[Memory] Allocations: %zu, Frees: %zu, "
             "Current: %zu bytes, Peak: %zu bytes\n%s",
-            XVR_CC_NOTICE, g_alloc_count, g_free_count, g_current_memory,
-            g_peak_memory, XVR_CC_RESET);
+            XVR_CC_NOTICE, g_alloc_count.load(), g_free_count.load(),
+            g_current_memory.load(), g_peak_memory.load(), XVR_CC_RESET);
 }
 
 size_t Xvr_debugGetAllocCount(void) { return g_alloc_count; }
@@ -80,8 +83,10 @@ void* Xvr_private_defaultMemoryAllocator(void* pointer, size_t oldSize,
     } else {
         g_current_memory += newSize - oldSize;
     }
-    if (g_current_memory > g_peak_memory) {
-        g_peak_memory = g_current_memory;
+    size_t current = g_current_memory.load();
+    size_t peak = g_peak_memory.load();
+    while (current > peak &&
+           !g_peak_memory.compare_exchange_weak(peak, current)) {
     }
 #endif
 
@@ -89,11 +94,22 @@ void* Xvr_private_defaultMemoryAllocator(void* pointer, size_t oldSize,
 }
 
 static Xvr_MemoryAllocatorFn allocator = Xvr_private_defaultMemoryAllocator;
+static thread_local Xvr_MemoryAllocatorFn thread_allocator = NULL;
 
 void* Xvr_reallocate(void* pointer, size_t oldSize, size_t newSize) {
+    if (thread_allocator) {
+        return thread_allocator(pointer, oldSize, newSize);
+    }
     return allocator(pointer, oldSize, newSize);
 }
 
+Xvr_MemoryAllocatorFn Xvr_private_setThreadMemoryAllocator(
+    Xvr_MemoryAllocatorFn fn) {
+    Xvr_MemoryAllocatorFn previous = thread_allocator;
+    thread_allocator = fn == Xvr_reallocate ? NULL : fn;
+    return previous;
+}
+
 void Xvr_setMemoryAllocator(Xvr_MemoryAllocatorFn fn) {
     if (fn == NULL) {
         fprintf(stderr,
@@ -121,6 +121,11 @@ typedef void* (*Xvr_MemoryAllocatorFn)(void* pointer, size_t oldSize,
  */
 XVR_API void Xvr_setMemoryAllocator(Xvr_MemoryAllocatorFn);
 
+/* allocations made on the calling thread go to `fn` instead, NULL goes back
+ * to the process allocator; returns the one it replaces */
+XVR_API Xvr_MemoryAllocatorFn Xvr_private_setThreadMemoryAllocator(
+    Xvr_MemoryAllocatorFn fn);
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,8 +5,10 @@
 
 #include "xvr_ast_node.h"
 #include "xvr_common.h"
+#include "xvr_compiler_session.h"
 #include "xvr_console_colors.h"
 #include "xvr_lexer.h"
+#include "xvr_line_index.h"
 #include "xvr_literal.h"
 #include "xvr_memory.h"
 #include "xvr_opcodes.h"
@@ -16,9 +18,36 @@
 static void error(Xvr_Parser* parser, Xvr_Token token, const char* message) {
     if (parser->panic) return;
 
+    parser->error = true;
+    parser->panic = true;
+
+    // a streaming parser has no newline index, build one up to the token
+    const Xvr_SourceLocation location =
+        parser->tokens
+            ? Xvr_TokenBufferLocate(parser->tokens, token.offset)
+            : Xvr_resolveSourceOffset(parser->lexer->source, token.offset);
+
+    Xvr_CompilerSession* session = parser->lexer->session;
+    if (session) {
+        char detail[512];
+        if (token.type == XVR_TOKEN_EOF) {
+            snprintf(detail, sizeof(detail), "%s, unexpected end of file",
+                     message);
+        } else {
+            snprintf(detail, sizeof(detail), "%s, unexpected token '%.*s'",
+                     message, token.length, token.lexeme);
+        }
+        Xvr_CompilerSessionReportAt(session, location.line, location.column,
+                                    detail);
+    }
+    if (!Xvr_CompilerSessionPrintsDiagnostics(session)) {
+        return;
+    }
+
     fprintf(stderr, "\n");
     fprintf(stderr, "%serror%s: %s\n", XVR_CC_FONT_RED, XVR_CC_RESET, message);
-    fprintf(stderr, "  --> line %d\n", token.line);
+    fprintf(stderr, "  --> line %d, column %d\n", location.line,
+            location.column);
 
     if (token.type == XVR_TOKEN_EOF) {
         fprintf(stderr, "%shelp%s: unexpected end of file\n", XVR_CC_NOTICE,
@@ -28,14 +57,15 @@ static void error(Xvr_Parser* parser, Xvr_Token token, const char* message) {
                 XVR_CC_RESET, token.length, token.lexeme);
     }
     fprintf(stderr, "\n");
-
-    parser->error = true;
-    parser->panic = true;
 }
 
 static void advance(Xvr_Parser* parser) {
     parser->previous = parser->current;
-    parser->current = Xvr_private_scanLexer(parser->lexer);
+    if (parser->tokens) {
+        parser->current = Xvr_TokenBufferGet(parser->tokens, ++parser->index);
+    } else {
+        parser->current = Xvr_private_scanLexer(parser->lexer);
+    }
 
     if (parser->current.type == XVR_TOKEN_ERROR) {
         error(parser, parser->current, "Xvr_Lexer error");
@@ -75,7 +105,7 @@ static void consume(Xvr_Parser* parser, Xvr_TokenType tokenType,
 
 static void synchronize(Xvr_Parser* parser) {
 #ifndef XVR_EXPORT
-    if (Xvr_commandLine.verbose) {
+    if (Xvr_CompilerSessionGetOptions(parser->lexer->session)->verbose) {
         fprintf(stderr, "%sSynchronizing input\n%s", XVR_CC_ERROR,
                 XVR_CC_RESET);
     }
@@ -2684,7 +2714,7 @@ static void varDecl(Xvr_Parser* parser, Xvr_ASTNode** nodeHandle) {
 
     // declare it
     Xvr_emitASTNodeVarDecl(nodeHandle, identifier, typeLiteral, expressionNode,
-                           identifierToken.line);
+                           identifierToken.offset);
 
     consumeSemicolon(parser);
 }
@@ -2759,7 +2789,7 @@ static void fnDecl(Xvr_Parser* parser, Xvr_ASTNode** nodeHandle) {
                 Xvr_ASTNode* literalNode = NULL;
                 Xvr_emitASTNodeVarDecl(&literalNode, argIdentifier,
                                        argTypeLiteral, NULL,
-                                       argIdentifierToken.line);
+                                       argIdentifierToken.offset);
 
                 argumentNode->fnCollection
                     .nodes[argumentNode->fnCollection.count++] = *literalNode;
@@ -2810,7 +2840,7 @@ static void fnDecl(Xvr_Parser* parser, Xvr_ASTNode** nodeHandle) {
             // store the arg in the array
             Xvr_ASTNode* literalNode = NULL;
             Xvr_emitASTNodeVarDecl(&literalNode, argIdentifier, argTypeLiteral,
-                                   NULL, argIdentifierToken.line);
+                                   NULL, argIdentifierToken.offset);
 
             argumentNode->fnCollection
                 .nodes[argumentNode->fnCollection.count++] = *literalNode;
@@ -2856,7 +2886,7 @@ static void fnDecl(Xvr_Parser* parser, Xvr_ASTNode** nodeHandle) {
 
     // declare it
     Xvr_emitASTNodeFnDecl(nodeHandle, identifier, argumentNode, returnNode,
-                          blockNode, identifierToken.line);
+                          blockNode, identifierToken.offset);
 }
 
 static void declaration(Xvr_Parser* parser, Xvr_ASTNode** nodeHandle) {
@@ -2871,9 +2901,36 @@ static void declaration(Xvr_Parser* parser, Xvr_ASTNode** nodeHandle) {
 
 // exposed functions
 void Xvr_initParser(Xvr_Parser* parser, Xvr_Lexer* lexer) {
+    Xvr_TokenBuffer* tokens =
+        lexer->session ? Xvr_CompilerSessionAcquireTokens(lexer->session)
+                       : NULL;
+
+    Xvr_initParserWithTokens(parser, lexer, tokens);
+
+    // a buffer that could not be filled goes straight back
+    if (tokens && !parser->tokens) {
+        Xvr_CompilerSessionReleaseTokens(lexer->session, tokens);
+    }
+    parser->pooled = parser->tokens != NULL;
+}
+
+void Xvr_initParserWithTokens(Xvr_Parser* parser, Xvr_Lexer* lexer,
+                              Xvr_TokenBuffer* tokens) {
     parser->lexer = lexer;
     parser->error = false;
     parser->panic = false;
+    parser->tokens = NULL;
+    parser->index = -1;  // advance() steps onto the first token
+    parser->pooled = false;
+
+    if (tokens) {
+        const Xvr_Lexer start = *lexer;
+        if (Xvr_TokenBufferFill(tokens, lexer)) {
+            parser->tokens = tokens;
+        } else {
+            *lexer = start;
+        }
+    }
 
     parser->previous.type = XVR_TOKEN_NULL;
     parser->current.type = XVR_TOKEN_NULL;
@@ -2881,6 +2938,13 @@ void Xvr_initParser(Xvr_Parser* parser, Xvr_Lexer* lexer) {
 }
 
 void Xvr_freeParser(Xvr_Parser* parser) {
+    if (parser->pooled && parser->lexer) {
+        Xvr_CompilerSessionReleaseTokens(parser->lexer->session,
+                                         parser->tokens);
+    }
+    parser->tokens = NULL;
+    parser->index = 0;
+    parser->pooled = false;
     parser->lexer = NULL;
     parser->error = false;
     parser->panic = false;
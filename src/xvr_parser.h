@@ -26,7 +26,8 @@ SOFTWARE.
  * @brief recursive descent parser for the XVR
  *
  * Xvr_Parser implemeting pratt-style recursive descent parser with
- *   - single token lookahead
+ *   - single token lookahead, or any lookahead over a pre-lexed
+ *     Xvr_TokenBuffer
  *   - panic-mode error recovery
  *   - operator precedence climbing for expression
  *   - automatic AST node generation
@@ -48,6 +49,7 @@ extern "C" {
 #include "xvr_ast_node.h"
 #include "xvr_common.h"
 #include "xvr_lexer.h"
+#include "xvr_token_buffer.h"
 
 /**
  * @struct Xvr_Parser
@@ -60,6 +62,8 @@ extern "C" {
  *  - panic: set to true if currently in error recovery mode
  *  - current: current token to process
  * - previous: last consumed token
+ *  - tokens: the whole source pre-lexed, NULL when pulling from the lexer
+ *  - index: position of `current` in `tokens`
  *
  *   @note size are: 48 bytes (2 tokens + 2 ptrs + 2 bools) -> fits in registers
  * / cache line
@@ -71,6 +75,10 @@ typedef struct {
 
     Xvr_Token current;   // current token to process
     Xvr_Token previous;  // last consumed token
+
+    Xvr_TokenBuffer* tokens;  // pre-lexed source, or NULL to stream
+    int index;                // index of `current` in `tokens`
+    bool pooled;              // `tokens` goes back to the lexer's session
 } Xvr_Parser;
 
 /**
@@ -84,14 +92,30 @@ typedef struct {
  * - error = false, panic = false
  * - current = next token from lexer (or EOF if empty)
  *
+ * a lexer with a session is lexed up front into one of the session's token
+ * buffers, see Xvr_initParserWithTokens; without one tokens are pulled as
+ * the parser goes
+ *
  * @note this safe to call on zeroed memory: calling twice are safe but
  * overwrites lexer
  */
 XVR_API void Xvr_initParser(Xvr_Parser* parser, Xvr_Lexer* lexer);
 
+/**
+ * @brief initializes parser over `tokens`, filled from the rest of `lexer`
+ *
+ * the parser then moves by index through the buffer; `tokens` stays owned
+ * by the caller and can be reused for the next source once the parser is
+ * freed. when the buffer cannot grow the parser streams from the lexer
+ */
+XVR_API void Xvr_initParserWithTokens(Xvr_Parser* parser, Xvr_Lexer* lexer,
+                                      Xvr_TokenBuffer* tokens);
+
 /**
  * @brief frees parser resource / does not free lexer
  *
+ * a token buffer taken from the lexer's session is handed back to it
+ *
  * @param[in, out] parser parser to destroy
  *
  * @note safe to call even if parser->error == true
@@ -1,5 +1,6 @@
 #include "xvr_refstring.h"
 
+#include <atomic>
 #include <cstring>
 #include <cstdio>
 
@@ -7,7 +8,7 @@
 #include "xvr_string_utils.h"
 
 #if defined(XVR_DEBUG) || defined(DEBUG)
-static int g_refstring_count = 0;
+static std::atomic<int> g_refstring_count{0};
 #endif
 
 static Xvr_RefStringAllocatorFn allocate = [](void* pointer, size_t oldSize, size_t newSize) -> void* {
@@ -112,7 +113,8 @@ bool Xvr_equalsRefStringCString(Xvr_RefString* lhs, char* cstring) {
 
 #if defined(XVR_DEBUG) || defined(DEBUG)
 void Xvr_debugPrintRefStringStats(void) {
-    fprintf(stderr, "[RefString] Active strings: %d\n", g_refstring_count);
+    fprintf(stderr, "[RefString] Active strings: %d\n",
+            g_refstring_count.load());
 }
 
 int Xvr_debugGetRefStringCount(void) { return g_refstring_count; }
@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "xvr_runtime.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -38,13 +40,17 @@ char* xvr_string_concat(const char* lhs, const char* rhs) {
     return result;
 }
 
+int xvr_str_len(const char* str) {
+    return str ? (int)strlen(str) : 0;
+}
+
 typedef struct {
     int* data;
     int size;
     int capacity;
 } XvrArrayInt;
 
-XvrArrayInt* xvr_array_create_int() {
+void* xvr_array_create_int(void) {
     XvrArrayInt* arr = (XvrArrayInt*)malloc(sizeof(XvrArrayInt));
     if (!arr) return NULL;
     arr->data = NULL;
@@ -79,6 +85,26 @@ static void xvr_array_help(const char* msg) {
     fprintf(stderr, "%s%s%s%s\n", XVR_CC_NOTICE, "help: ", XVR_CC_RESET, msg);
 }
 
+/* the diagnostics live out of line so the checked accessors stay small
+ * enough to inline into loops when the runtime is linked as bitcode */
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline, cold))
+#endif
+static void xvr_array_index_fail(const char* empty_msg, int index, int size) {
+    if (size == 0) {
+        xvr_array_error(empty_msg);
+        xvr_array_help("array is empty, use insert() to add elements first");
+    } else if (index < 0) {
+        xvr_array_error("array index is negative");
+        xvr_array_help("use a non-negative index (0 or greater)");
+    } else {
+        xvr_array_error_idx(index, size);
+        fprintf(stderr, "%s%s%svalid index range is 0 to %d\n", XVR_CC_NOTICE,
+                "help: ", XVR_CC_RESET, size - 1);
+    }
+    raise(SIGABRT);
+}
+
 int xvr_array_len(void* arr_ptr) {
     XvrArrayInt* arr = (XvrArrayInt*)arr_ptr;
     if (!arr) return 0;
@@ -88,22 +114,9 @@ int xvr_array_len(void* arr_ptr) {
 int xvr_array_get_int(void* arr_ptr, int index) {
     XvrArrayInt* arr = (XvrArrayInt*)arr_ptr;
     if (!arr) return 0;
-    if (arr->size == 0) {
-        xvr_array_error("cannot get from empty array");
-        xvr_array_help("array is empty, use insert() to add elements first");
-        raise(SIGABRT);
-    }
-    if (index < 0) {
-        xvr_array_error("array index is negative");
-        xvr_array_help("use a non-negative index (0 or greater)");
-        raise(SIGABRT);
-    }
-    if (index >= arr->size) {
-        xvr_array_error_idx(index, arr->size);
-        int upper = arr->size - 1;
-        fprintf(stderr, "%s%s%svalid index range is 0 to %d\n", XVR_CC_NOTICE,
-                "help: ", XVR_CC_RESET, upper);
-        raise(SIGABRT);
+    /* one unsigned compare covers the empty, negative and past-the-end cases */
+    if ((unsigned)index >= (unsigned)arr->size) {
+        xvr_array_index_fail("cannot get from empty array", index, arr->size);
     }
     return arr->data[index];
 }
@@ -111,22 +124,8 @@ int xvr_array_get_int(void* arr_ptr, int index) {
 void xvr_array_set_int(void* arr_ptr, int index, int value) {
     XvrArrayInt* arr = (XvrArrayInt*)arr_ptr;
     if (!arr) return;
-    if (arr->size == 0) {
-        xvr_array_error("cannot set in empty array");
-        xvr_array_help("array is empty, use insert() to add elements first");
-        raise(SIGABRT);
-    }
-    if (index < 0) {
-        xvr_array_error("array index is negative");
-        xvr_array_help("use a non-negative index (0 or greater)");
-        raise(SIGABRT);
-    }
-    if (index >= arr->size) {
-        xvr_array_error_idx(index, arr->size);
-        int upper = arr->size - 1;
-        fprintf(stderr, "%s%s%svalid index range is 0 to %d\n", XVR_CC_NOTICE,
-                "help: ", XVR_CC_RESET, upper);
-        raise(SIGABRT);
+    if ((unsigned)index >= (unsigned)arr->size) {
+        xvr_array_index_fail("cannot set in empty array", index, arr->size);
     }
     arr->data[index] = value;
 }
@@ -0,0 +1,52 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @brief runtime support functions called from generated code
+ *
+ * these symbols are referenced by name from emitted IR, either linked from
+ * libxvr.a into native executables or bound directly into the JIT session
+ */
+
+#ifndef XVR_RUNTIME_H
+#define XVR_RUNTIME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+char* xvr_string_concat(const char* lhs, const char* rhs);
+int xvr_str_len(const char* str);
+
+void* xvr_array_create_int(void);
+void xvr_array_insert_int(void* arr_ptr, int value);
+int xvr_array_len(void* arr_ptr);
+int xvr_array_get_int(void* arr_ptr, int index);
+void xvr_array_set_int(void* arr_ptr, int index, int value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !XVR_RUNTIME_H
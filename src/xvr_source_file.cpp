@@ -0,0 +1,167 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_source_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static size_t pageSize(void) {
+    static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return page;
+}
+
+// whole pages covering the source and the NUL after it
+static size_t mappingLength(size_t size) {
+    const size_t page = pageSize();
+    return (size + page) / page * page;
+}
+
+static char* reserve(size_t size) {
+    void* base = mmap(NULL, mappingLength(size), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return base == MAP_FAILED ? NULL : (char*)base;
+}
+
+static const char* mapRegular(int fd, size_t size) {
+    // the tail of the file's last page reads as zero, and when the file
+    // fills it exactly the spare reserved page does
+    void* base = mmap(NULL, mappingLength(size), PROT_READ,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    if (mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) ==
+        MAP_FAILED) {
+        munmap(base, mappingLength(size));
+        return NULL;
+    }
+
+    madvise(base, size, MADV_SEQUENTIAL);
+    return (const char*)base;
+}
+
+static const char* readStream(int fd, size_t* size) {
+    size_t capacity = 4096;
+    size_t count = 0;
+    char* buffer = (char*)malloc(capacity);
+
+    while (buffer != NULL) {
+        if (count == capacity) {
+            capacity *= 2;
+            char* grown = (char*)realloc(buffer, capacity);
+            if (grown == NULL) {
+                break;
+            }
+            buffer = grown;
+        }
+
+        const ssize_t got = read(fd, buffer + count, capacity - count);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0) {
+            break;
+        }
+        if (got == 0) {
+            // handed out like a mapping so both are released the same way
+            char* source = reserve(count);
+            if (source != NULL) {
+                memcpy(source, buffer, count);
+                mprotect(source, mappingLength(count), PROT_READ);
+                *size = count;
+            }
+            free(buffer);
+            return source;
+        }
+        count += (size_t)got;
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+const char* Xvr_mapSourceFile(const char* path, size_t* size) {
+    const bool isStdin = strcmp(path, "-") == 0;
+    const int fd = isStdin ? STDIN_FILENO : open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    const char* source = NULL;
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+        if (S_ISREG(st.st_mode) && st.st_size > 0) {
+            source = mapRegular(fd, (size_t)st.st_size);
+            if (source != NULL) {
+                *size = (size_t)st.st_size;
+            }
+        } else if (!S_ISDIR(st.st_mode)) {
+            source = readStream(fd, size);
+        }
+    }
+
+    if (!isStdin) {
+        close(fd);
+    }
+    return source;
+}
+
+void Xvr_unmapSourceFile(const char* source, size_t size) {
+    if (source != NULL) {
+        munmap((void*)source, mappingLength(size));
+    }
+}
+
+const char* Xvr_readSourceFile(const char* path, size_t* size) {
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    const char* source = readStream(fd, size);
+    close(fd);
+    return source;
+}
+
+char* Xvr_sourceFileStem(const char* path) {
+    const char* slash = strrchr(path, '/');
+    const char* base = slash != NULL ? slash + 1 : path;
+    size_t length = strlen(base);
+    if (length > 4 && strcmp(base + length - 4, ".xvr") == 0) {
+        length -= 4;
+    }
+
+    char* stem = (char*)malloc(length + 1);
+    if (stem != NULL) {
+        memcpy(stem, base, length);
+        stem[length] = '\0';
+    }
+    return stem;
+}
@@ -0,0 +1,85 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @brief zero-copy source loading
+ *
+ * a regular file is mapped read-only with MADV_SEQUENTIAL instead of being
+ * copied into the heap; the mapping is laid over a zero-filled reservation
+ * one byte longer than the file, so the byte after the source is always NUL
+ * and the lexer can read it as a C string without a copy
+ *
+ * pipes, stdin (`-`) and files that report no size, like those under /proc,
+ * are read instead and handed out the same way
+ *
+ * @note a mapped file that is truncated while it is still mapped faults on
+ * access, so anything that reads files while they are being edited should
+ * copy them instead
+ */
+
+#ifndef XVR_SOURCE_FILE_H
+#define XVR_SOURCE_FILE_H
+
+#include <stddef.h>
+
+#include "xvr_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief loads the source at `path`, `-` reads stdin
+ *
+ * @return NUL-terminated source of `*size` bytes, NULL when it can't be read
+ */
+XVR_API const char* Xvr_mapSourceFile(const char* path, size_t* size);
+
+/**
+ * @brief releases a source returned by Xvr_mapSourceFile, NULL is ignored
+ */
+XVR_API void Xvr_unmapSourceFile(const char* source, size_t size);
+
+/**
+ * @brief copies the file at `path` instead of mapping it, for files that
+ * may be rewritten while they are read; released with Xvr_unmapSourceFile
+ *
+ * @return NUL-terminated contents of `*size` bytes, NULL when it can't be
+ * read
+ */
+XVR_API const char* Xvr_readSourceFile(const char* path, size_t* size);
+
+/**
+ * @brief the file name of `path` without its directory and `.xvr`, which
+ * names the module compiled from it
+ *
+ * @return malloc'd name, NULL when out of memory
+ */
+XVR_API char* Xvr_sourceFileStem(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !XVR_SOURCE_FILE_H
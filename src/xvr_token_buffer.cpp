@@ -0,0 +1,187 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xvr_token_buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xvr_token_types.h"
+
+static_assert(XVR_TOKEN_EOF <= UINT8_MAX, "token types are stored in a byte");
+
+static bool grow(void** array, size_t element, int capacity) {
+    void* grown = realloc(*array, element * capacity);
+    if (!grown) {
+        return false;
+    }
+    *array = grown;
+    return true;
+}
+
+static bool reserveTokens(Xvr_TokenBuffer* buffer) {
+    if (buffer->count < buffer->capacity) {
+        return true;
+    }
+
+    const int capacity = buffer->capacity < 256 ? 256 : buffer->capacity * 2;
+    if (!grow((void**)&buffer->types, sizeof(uint8_t), capacity) ||
+        !grow((void**)&buffer->offsets, sizeof(uint32_t), capacity) ||
+        !grow((void**)&buffer->lengths, sizeof(uint32_t), capacity)) {
+        return false;
+    }
+    buffer->capacity = capacity;
+    return true;
+}
+
+static bool pushError(Xvr_TokenBuffer* buffer, Xvr_Token token) {
+    if (buffer->error_count == buffer->error_capacity) {
+        const int capacity =
+            buffer->error_capacity < 8 ? 8 : buffer->error_capacity * 2;
+        if (!grow((void**)&buffer->errors, sizeof(Xvr_TokenError), capacity)) {
+            return false;
+        }
+        buffer->error_capacity = capacity;
+    }
+
+    // the lexer reuses its message storage for the next error, keep a copy
+    char* message = (char*)malloc(token.length + 1);
+    if (!message) {
+        return false;
+    }
+    memcpy(message, token.lexeme, token.length);
+    message[token.length] = '\0';
+
+    buffer->errors[buffer->error_count].token = buffer->count;
+    buffer->errors[buffer->error_count].message = message;
+    buffer->error_count++;
+    return true;
+}
+
+static void clearErrors(Xvr_TokenBuffer* buffer) {
+    for (int i = 0; i < buffer->error_count; i++) {
+        free(buffer->errors[i].message);
+    }
+    buffer->error_count = 0;
+}
+
+Xvr_TokenBuffer* Xvr_TokenBufferCreate(void) {
+    return (Xvr_TokenBuffer*)calloc(1, sizeof(Xvr_TokenBuffer));
+}
+
+void Xvr_TokenBufferDestroy(Xvr_TokenBuffer* buffer) {
+    if (!buffer) {
+        return;
+    }
+
+    clearErrors(buffer);
+    free(buffer->types);
+    free(buffer->offsets);
+    free(buffer->lengths);
+    Xvr_freeLineIndex(&buffer->lines);
+    free(buffer->errors);
+    free(buffer);
+}
+
+bool Xvr_TokenBufferFill(Xvr_TokenBuffer* buffer, Xvr_Lexer* lexer) {
+    clearErrors(buffer);
+    buffer->source = lexer->source;
+    buffer->count = 0;
+
+    if (!Xvr_buildLineIndex(&buffer->lines, lexer->source, lexer->length)) {
+        return false;
+    }
+
+    for (;;) {
+        Xvr_Token token = Xvr_private_scanLexer(lexer);
+
+        if (!reserveTokens(buffer)) {
+            break;
+        }
+        if (token.type == XVR_TOKEN_ERROR && !pushError(buffer, token)) {
+            break;
+        }
+
+        buffer->types[buffer->count] = (uint8_t)token.type;
+        buffer->offsets[buffer->count] = (uint32_t)token.offset;
+        buffer->lengths[buffer->count] = (uint32_t)token.length;
+        buffer->count++;
+
+        if (token.type == XVR_TOKEN_EOF) {
+            return true;
+        }
+    }
+
+    clearErrors(buffer);
+    buffer->count = 0;
+    return false;
+}
+
+Xvr_SourceLocation Xvr_TokenBufferLocate(const Xvr_TokenBuffer* buffer,
+                                         int offset) {
+    return Xvr_resolveLineIndex(&buffer->lines, offset);
+}
+
+static const char* errorMessage(const Xvr_TokenBuffer* buffer, int index) {
+    int low = 0;
+    int high = buffer->error_count - 1;
+    while (low < high) {
+        const int mid = low + (high - low) / 2;
+        if (buffer->errors[mid].token < index) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return buffer->errors[low].message;
+}
+
+Xvr_Token Xvr_TokenBufferGet(const Xvr_TokenBuffer* buffer, int index) {
+    Xvr_Token token;
+
+    if (buffer->count == 0) {
+        token.type = XVR_TOKEN_EOF;
+        token.lexeme = buffer->source ? buffer->source : "";
+        token.length = 0;
+        token.offset = 0;
+        return token;
+    }
+
+    if (index >= buffer->count) {
+        index = buffer->count - 1;
+    }
+
+    token.type = (Xvr_TokenType)buffer->types[index];
+    token.length = (int)buffer->lengths[index];
+    token.offset = (int)buffer->offsets[index];
+    if (token.type == XVR_TOKEN_ERROR) {
+        token.lexeme = errorMessage(buffer, index);
+    } else if (token.type == XVR_TOKEN_LITERAL_STRING) {
+        // offset is the opening quote, the lexeme is the body after it
+        token.lexeme = buffer->source + token.offset + 1;
+    } else {
+        token.lexeme = buffer->source + token.offset;
+    }
+    return token;
+}
@@ -0,0 +1,109 @@
+/**
+MIT License
+
+Copyright (c) 2025 arfy slowy
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @brief a whole source lexed once into a structure-of-arrays token stream
+ *
+ * the parser reads tokens from it by index, so looking ahead or going back
+ * is an array access instead of a rescan
+ *
+ * layout, per token:
+ *   - types: one byte of Xvr_TokenType
+ *   - offsets: 32-bit offset of the lexeme in `source`
+ *   - lengths: 32-bit length of the lexeme
+ *
+ * filling also indexes the source's newlines, so a diagnostic can resolve
+ * any token's line and column; error tokens keep their message in a side
+ * table since it is not in `source`
+ *
+ * memory management:
+ *   - the buffer borrows `source`, which must outlive the tokens
+ *   - refilling keeps every array's capacity, so a buffer reused across
+ *     compilations stops allocating once it has seen its largest source
+ */
+
+#ifndef XVR_TOKEN_BUFFER_H
+#define XVR_TOKEN_BUFFER_H
+
+#include <stdint.h>
+
+#include "xvr_common.h"
+#include "xvr_lexer.h"
+#include "xvr_line_index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int token;      // index of the XVR_TOKEN_ERROR token
+    char* message;  // owned copy of its lexeme
+} Xvr_TokenError;
+
+typedef struct Xvr_TokenBuffer {
+    const char* source;
+
+    uint8_t* types;
+    uint32_t* offsets;
+    uint32_t* lengths;
+    int count;  // tokens, the last one is always XVR_TOKEN_EOF
+    int capacity;
+
+    Xvr_LineIndex lines;
+
+    Xvr_TokenError* errors;
+    int error_count;
+    int error_capacity;
+} Xvr_TokenBuffer;
+
+XVR_API Xvr_TokenBuffer* Xvr_TokenBufferCreate(void);
+
+XVR_API void Xvr_TokenBufferDestroy(Xvr_TokenBuffer* buffer);
+
+/**
+ * @brief lexes everything left in `lexer` into `buffer`, replacing what it
+ * held
+ *
+ * @return false when out of memory, the buffer is then empty
+ */
+XVR_API bool Xvr_TokenBufferFill(Xvr_TokenBuffer* buffer, Xvr_Lexer* lexer);
+
+/**
+ * @brief the token at `index` as the lexer returned it, an index past the
+ * end gives the final XVR_TOKEN_EOF
+ */
+XVR_API Xvr_Token Xvr_TokenBufferGet(const Xvr_TokenBuffer* buffer,
+                                     int index);
+
+/**
+ * @brief line and column of the byte at `offset` in the buffered source
+ */
+XVR_API Xvr_SourceLocation Xvr_TokenBufferLocate(const Xvr_TokenBuffer* buffer,
+                                                 int offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !XVR_TOKEN_BUFFER_H
@@ -1,6 +1,7 @@
 #include "xvr_unused.h"
 
 #include <cstdio>
+#include <cstring>
 
 #include "xvr_console_colors.h"
 #include "xvr_literal.h"
@@ -32,12 +33,24 @@ static void popScope(Xvr_UnusedChecker* checker) {
                 scope->declarations[i].identifier.as.identifier.ptr);
             const char* kind =
                 scope->declarations[i].isFunction ? "procedure" : "variable";
-            int line = scope->declarations[i].line;
 
             fprintf(stderr, "\n");
             fprintf(stderr, "%serror%s: unused %s '%s'\n", XVR_CC_FONT_RED,
                     XVR_CC_RESET, kind, name);
-            fprintf(stderr, "  --> line %d\n", line);
+            if (checker->source) {
+                // the first report pays for the newline index
+                if (checker->lines.newlines == NULL &&
+                    !Xvr_buildLineIndex(&checker->lines, checker->source,
+                                        (int)strlen(checker->source))) {
+                    checker->source = NULL;
+                }
+            }
+            if (checker->source) {
+                Xvr_SourceLocation location = Xvr_resolveLineIndex(
+                    &checker->lines, scope->declarations[i].offset);
+                fprintf(stderr, "  --> line %d, column %d\n", location.line,
+                        location.column);
+            }
             fprintf(stderr, "%shelp%s: %s '%s' is declared but never used\n",
                     XVR_CC_NOTICE, XVR_CC_RESET, kind, name);
 
@@ -60,7 +73,7 @@ static void popScope(Xvr_UnusedChecker* checker) {
 }
 
 static void addDeclaration(Xvr_UnusedChecker* checker, Xvr_Literal identifier,
-                           int line, bool isFunction) {
+                           int offset, bool isFunction) {
     if (checker->scopeCount <= 0) return;
 
     Xvr_UnusedScope* scope = &checker->scopes[checker->scopeCount - 1];
@@ -75,7 +88,7 @@ static void addDeclaration(Xvr_UnusedChecker* checker, Xvr_Literal identifier,
     Xvr_UnusedDecl* decl = &scope->declarations[scope->count++];
     decl->identifier = identifier;
     Xvr_copyRefString(identifier.as.identifier.ptr);
-    decl->line = line;
+    decl->offset = offset;
     decl->used = false;
     decl->isFunction = isFunction;
 }
@@ -163,12 +176,12 @@ static void checkNode(Xvr_UnusedChecker* checker, Xvr_ASTNode* node) {
 
     case XVR_AST_NODE_VAR_DECL: {
         checkNode(checker, node->varDecl.expression);
-        addDeclaration(checker, node->varDecl.identifier, node->varDecl.line,
+        addDeclaration(checker, node->varDecl.identifier, node->varDecl.offset,
                        false);
     } break;
 
     case XVR_AST_NODE_FN_DECL: {
-        addDeclaration(checker, node->fnDecl.identifier, node->fnDecl.line,
+        addDeclaration(checker, node->fnDecl.identifier, node->fnDecl.offset,
                        true);
 
         pushScope(checker);
@@ -180,7 +193,7 @@ static void checkNode(Xvr_UnusedChecker* checker, Xvr_ASTNode* node) {
                     &node->fnDecl.arguments->fnCollection.nodes[i];
                 if (arg->type == XVR_AST_NODE_VAR_DECL) {
                     addDeclaration(checker, arg->varDecl.identifier,
-                                   arg->varDecl.line, false);
+                                   arg->varDecl.offset, false);
                 }
             }
         }
@@ -279,6 +292,14 @@ void Xvr_initUnusedChecker(Xvr_UnusedChecker* checker) {
     checker->scopeCount = 0;
     checker->scopeCapacity = 0;
     checker->hasError = false;
+    checker->source = NULL;
+    memset(&checker->lines, 0, sizeof(checker->lines));
+}
+
+void Xvr_initUnusedCheckerWithSource(Xvr_UnusedChecker* checker,
+                                     const char* source) {
+    Xvr_initUnusedChecker(checker);
+    checker->source = source;
 }
 
 void Xvr_freeUnusedChecker(Xvr_UnusedChecker* checker) {
@@ -289,6 +310,7 @@ void Xvr_freeUnusedChecker(Xvr_UnusedChecker* checker) {
     checker->scopes = NULL;
     checker->scopeCount = 0;
     checker->scopeCapacity = 0;
+    Xvr_freeLineIndex(&checker->lines);
 }
 
 void Xvr_checkUnusedBegin(Xvr_UnusedChecker* checker) { pushScope(checker); }
@@ -33,6 +33,7 @@ extern "C" {
 
 #include "xvr_ast_node.h"
 #include "xvr_common.h"
+#include "xvr_line_index.h"
 
 /**
  * @struct Xvr_UnusedDecl
@@ -41,8 +42,8 @@ extern "C" {
  * @var Xvr_UnusedDecl::identifier
  * The name of the declared variable or procedure.
  *
- * @var Xvr_UnusedDecl::line
- * The line number where the declaration appears (1-indexed).
+ * @var Xvr_UnusedDecl::offset
+ * The byte offset in the source where the declared name appears.
  *
  * @var Xvr_UnusedDecl::used
  * Set to true if the declaration is referenced anywhere in the code.
@@ -52,7 +53,7 @@ extern "C" {
  */
 typedef struct Xvr_UnusedDecl {
     Xvr_Literal identifier;
-    int line;
+    int offset;
     bool used;
     bool isFunction;
 } Xvr_UnusedDecl;
@@ -95,12 +96,20 @@ typedef struct Xvr_UnusedScope {
  *
  * @var Xvr_UnusedChecker::hasError
  * Set to true if any unused declaration was found.
+ *
+ * @var Xvr_UnusedChecker::source
+ * The checked source, NULL when reports go without a position.
+ *
+ * @var Xvr_UnusedChecker::lines
+ * Newline index of the source, built at the first report.
  */
 typedef struct Xvr_UnusedChecker {
     Xvr_UnusedScope* scopes;
     int scopeCount;
     int scopeCapacity;
     bool hasError;
+    const char* source;
+    Xvr_LineIndex lines;
 } Xvr_UnusedChecker;
 
 /**
@@ -112,6 +121,16 @@ typedef struct Xvr_UnusedChecker {
  */
 XVR_API void Xvr_initUnusedChecker(Xvr_UnusedChecker* checker);
 
+/**
+ * @brief Initializes a checker that reports the line and column of each
+ * unused declaration in `source`.
+ *
+ * @param checker Pointer to the checker structure to initialize.
+ * @param source The source the checked nodes were parsed from.
+ */
+XVR_API void Xvr_initUnusedCheckerWithSource(Xvr_UnusedChecker* checker,
+                                             const char* source);
+
 /**
  * @brief Frees all memory associated with an unused checker.
  *
@@ -148,7 +167,8 @@ XVR_API void Xvr_checkUnusedNode(Xvr_UnusedChecker* checker, Xvr_ASTNode* node);
  *
  * Pops the current scope and reports all unused declarations within it
  * to stderr. Prints error messages in format:
- * "error: unused [variable|procedure] 'name' declared at line N"
+ * "error: unused [variable|procedure] 'name'", followed by its line and
+ * column when the checker has the source
  *
  * @param checker Pointer to the active checker.
  * @return true if no unused declarations were found, false otherwise.
@@ -1,6 +1,15 @@
 #include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "xvr_keyword_types.h"
 #include "xvr_lexer.h"
+#include "xvr_lexer_scan.h"
+#include "xvr_line_index.h"
+#include "xvr_source_file.h"
 
 TEST_CASE("Lexer basic semicolon tokenization", "[lexer][unit]") {
     const char* source = "var null;";
@@ -78,3 +87,358 @@ TEST_CASE("Lexer mixed statements with semicolons", "[lexer][unit]") {
 
     REQUIRE(semi_count == 1);
 }
+
+namespace {
+
+struct LexedToken {
+    int type;
+    long lexeme;  // -1 for error tokens, their text is not in the source
+    int length;
+    int offset;
+
+    bool operator==(const LexedToken&) const = default;
+};
+
+std::vector<LexedToken> lexAll(const std::string& source) {
+    Xvr_Lexer lexer;
+    Xvr_initLexer(&lexer, source.c_str());
+
+    std::vector<LexedToken> tokens;
+    for (;;) {
+        Xvr_Token tok = Xvr_private_scanLexer(&lexer);
+        long lexeme = tok.type == XVR_TOKEN_ERROR
+                          ? -1
+                          : (long)(tok.lexeme - source.c_str());
+        tokens.push_back({tok.type, lexeme, tok.length, tok.offset});
+        if (tok.type == XVR_TOKEN_EOF || tokens.size() > source.size() + 1) {
+            return tokens;
+        }
+    }
+}
+
+/* long runs of every scanned class, so chunks end inside and at the edge of
+ * each of them */
+std::string generateSource(size_t bytes) {
+    static const char* const pieces[] = {
+        "var counter_with_a_rather_long_name_0123456789 = 1_000_000;\n",
+        "  \t \r\n\n        \n\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t x",
+        "// a line comment that is longer than one vector ** \"\\ /*\n",
+        "/* a block * comment\n with ** stars and \n newlines *\n**/",
+        "\"a string with \\\" escapes \\n and\n a newline and \\ \"",
+        "3.14159_26535f64 + 12345678901234567890123456789012i64;",
+        "proc f(a: int32) { return a * 2 / 3 - 4 % 5; }\n",
+        "identifiers_that_cross_the_thirty_two_byte_boundary_x;",
+        "a;b;c;",
+        "\xc3\xa9",  // bytes above 0x7f end every run
+    };
+    const size_t count = sizeof(pieces) / sizeof(pieces[0]);
+
+    std::string source;
+    unsigned int seed = 12345;
+    while (source.size() < bytes) {
+        seed = seed * 1103515245u + 12345u;
+        source += pieces[(seed >> 16) % count];
+        source.append((seed >> 8) % 5, ' ');
+    }
+    return source;
+}
+
+}  // namespace
+
+TEST_CASE("Lexer vector kernels match the scalar scan", "[lexer][unit]") {
+    const Xvr_LexerScanLevel supported = Xvr_private_lexerScanLevel();
+    const std::string source = generateSource(4096);
+
+    Xvr_private_setLexerScanLevel(XVR_LEXER_SCAN_SCALAR);
+    std::vector<std::vector<LexedToken>> expected;
+    for (size_t length = 0; length <= 600; length++) {
+        expected.push_back(lexAll(source.substr(0, length)));
+    }
+    std::vector<LexedToken> expected_all = lexAll(source);
+
+    REQUIRE(expected_all.size() > 100);
+    REQUIRE(expected_all.back().type == XVR_TOKEN_EOF);
+    REQUIRE(expected_all.back().offset == (int)source.size());
+
+    for (int level = XVR_LEXER_SCAN_SSE42; level <= supported; level++) {
+        REQUIRE(Xvr_private_setLexerScanLevel((Xvr_LexerScanLevel)level) ==
+                level);
+
+        // every prefix ends the source at a different offset in a vector
+        for (size_t length = 0; length <= 600; length++) {
+            INFO("level " << level << ", prefix " << length);
+            REQUIRE(lexAll(source.substr(0, length)) == expected[length]);
+        }
+        REQUIRE(lexAll(source) == expected_all);
+    }
+
+    Xvr_private_setLexerScanLevel(supported);
+    REQUIRE(Xvr_private_lexerScanLevel() == supported);
+}
+
+TEST_CASE("Lexer block comments stop at the end", "[lexer][unit]") {
+    const char* source = "/* one\n two * three\n */ x /* unterminated\n";
+    Xvr_Lexer lexer;
+    Xvr_initLexer(&lexer, source);
+
+    Xvr_Token x = Xvr_private_scanLexer(&lexer);
+    Xvr_Token eof = Xvr_private_scanLexer(&lexer);
+
+    REQUIRE(x.type == XVR_TOKEN_IDENTIFIER);
+    REQUIRE(x.offset == 24);
+    REQUIRE(eof.type == XVR_TOKEN_EOF);
+    REQUIRE(eof.offset == (int)strlen(source));
+}
+
+TEST_CASE("Line index resolves offsets to lines and columns",
+          "[lexer][unit]") {
+    const Xvr_LexerScanLevel supported = Xvr_private_lexerScanLevel();
+    const std::string source = generateSource(4096);
+
+    std::vector<int> expected;
+    for (size_t i = 0; i < source.size(); i++) {
+        if (source[i] == '\n') {
+            expected.push_back((int)i);
+        }
+    }
+    REQUIRE(expected.size() > 50);
+
+    // every level finds the same newlines, counting or writing them out
+    for (int level = XVR_LEXER_SCAN_SCALAR; level <= supported; level++) {
+        Xvr_private_setLexerScanLevel((Xvr_LexerScanLevel)level);
+        for (int length : {0, 1, 31, 32, 33, 100, (int)source.size()}) {
+            INFO("level " << level << ", length " << length);
+            std::vector<int> offsets(source.size());
+            int count = Xvr_private_lexerIndexNewlines(source.c_str(), length,
+                                                       offsets.data());
+            offsets.resize(count);
+
+            std::vector<int> want;
+            for (int offset : expected) {
+                if (offset < length) want.push_back(offset);
+            }
+            REQUIRE(offsets == want);
+            REQUIRE(Xvr_private_lexerIndexNewlines(source.c_str(), length,
+                                                   NULL) == count);
+        }
+    }
+    Xvr_private_setLexerScanLevel(supported);
+
+    Xvr_LineIndex index;
+    memset(&index, 0, sizeof(index));
+    const char* text = "ab\n\ncd\n";
+    REQUIRE(Xvr_buildLineIndex(&index, text, (int)strlen(text)));
+    REQUIRE(index.count == 3);
+
+    const int offsets[] = {0, 1, 2, 3, 4, 5, 6, 7};
+    const Xvr_SourceLocation want[] = {{1, 1}, {1, 2}, {1, 3}, {2, 1},
+                                       {3, 1}, {3, 2}, {3, 3}, {4, 1}};
+    for (int i = 0; i < 8; i++) {
+        Xvr_SourceLocation got = Xvr_resolveLineIndex(&index, offsets[i]);
+        INFO("offset " << offsets[i]);
+        REQUIRE(got.line == want[i].line);
+        REQUIRE(got.column == want[i].column);
+
+        got = Xvr_resolveSourceOffset(text, offsets[i]);
+        REQUIRE(got.line == want[i].line);
+        REQUIRE(got.column == want[i].column);
+    }
+
+    // rebuilding a smaller source keeps the allocation
+    const int* newlines = index.newlines;
+    REQUIRE(Xvr_buildLineIndex(&index, "x\ny", 3));
+    REQUIRE(index.count == 1);
+    REQUIRE(index.newlines == newlines);
+    Xvr_freeLineIndex(&index);
+}
+
+TEST_CASE("Mapped sources end in a NUL without a copy", "[lexer][unit]") {
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    char path[] = "/tmp/xvr_source_XXXXXX";
+    const int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+
+    // a file filling its pages exactly leaves no zeroed tail to end on
+    for (size_t length : {page, page + 11, (size_t)7}) {
+        std::string text(length, 'a');
+        text.replace(length - 4, 4, "; x;");
+        REQUIRE(ftruncate(fd, 0) == 0);
+        REQUIRE(pwrite(fd, text.data(), length, 0) == (ssize_t)length);
+
+        size_t size = 0;
+        const char* source = Xvr_mapSourceFile(path, &size);
+        REQUIRE(source != nullptr);
+        REQUIRE(size == length);
+        REQUIRE(std::string(source, size) == text);
+        REQUIRE(source[size] == '\0');
+
+        Xvr_Lexer lexer;
+        Xvr_initLexer(&lexer, source);
+        REQUIRE(Xvr_private_scanLexer(&lexer).type == XVR_TOKEN_IDENTIFIER);
+        REQUIRE(Xvr_private_scanLexer(&lexer).type == XVR_TOKEN_SEMICOLON);
+        Xvr_Token x = Xvr_private_scanLexer(&lexer);
+        REQUIRE(x.offset == (int)length - 2);
+        Xvr_unmapSourceFile(source, size);
+    }
+    close(fd);
+    unlink(path);
+
+    // pipes are read instead
+    int ends[2];
+    REQUIRE(pipe(ends) == 0);
+    REQUIRE(write(ends[1], "var a;", 6) == 6);
+    close(ends[1]);
+    const std::string piped = "/dev/fd/" + std::to_string(ends[0]);
+    size_t size = 0;
+    const char* source = Xvr_mapSourceFile(piped.c_str(), &size);
+    REQUIRE(source != nullptr);
+    REQUIRE(std::string(source, size + 1) == std::string("var a;", 7));
+    Xvr_unmapSourceFile(source, size);
+    close(ends[0]);
+
+    REQUIRE(Xvr_mapSourceFile("/tmp/xvr_source_missing.xvr", &size) ==
+            nullptr);
+}
+
+TEST_CASE("Keyword lookup matches whole words only", "[lexer][unit]") {
+    for (int i = 0; Xvr_keywordTypes[i].keyword; i++) {
+        const char* keyword = Xvr_keywordTypes[i].keyword;
+        INFO(keyword);
+        REQUIRE(Xvr_findTypeByKeyword(keyword) == Xvr_keywordTypes[i].type);
+
+        // a prefix or an extension of a keyword is an identifier
+        const std::string word = keyword;
+        for (size_t length = 1; length < word.size(); length++) {
+            Xvr_TokenType type =
+                Xvr_findTypeByKeywordLength(word.c_str(), (int)length);
+            if (type != XVR_TOKEN_IDENTIFIER) {
+                REQUIRE(Xvr_findKeywordByType(type) == word.substr(0, length));
+            }
+        }
+        REQUIRE(Xvr_findTypeByKeyword((word + "x").c_str()) ==
+                XVR_TOKEN_IDENTIFIER);
+    }
+
+    REQUIRE(Xvr_findTypeByKeyword("i") == XVR_TOKEN_IDENTIFIER);
+    REQUIRE(Xvr_findTypeByKeyword("in") == XVR_TOKEN_IN);
+    REQUIRE(Xvr_findTypeByKeyword("int") == XVR_TOKEN_INTEGER);
+    REQUIRE(Xvr_findTypeByKeyword("int6") == XVR_TOKEN_IDENTIFIER);
+    REQUIRE(Xvr_findTypeByKeyword("") == XVR_TOKEN_IDENTIFIER);
+    REQUIRE(Xvr_findTypeByKeyword(NULL) == XVR_TOKEN_EOF);
+    REQUIRE(Xvr_findTypeByKeywordLength("typeof(x)", 6) == XVR_TOKEN_TYPEOF);
+
+    const char* source = "true type typeof trueish _ print32";
+    Xvr_Lexer lexer;
+    Xvr_initLexer(&lexer, source);
+
+    REQUIRE(Xvr_private_scanLexer(&lexer).type == XVR_TOKEN_LITERAL_TRUE);
+    REQUIRE(Xvr_private_scanLexer(&lexer).type == XVR_TOKEN_TYPE);
+    REQUIRE(Xvr_private_scanLexer(&lexer).type == XVR_TOKEN_TYPEOF);
+    REQUIRE(Xvr_private_scanLexer(&lexer).type == XVR_TOKEN_IDENTIFIER);
+    REQUIRE(Xvr_private_scanLexer(&lexer).type == XVR_TOKEN_IDENTIFIER);
+    REQUIRE(Xvr_private_scanLexer(&lexer).type == XVR_TOKEN_IDENTIFIER);
+    REQUIRE(Xvr_private_scanLexer(&lexer).type == XVR_TOKEN_EOF);
+}
+
+TEST_CASE("Keyword lookup throughput", "[.][lexer][benchmark]") {
+    // identifier-heavy source: keywords, near misses and plain names
+    static const char* const words[] = {
+        "var",    "value", "proc",    "process", "int32",  "int",
+        "in",     "index", "return",  "result",  "typeof", "type",
+        "string", "str",   "foreach", "for",     "x",      "counter_total",
+    };
+    const size_t count = sizeof(words) / sizeof(words[0]);
+
+    std::string source;
+    unsigned int seed = 12345;
+    while (source.size() < 16 * 1024 * 1024) {
+        seed = seed * 1103515245u + 12345u;
+        source += words[(seed >> 16) % count];
+        source += ' ';
+    }
+
+    std::vector<std::pair<const char*, int>> identifiers;
+    {
+        Xvr_Lexer lexer;
+        Xvr_initLexer(&lexer, source.c_str());
+        Xvr_Token tok;
+        while ((tok = Xvr_private_scanLexer(&lexer)).type != XVR_TOKEN_EOF) {
+            identifiers.push_back({tok.lexeme, tok.length});
+        }
+    }
+
+    // the lookup the lexer used before: every entry, strlen then strncmp
+    auto linear = [](const char* text, int length) {
+        for (int i = 0; Xvr_keywordTypes[i].keyword; i++) {
+            const char* keyword = Xvr_keywordTypes[i].keyword;
+            if (strlen(keyword) == (size_t)length &&
+                !strncmp(keyword, text, length)) {
+                return Xvr_keywordTypes[i].type;
+            }
+        }
+        return XVR_TOKEN_IDENTIFIER;
+    };
+
+    for (int pass = 0; pass < 2; pass++) {
+        auto start = std::chrono::steady_clock::now();
+        long keywords = 0;
+        for (const auto& [text, length] : identifiers) {
+            Xvr_TokenType type = pass == 0
+                                     ? linear(text, length)
+                                     : Xvr_findTypeByKeywordLength(text, length);
+            keywords += type != XVR_TOKEN_IDENTIFIER;
+        }
+        std::chrono::duration<double> took =
+            std::chrono::steady_clock::now() - start;
+
+        std::printf("keywords %-7s %6.1f ns/lookup (%ld of %zu are keywords)\n",
+                    pass == 0 ? "linear" : "hashed",
+                    took.count() * 1e9 / identifiers.size(), keywords,
+                    identifiers.size());
+    }
+
+    Xvr_Lexer lexer;
+    Xvr_initLexer(&lexer, source.c_str());
+    auto start = std::chrono::steady_clock::now();
+    while (Xvr_private_scanLexer(&lexer).type != XVR_TOKEN_EOF);
+    std::chrono::duration<double> took =
+        std::chrono::steady_clock::now() - start;
+
+    std::printf("lexer identifiers %8.1f MB/s\n",
+                source.size() / took.count() / (1024 * 1024));
+}
+
+TEST_CASE("Lexer throughput", "[.][lexer][benchmark]") {
+    static const char* const names[] = {"scalar", "sse4.2", "avx2"};
+    const Xvr_LexerScanLevel supported = Xvr_private_lexerScanLevel();
+    const std::string source = generateSource(32 * 1024 * 1024);
+
+    for (int level = XVR_LEXER_SCAN_SCALAR; level <= supported; level++) {
+        Xvr_private_setLexerScanLevel((Xvr_LexerScanLevel)level);
+
+        double best = 0;
+        size_t tokens = 0;
+        for (int run = 0; run < 3; run++) {
+            Xvr_Lexer lexer;
+            Xvr_initLexer(&lexer, source.c_str());
+
+            auto start = std::chrono::steady_clock::now();
+            tokens = 0;
+            while (Xvr_private_scanLexer(&lexer).type != XVR_TOKEN_EOF) {
+                tokens++;
+            }
+            std::chrono::duration<double> took =
+                std::chrono::steady_clock::now() - start;
+
+            double mb_per_s = source.size() / took.count() / (1024 * 1024);
+            if (mb_per_s > best) {
+                best = mb_per_s;
+            }
+        }
+
+        std::printf("lexer %-7s %8.1f MB/s (%zu tokens, %zu MB)\n",
+                    names[level], best, tokens, source.size() >> 20);
+    }
+
+    Xvr_private_setLexerScanLevel(supported);
+}
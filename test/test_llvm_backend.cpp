@@ -1,16 +1,80 @@
 #include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <llvm-c/BitWriter.h>
+
 #include "xvr_lexer.h"
 #include "xvr_parser.h"
 #include "xvr_ast_node.h"
+#include "xvr_compiler_session.h"
+#include "adapters/llvm/xvr_llvm_build_cache.h"
 #include "adapters/llvm/xvr_llvm_codegen.h"
 #include "adapters/llvm/xvr_llvm_context.h"
 #include "adapters/llvm/xvr_llvm_expression_emitter.h"
 #include "adapters/llvm/xvr_llvm_function_emitter.h"
 #include "adapters/llvm/xvr_llvm_ir_builder.h"
+#include "adapters/llvm/xvr_llvm_linker.h"
 #include "adapters/llvm/xvr_llvm_module_manager.h"
+#include "adapters/llvm/xvr_llvm_object_cache.h"
 #include "adapters/llvm/xvr_llvm_optimizer.h"
+#include "adapters/llvm/xvr_llvm_precompiled.h"
+#include "adapters/llvm/xvr_llvm_repl.h"
+#include "adapters/llvm/xvr_llvm_source_build.h"
+#include "adapters/llvm/xvr_llvm_thin_build.h"
 #include "adapters/llvm/xvr_llvm_target.h"
+#include "adapters/llvm/xvr_llvm_thinlto.h"
 #include "adapters/llvm/xvr_llvm_type_mapper.h"
+#include "sema/xvr_decl_fingerprint.h"
+#include "sema/xvr_module_graph.h"
+#include "sema/xvr_module_manifest.h"
+#include "sema/xvr_watch.h"
+
+/* a private directory for one test case. with `stdlib` it also holds an
+ * empty lib/std and is the working directory, so imports resolve inside it.
+ * the destructor restores the working directory and removes the tree, even
+ * when a failed REQUIRE ends the test early */
+class ScratchDir {
+public:
+    explicit ScratchDir(const char* name, bool stdlib = false) {
+        std::string pattern = std::string("/tmp/xvr-") + name + "-test-XXXXXX";
+        REQUIRE(mkdtemp(&pattern[0]) != nullptr);
+        root_ = pattern;
+        if (stdlib) {
+            std::filesystem::create_directories(this->stdlib());
+            cwd_ = std::filesystem::current_path();
+            std::filesystem::current_path(root_);
+        }
+    }
+
+    ~ScratchDir() {
+        std::error_code ignored;
+        if (!cwd_.empty()) {
+            std::filesystem::current_path(cwd_, ignored);
+        }
+        std::filesystem::remove_all(root_, ignored);
+    }
+
+    ScratchDir(const ScratchDir&) = delete;
+    ScratchDir& operator=(const ScratchDir&) = delete;
+
+    const std::filesystem::path& path() const { return root_; }
+    std::filesystem::path stdlib() const { return root_ / "lib" / "std"; }
+
+private:
+    std::filesystem::path root_;
+    std::filesystem::path cwd_;
+};
 
 static void compileAndVerify(const char* source) {
     Xvr_Lexer lexer;
@@ -168,6 +232,14 @@ TEST_CASE("Target configuration", "[llvm_backend][llvm]") {
     REQUIRE(default_cpu != nullptr);
 
     Xvr_LLVMTargetConfigDestroy(config);
+
+    /* a warm process still creates machines as before */
+    Xvr_LLVMTargetWarmUp();
+    Xvr_LLVMTargetWarmUp();
+    REQUIRE(Xvr_LLVMTargetMachineGetHostCPU() != nullptr);
+    Xvr_LLVMTargetMachine* tm = Xvr_LLVMTargetMachineCreate(Xvr_LLVMTargetConfigCreate());
+    REQUIRE(tm != nullptr);
+    Xvr_LLVMTargetMachineDestroy(tm);
 }
 
 TEST_CASE("Codegen basic operations", "[llvm_backend][llvm]") {
@@ -286,3 +358,1703 @@ TEST_CASE("Data types compilation - Boolean", "[llvm_backend][llvm]") {
 TEST_CASE("Data types compilation - Negative", "[llvm_backend][llvm]") {
     compileAndVerify("var x = -42;\n");
 }
+
+/* nodes must outlive the codegen, emitted locals point into the AST */
+static std::vector<Xvr_ASTNode*> emitSource(Xvr_LLVMCodegen* codegen,
+                                            const char* source) {
+    Xvr_Lexer lexer;
+    Xvr_Parser parser;
+    Xvr_initLexer(&lexer, source);
+    Xvr_initParser(&parser, &lexer);
+
+    std::vector<Xvr_ASTNode*> nodes;
+    Xvr_ASTNode* node = Xvr_scanParser(&parser);
+    while (node != nullptr) {
+        nodes.push_back(node);
+        if (node->type == XVR_AST_NODE_ERROR) {
+            break;
+        }
+        Xvr_LLVMCodegenEmitAST(codegen, node);
+        node = Xvr_scanParser(&parser);
+    }
+    Xvr_freeParser(&parser);
+    return nodes;
+}
+
+static void freeNodes(std::vector<Xvr_ASTNode*>& nodes) {
+    for (Xvr_ASTNode* node : nodes) {
+        Xvr_freeASTNode(node);
+    }
+    nodes.clear();
+}
+
+TEST_CASE("JIT execution resolves runtime symbols", "[llvm_backend][llvm][jit]") {
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("jit_test");
+    REQUIRE(codegen != nullptr);
+
+    std::vector<Xvr_ASTNode*> nodes = emitSource(codegen,
+                                                 "var a = [1, 2, 3];\n"
+                                                 "var b = a[1] + 1;\n"
+                                                 "a[0] = b;\n");
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(codegen));
+
+    Xvr_LLVMJITStats stats = {0.0, 0.0, -1};
+    REQUIRE(Xvr_LLVMCodegenExecuteJIT(codegen, &stats));
+    REQUIRE(stats.exit_code == 0);
+    REQUIRE(stats.compile_ms >= 0.0);
+    REQUIRE(stats.exec_ms >= 0.0);
+
+    /* the codegen module is left intact and can run again */
+    REQUIRE(Xvr_LLVMCodegenExecuteJIT(codegen, nullptr));
+
+    Xvr_LLVMCodegenDestroy(codegen);
+    freeNodes(nodes);
+}
+
+TEST_CASE("JIT execution without main fails cleanly", "[llvm_backend][llvm][jit]") {
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("jit_empty");
+    REQUIRE(codegen != nullptr);
+
+    REQUIRE_FALSE(Xvr_LLVMCodegenExecuteJIT(codegen, nullptr));
+    REQUIRE(Xvr_LLVMCodegenHasError(codegen));
+
+    Xvr_LLVMCodegenDestroy(codegen);
+}
+
+TEST_CASE("Linker links an in-memory object", "[llvm_backend][llvm][link]") {
+    REQUIRE(Xvr_LLVMLinkerFindRuntimeLibrary() != nullptr);
+
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("link_test");
+    REQUIRE(codegen != nullptr);
+
+    std::vector<Xvr_ASTNode*> nodes = emitSource(codegen,
+                                                 "var a = [4, 5];\n"
+                                                 "a[1] = a[0];\n");
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(codegen));
+
+    size_t object_size = 0;
+    void* object = Xvr_LLVMCodegenEmitObject(codegen, &object_size);
+    REQUIRE(object != nullptr);
+    REQUIRE(object_size > 0);
+
+    ScratchDir scratch("link");
+    std::string exe = (scratch.path() / "app").string();
+
+    char* error = nullptr;
+    bool linked = Xvr_LLVMLinkerLinkExecutable(object, object_size,
+                                               exe.c_str(), &error);
+    INFO((error ? error : ""));
+    REQUIRE(linked);
+    REQUIRE(access(exe.c_str(), X_OK) == 0);
+    REQUIRE(system(exe.c_str()) == 0);
+
+    free(error);
+    free(object);
+    Xvr_LLVMCodegenDestroy(codegen);
+    freeNodes(nodes);
+}
+
+TEST_CASE("Codegen optimizer runs the O2 pipeline", "[llvm_backend][llvm][opt]") {
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("opt_test");
+    REQUIRE(codegen != nullptr);
+
+    std::vector<Xvr_ASTNode*> nodes = emitSource(codegen,
+                                                 "var a = [1, 2, 3];\n"
+                                                 "var i = 0;\n"
+                                                 "while (i < 3) {\n"
+                                                 "    if (i == 2) {\n"
+                                                 "        break;\n"
+                                                 "        i = 5;\n"
+                                                 "    } else {\n"
+                                                 "        a[i] = i;\n"
+                                                 "    }\n"
+                                                 "    i = i + 1;\n"
+                                                 "}\n");
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(codegen));
+
+    REQUIRE(Xvr_LLVMCodegenVerify(codegen));
+    REQUIRE(Xvr_LLVMCodegenSetOptimizationLevel(codegen, XVR_LLVM_OPT_O2));
+    bool optimized = Xvr_LLVMCodegenRunOptimizer(codegen);
+    INFO(Xvr_LLVMCodegenGetError(codegen));
+    REQUIRE(optimized);
+
+    /* mem2reg has promoted every local */
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(codegen, &ir_len);
+    REQUIRE(ir != nullptr);
+    REQUIRE(strstr(ir, "alloca") == nullptr);
+    free(ir);
+
+    /* blocks removed by the passes must not be revisited when emitting */
+    size_t object_size = 0;
+    void* object = Xvr_LLVMCodegenEmitObject(codegen, &object_size);
+    REQUIRE(object != nullptr);
+    REQUIRE(object_size > 0);
+
+    free(object);
+    Xvr_LLVMCodegenDestroy(codegen);
+    freeNodes(nodes);
+}
+
+/* optimizes one corpus program and returns its IR; loop_vectorize < 0 keeps
+ * the level's own policy */
+static std::string optimizedIR(const std::string& source,
+                               Xvr_LLVMOptimizationLevel level,
+                               int loop_vectorize) {
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("vectorize_corpus");
+    REQUIRE(codegen != nullptr);
+
+    std::vector<Xvr_ASTNode*> nodes = emitSource(codegen, source.c_str());
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(codegen));
+
+    REQUIRE(Xvr_LLVMCodegenSetOptimizationLevel(codegen, level));
+    if (loop_vectorize >= 0) {
+        REQUIRE(Xvr_LLVMCodegenSetLoopVectorize(codegen, loop_vectorize));
+    }
+    bool optimized = Xvr_LLVMCodegenRunOptimizer(codegen);
+    INFO(Xvr_LLVMCodegenGetError(codegen));
+    REQUIRE(optimized);
+
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(codegen, &ir_len);
+    REQUIRE(ir != nullptr);
+    std::string result(ir, ir_len);
+
+    free(ir);
+    Xvr_LLVMCodegenDestroy(codegen);
+    freeNodes(nodes);
+    return result;
+}
+
+static bool hasVectorCode(const std::string& ir) {
+    static const std::regex vector_type("<[0-9]+ x (i[0-9]+|float|double)>");
+    return std::regex_search(ir, vector_type);
+}
+
+TEST_CASE("Vectorization policy over the loop corpus", "[llvm_backend][llvm][opt]") {
+    std::vector<std::filesystem::path> corpus;
+    for (const auto& entry :
+         std::filesystem::directory_iterator(XVR_VECTORIZE_CORPUS_DIR)) {
+        if (entry.path().extension() == ".xvr") {
+            corpus.push_back(entry.path());
+        }
+    }
+    std::sort(corpus.begin(), corpus.end());
+    REQUIRE_FALSE(corpus.empty());
+
+    for (const auto& path : corpus) {
+        std::ifstream file(path);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string source = buffer.str();
+        INFO(path.filename().string());
+
+        CHECK(hasVectorCode(optimizedIR(source, XVR_LLVM_OPT_O2, -1)));
+        CHECK(hasVectorCode(optimizedIR(source, XVR_LLVM_OPT_O3, -1)));
+        CHECK_FALSE(hasVectorCode(optimizedIR(source, XVR_LLVM_OPT_O1, -1)));
+        CHECK_FALSE(hasVectorCode(optimizedIR(source, XVR_LLVM_OPT_OS, -1)));
+        CHECK_FALSE(hasVectorCode(optimizedIR(source, XVR_LLVM_OPT_OZ, -1)));
+
+        /* explicit overrides win over the level */
+        CHECK_FALSE(hasVectorCode(optimizedIR(source, XVR_LLVM_OPT_O3, 0)));
+        CHECK(hasVectorCode(optimizedIR(source, XVR_LLVM_OPT_OS, 1)));
+    }
+}
+
+TEST_CASE("Codegen target CPU and features reach the IR", "[llvm_backend][llvm]") {
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("target_attrs");
+    REQUIRE(codegen != nullptr);
+
+    std::vector<Xvr_ASTNode*> nodes = emitSource(codegen,
+                                                 "var a = 1;\n"
+                                                 "var b = a + 1;\n"
+                                                 "a = b;\n");
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(codegen));
+
+    REQUIRE(Xvr_LLVMCodegenSetTargetCPU(codegen, "native"));
+    REQUIRE(Xvr_LLVMCodegenSetTargetFeatures(codegen, "+sse2"));
+
+    /* an unknown CPU is rejected and the previous target stays in place */
+    REQUIRE_FALSE(Xvr_LLVMCodegenSetTargetCPU(codegen, "not-a-cpu"));
+
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(codegen, &ir_len);
+    REQUIRE(ir != nullptr);
+    std::string text(ir);
+    free(ir);
+
+    std::string triple = Xvr_LLVMTargetMachineGetDefaultTargetTriple();
+    std::string cpu = Xvr_LLVMTargetMachineGetHostCPU();
+    CHECK(text.find("target triple = \"" + triple + "\"") != std::string::npos);
+    CHECK(text.find("target datalayout") != std::string::npos);
+    CHECK(text.find("\"target-cpu\"=\"" + cpu + "\"") != std::string::npos);
+    CHECK(text.find("+sse2\"") != std::string::npos);
+
+    Xvr_LLVMCodegenDestroy(codegen);
+    freeNodes(nodes);
+}
+
+TEST_CASE("Custom pass pipelines parse up front and run at -O0", "[llvm_backend][llvm][opt]") {
+    Xvr_LLVMOptimizer* opt = Xvr_LLVMOptimizerCreate();
+    REQUIRE(opt != nullptr);
+    REQUIRE(Xvr_LLVMOptimizerSetLevel(opt, XVR_LLVM_OPT_NONE));
+
+    REQUIRE_FALSE(Xvr_LLVMOptimizerAddPass(opt, "not-a-pass"));
+    REQUIRE(Xvr_LLVMOptimizerGetError(opt) != nullptr);
+    CHECK(std::string(Xvr_LLVMOptimizerGetPipeline(opt)).empty());
+
+    /* the standard entry is empty at -O0 and expands once a level is set */
+    REQUIRE(Xvr_LLVMOptimizerAddPass(opt, "function(mem2reg)"));
+    REQUIRE(Xvr_LLVMOptimizerAddStandardPasses(opt));
+    CHECK(std::string(Xvr_LLVMOptimizerGetPipeline(opt)) == "function(mem2reg)");
+    REQUIRE(Xvr_LLVMOptimizerSetLevel(opt, XVR_LLVM_OPT_O1));
+    std::string expanded = Xvr_LLVMOptimizerGetPipeline(opt);
+    CHECK(expanded.rfind("function(mem2reg),", 0) == 0);
+    CHECK(expanded.find("instcombine") != std::string::npos);
+    Xvr_LLVMOptimizerDestroy(opt);
+
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("custom_passes");
+    REQUIRE(codegen != nullptr);
+    std::vector<Xvr_ASTNode*> nodes = emitSource(codegen,
+                                                 "var a = 1;\n"
+                                                 "var b = a + 2;\n"
+                                                 "a = b;\n");
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(codegen));
+
+    REQUIRE(Xvr_LLVMCodegenSetOptimizationLevel(codegen, XVR_LLVM_OPT_NONE));
+    REQUIRE(Xvr_LLVMCodegenAddPasses(codegen, "function(mem2reg)"));
+    bool optimized = Xvr_LLVMCodegenRunOptimizer(codegen);
+    INFO(Xvr_LLVMCodegenGetError(codegen));
+    REQUIRE(optimized);
+
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(codegen, &ir_len);
+    REQUIRE(ir != nullptr);
+    CHECK(strstr(ir, "alloca") == nullptr);
+    free(ir);
+
+    Xvr_LLVMCodegenDestroy(codegen);
+    freeNodes(nodes);
+}
+
+static const char* const pgoSource = "proc classify(n: int): int {\n"
+                                     "    if (n % 7 == 0) {\n"
+                                     "        return 1;\n"
+                                     "    }\n"
+                                     "    return 0;\n"
+                                     "}\n"
+                                     "var i = 0;\n"
+                                     "var hits = 0;\n"
+                                     "while (i < 1000) {\n"
+                                     "    hits = hits + classify(i);\n"
+                                     "    i = i + 1;\n"
+                                     "}\n";
+
+/* runs -O0 plus the profile passes and returns the IR */
+static std::string profiledIR(const char* generate, const char* use) {
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("pgo");
+    REQUIRE(codegen != nullptr);
+    std::vector<Xvr_ASTNode*> nodes = emitSource(codegen, pgoSource);
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(codegen));
+
+    REQUIRE(Xvr_LLVMCodegenSetOptimizationLevel(codegen, XVR_LLVM_OPT_NONE));
+    REQUIRE(Xvr_LLVMCodegenSetProfileGenerate(codegen, generate));
+    REQUIRE(Xvr_LLVMCodegenSetProfileUse(codegen, use));
+    bool optimized = Xvr_LLVMCodegenRunOptimizer(codegen);
+    INFO(Xvr_LLVMCodegenGetError(codegen));
+    REQUIRE(optimized);
+
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(codegen, &ir_len);
+    REQUIRE(ir != nullptr);
+    std::string text(ir);
+    free(ir);
+
+    Xvr_LLVMCodegenDestroy(codegen);
+    freeNodes(nodes);
+    return text;
+}
+
+TEST_CASE("Profile-guided optimization instruments and applies profiles", "[llvm_backend][llvm][opt][pgo]") {
+    std::string instrumented = profiledIR("pgo-%p.profraw", nullptr);
+    CHECK(instrumented.find("@__llvm_profile_filename") != std::string::npos);
+    CHECK(instrumented.find("c\"pgo-%p.profraw\\00\"") != std::string::npos);
+    CHECK(instrumented.find("@__profc_classify") != std::string::npos);
+
+    /* missing files and unmerged raw profiles are refused up front */
+    Xvr_LLVMOptimizer* opt = Xvr_LLVMOptimizerCreate();
+    REQUIRE(opt != nullptr);
+    CHECK_FALSE(Xvr_LLVMOptimizerSetProfileUse(opt, "/nonexistent.profdata"));
+    std::filesystem::path raw =
+        std::filesystem::temp_directory_path() / "xvr_test.profraw";
+    {
+        std::ofstream out(raw, std::ios::binary);
+        out.write("\xfflprofr\x81\0\0\0\0\0\0\0\0", 16);
+    }
+    CHECK_FALSE(Xvr_LLVMOptimizerSetProfileUse(opt, raw.c_str()));
+    CHECK(std::string(Xvr_LLVMOptimizerGetError(opt)).find("raw profile") !=
+          std::string::npos);
+    std::filesystem::remove(raw);
+    Xvr_LLVMOptimizerDestroy(opt);
+
+#ifdef XVR_LLVM_PROFDATA
+    /* write the counters a run would have produced, keyed by the CFG hashes
+     * recorded in the instrumented module */
+    std::regex data("@__profd_(\\w+) = .*?\\{ i64 -?\\d+, i64 (-?\\d+)");
+    std::ostringstream profile;
+    profile << ":ir\n";
+    for (std::sregex_iterator it(instrumented.begin(), instrumented.end(),
+                                 data);
+         it != std::sregex_iterator(); ++it) {
+        bool is_classify = (*it)[1] == "classify";
+        profile << (*it)[1] << "\n"
+                << (*it)[2] << "\n2\n"
+                << (is_classify ? "143\n857\n" : "1000\n1\n") << "\n";
+    }
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::filesystem::path text = dir / "xvr_test_pgo.proftext";
+    std::filesystem::path merged = dir / "xvr_test_pgo.profdata";
+    std::ofstream(text) << profile.str();
+    std::string command = std::string(XVR_LLVM_PROFDATA) + " merge -o " +
+                          merged.string() + " " + text.string();
+    REQUIRE(std::system(command.c_str()) == 0);
+
+    std::string optimized = profiledIR(nullptr, merged.c_str());
+    CHECK(optimized.find("!\"ProfileSummary\"") != std::string::npos);
+    CHECK(optimized.find("!{!\"function_entry_count\", i64 1000}") !=
+          std::string::npos);
+    CHECK(optimized.find("!\"branch_weights\"") != std::string::npos);
+
+    std::filesystem::remove(text);
+    std::filesystem::remove(merged);
+#endif
+}
+
+/* a stand-in for xvr_runtime.bc: the real one needs a matching clang, so
+ * an unchecked element getter is built with the C API instead, next to a
+ * helper nothing calls */
+static std::string writeRuntimeBitcode() {
+    LLVMContextRef ctx = LLVMContextCreate();
+    LLVMModuleRef module = LLVMModuleCreateWithNameInContext("runtime", ctx);
+    LLVMSetTarget(module, Xvr_LLVMTargetMachineGetDefaultTargetTriple());
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(ctx);
+
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(ctx);
+    LLVMTypeRef fields[] = {LLVMPointerType(i32, 0), i32, i32};
+    LLVMTypeRef array = LLVMStructTypeInContext(ctx, fields, 3, 0);
+    LLVMTypeRef params[] = {LLVMPointerType(LLVMInt8TypeInContext(ctx), 0), i32};
+
+    LLVMValueRef get = LLVMAddFunction(module, "xvr_array_get_int",
+                                       LLVMFunctionType(i32, params, 2, 0));
+    LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(ctx, get, "entry"));
+    LLVMValueRef arr = LLVMBuildPointerCast(builder, LLVMGetParam(get, 0),
+                                            LLVMPointerType(array, 0), "arr");
+    LLVMValueRef data_ptr = LLVMBuildStructGEP2(builder, array, arr, 0, "data_ptr");
+    LLVMValueRef data = LLVMBuildLoad2(builder, fields[0], data_ptr, "data");
+    LLVMValueRef index = LLVMGetParam(get, 1);
+    LLVMValueRef elem = LLVMBuildGEP2(builder, i32, data, &index, 1, "elem");
+    LLVMBuildRet(builder, LLVMBuildLoad2(builder, i32, elem, "value"));
+
+    LLVMValueRef unused = LLVMAddFunction(module, "xvr_runtime_unused",
+                                          LLVMFunctionType(i32, nullptr, 0, 0));
+    LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(ctx, unused, "entry"));
+    LLVMBuildRet(builder, LLVMConstInt(i32, 7, 0));
+
+    std::string path =
+        (std::filesystem::temp_directory_path() / "xvr_test_runtime.bc").string();
+    REQUIRE(LLVMWriteBitcodeToFile(module, path.c_str()) == 0);
+    LLVMDisposeBuilder(builder);
+    LLVMDisposeModule(module);
+    LLVMContextDispose(ctx);
+    return path;
+}
+
+static std::string runtimeLinkedIR(const char* bitcode) {
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("runtime_link");
+    REQUIRE(codegen != nullptr);
+    std::vector<Xvr_ASTNode*> nodes = emitSource(codegen,
+                                                 "var a = [1, 2, 3];\n"
+                                                 "var n = a[1];\n"
+                                                 "std::print(\"{}\\n\", n);\n");
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(codegen));
+
+    REQUIRE(Xvr_LLVMCodegenSetRuntimeBitcode(codegen, bitcode));
+    REQUIRE(Xvr_LLVMCodegenSetOptimizationLevel(codegen, XVR_LLVM_OPT_O2));
+    bool optimized = Xvr_LLVMCodegenRunOptimizer(codegen);
+    INFO(Xvr_LLVMCodegenGetError(codegen));
+    REQUIRE(optimized);
+
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(codegen, &ir_len);
+    REQUIRE(ir != nullptr);
+    std::string text(ir);
+    free(ir);
+
+    Xvr_LLVMCodegenDestroy(codegen);
+    freeNodes(nodes);
+    return text;
+}
+
+TEST_CASE("Runtime bitcode is linked, internalized and inlined", "[llvm_backend][llvm][opt]") {
+    std::string bitcode = writeRuntimeBitcode();
+
+    std::string opaque = runtimeLinkedIR(nullptr);
+    CHECK(opaque.find("@xvr_array_get_int(") != std::string::npos);
+
+    /* the element load replaces the call; the helper nothing references is
+     * never pulled in */
+    std::string linked = runtimeLinkedIR(bitcode.c_str());
+    CHECK(linked.find("@xvr_array_get_int(") == std::string::npos);
+    CHECK(linked.find("xvr_runtime_unused") == std::string::npos);
+
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("runtime_missing");
+    REQUIRE(codegen != nullptr);
+    std::vector<Xvr_ASTNode*> nodes = emitSource(codegen, "var a = [1];\n"
+                                                          "var n = a[0];\n"
+                                                          "a[0] = n;\n");
+    REQUIRE(Xvr_LLVMCodegenSetRuntimeBitcode(codegen, "/nonexistent/xvr_runtime.bc"));
+    CHECK_FALSE(Xvr_LLVMCodegenRunOptimizer(codegen));
+    CHECK(std::string(Xvr_LLVMCodegenGetError(codegen)).find("runtime bitcode") !=
+          std::string::npos);
+    Xvr_LLVMCodegenDestroy(codegen);
+    freeNodes(nodes);
+
+    std::filesystem::remove(bitcode);
+}
+
+static std::vector<char> thinBitcode(Xvr_LLVMCodegen* codegen) {
+    REQUIRE(Xvr_LLVMCodegenSetOptimizationLevel(codegen, XVR_LLVM_OPT_O2));
+    bool optimized = Xvr_LLVMCodegenRunOptimizer(codegen);
+    INFO(Xvr_LLVMCodegenGetError(codegen));
+    REQUIRE(optimized);
+
+    size_t size = 0;
+    char* bitcode = static_cast<char*>(Xvr_LLVMCodegenEmitThinLTOBitcode(codegen, &size));
+    REQUIRE(bitcode != nullptr);
+    std::vector<char> bytes(bitcode, bitcode + size);
+    free(bitcode);
+    return bytes;
+}
+
+TEST_CASE("ThinLTO links separately compiled modules", "[llvm_backend][llvm][thinlto]") {
+    /* imports resolve against lib/std in the working directory */
+    ScratchDir scratch("thinlto", true);
+    const std::filesystem::path& root = scratch.path();
+    const char* library = "proc thin_square(x: int): int {\n"
+                          "    return x * x;\n"
+                          "}\n";
+    std::ofstream(root / "lib" / "std" / "thin_math.xvr") << library;
+
+    Xvr_LLVMCodegen* app = Xvr_LLVMCodegenCreate("app");
+    REQUIRE(app != nullptr);
+    REQUIRE(Xvr_LLVMCodegenSetThinLTO(app, true));
+    std::vector<Xvr_ASTNode*> app_nodes = emitSource(app,
+                                                     "import thin_math;\n"
+                                                     "var n = thin_square(7);\n"
+                                                     "std::print(\"{}\\n\", n);\n");
+    INFO(Xvr_LLVMCodegenGetError(app));
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(app));
+    REQUIRE(Xvr_LLVMCodegenGetImportCount(app) == 1);
+    CHECK(std::string(Xvr_LLVMCodegenGetImport(app, 0)).find("thin_math.xvr") != std::string::npos);
+
+    /* the app only declares the import, its body lives in the other module */
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(app, &ir_len);
+    REQUIRE(ir != nullptr);
+    CHECK(std::string(ir).find("declare i32 @thin_square(") != std::string::npos);
+    free(ir);
+
+    Xvr_LLVMCodegen* lib = Xvr_LLVMCodegenCreate("thin_math");
+    REQUIRE(lib != nullptr);
+    REQUIRE(Xvr_LLVMCodegenSetThinLTO(lib, true));
+    REQUIRE(Xvr_LLVMCodegenSetLibraryUnit(lib, true));
+    std::vector<Xvr_ASTNode*> lib_nodes = emitSource(lib, library);
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(lib));
+
+    std::vector<char> app_bc = thinBitcode(app);
+    std::vector<char> lib_bc = thinBitcode(lib);
+
+    Xvr_LLVMThinLink* link = Xvr_LLVMThinLinkCreate();
+    REQUIRE(link != nullptr);
+    REQUIRE(Xvr_LLVMThinLinkSetCacheDir(link, (root / "cache").c_str()));
+    REQUIRE(Xvr_LLVMThinLinkAddModule(link, "app", app_bc.data(), app_bc.size()));
+    REQUIRE(Xvr_LLVMThinLinkAddModule(link, "thin_math", lib_bc.data(), lib_bc.size()));
+    CHECK_FALSE(Xvr_LLVMThinLinkAddModule(link, "app", app_bc.data(), app_bc.size()));
+
+    bool ran = Xvr_LLVMThinLinkRun(link);
+    INFO(Xvr_LLVMThinLinkGetError(link));
+    REQUIRE(ran);
+    REQUIRE(Xvr_LLVMThinLinkGetObjectCount(link) == 2);
+
+    std::vector<const void*> objects;
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < Xvr_LLVMThinLinkGetObjectCount(link); i++) {
+        size_t size = 0;
+        objects.push_back(Xvr_LLVMThinLinkGetObject(link, i, &size));
+        REQUIRE(size > 0);
+        sizes.push_back(size);
+    }
+
+    std::string exe = (root / "app").string();
+    char* error = nullptr;
+    bool linked = Xvr_LLVMLinkerLinkExecutables(objects.data(), sizes.data(),
+                                                objects.size(), exe.c_str(), &error);
+    INFO((error ? error : ""));
+    REQUIRE(linked);
+    std::string command = exe + " > " + (root / "out.txt").string();
+    REQUIRE(system(command.c_str()) == 0);
+    std::ifstream output(root / "out.txt");
+    std::string line;
+    std::getline(output, line);
+    CHECK(line == "49");
+    free(error);
+
+    /* plain bitcode carries no summary and is turned away */
+    Xvr_LLVMThinLink* plain = Xvr_LLVMThinLinkCreate();
+    REQUIRE(plain != nullptr);
+    std::string plain_path = (root / "plain.bc").string();
+    REQUIRE(Xvr_LLVMCodegenWriteBitcode(lib, plain_path.c_str()));
+    std::ifstream plain_file(plain_path, std::ios::binary);
+    std::vector<char> plain_bc((std::istreambuf_iterator<char>(plain_file)),
+                               std::istreambuf_iterator<char>());
+    REQUIRE_FALSE(plain_bc.empty());
+    CHECK_FALSE(Xvr_LLVMThinLinkAddModule(plain, "plain", plain_bc.data(), plain_bc.size()));
+    CHECK(std::string(Xvr_LLVMThinLinkGetError(plain)).find("summary") != std::string::npos);
+    Xvr_LLVMThinLinkDestroy(plain);
+
+    Xvr_LLVMThinLinkDestroy(link);
+    Xvr_LLVMCodegenDestroy(lib);
+    Xvr_LLVMCodegenDestroy(app);
+    freeNodes(lib_nodes);
+    freeNodes(app_nodes);
+}
+
+static std::vector<std::string> partitionedObjects(unsigned jobs) {
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("split");
+    REQUIRE(codegen != nullptr);
+    std::vector<Xvr_ASTNode*> nodes = emitSource(codegen,
+                                                 "proc twice(x: int): int {\n"
+                                                 "    return x * 2;\n"
+                                                 "}\n"
+                                                 "proc inc(x: int): int {\n"
+                                                 "    return x + 1;\n"
+                                                 "}\n"
+                                                 "proc both(x: int): int {\n"
+                                                 "    return twice(inc(x));\n"
+                                                 "}\n"
+                                                 "var n = both(20);\n"
+                                                 "std::print(\"{}\\n\", n);\n");
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(codegen));
+    REQUIRE(Xvr_LLVMCodegenSetCodegenJobs(codegen, jobs));
+
+    size_t* sizes = nullptr;
+    size_t count = 0;
+    Xvr_LLVMCodegenTiming timing = {0.0, 0.0, 0};
+    void** objects = Xvr_LLVMCodegenEmitObjects(codegen, false, &sizes, &count, &timing);
+    INFO(Xvr_LLVMCodegenGetError(codegen));
+    REQUIRE(objects != nullptr);
+    CHECK(timing.jobs == (jobs > 1 ? jobs : 1));
+    CHECK(timing.wall_ms >= 0.0);
+
+    std::vector<std::string> result;
+    for (size_t i = 0; i < count; i++) {
+        result.emplace_back(static_cast<char*>(objects[i]), sizes[i]);
+        free(objects[i]);
+    }
+    free(objects);
+    free(sizes);
+    Xvr_LLVMCodegenDestroy(codegen);
+    freeNodes(nodes);
+    return result;
+}
+
+TEST_CASE("ThinLTO rejects two strong definitions of a symbol", "[llvm_backend][llvm][thinlto]") {
+    const char* library = "proc thin_twice(x: int): int {\n"
+                          "    return x + x;\n"
+                          "}\n";
+    std::vector<char> bitcode[2];
+    std::vector<Xvr_ASTNode*> nodes[2];
+    Xvr_LLVMCodegen* codegens[2];
+    for (int i = 0; i < 2; i++) {
+        codegens[i] = Xvr_LLVMCodegenCreate(i == 0 ? "first" : "second");
+        REQUIRE(codegens[i] != nullptr);
+        REQUIRE(Xvr_LLVMCodegenSetThinLTO(codegens[i], true));
+        REQUIRE(Xvr_LLVMCodegenSetLibraryUnit(codegens[i], true));
+        nodes[i] = emitSource(codegens[i], library);
+        REQUIRE_FALSE(Xvr_LLVMCodegenHasError(codegens[i]));
+        bitcode[i] = thinBitcode(codegens[i]);
+    }
+
+    Xvr_LLVMThinLink* link = Xvr_LLVMThinLinkCreate();
+    REQUIRE(link != nullptr);
+    REQUIRE(Xvr_LLVMThinLinkAddModule(link, "first", bitcode[0].data(), bitcode[0].size()));
+    REQUIRE(Xvr_LLVMThinLinkAddModule(link, "second", bitcode[1].data(), bitcode[1].size()));
+    CHECK_FALSE(Xvr_LLVMThinLinkRun(link));
+    std::string error = Xvr_LLVMThinLinkGetError(link);
+    CHECK(error.find("duplicate symbol 'thin_twice'") != std::string::npos);
+    CHECK(error.find("first") != std::string::npos);
+    CHECK(error.find("second") != std::string::npos);
+    CHECK(Xvr_LLVMThinLinkGetObjectCount(link) == 0);
+
+    Xvr_LLVMThinLinkDestroy(link);
+    for (int i = 0; i < 2; i++) {
+        Xvr_LLVMCodegenDestroy(codegens[i]);
+        freeNodes(nodes[i]);
+    }
+}
+
+TEST_CASE("ThinLTO builds compile and link what a program imports", "[llvm_backend][llvm][thinlto]") {
+    ScratchDir scratch("thin-build", true);
+    const std::filesystem::path& root = scratch.path();
+    std::ofstream(root / "lib" / "std" / "thin_cube.xvr") << "proc thin_cube(x: int): int {\n"
+                                                             "    return x * x * x;\n"
+                                                             "}\n";
+
+    Xvr_CompilerOptions options;
+    Xvr_CompilerOptionsInit(&options);
+    options.optimizationLevel = 2;
+    options.thinLTO = true;
+    options.runtimeBitcode = false;
+    Xvr_CompilerSession* session = Xvr_CompilerSessionCreate(&options);
+    Xvr_LLVMCodegen* app = Xvr_LLVMCodegenCreateWithSession("app", session);
+    REQUIRE(app != nullptr);
+    std::vector<Xvr_ASTNode*> nodes = emitSource(app,
+                                                 "import thin_cube;\n"
+                                                 "var n = thin_cube(3);\n"
+                                                 "std::print(\"{}\\n\", n);\n");
+    REQUIRE(Xvr_LLVMCodegenOptimize(app));
+
+    Xvr_LLVMThinBuild* build = Xvr_LLVMThinBuildCreate(session);
+    REQUIRE(build != nullptr);
+    bool added = Xvr_LLVMThinBuildAddProgram(build, "app.xvr", app);
+    INFO((Xvr_LLVMThinBuildGetError(build) ? Xvr_LLVMThinBuildGetError(build) : ""));
+    REQUIRE(added);
+    REQUIRE(Xvr_LLVMThinBuildGetModuleCount(build) == 2);
+    CHECK(std::string(Xvr_LLVMThinBuildGetModulePath(build, 1)).find("thin_cube.xvr") != std::string::npos);
+
+    /* -c writes the import next to the program, named after its source */
+    std::string object = (root / "app.o").string();
+    REQUIRE(Xvr_LLVMThinBuildWrite(build, object.c_str()));
+    CHECK(std::filesystem::exists(root / "thin_cube.o"));
+
+    Xvr_LLVMThinLink* link = Xvr_LLVMThinBuildLink(build, app, nullptr);
+    REQUIRE(link != nullptr);
+    std::string exe = (root / "app").string();
+    char* error = nullptr;
+    REQUIRE(Xvr_LLVMThinBuildLinkExecutable(link, nullptr, nullptr, 0, exe.c_str(), &error));
+    CHECK(system((exe + " | grep -qx 27").c_str()) == 0);
+
+    /* the written bitcode links again as object inputs */
+    const char* inputs[2] = {"app.o", "thin_cube.o"};
+    bool linked = Xvr_LLVMThinBuildLinkInputs(session, inputs, 2, nullptr, "relinked", &error);
+    INFO((error ? error : ""));
+    REQUIRE(linked);
+    CHECK(system("./relinked | grep -qx 27") == 0);
+    const char* missing[1] = {"missing.o"};
+    CHECK_FALSE(Xvr_LLVMThinBuildLinkInputs(session, missing, 1, nullptr, "never", &error));
+    REQUIRE(error != nullptr);
+    CHECK(std::string(error).find("missing.o") != std::string::npos);
+    free(error);
+
+    Xvr_LLVMThinLinkDestroy(link);
+    Xvr_LLVMThinBuildDestroy(build);
+    Xvr_LLVMCodegenDestroy(app);
+    freeNodes(nodes);
+    Xvr_CompilerSessionDestroy(session);
+}
+
+TEST_CASE("Partitioned codegen is deterministic and links", "[llvm_backend][llvm][link]") {
+    REQUIRE(partitionedObjects(0).size() == 1);
+
+    std::vector<std::string> first = partitionedObjects(3);
+    REQUIRE(first.size() == 3);
+    CHECK(first == partitionedObjects(3));
+
+    std::vector<const void*> objects;
+    std::vector<size_t> sizes;
+    for (const std::string& object : first) {
+        objects.push_back(object.data());
+        sizes.push_back(object.size());
+    }
+
+    ScratchDir scratch("split");
+    std::string exe = (scratch.path() / "app").string();
+    std::string merged = (scratch.path() / "app.o").string();
+    char* error = nullptr;
+    bool linked = Xvr_LLVMLinkerLinkExecutables(objects.data(), sizes.data(),
+                                                objects.size(), exe.c_str(), &error);
+    INFO((error ? error : ""));
+    REQUIRE(linked);
+    std::string command = exe + " | grep -qx 42";
+    CHECK(system(command.c_str()) == 0);
+
+    CHECK(Xvr_LLVMLinkerLinkRelocatable(objects.data(), sizes.data(), objects.size(),
+                                        merged.c_str(), &error));
+    CHECK(access(merged.c_str(), R_OK) == 0);
+
+    free(error);
+}
+
+TEST_CASE("Object cache hits, follows dependencies and evicts", "[llvm_backend][llvm][cache]") {
+    ScratchDir scratch("cache");
+    const std::filesystem::path& root = scratch.path();
+    std::string dep = (root / "dep.xvr").string();
+    std::ofstream(dep) << "proc one(): int { return 1; }\n";
+
+    Xvr_LLVMObjectCache* cache = Xvr_LLVMObjectCacheCreate((root / "cache").c_str(), 0);
+    REQUIRE(cache != nullptr);
+
+    const std::string source = "import dep;\n";
+    const std::string first = "object one";
+    const std::string second = "object two";
+    const void* objects[] = {first.data(), second.data()};
+    const size_t sizes[] = {first.size(), second.size()};
+    const char* deps[] = {dep.c_str()};
+
+    size_t* got_sizes = nullptr;
+    size_t got_count = 0;
+    CHECK(Xvr_LLVMObjectCacheLookup(cache, "O=2", source.data(), source.size(),
+                                    &got_sizes, &got_count) == nullptr);
+    REQUIRE(Xvr_LLVMObjectCacheStore(cache, "O=2", source.data(), source.size(), deps, 1,
+                                     objects, sizes, 2));
+
+    /* entries are readable like any other file the user creates */
+    mode_t mask = umask(0);
+    umask(mask);
+    for (const auto& item : std::filesystem::directory_iterator(root / "cache")) {
+        if (item.path().filename() == "stats") {
+            continue;
+        }
+        INFO(item.path());
+        CHECK((item.status().permissions() & std::filesystem::perms::all) ==
+              std::filesystem::perms(0644 & ~mask));
+    }
+
+    void** hit = Xvr_LLVMObjectCacheLookup(cache, "O=2", source.data(), source.size(),
+                                           &got_sizes, &got_count);
+    REQUIRE(hit != nullptr);
+    REQUIRE(got_count == 2);
+    CHECK(std::string(static_cast<char*>(hit[0]), got_sizes[0]) == first);
+    CHECK(std::string(static_cast<char*>(hit[1]), got_sizes[1]) == second);
+    for (size_t i = 0; i < got_count; i++) {
+        free(hit[i]);
+    }
+    free(hit);
+    free(got_sizes);
+
+    /* other options, or a dependency that changed on disk, miss */
+    CHECK(Xvr_LLVMObjectCacheLookup(cache, "O=3", source.data(), source.size(),
+                                    &got_sizes, &got_count) == nullptr);
+    std::ofstream(dep) << "proc one(): int { return 2; }\n";
+    CHECK(Xvr_LLVMObjectCacheLookup(cache, "O=2", source.data(), source.size(),
+                                    &got_sizes, &got_count) == nullptr);
+
+    Xvr_LLVMObjectCacheStats stats;
+    REQUIRE(Xvr_LLVMObjectCacheGetStats(cache, &stats));
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 3);
+    CHECK(stats.stores == 1);
+    CHECK(stats.entries == 1);
+    Xvr_LLVMObjectCacheDestroy(cache);
+
+    /* a limit below one entry keeps only the newest, and temporary files
+     * of a compiler killed long ago go with the evicted entries */
+    std::ofstream(root / "cache" / ".tmp-stale") << "partial";
+    std::ofstream(root / "cache" / ".tmp-fresh") << "partial";
+    std::filesystem::last_write_time(root / "cache" / ".tmp-stale",
+                                     std::filesystem::file_time_type::clock::now() -
+                                         std::chrono::hours(1));
+    cache = Xvr_LLVMObjectCacheCreate((root / "cache").c_str(), 64);
+    REQUIRE(cache != nullptr);
+    REQUIRE(Xvr_LLVMObjectCacheStore(cache, "O=1", source.data(), source.size(), nullptr, 0,
+                                     objects, sizes, 1));
+    REQUIRE(Xvr_LLVMObjectCacheGetStats(cache, &stats));
+    CHECK(stats.evictions > 0);
+    CHECK(stats.bytes <= 64);
+    CHECK_FALSE(std::filesystem::exists(root / "cache" / ".tmp-stale"));
+    CHECK(std::filesystem::exists(root / "cache" / ".tmp-fresh"));
+    Xvr_LLVMObjectCacheDestroy(cache);
+}
+
+TEST_CASE("Source builds compile every file and import to an object", "[llvm_backend][llvm][source_build]") {
+    ScratchDir scratch("source-build", true);
+    const std::filesystem::path& root = scratch.path();
+    std::ofstream(root / "lib" / "std" / "pool_sq.xvr") << "proc pool_sq(x: int): int {\n"
+                                                          "    return x * x;\n"
+                                                          "}\n";
+    std::ofstream(root / "main.xvr") << "include std;\n"
+                                        "import pool_sq;\n"
+                                        "std::print(\"{}\\n\", pool_sq(4) + pool_add(1, 2));\n";
+    std::ofstream(root / "add.xvr") << "include std;\n"
+                                       "proc pool_add(a: int, b: int): int {\n"
+                                       "    return a + b;\n"
+                                       "}\n";
+    std::ofstream(root / "bad.xvr") << "var stray = 1;\n";
+
+    Xvr_CompilerOptions options;
+    Xvr_CompilerOptionsInit(&options);
+    options.optimizationLevel = 1;
+    options.runtimeBitcode = false;
+
+    Xvr_LLVMSourceBuild* build = Xvr_LLVMSourceBuildCreate(&options, 2);
+    REQUIRE(build != nullptr);
+    CHECK(Xvr_LLVMSourceBuildGetJobs(build) == 2);
+    REQUIRE(Xvr_LLVMSourceBuildAddInput(build, "main.xvr"));
+    REQUIRE(Xvr_LLVMSourceBuildAddInput(build, "add.xvr"));
+    bool built = Xvr_LLVMSourceBuildRun(build);
+    for (size_t i = 0; i < Xvr_LLVMSourceBuildGetUnitCount(build); i++) {
+        const char* message = Xvr_LLVMSourceBuildGetUnitMessage(build, i);
+        INFO(Xvr_LLVMSourceBuildGetUnitPath(build, i) << ": " << (message ? message : ""));
+        CHECK(message == nullptr);
+    }
+    REQUIRE(built);
+    REQUIRE(Xvr_LLVMSourceBuildGetUnitCount(build) == 3);
+    CHECK(std::string(Xvr_LLVMSourceBuildGetUnitPath(build, 2)).find("pool_sq.xvr") != std::string::npos);
+
+    size_t* sizes = nullptr;
+    size_t count = 0;
+    void** objects = Xvr_LLVMSourceBuildTakeObjects(build, &sizes, &count);
+    REQUIRE(objects != nullptr);
+    REQUIRE(count == 3);
+    std::string exe = (root / "app").string();
+    char* error = nullptr;
+    bool linked = Xvr_LLVMLinkerLinkExecutables(const_cast<const void* const*>(objects), sizes,
+                                                count, exe.c_str(), &error);
+    INFO((error ? error : ""));
+    REQUIRE(linked);
+    CHECK(system((exe + " | grep -qx 19").c_str()) == 0);
+    for (size_t i = 0; i < count; i++) {
+        free(objects[i]);
+    }
+    free(objects);
+    free(sizes);
+    free(error);
+    Xvr_LLVMSourceBuildDestroy(build);
+
+    /* only the first file may have statements of its own */
+    build = Xvr_LLVMSourceBuildCreate(&options, 0);
+    REQUIRE(build != nullptr);
+    REQUIRE(Xvr_LLVMSourceBuildAddInput(build, "main.xvr"));
+    REQUIRE(Xvr_LLVMSourceBuildAddInput(build, "bad.xvr"));
+    CHECK_FALSE(Xvr_LLVMSourceBuildRun(build));
+    CHECK(Xvr_LLVMSourceBuildGetUnitMessage(build, 1) != nullptr);
+    Xvr_LLVMSourceBuildDestroy(build);
+}
+
+TEST_CASE("Build cache keys builds by the session's options", "[llvm_backend][llvm][cache]") {
+    ScratchDir scratch("build-cache");
+    const std::filesystem::path& root = scratch.path();
+    std::string cache_dir = (root / "cache").string();
+    std::string profile = (root / "app.profdata").string();
+    std::ofstream(profile) << "counts";
+
+    Xvr_CompilerOptions options;
+    Xvr_CompilerOptionsInit(&options);
+    options.optimizationLevel = 2;
+    options.profileUse = profile.c_str();
+
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreate("app");
+    REQUIRE(codegen != nullptr);
+    const std::string source = "var x = 1;\n";
+    const std::string object = "object";
+    const void* objects[] = {object.data()};
+    const size_t sizes[] = {object.size()};
+
+    Xvr_LLVMBuildCache* cache =
+        Xvr_LLVMBuildCacheCreate(cache_dir.c_str(), 0, &options, "app", true);
+    REQUIRE(cache != nullptr);
+    CHECK(std::string(Xvr_LLVMBuildCacheGetFingerprint(cache)).find("O=2\n") !=
+          std::string::npos);
+    REQUIRE(Xvr_LLVMBuildCacheStore(cache, source.data(), source.size(), codegen, objects,
+                                    sizes, 1));
+    size_t* got_sizes = nullptr;
+    size_t got_count = 0;
+    void** hit = Xvr_LLVMBuildCacheLookup(cache, source.data(), source.size(), &got_sizes,
+                                          &got_count);
+    REQUIRE(hit != nullptr);
+    REQUIRE(got_count == 1);
+    CHECK(std::string(static_cast<char*>(hit[0]), got_sizes[0]) == object);
+    free(hit[0]);
+    free(hit);
+    free(got_sizes);
+    Xvr_LLVMBuildCacheDestroy(cache);
+
+    /* another level, a -c build or a changed profile all miss */
+    options.optimizationLevel = 3;
+    cache = Xvr_LLVMBuildCacheCreate(cache_dir.c_str(), 0, &options, "app", true);
+    CHECK(Xvr_LLVMBuildCacheLookup(cache, source.data(), source.size(), &got_sizes,
+                                   &got_count) == nullptr);
+    Xvr_LLVMBuildCacheDestroy(cache);
+    options.optimizationLevel = 2;
+    cache = Xvr_LLVMBuildCacheCreate(cache_dir.c_str(), 0, &options, "app", false);
+    CHECK(Xvr_LLVMBuildCacheLookup(cache, source.data(), source.size(), &got_sizes,
+                                   &got_count) == nullptr);
+    Xvr_LLVMBuildCacheDestroy(cache);
+    std::ofstream(profile) << "other counts";
+    cache = Xvr_LLVMBuildCacheCreate(cache_dir.c_str(), 0, &options, "app", true);
+    CHECK(Xvr_LLVMBuildCacheLookup(cache, source.data(), source.size(), &got_sizes,
+                                   &got_count) == nullptr);
+    Xvr_LLVMBuildCacheDestroy(cache);
+
+    Xvr_LLVMCodegenDestroy(codegen);
+}
+
+static std::string importerIR() {
+    Xvr_LLVMCodegen* app = Xvr_LLVMCodegenCreate("app");
+    REQUIRE(app != nullptr);
+    std::vector<Xvr_ASTNode*> nodes = emitSource(app,
+                                                 "import pre_val;\n"
+                                                 "var n = pre_val();\n"
+                                                 "std::print(\"{}\\n\", n);\n");
+    INFO(Xvr_LLVMCodegenGetError(app));
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(app));
+    REQUIRE(Xvr_LLVMCodegenVerify(app));
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(app, &ir_len);
+    REQUIRE(ir != nullptr);
+    std::string text(ir, ir_len);
+    free(ir);
+    Xvr_LLVMCodegenDestroy(app);
+    freeNodes(nodes);
+    return text;
+}
+
+TEST_CASE("Precompiled modules replace parsing until the source changes", "[llvm_backend][llvm][precompiled]") {
+    ScratchDir scratch("precompiled", true);
+    const std::filesystem::path& root = scratch.path();
+    const std::string on_disk = "proc pre_val(): int { return 5; }\n";
+    std::ofstream(root / "lib" / "std" / "pre_val.xvr") << on_disk;
+
+    char* path = Xvr_LLVMPrecompiledPath("./lib/std/pre_val.xvr");
+    REQUIRE(path != nullptr);
+    CHECK(std::string(path) == "./lib/std/pre_val.xvrm");
+
+    /* built from other text than the file holds, so a hit is visible */
+    Xvr_LLVMCodegen* lib = Xvr_LLVMCodegenCreate("pre_val");
+    REQUIRE(lib != nullptr);
+    REQUIRE(Xvr_LLVMCodegenSetLibraryUnit(lib, true));
+    std::vector<Xvr_ASTNode*> lib_nodes = emitSource(lib, "proc pre_val(): int { return 7; }\n");
+    bool written = Xvr_LLVMCodegenWritePrecompiled(lib, on_disk.data(), on_disk.size(), path);
+    INFO(Xvr_LLVMCodegenGetError(lib));
+    REQUIRE(written);
+
+    Xvr_LLVMPrecompiledModule* loaded =
+        Xvr_LLVMPrecompiledLoad(LLVMGetGlobalContext(), "./lib/std/pre_val.xvr");
+    REQUIRE(loaded != nullptr);
+    REQUIRE(Xvr_LLVMPrecompiledGetProcCount(loaded) == 1);
+    CHECK(std::string(Xvr_LLVMPrecompiledGetProc(loaded, 0)) == "pre_val");
+    CHECK(Xvr_LLVMPrecompiledGetImportCount(loaded) == 0);
+    Xvr_LLVMPrecompiledDestroy(loaded);
+
+    CHECK(importerIR().find("ret i32 7") != std::string::npos);
+
+    /* an edited source makes the precompiled module stale */
+    std::ofstream(root / "lib" / "std" / "pre_val.xvr") << on_disk << "\n";
+    CHECK(Xvr_LLVMPrecompiledLoad(LLVMGetGlobalContext(), "./lib/std/pre_val.xvr") == nullptr);
+    std::string stale = importerIR();
+    CHECK(stale.find("ret i32 5") != std::string::npos);
+    CHECK(stale.find("ret i32 7") == std::string::npos);
+
+    /* a session precompiles the file as it is now */
+    Xvr_CompilerSession* session = Xvr_CompilerSessionCreate(nullptr);
+    REQUIRE(Xvr_CompilerSessionPrecompile(session, "./lib/std/pre_val.xvr", path));
+    loaded = Xvr_LLVMPrecompiledLoad(LLVMGetGlobalContext(), "./lib/std/pre_val.xvr");
+    CHECK(loaded != nullptr);
+    Xvr_LLVMPrecompiledDestroy(loaded);
+    std::ofstream(root / "main.xvr") << "std::print(\"{}\\n\", 1);\n";
+    CHECK_FALSE(Xvr_CompilerSessionPrecompile(session, "main.xvr", (root / "main.xvrm").c_str()));
+    REQUIRE(Xvr_CompilerSessionGetDiagnosticCount(session) == 1);
+    CHECK(std::string(Xvr_CompilerSessionGetDiagnostic(session, 0)).find("top-level") != std::string::npos);
+    Xvr_CompilerSessionDestroy(session);
+
+    /* top-level statements have nowhere to go in a precompiled module */
+    Xvr_LLVMCodegen* statements = Xvr_LLVMCodegenCreate("statements");
+    REQUIRE(statements != nullptr);
+    REQUIRE(Xvr_LLVMCodegenSetLibraryUnit(statements, true));
+    std::vector<Xvr_ASTNode*> statement_nodes = emitSource(statements,
+                                                           "proc f(): int { return 1; }\n"
+                                                           "std::print(\"{}\\n\", f());\n");
+    CHECK_FALSE(Xvr_LLVMCodegenWritePrecompiled(statements, "x", 1, (root / "s.xvrm").c_str()));
+    CHECK(std::string(Xvr_LLVMCodegenGetError(statements)).find("top-level") != std::string::npos);
+
+    Xvr_LLVMCodegenDestroy(statements);
+    Xvr_LLVMCodegenDestroy(lib);
+    freeNodes(statement_nodes);
+    freeNodes(lib_nodes);
+    free(path);
+}
+
+TEST_CASE("Module graph parses each import once and reports cycles", "[llvm_backend][llvm][imports]") {
+    ScratchDir scratch("graph", true);
+    const std::filesystem::path& root = scratch.path();
+    std::filesystem::path std_dir = scratch.stdlib();
+    std::ofstream(std_dir / "g_base.xvr") << "proc g_base(): int { return 1; }\n";
+    std::ofstream(std_dir / "g_left.xvr") << "import g_base;\n"
+                                             "proc g_left(): int { return g_base() + 1; }\n";
+    std::ofstream(std_dir / "g_right.xvr") << "import g_base;\n"
+                                              "proc g_right(): int { return g_base() + 2; }\n";
+    std::ofstream(std_dir / "g_loop_a.xvr") << "import g_loop_b;\n";
+    std::ofstream(std_dir / "g_loop_b.xvr") << "import g_loop_a;\n";
+
+    Xvr_ModuleResolver* resolver = Xvr_ModuleResolverCreate("./lib/std");
+    Xvr_ModuleGraph* graph = Xvr_ModuleGraphCreate(resolver);
+    REQUIRE(graph != nullptr);
+    const char* roots[] = {"g_left", "g_right", "g_missing"};
+    Xvr_ModuleGraphAdd(graph, roots, 3);
+    CHECK(Xvr_ModuleGraphGetCount(graph) == 4);
+    CHECK(Xvr_ModuleGraphGetParseCount(graph) == 4);
+
+    /* a module that cannot be read is kept, with nothing to emit */
+    size_t missing = 0;
+    int node_count = -1;
+    REQUIRE(Xvr_ModuleGraphRequire(graph, "g_missing", &missing));
+    CHECK(Xvr_ModuleGraphGetNodes(graph, missing, &node_count) == nullptr);
+    CHECK(node_count == 0);
+
+    size_t left = 0;
+    REQUIRE(Xvr_ModuleGraphRequire(graph, "g_left", &left));
+    size_t count = 0;
+    size_t* order = Xvr_ModuleGraphOrder(graph, left, &count);
+    REQUIRE(order != nullptr);
+    REQUIRE(count == 2);
+    CHECK(std::string(Xvr_ModuleGraphGetName(graph, order[0])) == "g_base");
+    CHECK(std::string(Xvr_ModuleGraphGetName(graph, order[1])) == "g_left");
+    free(order);
+
+    /* g_base is already handed out */
+    size_t right = 0;
+    REQUIRE(Xvr_ModuleGraphRequire(graph, "g_right", &right));
+    order = Xvr_ModuleGraphOrder(graph, right, &count);
+    REQUIRE(order != nullptr);
+    REQUIRE(count == 1);
+    CHECK(order[0] == right);
+    free(order);
+
+    size_t loop = 0;
+    REQUIRE(Xvr_ModuleGraphRequire(graph, "g_loop_a", &loop));
+    CHECK(Xvr_ModuleGraphOrder(graph, loop, &count) == nullptr);
+    CHECK(std::string(Xvr_ModuleGraphGetError(graph)) ==
+          "import cycle: g_loop_a -> g_loop_b -> g_loop_a");
+    CHECK(Xvr_ModuleGraphGetParseCount(graph) == 6);
+    Xvr_ModuleGraphDestroy(graph);
+    Xvr_ModuleResolverDestroy(resolver);
+
+    /* a diamond import emits the shared module once */
+    Xvr_LLVMCodegen* app = Xvr_LLVMCodegenCreate("app");
+    REQUIRE(app != nullptr);
+    std::vector<Xvr_ASTNode*> nodes = emitSource(app,
+                                                 "import g_left;\n"
+                                                 "import g_right;\n"
+                                                 "var n = g_left() + g_right();\n"
+                                                 "std::print(\"{}\\n\", n);\n");
+    INFO(Xvr_LLVMCodegenGetError(app));
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(app));
+    CHECK(Xvr_LLVMCodegenGetImportCount(app) == 3);
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(app, &ir_len);
+    REQUIRE(ir != nullptr);
+    std::string text(ir, ir_len);
+    free(ir);
+    CHECK(text.find("define i32 @g_base(") != std::string::npos);
+    CHECK(text.find("@g_base.1") == std::string::npos);
+    Xvr_LLVMCodegenDestroy(app);
+    freeNodes(nodes);
+
+    Xvr_LLVMCodegen* cyclic = Xvr_LLVMCodegenCreate("cyclic");
+    REQUIRE(cyclic != nullptr);
+    std::vector<Xvr_ASTNode*> cyclic_nodes = emitSource(cyclic, "import g_loop_a;\n");
+    CHECK(std::string(Xvr_LLVMCodegenGetError(cyclic)).find("import cycle") != std::string::npos);
+    Xvr_LLVMCodegenDestroy(cyclic);
+    freeNodes(cyclic_nodes);
+}
+
+TEST_CASE("Preloaded stdlib modules are handed out until their file changes", "[llvm_backend][llvm][server]") {
+    ScratchDir scratch("preload");
+    const std::filesystem::path& root = scratch.path();
+    std::filesystem::path module = root / "p_one.xvr";
+    /* same length, so only the modification time tells them apart */
+    const char* valid = "proc p_one(): int { return 1; }\n";
+    const char* broken = "proc p_one(): int { return +; }\n";
+    std::ofstream(root / "p_broken.xvr") << broken;
+    std::ofstream(root / "notes.txt") << "not a module\n";
+
+    Xvr_CompilerOptions options;
+    Xvr_CompilerOptionsInit(&options);
+    options.printDiagnostics = false;
+    Xvr_CompilerSession* session = Xvr_CompilerSessionCreate(&options);
+    Xvr_ModuleResolver* resolver = Xvr_ModuleResolverCreate(root.c_str());
+    Xvr_ModuleResolverSetSession(resolver, session);
+    Xvr_ASTNode** nodes = nullptr;
+    int count = 0;
+
+    /* an edited module is parsed again */
+    std::ofstream(module) << valid;
+    CHECK(Xvr_ModuleResolverPreloadStdlib(resolver) == 1);
+    std::filesystem::file_time_type preloaded = std::filesystem::last_write_time(module);
+    std::ofstream(module) << broken;
+    std::filesystem::last_write_time(module, preloaded + std::chrono::seconds(1));
+    CHECK_FALSE(Xvr_ModuleResolverLoadModule(resolver, module.c_str(), &nodes, &count));
+
+    /* an unchanged one is taken from the preload, once */
+    std::ofstream(module) << valid;
+    CHECK(Xvr_ModuleResolverPreloadStdlib(resolver) == 1);
+    preloaded = std::filesystem::last_write_time(module);
+    std::ofstream(module) << broken;
+    std::filesystem::last_write_time(module, preloaded);
+    REQUIRE(Xvr_ModuleResolverLoadModule(resolver, module.c_str(), &nodes, &count));
+    CHECK(count == 1);
+    std::vector<Xvr_ASTNode*> owned(nodes, nodes + count);
+    free(nodes);
+    freeNodes(owned);
+    CHECK_FALSE(Xvr_ModuleResolverLoadModule(resolver, module.c_str(), &nodes, &count));
+
+    Xvr_ModuleResolverDestroy(resolver);
+    Xvr_CompilerSessionDestroy(session);
+}
+
+TEST_CASE("Declaration fingerprints follow edits to a proc and its callers", "[llvm_backend][llvm][watch]") {
+    struct Fingerprints {
+        uint64_t program = 0;
+        uint64_t square = 0;
+        uint64_t twice = 0;
+        uint64_t other = 0;
+    };
+    auto fingerprint = [](const char* source) {
+        Xvr_DeclFingerprints* fingerprints = Xvr_DeclFingerprintsCreate(source);
+        REQUIRE(fingerprints != nullptr);
+        Fingerprints result;
+        result.program = Xvr_DeclFingerprintsGetProgram(fingerprints);
+        CHECK(Xvr_DeclFingerprintsGetProc(fingerprints, "square", &result.square));
+        CHECK(Xvr_DeclFingerprintsGetProc(fingerprints, "twice", &result.twice));
+        CHECK(Xvr_DeclFingerprintsGetProc(fingerprints, "other", &result.other));
+        CHECK_FALSE(Xvr_DeclFingerprintsGetProc(fingerprints, "missing", &result.other));
+        Xvr_DeclFingerprintsDestroy(fingerprints);
+        return result;
+    };
+
+    Fingerprints base = fingerprint("proc square(x: int): int { return x * x; }\n"
+                                    "proc twice(x: int): int { return square(x) * 2; }\n"
+                                    "proc other(): int { return 1; }\n"
+                                    "std::print(\"{}\\n\", twice(3));\n");
+
+    /* layout and comments are not tokens */
+    Fingerprints reformatted = fingerprint("proc square(x: int): int {\n"
+                                           "    return x * x;\n"
+                                           "}\n"
+                                           "proc twice(x: int): int { return square(x) * 2; }\n"
+                                           "proc other(): int { return 1; }\n"
+                                           "std::print(\"{}\\n\", twice(3));\n");
+    CHECK(reformatted.square == base.square);
+    CHECK(reformatted.twice == base.twice);
+    CHECK(reformatted.program == base.program);
+
+    /* a new body only touches the proc itself */
+    Fingerprints body = fingerprint("proc square(x: int): int { return x * x * x; }\n"
+                                    "proc twice(x: int): int { return square(x) * 2; }\n"
+                                    "proc other(): int { return 1; }\n"
+                                    "std::print(\"{}\\n\", twice(3));\n");
+    CHECK(body.square != base.square);
+    CHECK(body.twice == base.twice);
+    CHECK(body.other == base.other);
+    CHECK(body.program == base.program);
+
+    /* a new signature reaches its callers */
+    Fingerprints signature = fingerprint("proc square(x: int, y: int): int { return x * y; }\n"
+                                         "proc twice(x: int): int { return square(x) * 2; }\n"
+                                         "proc other(): int { return 1; }\n"
+                                         "std::print(\"{}\\n\", twice(3));\n");
+    CHECK(signature.square != base.square);
+    CHECK(signature.twice != base.twice);
+    CHECK(signature.other == base.other);
+    CHECK(signature.program == base.program);
+
+    /* every proc depends on the imports */
+    Fingerprints imported = fingerprint("import io;\n"
+                                        "proc square(x: int): int { return x * x; }\n"
+                                        "proc twice(x: int): int { return square(x) * 2; }\n"
+                                        "proc other(): int { return 1; }\n"
+                                        "std::print(\"{}\\n\", twice(3));\n");
+    CHECK(imported.other != base.other);
+    CHECK(imported.program != base.program);
+
+    /* two procs of the same name have no fingerprint */
+    Xvr_DeclFingerprints* duplicate = Xvr_DeclFingerprintsCreate("proc f(): int { return 1; }\n"
+                                                                 "proc f(): int { return 2; }\n");
+    uint64_t unused = 0;
+    CHECK_FALSE(Xvr_DeclFingerprintsGetProc(duplicate, "f", &unused));
+    Xvr_DeclFingerprintsDestroy(duplicate);
+}
+
+TEST_CASE("Watch builds compile only the fragments an edit touched", "[llvm_backend][llvm][watch]") {
+    ScratchDir scratch("watch", true);
+    const std::filesystem::path& root = scratch.path();
+    std::filesystem::path import = root / "lib" / "std" / "watch_inc.xvr";
+    std::ofstream(import) << "proc watch_inc(x: int): int { return x + 1; }\n";
+    std::filesystem::path app = root / "app.xvr";
+    auto write_app = [&app](const char* square) {
+        std::ofstream(app) << "include std;\n"
+                              "import watch_inc;\n"
+                           << square
+                           << "proc twice(x: int): int { return square(x) * 2; }\n"
+                              "std::print(\"{}\\n\", watch_inc(twice(3)));\n";
+    };
+    write_app("proc square(x: int): int { return x * x; }\n");
+
+    Xvr_CompilerOptions options;
+    Xvr_CompilerOptionsInit(&options);
+    options.runtimeBitcode = false;
+    Xvr_Watch* watch = Xvr_WatchCreate(&options, "app.xvr");
+    REQUIRE(watch != nullptr);
+
+    auto run = [&root, watch]() {
+        size_t* sizes = nullptr;
+        size_t count = 0;
+        void** objects = Xvr_WatchCopyObjects(watch, &sizes, &count);
+        REQUIRE(objects != nullptr);
+        std::string exe = (root / "app").string();
+        char* error = nullptr;
+        bool linked = Xvr_LLVMLinkerLinkExecutables(const_cast<const void* const*>(objects),
+                                                    sizes, count, exe.c_str(), &error);
+        INFO((error ? error : ""));
+        REQUIRE(linked);
+        for (size_t i = 0; i < count; i++) {
+            free(objects[i]);
+        }
+        free(objects);
+        free(sizes);
+        free(error);
+        std::string output;
+        FILE* pipe = popen(exe.c_str(), "r");
+        REQUIRE(pipe != nullptr);
+        char buffer[64];
+        while (fgets(buffer, sizeof(buffer), pipe)) {
+            output += buffer;
+        }
+        pclose(pipe);
+        return output;
+    };
+
+    bool built = Xvr_WatchBuild(watch);
+    INFO((Xvr_WatchGetError(watch) ? Xvr_WatchGetError(watch) : ""));
+    REQUIRE(built);
+    /* the program, square, twice and the import */
+    CHECK(Xvr_WatchGetFragmentCount(watch) == 4);
+    CHECK(Xvr_WatchGetCompiledCount(watch) == 4);
+    CHECK(run() == "19\n");
+
+    /* a new body only compiles its own proc */
+    write_app("proc square(x: int): int { return x * x * x; }\n");
+    REQUIRE(Xvr_WatchBuild(watch));
+    CHECK(Xvr_WatchGetCompiledCount(watch) == 1);
+    CHECK(run() == "55\n");
+
+    /* an edited import compiles everything again */
+    CHECK_FALSE(Xvr_WatchImportsChanged(watch));
+    std::ofstream(import) << "proc watch_inc(x: int): int { return x + 2; }\n";
+    CHECK(Xvr_WatchImportsChanged(watch));
+    REQUIRE(Xvr_WatchBuild(watch));
+    CHECK(Xvr_WatchGetCompiledCount(watch) == 4);
+    CHECK(run() == "56\n");
+
+    /* a failed build names the file and keeps the last objects */
+    write_app("proc square(x: int): int { return x * ; }\n");
+    CHECK_FALSE(Xvr_WatchBuild(watch));
+    REQUIRE(Xvr_WatchGetError(watch) != nullptr);
+    CHECK(std::string(Xvr_WatchGetErrorPath(watch)) == "app.xvr");
+    CHECK(run() == "56\n");
+
+    Xvr_WatchDestroy(watch);
+}
+
+TEST_CASE("Module manifests internalize and strip unexported procs", "[llvm_backend][llvm][imports]") {
+    const char text[] = "# comment\n"
+                        "module m_priv\n"
+                        "export m_pub\n"
+                        "native m_host\n";
+    Xvr_ModuleManifest* manifest = Xvr_ModuleManifestParse(text, sizeof(text) - 1);
+    REQUIRE(manifest != nullptr);
+    CHECK(std::string(Xvr_ModuleManifestGetName(manifest)) == "m_priv");
+    CHECK(Xvr_ModuleManifestGetExportCount(manifest) == 1);
+    CHECK(Xvr_ModuleManifestGetNativeCount(manifest) == 1);
+    CHECK(Xvr_ModuleManifestIsExported(manifest, "m_pub"));
+    CHECK(Xvr_ModuleManifestIsExported(manifest, "m_host"));
+    CHECK_FALSE(Xvr_ModuleManifestIsExported(manifest, "m_helper"));
+    Xvr_ModuleManifestDestroy(manifest);
+
+    /* without an export list everything stays visible */
+    manifest = Xvr_ModuleManifestParse("module open\n", 12);
+    REQUIRE(manifest != nullptr);
+    CHECK(Xvr_ModuleManifestIsExported(manifest, "anything"));
+    Xvr_ModuleManifestDestroy(manifest);
+
+    ScratchDir scratch("manifest", true);
+    const std::filesystem::path& root = scratch.path();
+    std::filesystem::path std_dir = scratch.stdlib();
+    std::ofstream(std_dir / "m_priv.xvr") << "proc m_helper(x: int): int { return x * 3; }\n"
+                                             "proc m_unused(): int { return 9; }\n"
+                                             "proc m_pub(x: int): int { return m_helper(x) + 1; }\n";
+    std::ofstream(std_dir / "m_priv.mod") << "module m_priv\n"
+                                             "export m_pub\n";
+
+    Xvr_LLVMCodegen* app = Xvr_LLVMCodegenCreate("app");
+    REQUIRE(app != nullptr);
+    std::vector<Xvr_ASTNode*> nodes = emitSource(app,
+                                                 "import m_priv;\n"
+                                                 "var n = m_pub(2);\n"
+                                                 "std::print(\"{}\\n\", n);\n");
+    INFO(Xvr_LLVMCodegenGetError(app));
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(app));
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(app, &ir_len);
+    REQUIRE(ir != nullptr);
+    std::string text_ir(ir, ir_len);
+    free(ir);
+    CHECK(text_ir.find("define i32 @m_pub(") != std::string::npos);
+    CHECK(text_ir.find("define internal i32 @m_helper(") != std::string::npos);
+    CHECK(text_ir.find("@m_unused") == std::string::npos);
+    Xvr_LLVMCodegenDestroy(app);
+    freeNodes(nodes);
+}
+
+TEST_CASE("Imported procs are emitted only once something calls them", "[llvm_backend][llvm][imports]") {
+    ScratchDir scratch("lazy", true);
+    const std::filesystem::path& root = scratch.path();
+    std::filesystem::path std_dir = scratch.stdlib();
+    std::ofstream(std_dir / "lz_math.xvr") << "proc lz_sq(x: int): int { return x * x; }\n"
+                                              "proc lz_cube(x: int): int { return lz_sq(x) * x; }\n"
+                                              "proc lz_neg(x: int): int { return 0 - x; }\n"
+                                              "proc lz_abs(x: int): int { return lz_neg(x); }\n"
+                                              "proc lz_one(): int { return 1; }\n"
+                                              "std::print(\"{}\\n\", lz_one());\n";
+
+    Xvr_LLVMCodegen* app = Xvr_LLVMCodegenCreate("app");
+    REQUIRE(app != nullptr);
+    std::vector<Xvr_ASTNode*> nodes = emitSource(app,
+                                                 "import lz_math;\n"
+                                                 "var n = lz_cube(3);\n"
+                                                 "std::print(\"{}\\n\", n);\n");
+    INFO(Xvr_LLVMCodegenGetError(app));
+    REQUIRE_FALSE(Xvr_LLVMCodegenHasError(app));
+    REQUIRE(Xvr_LLVMCodegenVerify(app));
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(app, &ir_len);
+    REQUIRE(ir != nullptr);
+    std::string text(ir, ir_len);
+    free(ir);
+    /* called from main, through another proc, and by the module itself */
+    CHECK(text.find("define i32 @lz_cube(") != std::string::npos);
+    CHECK(text.find("define i32 @lz_sq(") != std::string::npos);
+    CHECK(text.find("define i32 @lz_one(") != std::string::npos);
+    CHECK(text.find("@lz_neg") == std::string::npos);
+    CHECK(text.find("@lz_abs") == std::string::npos);
+    Xvr_LLVMCodegenDestroy(app);
+    freeNodes(nodes);
+}
+
+static std::vector<Xvr_ASTNode*> parseSource(const char* source) {
+    Xvr_Lexer lexer;
+    Xvr_Parser parser;
+    Xvr_initLexer(&lexer, source);
+    Xvr_initParser(&parser, &lexer);
+
+    std::vector<Xvr_ASTNode*> nodes;
+    for (Xvr_ASTNode* node = Xvr_scanParser(&parser); node != nullptr;
+         node = Xvr_scanParser(&parser)) {
+        nodes.push_back(node);
+    }
+    Xvr_freeParser(&parser);
+    return nodes;
+}
+
+static std::string unitObject(Xvr_LLVMCodegen* codegen, std::vector<Xvr_ASTNode*>& nodes) {
+    bool ok = true;
+    for (size_t i = 0; ok && i < nodes.size(); i++) {
+        ok = Xvr_LLVMCodegenEmitAST(codegen, nodes[i]);
+    }
+    size_t size = 0;
+    void* object = ok && Xvr_LLVMCodegenVerify(codegen) ? Xvr_LLVMCodegenEmitObject(codegen, &size) : nullptr;
+    std::string result(static_cast<const char*>(object), object ? size : 0);
+    free(object);
+    return result;
+}
+
+TEST_CASE("Source files compile on separate threads and link", "[llvm_backend][llvm][link]") {
+    std::vector<Xvr_ASTNode*> program = parseSource("var n = unit_twice(20) + 2;\n"
+                                                    "std::print(\"{}\\n\", n);\n");
+    std::vector<Xvr_ASTNode*> library = parseSource("proc unit_twice(x: int): int { return x * 2; }\n");
+
+    /* the program only declares what the other file defines */
+    Xvr_LLVMCodegen* app = Xvr_LLVMCodegenCreate("app");
+    Xvr_LLVMCodegen* lib = Xvr_LLVMCodegenCreate("lib");
+    REQUIRE(app != nullptr);
+    REQUIRE(lib != nullptr);
+    REQUIRE(Xvr_LLVMCodegenSetSeparateImports(app, true));
+    REQUIRE(Xvr_LLVMCodegenSetLibraryUnit(lib, true));
+    REQUIRE(Xvr_LLVMCodegenDeclareProcs(app, library.data(), static_cast<int>(library.size())));
+    REQUIRE(Xvr_LLVMCodegenDeclareProcs(lib, program.data(), static_cast<int>(program.size())));
+
+    std::string objects[2];
+    std::thread worker([&] { objects[1] = unitObject(lib, library); });
+    objects[0] = unitObject(app, program);
+    worker.join();
+    INFO(Xvr_LLVMCodegenGetError(app));
+    INFO(Xvr_LLVMCodegenGetError(lib));
+    REQUIRE_FALSE(objects[0].empty());
+    REQUIRE_FALSE(objects[1].empty());
+
+    ScratchDir scratch("units");
+    std::string exe = (scratch.path() / "app").string();
+    const void* data[2] = {objects[0].data(), objects[1].data()};
+    size_t sizes[2] = {objects[0].size(), objects[1].size()};
+    char* error = nullptr;
+    bool linked = Xvr_LLVMLinkerLinkExecutables(data, sizes, 2, exe.c_str(), &error);
+    INFO((error ? error : ""));
+    REQUIRE(linked);
+    std::string command = exe + " | grep -qx 42";
+    CHECK(system(command.c_str()) == 0);
+
+    free(error);
+    Xvr_LLVMCodegenDestroy(app);
+    Xvr_LLVMCodegenDestroy(lib);
+    freeNodes(program);
+    freeNodes(library);
+}
+
+TEST_CASE("Session type tables keep every type they hand out", "[llvm_backend][llvm][session]") {
+    Xvr_CompilerSession* session = Xvr_CompilerSessionCreate(nullptr);
+    Xvr_TypeTable* table = Xvr_CompilerSessionGetTypeTable(session);
+    REQUIRE(table != nullptr);
+
+    /* more sizes than the table first has room for */
+    std::vector<Xvr_Type*> first;
+    for (int bits = 1; bits <= 80; bits++) {
+        first.push_back(Xvr_TypeTableGetInteger(table, bits, XVR_SIGNEDNESS_SIGNED));
+        REQUIRE(first.back() != nullptr);
+    }
+    CHECK(table->count == 80);
+    for (int bits = 1; bits <= 80; bits++) {
+        CHECK(Xvr_TypeTableGetInteger(table, bits, XVR_SIGNEDNESS_SIGNED) == first[bits - 1]);
+    }
+    CHECK(table->count == 80);
+    Xvr_CompilerSessionDestroy(session);
+}
+
+TEST_CASE("Codegens take their optimizer options from the session", "[llvm_backend][llvm][session]") {
+    Xvr_CompilerOptions options;
+    Xvr_CompilerOptionsInit(&options);
+    options.passPipeline = "function(mem2reg)";
+    options.runtimeBitcode = false;
+    Xvr_CompilerSession* session = Xvr_CompilerSessionCreate(&options);
+    REQUIRE(session != nullptr);
+
+    /* the session keeps its own copy of the pipeline */
+    CHECK(Xvr_CompilerSessionGetOptions(session)->passPipeline != options.passPipeline);
+
+    int count = -1;
+    Xvr_ASTNode** nodes = Xvr_CompilerSessionParse(session, "var a = 1;\nvar b = a + 2;\na = b;\n", &count);
+    REQUIRE(nodes != nullptr);
+    CHECK(count == 3);
+
+    Xvr_LLVMCodegen* codegen = Xvr_LLVMCodegenCreateWithSession("session_passes", session);
+    REQUIRE(codegen != nullptr);
+    REQUIRE(Xvr_LLVMCodegenApplySessionPipeline(codegen));
+    CHECK(std::string(Xvr_LLVMCodegenGetPipeline(codegen)) == "function(mem2reg)");
+    for (int i = 0; i < count; i++) {
+        REQUIRE(Xvr_LLVMCodegenEmitAST(codegen, nodes[i]));
+    }
+    /* -O0 with a pipeline of its own still runs it */
+    REQUIRE(Xvr_LLVMCodegenOptimize(codegen));
+    size_t ir_len = 0;
+    char* ir = Xvr_LLVMCodegenPrintIR(codegen, &ir_len);
+    REQUIRE(ir != nullptr);
+    CHECK(std::string(ir).find("alloca") == std::string::npos);
+    free(ir);
+    Xvr_LLVMCodegenDestroy(codegen);
+    for (int i = 0; i < count; i++) {
+        Xvr_freeASTNode(nodes[i]);
+    }
+    free(nodes);
+
+    /* an empty source parses to no nodes, a broken one fails */
+    nodes = Xvr_CompilerSessionParse(session, "", &count);
+    REQUIRE(nodes != nullptr);
+    CHECK(count == 0);
+    free(nodes);
+    Xvr_CompilerSessionDestroy(session);
+
+    options.passPipeline = "not-a-pass";
+    session = Xvr_CompilerSessionCreate(&options);
+    codegen = Xvr_LLVMCodegenCreateWithSession("bad_passes", session);
+    REQUIRE(codegen != nullptr);
+    CHECK_FALSE(Xvr_LLVMCodegenApplySessionPipeline(codegen));
+    CHECK(Xvr_LLVMCodegenGetError(codegen) != nullptr);
+    Xvr_LLVMCodegenDestroy(codegen);
+    Xvr_CompilerSessionDestroy(session);
+}
+
+TEST_CASE("Compiler sessions compile concurrently and keep their diagnostics", "[llvm_backend][llvm][session]") {
+    /* both casts intern types, each in its own session's table */
+    const char* sources[2] = {
+        "var half = 20.5;\nvar n = int32(half) * 2 + 2;\nstd::print(\"{}\\n\", n);\n",
+        "var wide: int64 = 43;\nvar n = int32(wide);\nstd::print(\"{}\\n\", n);\n",
+    };
+    const char* expected[2] = {"42", "43"};
+
+    std::string objects[2];
+    std::string errors[2];
+    auto compile = [&](int index) {
+        Xvr_CompilerOptions options;
+        Xvr_CompilerOptionsInit(&options);
+        options.optimizationLevel = index == 0 ? 2 : 0;
+        Xvr_CompilerSession* session = Xvr_CompilerSessionCreate(&options);
+        size_t size = 0;
+        void* object = Xvr_CompilerSessionCompile(session, sources[index], strlen(sources[index]),
+                                                  index == 0 ? "first" : "second", &size);
+        if (object) {
+            objects[index].assign(static_cast<const char*>(object), size);
+            free(object);
+        } else if (Xvr_CompilerSessionGetDiagnosticCount(session) > 0) {
+            errors[index] = Xvr_CompilerSessionGetDiagnostic(session, 0);
+        }
+        Xvr_CompilerSessionDestroy(session);
+    };
+    std::thread worker(compile, 1);
+    compile(0);
+    worker.join();
+
+    ScratchDir scratch("session");
+    for (int i = 0; i < 2; i++) {
+        INFO(errors[i]);
+        REQUIRE_FALSE(objects[i].empty());
+        std::string exe = (scratch.path() / ("app" + std::to_string(i))).string();
+        const void* data[1] = {objects[i].data()};
+        size_t sizes[1] = {objects[i].size()};
+        char* error = nullptr;
+        bool linked = Xvr_LLVMLinkerLinkExecutables(data, sizes, 1, exe.c_str(), &error);
+        INFO((error ? error : ""));
+        REQUIRE(linked);
+        free(error);
+        std::string command = exe + " | grep -qx " + expected[i];
+        CHECK(system(command.c_str()) == 0);
+    }
+
+    /* syntax errors land in the session instead of on stderr */
+    Xvr_CompilerSession* session = Xvr_CompilerSessionCreate(nullptr);
+    const char* broken = "var n = 1;\nvar = ;\n";
+    size_t size = 0;
+    CHECK(Xvr_CompilerSessionCompile(session, broken, strlen(broken), "broken", &size) == nullptr);
+    REQUIRE(Xvr_CompilerSessionGetDiagnosticCount(session) >= 1);
+    CHECK(std::string(Xvr_CompilerSessionGetDiagnostic(session, 0)).rfind("line 2, column 5: ", 0) == 0);
+    Xvr_CompilerSessionClearDiagnostics(session);
+    CHECK(Xvr_CompilerSessionGetDiagnosticCount(session) == 0);
+    Xvr_CompilerSessionDestroy(session);
+}
+
+TEST_CASE("REPL entries share variables and procs through one JIT", "[llvm_backend][llvm][repl]") {
+    CHECK(Xvr_LLVMReplIsComplete("var n = 1;\n"));
+    CHECK(Xvr_LLVMReplIsComplete("proc f(x: int): int {\n    return x;\n}\n"));
+    CHECK_FALSE(Xvr_LLVMReplIsComplete("proc f(x: int): int {\n"));
+    CHECK_FALSE(Xvr_LLVMReplIsComplete("std::print(\"{}\\n\",\n"));
+
+    Xvr_CompilerSession* session = Xvr_CompilerSessionCreate(nullptr);
+    Xvr_LLVMRepl* repl = Xvr_LLVMReplCreate(session);
+    REQUIRE(repl != nullptr);
+
+    const char* entries[] = {
+        "var n = 20;",
+        "proc twice(x: int): int { return x * 2; }",
+        "var m = twice(n) + 2;",
+        "n = n + 1;",
+        "var label = \"answer\";",
+        "std::print(\"{} {} {}\\n\", label, m, n);",
+    };
+
+    char path[] = "/tmp/xvr-repl-test-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    bool ran = true;
+    for (const char* entry : entries) {
+        ran = ran && Xvr_LLVMReplEval(repl, entry, nullptr);
+    }
+    /* the engine keeps the first definition, the session goes on */
+    bool redefined = Xvr_LLVMReplEval(repl, "proc twice(x: int): int { return x; }", nullptr);
+    bool called = Xvr_LLVMReplEval(repl, "std::print(\"{}\\n\", twice(m));", nullptr);
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    close(fd);
+
+    std::ifstream in(path);
+    std::stringstream output;
+    output << in.rdbuf();
+    unlink(path);
+
+    CHECK(ran);
+    CHECK_FALSE(redefined);
+    CHECK(called);
+    CHECK(output.str() == "answer 42 21\n84\n");
+    REQUIRE(Xvr_CompilerSessionGetDiagnosticCount(session) == 1);
+    CHECK(std::string(Xvr_CompilerSessionGetDiagnostic(session, 0)).find("already defined") !=
+          std::string::npos);
+
+    Xvr_LLVMReplDestroy(repl);
+    Xvr_CompilerSessionDestroy(session);
+}
+
+TEST_CASE("REPL sessions gather lines into whole entries", "[llvm_backend][llvm][repl]") {
+    Xvr_CompilerSession* session = Xvr_CompilerSessionCreate(nullptr);
+    Xvr_LLVMRepl* repl = Xvr_LLVMReplCreate(session);
+    REQUIRE(repl != nullptr);
+
+    char input[] = "var k =\n"
+                   "    5;\n"
+                   "\n"
+                   "proc thrice(x: int): int {\n"
+                   "    return x * 3;\n"
+                   "}\n"
+                   "std::print(\"{}\\n\", thrice(k));\n";
+    FILE* in = fmemopen(input, strlen(input), "r");
+    REQUIRE(in != nullptr);
+    char* prompts = nullptr;
+    size_t prompts_size = 0;
+    FILE* prompt = open_memstream(&prompts, &prompts_size);
+    REQUIRE(prompt != nullptr);
+
+    char path[] = "/tmp/xvr-repl-run-test-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    bool ran = Xvr_LLVMReplRun(repl, in, prompt, nullptr);
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    close(fd);
+    fclose(in);
+    fclose(prompt);
+
+    std::ifstream out(path);
+    std::stringstream output;
+    output << out.rdbuf();
+    unlink(path);
+
+    CHECK(ran);
+    CHECK(output.str() == "15\n");
+    CHECK(std::string(prompts, prompts_size) == "xvr> ...> xvr> xvr> ...> ...> xvr> xvr> \n");
+    free(prompts);
+
+    /* read from a file, a failed entry fails the session */
+    char broken[] = "var q = ;\n";
+    in = fmemopen(broken, strlen(broken), "r");
+    REQUIRE(in != nullptr);
+    CHECK_FALSE(Xvr_LLVMReplRun(repl, in, nullptr, nullptr));
+    fclose(in);
+
+    Xvr_LLVMReplDestroy(repl);
+    Xvr_CompilerSessionDestroy(session);
+}
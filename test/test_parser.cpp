@@ -1,7 +1,10 @@
 #include <catch2/catch_test_macros.hpp>
+#include <string>
 #include "xvr_lexer.h"
 #include "xvr_parser.h"
 #include "xvr_ast_node.h"
+#include "xvr_compiler_session.h"
+#include "xvr_token_buffer.h"
 
 TEST_CASE("Parser integer literal", "[parser][unit]") {
     const char* source = "42;";
@@ -658,3 +661,135 @@ TEST_CASE("Parser property access", "[parser][unit]") {
     Xvr_freeASTNode(node);
     Xvr_freeParser(&parser);
 }
+
+TEST_CASE("Token buffer holds the lexer's stream as arrays", "[parser][unit]") {
+    const char* source = "var a = 1;\n\n/* x\n */ a += \"two\nlines\"; & b";
+    Xvr_TokenBuffer* tokens = Xvr_TokenBufferCreate();
+    REQUIRE(tokens != nullptr);
+
+    Xvr_Lexer lexer;
+    Xvr_initLexer(&lexer, source);
+    REQUIRE(Xvr_TokenBufferFill(tokens, &lexer));
+
+    Xvr_Lexer expected;
+    Xvr_initLexer(&expected, source);
+    for (int i = 0; i < tokens->count; i++) {
+        Xvr_Token want = Xvr_private_scanLexer(&expected);
+        Xvr_Token got = Xvr_TokenBufferGet(tokens, i);
+        REQUIRE(got.type == want.type);
+        REQUIRE(got.length == want.length);
+        REQUIRE(got.offset == want.offset);
+        REQUIRE(std::string(got.lexeme, got.length) ==
+                std::string(want.lexeme, want.length));
+    }
+
+    REQUIRE(tokens->count == 12);
+    REQUIRE(tokens->types[tokens->count - 1] == XVR_TOKEN_EOF);
+    REQUIRE(tokens->lines.count == 4);
+    Xvr_SourceLocation string_start =
+        Xvr_TokenBufferLocate(tokens, Xvr_TokenBufferGet(tokens, 7).offset);
+    REQUIRE(string_start.line == 4);
+    REQUIRE(string_start.column == 10);
+    REQUIRE(tokens->error_count == 1);
+    REQUIRE(Xvr_TokenBufferGet(tokens, 1000).type == XVR_TOKEN_EOF);
+
+    // refilling with a smaller source keeps the arrays
+    const uint8_t* types = tokens->types;
+    const int capacity = tokens->capacity;
+    Xvr_initLexer(&lexer, "a;");
+    REQUIRE(Xvr_TokenBufferFill(tokens, &lexer));
+    REQUIRE(tokens->count == 3);
+    REQUIRE(tokens->error_count == 0);
+    REQUIRE(tokens->types == types);
+    REQUIRE(tokens->capacity == capacity);
+
+    Xvr_TokenBufferDestroy(tokens);
+}
+
+TEST_CASE("Token buffer keeps the lexer's error messages", "[parser][unit]") {
+    Xvr_TokenBuffer* tokens = Xvr_TokenBufferCreate();
+    REQUIRE(tokens != nullptr);
+
+    Xvr_Lexer lexer;
+    Xvr_initLexer(&lexer, "var b = a @ 2 # 3;");
+    REQUIRE(Xvr_TokenBufferFill(tokens, &lexer));
+    REQUIRE(tokens->error_count == 2);
+
+    Xvr_Token first = Xvr_TokenBufferGet(tokens, 4);
+    REQUIRE(first.type == XVR_TOKEN_ERROR);
+    REQUIRE(std::string(first.lexeme, first.length) == "Unexpected token: @");
+
+    Xvr_Token second = Xvr_TokenBufferGet(tokens, 6);
+    REQUIRE(second.type == XVR_TOKEN_ERROR);
+    REQUIRE(std::string(second.lexeme, second.length) ==
+            "Unexpected token: #");
+
+    Xvr_TokenBufferDestroy(tokens);
+}
+
+TEST_CASE("Parser reads a token buffer by index", "[parser][unit]") {
+    const char* source =
+        "var x: int32 = 1 + 2 * 3;\n"
+        "proc f(a: int32): int32 { return a; }\n"
+        "if (x > 2) { print x; } else { print f(x); }\n";
+    Xvr_TokenBuffer* tokens = Xvr_TokenBufferCreate();
+
+    Xvr_Lexer lexer;
+    Xvr_initLexer(&lexer, source);
+    Xvr_Parser parser;
+    Xvr_initParserWithTokens(&parser, &lexer, tokens);
+    REQUIRE(parser.tokens == tokens);
+    REQUIRE(parser.index == 0);
+
+    // the stream is all there, lookahead is an index
+    REQUIRE(Xvr_TokenBufferGet(parser.tokens, parser.index + 1).type ==
+            XVR_TOKEN_IDENTIFIER);
+
+    Xvr_Lexer streamed_lexer;
+    Xvr_initLexer(&streamed_lexer, source);
+    Xvr_Parser streamed;
+    Xvr_initParser(&streamed, &streamed_lexer);
+    REQUIRE(streamed.tokens == nullptr);
+
+    for (;;) {
+        Xvr_ASTNode* node = Xvr_scanParser(&parser);
+        Xvr_ASTNode* want = Xvr_scanParser(&streamed);
+        REQUIRE((node == nullptr) == (want == nullptr));
+        if (!node) {
+            break;
+        }
+        REQUIRE(node->type == want->type);
+        REQUIRE(parser.previous.offset == streamed.previous.offset);
+        Xvr_freeASTNode(node);
+        Xvr_freeASTNode(want);
+    }
+    REQUIRE(!parser.error);
+    Xvr_freeParser(&parser);
+    Xvr_freeParser(&streamed);
+
+    // a session lends its buffers out and takes them back for reuse
+    Xvr_CompilerSession* session = Xvr_CompilerSessionCreate(NULL);
+    Xvr_TokenBuffer* lent = nullptr;
+    for (int round = 0; round < 2; round++) {
+        Xvr_initLexerWithSession(&lexer, source, session);
+        Xvr_initParser(&parser, &lexer);
+        REQUIRE(parser.tokens != nullptr);
+        if (round == 1) {
+            REQUIRE(parser.tokens == lent);
+        }
+        lent = parser.tokens;
+
+        int count = 0;
+        for (Xvr_ASTNode* node = Xvr_scanParser(&parser); node;
+             node = Xvr_scanParser(&parser)) {
+            REQUIRE(node->type != XVR_AST_NODE_ERROR);
+            Xvr_freeASTNode(node);
+            count++;
+        }
+        REQUIRE(count == 3);
+        Xvr_freeParser(&parser);
+    }
+    Xvr_CompilerSessionDestroy(session);
+
+    Xvr_TokenBufferDestroy(tokens);
+}
@@ -2,6 +2,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <sys/wait.h>
 #include <unistd.h>
 
 static const char* get_xvr_path(void) {
@@ -137,4 +138,24 @@ TEST_CASE("std::println with variable", "[std][println]") {
     int status = capture_compile_run(source, output, sizeof(output));
     REQUIRE(status == 0);
     REQUIRE(strcmp(output, "value: 10") == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE("len of a string literal", "[std][len]") {
+    const char* source = "include std;\nvar n = len(\"arfy\");\nstd::print(\"{}\\n\", n);";
+    char output[4096] = {0};
+
+    int status = capture_compile_run(source, output, sizeof(output));
+    REQUIRE(status == 0);
+    REQUIRE(strcmp(output, "4") == 0);
+}
+
+TEST_CASE("Invalid IR fails the compile without crashing", "[std][driver]") {
+    // nested array literals reach the int array runtime unconverted
+    const char* source = "var m = [[1, 2], [3, 4]];\nstd::print(\"{}\\n\", m[0][0]);";
+    char output[4096] = {0};
+
+    int status = capture_compile_run(source, output, sizeof(output));
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 1);
+    REQUIRE(strstr(output, "error: invalid IR: ") != nullptr);
+}